@@ -3,11 +3,14 @@
 #include <CORE/BASE/appstats.h>
 #include <CORE/BASE/config.h>
 #include <CORE/BASE/logging.h>
+#include <CORE/BASE/logging_binary_sink.h>
+#include <CORE/BASE/logging_file_sink.h>
 #include <CORE/NET/net_common.h>
 #include <CORE/VFS/vfs.h>
 
 #include <.generated/version.h>
 
+#include <fstream>
 #include <iostream>
 
 #ifdef FISHY_DEBUG
@@ -18,6 +21,18 @@
 
 core::config::Flag< int >
     g_logVerbosity("log_verbosity", "Logging level [0, 4]", DEFAULT_LOG_LEVEL);
+core::config::Flag< std::string > g_binaryLog(
+    "binary_log",
+    "File to also write a binary log of every level to, for logdecode.",
+    "");
+core::config::Flag< std::string > g_logFile(
+    "log_file",
+    "File to also write the log to, rotated as it grows.",
+    "");
+core::config::Flag< bool > g_logFileFsync(
+    "log_file_fsync",
+    "Should the log file be synced to disk as it is written.",
+    false);
 core::config::Flag< bool > g_debugHalt(
     "haltonerror", "Should this binary halt on exit on error.", true);
 
@@ -105,4 +120,28 @@ void setupLogging() {
       core::logging::RegisterSink(std::shared_ptr< core::logging::iLogSink >(
           new core::logging::LoggingStdioSink(loggerLevels))),
       "Unable to setup stdio log sinks.");
+
+  if (!g_logFile.get().empty()) {
+    core::logging::LoggingFileSink::Options options;
+    options.m_path = g_logFile.get();
+    options.m_format = core::logging::LoggingStdioSink::Options::FORMAT_VERBOSE;
+    options.m_fsync = g_logFileFsync.get();
+    std::shared_ptr< core::logging::LoggingFileSink > pSink =
+        std::make_shared< core::logging::LoggingFileSink >(
+            loggerLevels, options);
+    CHECK_M(pSink->isOpen(), "Unable to open log file " << g_logFile.get());
+    CHECK_M(
+        core::logging::RegisterSink(pSink), "Unable to setup file log sink.");
+  }
+
+  if (!g_binaryLog.get().empty()) {
+    std::unique_ptr< std::ostream > pFile(new std::ofstream(
+        g_binaryLog.get().c_str(), std::ios_base::out | std::ios_base::binary));
+    CHECK_M(*pFile, "Unable to open binary log " << g_binaryLog.get());
+    CHECK_M(
+        core::logging::RegisterSink(
+            std::make_shared< core::logging::LoggingBinarySink >(
+                ~core::types::BitSet< LL >(), std::move(pFile))),
+        "Unable to setup binary log sink.");
+  }
 }
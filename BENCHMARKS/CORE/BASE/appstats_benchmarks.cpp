@@ -0,0 +1,65 @@
+#include <BENCHMARKS/benchmark.h>
+
+#include <CORE/ARCH/timer.h>
+#include <CORE/BASE/appstats.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using core::AppStat;
+using core::eAppStatMode;
+
+/**
+ * Increments made by each configuration, split across its threads.
+ */
+static const u64 INCREMENT_COUNT = 10000000;
+
+/**
+ * Increment {@code pStatName} from {@code threadCount} threads at once, and
+ * report the throughput.
+ */
+static void RunIncrements(
+    const std::string &name,
+    const char *pStatName,
+    const eAppStatMode::type mode,
+    const u32 threadCount) {
+  AppStat stat(pStatName, mode);
+  const u64 start = core::timer::GetTicks();
+
+  std::vector< std::thread > threads;
+  for (u32 i = 0; i < threadCount; ++i) {
+    threads.push_back(std::thread([&stat, threadCount]() {
+      for (u64 n = 0; n < INCREMENT_COUNT / threadCount; ++n) {
+        stat.increment();
+      }
+    }));
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  const f64 seconds =
+      core::timer::TicksToTime(core::timer::GetTicks() - start);
+  benchmark::Report(name, INCREMENT_COUNT, 0, seconds);
+}
+
+REGISTER_BENCHMARK(benchmarkAppStatIncrement) {
+  RunIncrements("appstat shared 1", "bench_shared", eAppStatMode::SHARED, 1);
+  RunIncrements("appstat shared 4", "bench_shared", eAppStatMode::SHARED, 4);
+  RunIncrements(
+      "appstat sharded 1", "bench_sharded", eAppStatMode::SHARDED, 1);
+  RunIncrements(
+      "appstat sharded 4", "bench_sharded", eAppStatMode::SHARDED, 4);
+}
+
+REGISTER_BENCHMARK(benchmarkAppStatSnapshot) {
+  const u64 count = 10000;
+  const u64 start = core::timer::GetTicks();
+  for (u64 n = 0; n < count; ++n) {
+    core::AppStatSnapshot::capture();
+  }
+  const f64 seconds =
+      core::timer::TicksToTime(core::timer::GetTicks() - start);
+  benchmark::Report("appstat snapshot", count, 0, seconds);
+}
@@ -0,0 +1,275 @@
+#include <BENCHMARKS/benchmark.h>
+
+#include <CORE/ARCH/timer.h>
+#include <CORE/BASE/logging.h>
+#include <CORE/BASE/logging_binary_sink.h>
+#include <CORE/BASE/logging_default_sinks.h>
+#include <CORE/BASE/logging_file_sink.h>
+#include <CORE/TYPES/concurrent_queue.h>
+#include <CORE/UTIL/lexical_cast.h>
+
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+using core::logging::AppendToLog;
+using core::logging::LogMessage;
+using core::logging::MAX_LOG_LEN;
+
+/**
+ * Messages formatted by each configuration.
+ */
+static const u32 MESSAGE_COUNT = 1000000;
+
+/**
+ * Formatting as LogMessageBuilder did before AppendToLog: a stringstream and
+ * a temporary string per value, and a strncat which rescans the message.
+ */
+template < typename T >
+static void LegacyAppend(LogMessage &message, const T &obj) {
+  std::string str;
+  const size_t remainingLen = MAX_LOG_LEN - 4 - (message.m_msgLen + 1);
+  if (core::util::lexical_cast(obj, str)) {
+    strncat(message.m_msg, str.c_str(), remainingLen);
+  }
+}
+
+/**
+ *
+ */
+static void LegacyAppend(LogMessage &message, const char *pStr) {
+  const size_t remainingLen = MAX_LOG_LEN - 4 - (message.m_msgLen + 1);
+  strncat(message.m_msg, pStr, remainingLen);
+}
+
+/**
+ * Format {@code Log(LL::Info) << "x=" << i << " y=" << f} into a message, and
+ * report the messages per second. Submitting to the logger is left out.
+ */
+template < bool tLegacy >
+static void RunFormat(const std::string &name) {
+  const u64 start = core::timer::GetTicks();
+  size_t totalLen = 0;
+  for (u32 i = 0; i < MESSAGE_COUNT; ++i) {
+    LogMessage message;
+    const f32 f = (f32) i * 0.25f;
+    if (tLegacy) {
+      LegacyAppend(message, "x=");
+      LegacyAppend(message, i);
+      LegacyAppend(message, " y=");
+      LegacyAppend(message, f);
+      totalLen += strlen(message.m_msg);
+    } else {
+      AppendToLog(message, "x=");
+      AppendToLog(message, i);
+      AppendToLog(message, " y=");
+      AppendToLog(message, f);
+      totalLen += message.m_msgLen;
+    }
+  }
+
+  const f64 seconds =
+      core::timer::TicksToTime(core::timer::GetTicks() - start);
+  benchmark::Report(name, MESSAGE_COUNT, totalLen, seconds);
+}
+
+REGISTER_BENCHMARK(benchmarkLogFormat) {
+  RunFormat< true >("log format lexical_cast");
+  RunFormat< false >("log format AppendToLog");
+}
+
+REGISTER_BENCHMARK(benchmarkLogDisabled) {
+  CHECK(core::logging::g_minLogLevel.fromString("Error"));
+  const u64 start = core::timer::GetTicks();
+  for (u32 i = 0; i < MESSAGE_COUNT; ++i) {
+    Log(LL::Info) << "x=" << i << " y=" << (f32) i * 0.25f;
+  }
+  const f64 seconds =
+      core::timer::TicksToTime(core::timer::GetTicks() - start);
+  benchmark::Report("log below min_log_level", MESSAGE_COUNT, 0, seconds);
+  CHECK(core::logging::g_minLogLevel.fromString("Trace"));
+}
+
+/**
+ * Messages submitted by each thread.
+ */
+static const u32 SUBMIT_COUNT = 200000;
+
+/**
+ * Submit messages from {@code threadCount} threads, and report the messages
+ * per second until the last is written. The legacy configuration passes whole
+ * LogMessages through one shared ConcurrentQueue, as the logger did before
+ * per thread buffers.
+ */
+template < bool tLegacy >
+static void RunSubmit(const std::string &name, const u32 threadCount) {
+  core::types::ConcurrentQueue< core::logging::LogMessage > queue(1024 * 16);
+  std::thread consumer;
+  if (tLegacy) {
+    consumer = std::thread([&queue]() {
+      core::logging::LogMessage message;
+      while (queue.pop(message)) {
+      }
+    });
+  }
+
+  const u64 start = core::timer::GetTicks();
+  std::vector< std::thread > threads;
+  for (u32 t = 0; t < threadCount; ++t) {
+    threads.push_back(std::thread([&queue]() {
+      for (u32 i = 0; i < SUBMIT_COUNT; ++i) {
+        if (tLegacy) {
+          core::logging::LogMessage message(LL::Error, LOG_TRACE_INFO());
+          AppendToLog(message, "submit ");
+          AppendToLog(message, i);
+          queue.push(std::move(message));
+        } else {
+          Log(LL::Error) << "submit " << i;
+        }
+      }
+    }));
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+  if (tLegacy) {
+    queue.waitEmpty();
+    queue.close();
+    consumer.join();
+  } else {
+    core::logging::FlushLogger();
+  }
+
+  const f64 seconds =
+      core::timer::TicksToTime(core::timer::GetTicks() - start);
+  benchmark::Report(name, threadCount * SUBMIT_COUNT, 0, seconds);
+}
+
+REGISTER_BENCHMARK(benchmarkLogSubmit) {
+  RunSubmit< true >("log submit ConcurrentQueue x1", 1);
+  RunSubmit< false >("log submit thread buffers x1", 1);
+  RunSubmit< true >("log submit ConcurrentQueue x4", 4);
+  RunSubmit< false >("log submit thread buffers x4", 4);
+}
+
+/**
+ * Stream buffer counting, then dropping, what is written to it.
+ */
+class CountingBuffer : public std::streambuf {
+  public:
+  CountingBuffer() : m_count(0) {}
+  size_t count() const { return m_count; }
+
+  protected:
+  virtual int overflow(int c) override {
+    m_count++;
+    return c;
+  }
+  virtual std::streamsize xsputn(const char *, std::streamsize n) override {
+    m_count += n;
+    return n;
+  }
+
+  private:
+  size_t m_count;
+};
+
+/**
+ * Record messages as the verbose stdio layout, or as a binary log, and report
+ * the messages per second and bytes written.
+ */
+template < bool tBinary >
+static void RunRecord(const std::string &name) {
+  CountingBuffer *pBuffer = new CountingBuffer();
+  std::unique_ptr< std::ostream > pStream(new std::ostream(pBuffer));
+  std::ostream &stream = *pStream;
+  std::shared_ptr< core::logging::iLogSink > pSink =
+      std::make_shared< core::logging::LoggingBinarySink >(
+          ~core::types::BitSet< LL >(), std::move(pStream));
+
+  core::logging::LogMessage message(LL::Trace, LOG_TRACE_INFO());
+  AppendToLog(message, "tick ");
+  AppendToLog(message, 12345);
+  AppendToLog(message, " took ");
+  AppendToLog(message, 0.25f);
+  AppendToLog(message, "ms");
+
+  const u64 start = core::timer::GetTicks();
+  for (u32 i = 0; i < MESSAGE_COUNT; ++i) {
+    if (tBinary) {
+      pSink->log(message).ignoreErrors();
+    } else {
+      std::string thread;
+      core::util::lexical_cast(message.m_trace.m_threadId, thread)
+          .ignoreErrors();
+      core::logging::WriteLogLine(
+          stream,
+          core::logging::LoggingStdioSink::Options::FORMAT_VERBOSE,
+          message.m_logLevel,
+          message.m_trace,
+          thread,
+          "0s",
+          std::string(message.m_msg) + '\n');
+    }
+  }
+  pSink->flush().ignoreErrors();
+
+  const f64 seconds =
+      core::timer::TicksToTime(core::timer::GetTicks() - start);
+  benchmark::Report(name, MESSAGE_COUNT, pBuffer->count(), seconds);
+  pSink.reset();
+  delete pBuffer;
+}
+
+REGISTER_BENCHMARK(benchmarkLogRecord) {
+  RunRecord< false >("log record verbose text");
+  RunRecord< true >("log record binary");
+}
+
+/**
+ * Hand messages to a {@link LoggingFileSink}, which the logger thread pays
+ * for, then wait for them to reach the file. The backlog holds every message,
+ * so none are dropped.
+ */
+REGISTER_BENCHMARK(benchmarkLogFileSink) {
+  core::logging::LoggingFileSink::Options options;
+  options.m_path = "logging_file_sink_benchmark.log";
+  options.m_maxBacklog = 512 * 1024 * 1024;
+  options.m_maxFileSize = 0;
+  std::remove(options.m_path.c_str());
+  std::shared_ptr< core::logging::iLogSink > pSink =
+      std::make_shared< core::logging::LoggingFileSink >(
+          ~core::types::BitSet< LL >(), options);
+
+  core::logging::LogMessage message(LL::Trace, LOG_TRACE_INFO());
+  AppendToLog(message, "tick ");
+  AppendToLog(message, 12345);
+  AppendToLog(message, " took ");
+  AppendToLog(message, 0.25f);
+  AppendToLog(message, "ms");
+
+  const u64 start = core::timer::GetTicks();
+  for (u32 i = 0; i < MESSAGE_COUNT; ++i) {
+    pSink->log(message).ignoreErrors();
+  }
+  const u64 submitted = core::timer::GetTicks();
+  pSink->flush().ignoreErrors();
+  const u64 end = core::timer::GetTicks();
+
+  benchmark::Report(
+      "log file sink submit",
+      MESSAGE_COUNT,
+      0,
+      core::timer::TicksToTime(submitted - start));
+  benchmark::Report(
+      "log file sink written",
+      MESSAGE_COUNT,
+      0,
+      core::timer::TicksToTime(end - start));
+  pSink.reset();
+  std::remove(options.m_path.c_str());
+}
@@ -0,0 +1,257 @@
+#include <BENCHMARKS/benchmark.h>
+
+#include <CORE/ARCH/timer.h>
+#include <CORE/NET/net_client.h>
+#include <CORE/NET/net_loopback.h>
+#include <CORE/NET/net_server.h>
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using core::memory::ConstBlob;
+using core::net::ClientDef;
+using core::net::eConnectionMode;
+using core::net::iClientConnectionHandler;
+using core::net::iNetClient;
+using core::net::iNetServer;
+using core::net::iServerConnectionHandler;
+using core::net::ServerDef;
+using core::net::tConnectionId;
+
+/**
+ * How long each configuration runs for.
+ */
+static const f64 RUN_SECONDS = 1.0;
+
+/**
+ * How long without a reply before outstanding datagrams are counted as lost.
+ */
+static const f64 LOSS_TIMEOUT_SECONDS = 0.2;
+
+/**
+ * Port for the in-process transport, which does not share socket ports.
+ */
+static const int LOOPBACK_PORT = 27200;
+
+/**
+ * Sends everything straight back.
+ */
+class EchoHandler : public iServerConnectionHandler {
+  public:
+  virtual bool process(
+      iNetServer &server,
+      const tConnectionId connectionId,
+      const ConstBlob &data) {
+    server.send(connectionId, data).ignoreErrors();
+    return true;
+  }
+  virtual void open(const tConnectionId) {}
+  virtual void close(const tConnectionId) {}
+  virtual void cleanup() {}
+};
+
+/**
+ * Splits echoed data back into fixed size messages, and records the round
+ * trip of each from the send time stamped at its front.
+ */
+class RoundTripHandler : public iClientConnectionHandler {
+  public:
+  RoundTripHandler(const size_t messageSize)
+      : m_messageSize(messageSize), m_completed(0) {}
+
+  virtual void process(iNetClient &, const ConstBlob &data) {
+    m_pending.insert(m_pending.end(), data.data(), data.data() + data.size());
+    const u64 now = core::timer::GetTicks();
+    size_t offset = 0;
+    for (; offset + m_messageSize <= m_pending.size();
+         offset += m_messageSize) {
+      u64 sent;
+      memcpy(&sent, &m_pending[offset], sizeof(sent));
+      m_latencies.add(now - sent);
+      m_completed++;
+    }
+    m_pending.erase(m_pending.begin(), m_pending.begin() + offset);
+  }
+  virtual void cleanup() {}
+
+  size_t m_messageSize;
+  u64 m_completed;
+  std::vector< u8 > m_pending;
+  benchmark::LatencySamples m_latencies;
+};
+
+/**
+ * Drive {@code server} from its own thread, until {@code running} is cleared.
+ */
+static void ServeEcho(iNetServer &server, std::atomic_bool &running) {
+  EchoHandler handler;
+  while (running) {
+    server.update(handler).ignoreErrors();
+    // Let the client run, when both share a core.
+    std::this_thread::yield();
+  }
+}
+
+/**
+ * Keep up to {@code window} messages of {@code messageSize} bytes in flight
+ * between {@code client} and an echoing server, and report the results.
+ */
+static void RunRoundTrips(
+    const std::string &name,
+    iNetClient &client,
+    const size_t messageSize,
+    const size_t window) {
+  RoundTripHandler handler(messageSize);
+  std::vector< u8 > message(messageSize, 0xAB);
+  u64 sent = 0;
+  u64 lost = 0;
+
+  const u64 start = core::timer::GetTicks();
+  const u64 end = start + core::timer::TimeToTicks(RUN_SECONDS);
+  const u64 lossTimeout = core::timer::TimeToTicks(LOSS_TIMEOUT_SECONDS);
+  u64 lastProgress = start;
+  u64 lastCompleted = 0;
+  u64 now = start;
+  while (now < end && client.valid()) {
+    while (sent - handler.m_completed - lost < window) {
+      memcpy(&message[0], &now, sizeof(now));
+      if (!client.send(ConstBlob(message.data(), message.size()))) {
+        break;
+      }
+      sent++;
+    }
+    client.update(handler).ignoreErrors();
+    std::this_thread::yield();
+
+    now = core::timer::GetTicks();
+    if (handler.m_completed != lastCompleted) {
+      lastCompleted = handler.m_completed;
+      lastProgress = now;
+    } else if (now - lastProgress > lossTimeout) {
+      // Only datagrams go missing, give up on whatever is outstanding.
+      lost = sent - handler.m_completed;
+      lastProgress = now;
+    }
+  }
+
+  const f64 seconds = core::timer::TicksToTime(now - start);
+  benchmark::Report(
+      name,
+      handler.m_completed,
+      handler.m_completed * messageSize,
+      seconds,
+      &handler.m_latencies);
+  if (lost != 0) {
+    std::cout << "#   lost " << lost << " of " << sent << " messages"
+              << std::endl;
+  }
+}
+
+/**
+ * Run the ping-pong and pipelined configurations against {@code server},
+ * connecting a fresh {@code tClient} for each.
+ */
+template < typename tClient >
+static void BenchmarkTransport(
+    const std::string &name,
+    iNetServer &server,
+    const ServerDef &serverDef,
+    const eConnectionMode::type mode,
+    const std::string &host,
+    int (*getPort)(iNetServer &)) {
+  core::net::Initialize();
+  if (!server.start(serverDef)) {
+    std::cout << "# " << name << ": failed to start server" << std::endl;
+    return;
+  }
+
+  std::atomic_bool running(true);
+  std::thread serverThread(ServeEcho, std::ref(server), std::ref(running));
+
+  struct Config {
+    const char *m_name;
+    size_t m_messageSize;
+    size_t m_window;
+  };
+  static const Config configs[] = {
+      {"pingpong 64B", 64, 1},
+      {"pipelined 1KB x32", 1024, 32},
+  };
+  for (size_t i = 0; i < sizeof(configs) / sizeof(configs[0]); ++i) {
+    tClient client(mode);
+    if (!client.start(ClientDef(host, getPort(server), 60))) {
+      std::cout << "# " << name << ": failed to connect" << std::endl;
+      continue;
+    }
+    RunRoundTrips(
+        name + " " + configs[i].m_name,
+        client,
+        configs[i].m_messageSize,
+        configs[i].m_window);
+    client.stop();
+  }
+
+  running = false;
+  serverThread.join();
+  server.stop();
+}
+
+/**
+ * {@link LoopbackNetClient} has no mode, adapt it to the socket client's
+ * constructor.
+ */
+class ModalLoopbackClient : public core::net::LoopbackNetClient {
+  public:
+  ModalLoopbackClient(eConnectionMode::type) {}
+};
+
+/**
+ *
+ */
+static int GetSocketPort(iNetServer &server) {
+  return ((core::net::NetServer &) server).getPort();
+}
+
+/**
+ *
+ */
+static int GetLoopbackPort(iNetServer &) {
+  return LOOPBACK_PORT;
+}
+
+REGISTER_BENCHMARK(benchmarkNetTcpAsync) {
+  core::net::NetServer server(eConnectionMode::TCP_ASYNC);
+  BenchmarkTransport< core::net::NetClient >(
+      "tcp_async",
+      server,
+      ServerDef(0, 4, 60, core::net::eEventBackend::EPOLL),
+      eConnectionMode::TCP_ASYNC,
+      "127.0.0.1",
+      GetSocketPort);
+}
+
+REGISTER_BENCHMARK(benchmarkNetUdpAsync) {
+  core::net::NetServer server(eConnectionMode::UDP_ASYNC);
+  BenchmarkTransport< core::net::NetClient >(
+      "udp_async",
+      server,
+      ServerDef(0, 4, 60, core::net::eEventBackend::EPOLL),
+      eConnectionMode::UDP_ASYNC,
+      "127.0.0.1",
+      GetSocketPort);
+}
+
+REGISTER_BENCHMARK(benchmarkNetLoopback) {
+  core::net::LoopbackNetServer server;
+  BenchmarkTransport< ModalLoopbackClient >(
+      "loopback",
+      server,
+      ServerDef(LOOPBACK_PORT, 4, 60),
+      eConnectionMode::TCP_ASYNC,
+      "",
+      GetLoopbackPort);
+}
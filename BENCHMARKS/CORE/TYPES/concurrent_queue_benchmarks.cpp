@@ -0,0 +1,130 @@
+#include <BENCHMARKS/benchmark.h>
+
+#include <CORE/ARCH/timer.h>
+#include <CORE/TYPES/bounded_ring_queue.h>
+#include <CORE/TYPES/concurrent_queue.h>
+#include <CORE/TYPES/spsc_queue.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+using core::types::BoundedRingQueue;
+using core::types::ConcurrentQueue;
+using core::types::SpscQueue;
+
+/**
+ * Items moved through the queue by each configuration.
+ */
+static const u64 ITEM_COUNT = 1000000;
+
+/**
+ * Capacity of the bounded queues.
+ */
+static const size_t QUEUE_CAPACITY = 1024;
+
+/**
+ * {@link ConcurrentQueue} behind the {@link BoundedRingQueue} interface.
+ */
+class LockedQueue {
+  public:
+  LockedQueue(const size_t capacity) : m_queue(capacity) {}
+
+  Status push(const u64 &val) {
+    m_queue.push(val);
+    return Status::ok();
+  }
+  Status pop(u64 &out) { return m_queue.pop(out); }
+
+  private:
+  ConcurrentQueue< u64 > m_queue;
+};
+
+/**
+ * Move {@link ITEM_COUNT} items from {@code producers} threads to
+ * {@code consumers} threads, and report the throughput.
+ */
+template < typename tQueue >
+static void
+RunQueue(const std::string &name, const u32 producers, const u32 consumers) {
+  tQueue queue(QUEUE_CAPACITY);
+  const u64 start = core::timer::GetTicks();
+
+  std::vector< std::thread > threads;
+  for (u32 i = 0; i < producers; ++i) {
+    const u64 count =
+        ITEM_COUNT / producers + (i < ITEM_COUNT % producers ? 1 : 0);
+    threads.push_back(std::thread([&queue, count]() {
+      for (u64 n = 0; n < count; ++n) {
+        queue.push(n).ignoreErrors();
+      }
+    }));
+  }
+  for (u32 i = 0; i < consumers; ++i) {
+    const u64 count =
+        ITEM_COUNT / consumers + (i < ITEM_COUNT % consumers ? 1 : 0);
+    threads.push_back(std::thread([&queue, count]() {
+      u64 val;
+      for (u64 n = 0; n < count; ++n) {
+        queue.pop(val).ignoreErrors();
+      }
+    }));
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  const f64 seconds =
+      core::timer::TicksToTime(core::timer::GetTicks() - start);
+  benchmark::Report(name, ITEM_COUNT, ITEM_COUNT * sizeof(u64), seconds);
+}
+
+REGISTER_BENCHMARK(benchmarkConcurrentQueue) {
+  RunQueue< LockedQueue >("concurrent_queue 1:1", 1, 1);
+  RunQueue< LockedQueue >("concurrent_queue 4:4", 4, 4);
+}
+
+REGISTER_BENCHMARK(benchmarkBoundedRingQueue) {
+  RunQueue< BoundedRingQueue< u64 > >("bounded_ring_queue 1:1", 1, 1);
+  RunQueue< BoundedRingQueue< u64 > >("bounded_ring_queue 4:4", 4, 4);
+}
+
+/**
+ * Move {@link ITEM_COUNT} items through a {@link SpscQueue}, {@code batch}
+ * at a time, and report the throughput.
+ */
+static void RunSpsc(const std::string &name, const size_t batch) {
+  SpscQueue< u64 > queue(QUEUE_CAPACITY);
+  const u64 start = core::timer::GetTicks();
+
+  std::thread producer([&queue, batch]() {
+    std::vector< u64 > items(batch);
+    for (u64 n = 0; n < ITEM_COUNT;) {
+      const size_t count = (size_t) std::min((u64) batch, ITEM_COUNT - n);
+      const size_t pushed = queue.pushN(items.data(), count);
+      n += pushed;
+      if (pushed == 0) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  std::vector< u64 > items(batch);
+  for (u64 n = 0; n < ITEM_COUNT;) {
+    const size_t popped = queue.popN(items.data(), batch);
+    n += popped;
+    if (popped == 0) {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+
+  const f64 seconds =
+      core::timer::TicksToTime(core::timer::GetTicks() - start);
+  benchmark::Report(name, ITEM_COUNT, ITEM_COUNT * sizeof(u64), seconds);
+}
+
+REGISTER_BENCHMARK(benchmarkSpscQueue) {
+  RunSpsc("spsc_queue 1:1", 1);
+  RunSpsc("spsc_queue 1:1 batch 64", 64);
+}
@@ -0,0 +1,129 @@
+#include <BENCHMARKS/benchmark.h>
+
+#include <CORE/ARCH/timer.h>
+#include <CORE/TYPES/concurrent_queue.h>
+#include <CORE/UTIL/task_scheduler.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using core::types::ConcurrentQueue;
+using core::util::ParallelFor;
+using core::util::TaskGroup;
+using core::util::TaskScheduler;
+using core::util::tTask;
+
+/**
+ * Number of small tasks run by each configuration.
+ */
+static const u64 TASK_COUNT = 200000;
+
+/**
+ * Work done by each small task.
+ */
+static const u32 TASK_WORK = 200;
+
+/**
+ * Worker threads in both pools.
+ */
+static const u32 WORKER_COUNT = 4;
+
+/**
+ * A little arithmetic. Tasks add the result to an atomic, so the optimizer
+ * can not remove it.
+ */
+static u64 Work(const u64 seed) {
+  u64 ret = seed;
+  for (u32 i = 0; i < TASK_WORK; ++i) {
+    ret = ret * 6364136223846793005ull + 1442695040888963407ull;
+  }
+  return ret;
+}
+
+/**
+ * Thread pool fed from a single {@link ConcurrentQueue}, as a baseline.
+ */
+class NaivePool {
+  public:
+  NaivePool(const u32 workerCount) : m_pending(0) {
+    for (u32 i = 0; i < workerCount; ++i) {
+      m_threads.push_back(std::thread([this]() {
+        tTask task;
+        while (m_tasks.pop(task)) {
+          task();
+          m_pending--;
+        }
+      }));
+    }
+  }
+
+  ~NaivePool() {
+    m_tasks.close();
+    for (size_t i = 0; i < m_threads.size(); ++i) {
+      m_threads[i].join();
+    }
+  }
+
+  void run(tTask &&task) {
+    m_pending++;
+    m_tasks.push(std::move(task));
+  }
+
+  void wait() {
+    while (m_pending.load() != 0) {
+      std::this_thread::yield();
+    }
+  }
+
+  private:
+  ConcurrentQueue< tTask > m_tasks;
+  std::vector< std::thread > m_threads;
+  std::atomic< u64 > m_pending;
+};
+
+/**
+ * Report {@link TASK_COUNT} tasks run since {@code start}.
+ */
+static void ReportTasks(const std::string &name, const u64 start) {
+  const f64 seconds =
+      core::timer::TicksToTime(core::timer::GetTicks() - start);
+  benchmark::Report(name, TASK_COUNT, 0, seconds);
+}
+
+REGISTER_BENCHMARK(benchmarkNaivePool) {
+  std::atomic< u64 > sink(0);
+  NaivePool pool(WORKER_COUNT);
+  const u64 start = core::timer::GetTicks();
+  for (u64 i = 0; i < TASK_COUNT; ++i) {
+    pool.run([&sink, i]() { sink += Work(i); });
+  }
+  pool.wait();
+  ReportTasks("naive_pool flat", start);
+}
+
+REGISTER_BENCHMARK(benchmarkTaskScheduler) {
+  std::atomic< u64 > sink(0);
+  TaskScheduler scheduler(WORKER_COUNT);
+
+  // Every task queued from outside, through the injection queue.
+  u64 start = core::timer::GetTicks();
+  {
+    TaskGroup group(scheduler);
+    for (u64 i = 0; i < TASK_COUNT; ++i) {
+      group.run([&sink, i]() { sink += Work(i); });
+    }
+    group.wait();
+  }
+  ReportTasks("task_scheduler flat", start);
+
+  // Tasks split recursively on the workers, mostly through their own deques.
+  start = core::timer::GetTicks();
+  ParallelFor(scheduler, 0, TASK_COUNT, 1, [&sink](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      sink += Work(i);
+    }
+  });
+  ReportTasks("task_scheduler parallel_for", start);
+}
@@ -0,0 +1,102 @@
+#include "benchmark.h"
+
+#include <CORE/ARCH/timer.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+namespace benchmark {
+
+/**
+ * Container for a benchmark and info about which file it came from
+ */
+struct BenchmarkInfo {
+  BenchmarkInfo(const char *file, const char *name, tBenchmarkFunc func)
+      : m_file(file), m_name(name), m_func(func) {}
+
+  std::string m_file;
+  std::string m_name;
+  tBenchmarkFunc m_func;
+};
+
+/**
+ * Global Benchmark Registry
+ */
+static std::vector< BenchmarkInfo > &getBenchmarkRegistry() {
+  static std::vector< BenchmarkInfo > registry;
+  return registry;
+}
+
+/**
+ * Register a function as a named benchmark
+ */
+void registerBenchmark(
+    const char *file, const char *name, tBenchmarkFunc func) {
+  getBenchmarkRegistry().push_back(BenchmarkInfo(file, name, func));
+}
+
+/**
+ * Run all registered benchmarks matching the filter.
+ */
+int runRegisteredBenchmarks(const std::string &filter) {
+  int count = 0;
+  const std::vector< BenchmarkInfo > &registry = getBenchmarkRegistry();
+  for (std::vector< BenchmarkInfo >::const_iterator itr = registry.begin();
+       itr != registry.end();
+       ++itr) {
+    if (itr->m_name.find(filter) == std::string::npos) {
+      continue;
+    }
+    std::cout << "# " << itr->m_name << std::endl;
+    itr->m_func();
+    count++;
+  }
+  return count;
+}
+
+/**
+ *
+ */
+f64 LatencySamples::percentile(const f64 fraction) {
+  if (m_samples.empty()) {
+    return 0.0;
+  }
+  const size_t index = std::min(
+      m_samples.size() - 1, (size_t) (fraction * (f64) m_samples.size()));
+  std::nth_element(
+      m_samples.begin(), m_samples.begin() + index, m_samples.end());
+  return core::timer::TicksToTime(m_samples[index]);
+}
+
+/**
+ *
+ */
+void Report(
+    const std::string &name,
+    const u64 operations,
+    const u64 bytes,
+    const f64 seconds,
+    LatencySamples *pLatencies) {
+  char line[256];
+  snprintf(
+      line,
+      sizeof(line),
+      "%-40s %12.0f ops/s %10.2f MB/s",
+      name.c_str(),
+      (f64) operations / seconds,
+      (f64) bytes / seconds / (1024.0 * 1024.0));
+  std::cout << line;
+  if (pLatencies != nullptr && pLatencies->size() != 0) {
+    snprintf(
+        line,
+        sizeof(line),
+        "   p50 %8.1f us   p99 %8.1f us",
+        pLatencies->percentile(0.5) * 1000000.0,
+        pLatencies->percentile(0.99) * 1000000.0);
+    std::cout << line;
+  }
+  std::cout << std::endl;
+}
+
+} // namespace benchmark
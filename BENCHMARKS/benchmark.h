@@ -0,0 +1,100 @@
+/**
+ * Core classes for registering and reporting benchmarks.
+ */
+#ifndef FISHY_BENCHMARK_H
+#define FISHY_BENCHMARK_H
+
+#ifndef BENCHMARKING
+#  error may only be included in benchmarks
+#endif
+
+#include <CORE/types.h>
+
+#include <string>
+#include <vector>
+
+namespace benchmark {
+
+/**
+ * Delegate function to be run as a benchmark
+ */
+typedef void (*tBenchmarkFunc)(void);
+
+/**
+ * Register a function to be run in the benchmark suite
+ */
+void registerBenchmark(const char *file, const char *name, tBenchmarkFunc func);
+
+/**
+ * Helper utility to register a benchmark.
+ */
+class StaticRegister {
+  public:
+  StaticRegister(const char *file, const char *name, tBenchmarkFunc func) {
+    registerBenchmark(file, name, func);
+  }
+};
+
+/**
+ * Run all registered benchmarks whose name contains {@code filter}.
+ *
+ * @return the number of benchmarks run
+ */
+int runRegisteredBenchmarks(const std::string &filter);
+
+/**
+ * Collects per operation latencies, for percentile reporting.
+ */
+class LatencySamples {
+  public:
+  /**
+   * Record one operation taking {@code ticks} timer ticks.
+   */
+  void add(const u64 ticks) { m_samples.push_back(ticks); }
+
+  /**
+   * @param fraction the percentile, between 0 and 1
+   * @return latency in seconds below which {@code fraction} of samples fall
+   */
+  f64 percentile(const f64 fraction);
+
+  /**
+   * @return the number of samples recorded
+   */
+  size_t size() const { return m_samples.size(); }
+
+  private:
+  std::vector< u64 > m_samples;
+};
+
+/**
+ * Print one line of results.
+ *
+ * @param name what was measured
+ * @param operations number of operations completed
+ * @param bytes number of payload bytes moved
+ * @param seconds wall time taken
+ * @param pLatencies optional per operation latencies
+ */
+void Report(
+    const std::string &name,
+    const u64 operations,
+    const u64 bytes,
+    const f64 seconds,
+    LatencySamples *pLatencies = nullptr);
+
+} // namespace benchmark
+
+#  ifndef UNIQUE_MACRO_NAME
+#    define UNIQUE_MACRO_NAME MAKE_NAME(__LINE__, __COUNTER__)
+#    define MAKE_NAME(line, counter) MAKE_NAME2(line, counter)
+#    define MAKE_NAME2(line, counter) cta_failurecond_##line##counter
+#  endif
+
+#  define REGISTER_BENCHMARK(f_benchmark_name)          \
+    void f_benchmark_name(void);                        \
+    static benchmark::StaticRegister UNIQUE_MACRO_NAME( \
+        __FILE__, #f_benchmark_name, f_benchmark_name); \
+    void f_benchmark_name(void)
+
+#endif
@@ -0,0 +1,30 @@
+/**
+ * Benchmark harness
+ *
+ * Usage: benchmarks [filter]
+ * Runs every registered benchmark, or only those whose name contains filter.
+ */
+#include <iostream>
+
+#include ".generated/version.h"
+
+#include "benchmark.h"
+
+#include <CORE/BASE/logging.h>
+
+int main(int argc, char **argv) {
+  // Only surface problems, benchmarks report on stdout.
+  core::types::BitSet< LL > levels;
+  levels.set(LL::Error);
+  core::logging::RegisterSink(
+      std::make_shared< core::logging::iLogSink >(levels))
+      .ignoreErrors();
+
+  std::cout << "# Benchmarks for build: " << BUILD_BRANCH_ID << "@"
+            << BUILD_VERSION_HASH << " built on " << BUILD_TIMESTAMP
+            << std::endl;
+  const int count =
+      benchmark::runRegisteredBenchmarks((argc > 1) ? argv[1] : "");
+  std::cout << "# Done. Ran " << count << " benchmarks." << std::endl;
+  return 0;
+}
@@ -0,0 +1,174 @@
+/**
+ * Typed atomics, fences and spin loop primitives.
+ */
+#ifndef FISHY_ATOMICS_H
+#define FISHY_ATOMICS_H
+
+#include <CORE/types.h>
+
+#include <atomic>
+
+namespace core {
+namespace arch {
+
+/**
+ * Size in bytes of a cache line, for keeping data written by different
+ * threads apart.
+ */
+static const size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * Atomic value, where every operation names its memory order. Unlike
+ * std::atomic there is no sequentially consistent default, so the cost of
+ * each operation is visible at the call site.
+ *
+ * Construction is constexpr, so atomics with static storage are ready before
+ * any static initializer runs.
+ */
+template < typename tType >
+class Atomic {
+  public:
+  constexpr Atomic();
+  explicit constexpr Atomic(const tType value);
+
+  tType load(const std::memory_order order) const;
+  void store(const tType value, const std::memory_order order);
+  tType exchange(const tType value, const std::memory_order order);
+
+  /**
+   * @return true if the value was {@code expected}, and is now
+   *     {@code desired}. Otherwise {@code expected} is set to the value.
+   */
+  bool compareExchange(
+      tType &expected,
+      const tType desired,
+      const std::memory_order success,
+      const std::memory_order failure);
+
+  /**
+   * May fail spuriously, for use in retry loops.
+   * @see compareExchange
+   */
+  bool compareExchangeWeak(
+      tType &expected,
+      const tType desired,
+      const std::memory_order success,
+      const std::memory_order failure);
+
+  /**
+   * @return the value before adding
+   */
+  tType fetchAdd(const tType amount, const std::memory_order order);
+
+  /**
+   * @return the value before subtracting
+   */
+  tType fetchSub(const tType amount, const std::memory_order order);
+
+  private:
+  std::atomic< tType > m_value;
+};
+
+/**
+ * Counter shared by threads, which orders nothing but itself.
+ */
+template < typename tType >
+class RelaxedCounter {
+  public:
+  constexpr RelaxedCounter() : m_value(0) {}
+
+  void add(const tType amount) {
+    m_value.fetchAdd(amount, std::memory_order_relaxed);
+  }
+  void sub(const tType amount) {
+    m_value.fetchSub(amount, std::memory_order_relaxed);
+  }
+  void set(const tType value) {
+    m_value.store(value, std::memory_order_relaxed);
+  }
+  tType get() const { return m_value.load(std::memory_order_relaxed); }
+
+  private:
+  Atomic< tType > m_value;
+};
+
+/**
+ * Counter only written by one thread, but read by any. Updates are a plain
+ * load and store, without a locked instruction.
+ */
+template < typename tType >
+class OwnedCounter {
+  public:
+  constexpr OwnedCounter() : m_value(0) {}
+
+  void add(const tType amount) {
+    m_value.store(
+        m_value.load(std::memory_order_relaxed) + amount,
+        std::memory_order_relaxed);
+  }
+  tType get() const { return m_value.load(std::memory_order_relaxed); }
+
+  private:
+  Atomic< tType > m_value;
+};
+
+/**
+ * Holds a value on cache lines of its own, so writes to it do not slow down
+ * threads using neighbouring data.
+ */
+template < typename tType >
+struct CacheAligned {
+  alignas(CACHE_LINE_SIZE) tType m_value;
+};
+
+/**
+ * Hint to the processor that the thread is spinning.
+ */
+void CpuPause();
+
+/**
+ * Order memory operations of this thread against other threads.
+ */
+void ThreadFence(const std::memory_order order);
+
+/**
+ * Stop the compiler, but not the processor, reordering memory operations
+ * across this point.
+ */
+void CompilerFence();
+
+/**
+ * Exponential backoff for spin loops. Pauses for twice as long on each call,
+ * and then yields the thread, so waiting on another thread also works when
+ * it shares the core.
+ */
+class Backoff {
+  public:
+  Backoff() : m_step(0) {}
+
+  /**
+   * Wait a little longer than last time.
+   */
+  void pause();
+
+  /**
+   * @return if pausing has given way to yielding, for callers that would
+   *     rather block from then on
+   */
+  bool yielding() const;
+
+  /**
+   * Start again from the shortest pause, after making progress.
+   */
+  void reset() { m_step = 0; }
+
+  private:
+  u32 m_step;
+};
+
+} // namespace arch
+} // namespace core
+
+#  include "atomics.inl"
+
+#endif
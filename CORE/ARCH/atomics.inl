@@ -0,0 +1,144 @@
+#ifndef FISHY_ATOMICS_INL
+#define FISHY_ATOMICS_INL
+
+#include <CORE/ARCH/intrinsics.h>
+
+#include <thread>
+
+namespace core {
+namespace arch {
+
+/**
+ * Spins of {@link Backoff}, doubling each step, before it yields instead.
+ */
+static const u32 BACKOFF_PAUSE_STEPS = 6;
+
+/**
+ *
+ */
+template < typename tType >
+inline constexpr Atomic< tType >::Atomic() : m_value(tType()) {
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline constexpr Atomic< tType >::Atomic(const tType value)
+    : m_value(value) {
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline tType Atomic< tType >::load(const std::memory_order order) const {
+  return m_value.load(order);
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline void
+Atomic< tType >::store(const tType value, const std::memory_order order) {
+  m_value.store(value, order);
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline tType
+Atomic< tType >::exchange(const tType value, const std::memory_order order) {
+  return m_value.exchange(value, order);
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline bool Atomic< tType >::compareExchange(
+    tType &expected,
+    const tType desired,
+    const std::memory_order success,
+    const std::memory_order failure) {
+  return m_value.compare_exchange_strong(expected, desired, success, failure);
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline bool Atomic< tType >::compareExchangeWeak(
+    tType &expected,
+    const tType desired,
+    const std::memory_order success,
+    const std::memory_order failure) {
+  return m_value.compare_exchange_weak(expected, desired, success, failure);
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline tType
+Atomic< tType >::fetchAdd(const tType amount, const std::memory_order order) {
+  return m_value.fetch_add(amount, order);
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline tType
+Atomic< tType >::fetchSub(const tType amount, const std::memory_order order) {
+  return m_value.fetch_sub(amount, order);
+}
+
+/**
+ *
+ */
+inline void CpuPause() {
+  CPU_PAUSE();
+}
+
+/**
+ *
+ */
+inline void ThreadFence(const std::memory_order order) {
+  std::atomic_thread_fence(order);
+}
+
+/**
+ *
+ */
+inline void CompilerFence() {
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+/**
+ *
+ */
+inline void Backoff::pause() {
+  if (m_step < BACKOFF_PAUSE_STEPS) {
+    for (u32 i = 0; i < (1u << m_step); ++i) {
+      CpuPause();
+    }
+    m_step++;
+  } else {
+    std::this_thread::yield();
+  }
+}
+
+/**
+ *
+ */
+inline bool Backoff::yielding() const {
+  return m_step >= BACKOFF_PAUSE_STEPS;
+}
+
+} // namespace arch
+} // namespace core
+
+#endif
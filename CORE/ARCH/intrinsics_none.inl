@@ -16,4 +16,7 @@ ALIGN_STRUCT_BEGIN(16) struct INTRINSIC_VECI_128 {
 typedef INTRINSIC_VECF_128 VECF_128;
 typedef INTRINSIC_VECI_128 VECI_128;
 
+// Spin loops, atomics themselves are in atomics.h
+#define CPU_PAUSE()
+
 #endif
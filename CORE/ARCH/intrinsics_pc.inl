@@ -52,21 +52,7 @@ typedef __m128i VECI_128;
 #  define VECF_128_SHUFFLE(s1, s2, mask) _mm_shuffle_ps(s1, s2, mask)
 #  define VECF_128_SHUFFLEM(s1x, s1y, s2z, s2w) _MM_SHUFFLE(s1x, s1y, s2z, s2w)
 
-// Atomics
-#  if defined(PLAT_WIN32)
-#    define ATOMIC_COMPARE_EXCHANGE_32(p, oldValue, newValue) \
-      InterlockedCompareExchange(p, newValue, oldValue)
-#    define ATOMIC_COMPARE_EXCHANGE_64(p, oldValue, newValue) \
-      InterlockedCompareExchange64(p, newValue, oldValue)
-#    define ATOMIC_INCREMENT(v) InterlockedIncrement(v)
-#    define ATOMIC_DECREMENT(v) InterlockedDecrement(v)
-#  elif defined(PLAT_LINUX)
-#    define ATOMIC_COMPARE_EXCHANGE_32(p, oldValue, newValue) \
-      __sync_val_compare_and_swap(p, oldValue, newValue)
-#    define ATOMIC_COMPARE_EXCHANGE_64(p, oldValue, newValue) \
-      __sync_val_compare_and_swap(p, oldValue, newValue)
-#    define ATOMIC_INCREMENT(v) __sync_fetch_and_add(v, 1)
-#    define ATOMIC_DECREMENT(v) __sync_fetch_and_sub(v, 1)
-#  endif
+// Spin loops, atomics themselves are in atomics.h
+#  define CPU_PAUSE() _mm_pause()
 
 #endif
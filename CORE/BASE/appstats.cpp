@@ -1,18 +1,57 @@
 #include "appstats.h"
 
-#include <CORE/ARCH/intrinsics.h>
+#include <CORE/ARCH/atomics.h>
+#include <CORE/ARCH/timer.h>
+#include <CORE/BASE/checks.h>
 #include <CORE/UTIL/stringutil.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <mutex>
+#include <unordered_map>
 
+using core::arch::CACHE_LINE_SIZE;
+using core::arch::OwnedCounter;
+using core::arch::RelaxedCounter;
 using core::util::IdentifierSafe;
 
 namespace core {
 
 static const u32 MAX_STATS = 1024;
+static const u32 MAX_SHARDED_STATS = 128;
 static const u32 MAX_INFO = 128;
+static const u32 NO_SHARD = ~0u;
+
+/**
+ * A registered stat, on its own cache line so counters bumped by different
+ * threads do not contend.
+ */
+struct StatSlot {
+  alignas(CACHE_LINE_SIZE) RelaxedCounter< u64 > m_value;
+  const char *m_pName = NULL;
+  u32 m_shard = NO_SHARD;
+};
+
+/**
+ * Counters of sharded stats, owned by one thread. They are never freed, so
+ * counts of exited threads remain, and readers walk the list without locks.
+ */
+struct StatShard {
+  StatShard() : m_pNext(NULL) {}
+
+  OwnedCounter< u64 > m_values[MAX_SHARDED_STATS];
+  StatShard *m_pNext;
+};
+
+static StatSlot s_stats[MAX_STATS];
+
+// Slots below the count are fully registered, and never change.
+static std::atomic< u32 > s_statCount(0);
+static u32 s_shardCount = 0;
+
+static std::atomic< StatShard * > s_pAllShards(NULL);
+static thread_local StatShard *s_pThreadShard = NULL;
 
 /**
  *
@@ -23,11 +62,11 @@ static std::mutex &GetGlobalMutex() {
 }
 
 /**
- *
+ * Index of each registered stat by name.
  */
-static tAppStatList &GetGlobalStats() {
-  static tAppStatList s_list = tAppStatList(MAX_STATS);
-  return s_list;
+static std::unordered_map< std::string, u32 > &GetStatIndex() {
+  static std::unordered_map< std::string, u32 > s_index;
+  return s_index;
 }
 
 /**
@@ -39,24 +78,42 @@ static tAppInfoList &GetGlobalInfo() {
 }
 
 /**
- * Helper lambda to match AppStat
+ * @return the calling thread's counters for sharded stats
  */
-class StatFinder : public std::unary_function< const tAppStat &, bool > {
-  public:
-  StatFinder(const char *pName) : m_pName(pName) {}
-  bool operator()(const core::tAppStat &stat) {
-    if (stat.first == m_pName) {
-      return true;
-    }
-    if (stat.first == nullptr || m_pName == nullptr) {
-      return false;
-    }
-    return strcmp(stat.first, m_pName) == 0;
+static StatShard &GetThreadShard() {
+  if (s_pThreadShard == NULL) {
+    StatShard *pShard = new StatShard();
+    StatShard *pHead = s_pAllShards.load();
+    do {
+      pShard->m_pNext = pHead;
+    } while (!s_pAllShards.compare_exchange_weak(pHead, pShard));
+    s_pThreadShard = pShard;
   }
+  return *s_pThreadShard;
+}
 
-  private:
-  const char *m_pName;
-};
+/**
+ * @return the sum of every thread's counter of a sharded stat
+ */
+static u64 SumShards(const u32 shard) {
+  u64 ret = 0;
+  for (StatShard *pShard = s_pAllShards.load(); pShard != NULL;
+       pShard = pShard->m_pNext) {
+    ret += pShard->m_values[shard].get();
+  }
+  return ret;
+}
+
+/**
+ * @return the current value of a registered stat
+ */
+static u64 ReadStat(const StatSlot &slot) {
+  u64 ret = slot.m_value.get();
+  if (slot.m_shard != NO_SHARD) {
+    ret += SumShards(slot.m_shard);
+  }
+  return ret;
+}
 
 /**
  * Helper lambda to match AppInfo.
@@ -88,26 +145,32 @@ bool operator==(const core::tAppInfo &info, const char *pName) {
 /**
  *
  */
-AppStat::AppStat() : m_pCounter(nullptr) {
+AppStat::AppStat() : m_index(MAX_STATS), m_shard(NO_SHARD) {
 }
 
 /**
- *
+ * Lookups only happen on construction, the counter is then used directly.
  */
-AppStat::AppStat(const char *pName) {
+AppStat::AppStat(const char *pName, const eAppStatMode::type mode) {
   ASSERT(IdentifierSafe(pName) == pName);
-  std::mutex &m = GetGlobalMutex();
-  std::unique_lock< std::mutex > lock(m);
+  std::unique_lock< std::mutex > lock(GetGlobalMutex());
 
-  tAppStatList &stats = GetGlobalStats();
-  tAppStatList::iterator itr =
-      std::find_if(stats.begin(), stats.end(), StatFinder(pName));
-  if (itr == stats.end()) {
-    itr = std::find_if(stats.begin(), stats.end(), StatFinder(nullptr));
-    ASSERT(itr != stats.end());
-    itr->first = pName;
+  std::unordered_map< std::string, u32 > &index = GetStatIndex();
+  std::unordered_map< std::string, u32 >::iterator itr = index.find(pName);
+  if (itr == index.end()) {
+    const u32 statIndex = s_statCount.load(std::memory_order_relaxed);
+    CHECK_M(statIndex < MAX_STATS, "Too many AppStats");
+    StatSlot &slot = s_stats[statIndex];
+    slot.m_pName = pName;
+    slot.m_shard = NO_SHARD;
+    if (mode == eAppStatMode::SHARDED && s_shardCount < MAX_SHARDED_STATS) {
+      slot.m_shard = s_shardCount++;
+    }
+    s_statCount.store(statIndex + 1, std::memory_order_release);
+    itr = index.insert(std::make_pair(std::string(pName), statIndex)).first;
   }
-  m_pCounter = &itr->second;
+  m_index = itr->second;
+  m_shard = s_stats[m_index].m_shard;
 }
 
 /**
@@ -156,37 +219,100 @@ void AppInfo::init(const char *pName, const char *pValue) {
  *
  */
 void AppStat::increment() {
-  ATOMIC_INCREMENT(m_pCounter);
+  increment(1);
+}
+
+/**
+ * Sharded counters are only written by their thread, so need no locked
+ * instruction.
+ */
+void AppStat::increment(const u64 amount) {
+  ASSERT(m_index < MAX_STATS);
+  if (m_shard != NO_SHARD) {
+    GetThreadShard().m_values[m_shard].add(amount);
+  } else {
+    s_stats[m_index].m_value.add(amount);
+  }
+}
+
+/**
+ * Adding the two's complement wraps a shard below zero, which the sum undoes.
+ */
+void AppStat::decrement() {
+  increment(~0ull);
+}
+
+/**
+ * Sharded stats offset the base value by the current sum of the shards, as
+ * the shards belong to other threads.
+ */
+void AppStat::reset() {
+  ASSERT(m_index < MAX_STATS);
+  StatSlot &slot = s_stats[m_index];
+  if (m_shard != NO_SHARD) {
+    slot.m_value.set(0 - SumShards(m_shard));
+  } else {
+    slot.m_value.set(0);
+  }
 }
 
 /**
  *
  */
-void AppStat::increment(const u32 amount) {
-  u32 oldValue;
-  u32 newValue;
-  do {
-    oldValue = *m_pCounter;
-    newValue = oldValue + amount;
-  } while (ATOMIC_COMPARE_EXCHANGE_32(m_pCounter, oldValue, newValue)
-           != oldValue);
+u64 AppStat::get() const {
+  ASSERT(m_index < MAX_STATS);
+  return ReadStat(s_stats[m_index]);
 }
 
 /**
  *
  */
-void AppStat::reset() {
-  u32 oldValue;
-  do {
-    oldValue = *m_pCounter;
-  } while (ATOMIC_COMPARE_EXCHANGE_32(m_pCounter, oldValue, 0u) != oldValue);
+AppStatSnapshot::AppStatSnapshot() : m_ticks(0) {
 }
 
 /**
  *
  */
-u32 AppStat::get() const {
-  return *m_pCounter;
+AppStatSnapshot AppStatSnapshot::capture() {
+  AppStatSnapshot ret;
+  ret.m_ticks = core::timer::GetTicks();
+  const u32 count = s_statCount.load(std::memory_order_acquire);
+  ret.m_values.resize(count);
+  for (u32 i = 0; i < count; ++i) {
+    ret.m_values[i] = ReadStat(s_stats[i]);
+  }
+  return ret;
+}
+
+/**
+ *
+ */
+tAppStatList AppStatSnapshot::values() const {
+  tAppStatList ret;
+  ret.reserve(m_values.size());
+  for (size_t i = 0; i < m_values.size(); ++i) {
+    ret.push_back(tAppStat(s_stats[i].m_pName, m_values[i]));
+  }
+  return ret;
+}
+
+/**
+ *
+ */
+tAppStatList AppStatSnapshot::delta(const AppStatSnapshot &earlier) const {
+  tAppStatList ret = values();
+  const size_t count = std::min(earlier.m_values.size(), ret.size());
+  for (size_t i = 0; i < count; ++i) {
+    ret[i].second -= earlier.m_values[i];
+  }
+  return ret;
+}
+
+/**
+ *
+ */
+f64 AppStatSnapshot::secondsSince(const AppStatSnapshot &earlier) const {
+  return core::timer::TicksToTime(m_ticks - earlier.m_ticks);
 }
 
 /**
@@ -220,11 +346,7 @@ std::string AppInfo::get() const {
  *
  */
 tAppStatList GetAllAppStats() {
-  std::mutex &m = GetGlobalMutex();
-  m.lock();
-  tAppStatList copy = GetGlobalStats();
-  m.unlock();
-  return copy;
+  return AppStatSnapshot::capture().values();
 }
 
 /**
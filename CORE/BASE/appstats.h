@@ -11,6 +11,21 @@
 
 namespace core {
 
+/**
+ * How an {@link AppStat} counter is stored.
+ */
+struct eAppStatMode {
+  enum type {
+    // One counter on its own cache line, updated atomically.
+    SHARED,
+
+    // A counter per thread, summed on read. For stats bumped from many
+    // threads at once, at the cost of slower reads and resets.
+    SHARDED,
+    COUNT
+  };
+};
+
 /**
  * AppStat represents a reference to a globally unique named counter.
  */
@@ -19,11 +34,16 @@ class AppStat {
   AppStat();
 
   /**
-   * Create an AppStat referencing the given statistic name.
+   * Create an AppStat referencing the given statistic name. The name is kept,
+   * so must outlive the program's stats.
    *
    * @param name the name of the referenced statistic
+   * @param mode storage of the statistic, if this creates it. References to
+   *     an existing statistic share its storage.
    */
-  AppStat(const char *name);
+  AppStat(
+      const char *name,
+      const eAppStatMode::type mode = eAppStatMode::SHARED);
 
   /**
    * Atomically increment this statistic.
@@ -35,20 +55,27 @@ class AppStat {
    *
    * @param the amount to increment by.
    */
-  void increment(const u32 amount);
+  void increment(const u64 amount);
+
+  /**
+   * Atomically decrement this statistic.
+   */
+  void decrement();
 
   /**
-   * Atomically reset this statistic to 0.
+   * Atomically reset this statistic to 0. Sharded statistics may lose
+   * increments made while resetting.
    */
   void reset();
 
   /**
    * Retrieve the current value.
    */
-  u32 get() const;
+  u64 get() const;
 
   private:
-  volatile u32 *m_pCounter;
+  u32 m_index;
+  u32 m_shard;
 };
 
 /**
@@ -94,11 +121,45 @@ class AppInfo {
   std::string *m_pInfoStr;
 };
 
-typedef std::pair< const char *, u32 > tAppStat;
+typedef std::pair< const char *, u64 > tAppStat;
 typedef std::vector< tAppStat > tAppStatList;
 typedef std::pair< const char *, std::string > tAppInfo;
 typedef std::vector< tAppInfo > tAppInfoList;
 
+/**
+ * Values of every registered {@link AppStat} at one point in time. Capturing
+ * takes no locks, so a monitoring thread may sample rates cheaply.
+ */
+class AppStatSnapshot {
+  public:
+  AppStatSnapshot();
+
+  /**
+   * @return the current value of every registered stat
+   */
+  static AppStatSnapshot capture();
+
+  /**
+   * @return the value of each stat, in registration order
+   */
+  tAppStatList values() const;
+
+  /**
+   * @return how much each stat changed since {@code earlier}, in
+   *     registration order. Stats registered since count from 0.
+   */
+  tAppStatList delta(const AppStatSnapshot &earlier) const;
+
+  /**
+   * @return seconds elapsed since {@code earlier} was captured
+   */
+  f64 secondsSince(const AppStatSnapshot &earlier) const;
+
+  private:
+  u64 m_ticks;
+  std::vector< u64 > m_values;
+};
+
 /**
  * Get a copy of all registered {@link AppStat}
  */
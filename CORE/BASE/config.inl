@@ -45,15 +45,13 @@ bool Flag< tType >::fromString(const std::string &value) {
   return false;
 }
 
-} // namespace config
-} // namespace core
-
 /**
- *
+ * In the namespace of {@link FlagEnum}, so lexical_cast finds it for enums
+ * declared in any namespace.
  */
 template < typename tEnum >
-inline std::stringstream &operator<<(
-    std::stringstream &stream, const core::config::FlagEnum< tEnum > &flag) {
+inline std::stringstream &
+operator<<(std::stringstream &stream, const FlagEnum< tEnum > &flag) {
   stream << tEnum::enumNames[flag.m_value];
   return stream;
 }
@@ -63,7 +61,7 @@ inline std::stringstream &operator<<(
  */
 template < typename tEnum >
 inline std::stringstream &
-operator>>(std::stringstream &stream, core::config::FlagEnum< tEnum > &flag) {
+operator>>(std::stringstream &stream, FlagEnum< tEnum > &flag) {
   std::string name;
   stream >> name;
   for (int i = 0; i < tEnum::COUNT; ++i) {
@@ -75,4 +73,7 @@ operator>>(std::stringstream &stream, core::config::FlagEnum< tEnum > &flag) {
   return stream;
 }
 
+} // namespace config
+} // namespace core
+
 #endif
@@ -1,30 +1,165 @@
 #include "logging.h"
 
+#include <CORE/BASE/appstats.h>
+#include <CORE/MEMORY/memory_tracking.h>
+#include <CORE/TYPES/spsc_byte_ring.h>
+
 #include <algorithm>
+#include <condition_variable>
+#include <cstring>
 #include <functional>
+#include <mutex>
+#include <utility>
 
 namespace core {
 namespace logging {
 
-// Set 16K messages @ ~1K/msg -> ~16Mb of log storage in memory.
-static const size_t MAX_LOG_BUFFER = 1024 * 16;
+/**
+ * Most records written per pass of the logger thread, so buffers of new
+ * threads are picked up while others keep logging.
+ */
+static const size_t MAX_RECORDS_PER_PASS = 1024;
+
+/**
+ *
+ */
+const char *LL::enumNames[LL::COUNT] = {"Trace", "Info", "Warning", "Error"};
+
+/**
+ *
+ */
+core::arch::Atomic< u32 > g_sinkLevels(~0u);
+
+/**
+ *
+ */
+core::config::Flag< core::config::FlagEnum< LL > > g_minLogLevel(
+    "min_log_level",
+    "Lowest level of messages to log: Trace, Info, Warning or Error.",
+    core::config::FlagEnum< LL >(LL::Trace));
+
+/**
+ *
+ */
+core::config::Flag< int > g_logBufferSize(
+    "log_buffer_size",
+    "Bytes of log records each thread may have waiting to be written.",
+    128 * 1024);
+
+/**
+ * Header of a message in a {@link ThreadLogBuffer}, followed by the
+ * {@code m_msgLen} characters of its text.
+ */
+struct LogRecord {
+  s64 m_timestamp;
+  const char *m_file;
+  const char *m_function;
+  uintptr_t m_stackPtr;
+  long m_line;
+  u32 m_level;
+  u32 m_msgLen;
+};
+
+/**
+ * Messages logged by one thread, waiting for the logger thread. Each takes
+ * only the bytes of its text, rather than a whole {@link LogMessage}.
+ */
+struct ThreadLogBuffer {
+  explicit ThreadLogBuffer(const size_t capacity);
+
+  core::types::SpscByteRing m_ring;
+  std::thread::id m_threadId;
+
+  // Set once the thread exits, so the buffer is freed after it is drained.
+  core::arch::Atomic< bool > m_retired;
+};
+
+/**
+ * Retires the buffer of a thread as it exits.
+ */
+struct ThreadLogBufferRetirer {
+  ~ThreadLogBufferRetirer();
+};
+
+// Plain thread locals, so messages logged by other thread local destructors
+// still find out the buffer is gone.
+static thread_local ThreadLogBuffer *s_pThreadBuffer = NULL;
+static thread_local bool s_threadExiting = false;
+static thread_local ThreadLogBufferRetirer s_threadBufferRetirer;
 
 /**
  * Collection of log sinks to be written to.
+ *
+ * Each thread logs into a buffer of its own, so threads never wait on each
+ * other. The logger thread merges the buffers by timestamp as it writes them
+ * to the sinks.
  */
 class LogManager : core::util::noncopyable {
   public:
   LogManager();
   ~LogManager();
 
-  Status write(const LogMessage &);
+  Status write(LogMessage &&);
   Status registerSink(std::shared_ptr< iLogSink >);
   void flush();
 
   private:
+  /**
+   * @return the calling thread's buffer, created on its first message
+   */
+  ThreadLogBuffer *getThreadBuffer();
+
+  /**
+   * Wake the logger thread.
+   */
+  void wake();
+
+  /**
+   * @return if there are sinks, and records waiting for them
+   */
+  bool hasPendingRecords();
+
+  /**
+   * Write waiting records to the sinks, oldest first, and free the buffers
+   * of exited threads. Only called by the logger thread.
+   *
+   * @return the number of records written
+   */
+  size_t drain();
+
+  /**
+   * Decode a record into {@link m_message}, and write it to every sink.
+   */
+  void writeRecord(const ThreadLogBuffer &, const LogRecord &);
+
   std::vector< std::shared_ptr< iLogSink > > m_sinks;
-  core::types::ConcurrentQueue< LogMessage > m_messages;
   std::mutex m_mutex;
+
+  std::vector< ThreadLogBuffer * > m_buffers;
+  std::mutex m_buffersMutex;
+
+  // Only used by the logger thread.
+  std::vector< ThreadLogBuffer * > m_draining;
+  std::vector< const LogRecord * > m_fronts;
+  LogMessage m_message;
+
+  std::mutex m_wakeMutex;
+  std::condition_variable m_wakeCondition;
+  std::condition_variable m_idleCondition;
+  core::arch::Atomic< bool > m_sleeping;
+  bool m_wakeup;
+  bool m_running;
+  u64 m_idlePasses;
+
+  // Idle passes the logger thread runs before it sleeps, for flush().
+  u64 m_flushPasses;
+
+  // Read by logging threads with a full buffer, which drop their message
+  // rather than wait on a logger thread that will never drain it.
+  core::arch::Atomic< bool > m_hasSinks;
+  core::arch::Atomic< bool > m_loggerAlive;
+  AppStat m_droppedStat;
+
   std::thread m_loggerThread;
 
   static void logFn(LogManager *);
@@ -52,11 +187,41 @@ void FlushLogger() {
   GetDefaultLogger().flush();
 }
 
+/**
+ * Large enough for the longest message.
+ */
+ThreadLogBuffer::ThreadLogBuffer(const size_t capacity)
+    : m_ring(std::max(
+          capacity,
+          2 * (core::types::BYTE_RING_HEADER_SIZE + sizeof(LogRecord)
+               + MAX_LOG_LEN))),
+      m_threadId(std::this_thread::get_id()),
+      m_retired(false) {
+}
+
+/**
+ *
+ */
+ThreadLogBufferRetirer::~ThreadLogBufferRetirer() {
+  if (s_pThreadBuffer != NULL) {
+    s_pThreadBuffer->m_retired.store(true, std::memory_order_release);
+    s_pThreadBuffer = NULL;
+  }
+  s_threadExiting = true;
+}
+
 /**
  *
  */
 LogManager::LogManager()
-    : m_messages(MAX_LOG_BUFFER),
+    : m_sleeping(false),
+      m_wakeup(false),
+      m_running(true),
+      m_idlePasses(0),
+      m_flushPasses(0),
+      m_hasSinks(false),
+      m_loggerAlive(true),
+      m_droppedStat("log_dropped"),
       m_loggerThread(std::bind(&LogManager::logFn, this)) {
 }
 
@@ -68,20 +233,40 @@ static void FlushSink(std::shared_ptr< iLogSink > &pSink) {
 }
 
 /**
- *
+ * Records still waiting once the logger thread is stopped have no sink to be
+ * written to, and are dropped with their buffers.
  */
 LogManager::~LogManager() {
-  m_messages.waitEmpty();
-  m_messages.close();
+  {
+    std::lock_guard< std::mutex > lock(m_wakeMutex);
+    m_running = false;
+    m_wakeup = true;
+  }
+  m_wakeCondition.notify_one();
   m_loggerThread.join();
+  m_loggerAlive.store(false, std::memory_order_release);
   std::for_each(m_sinks.begin(), m_sinks.end(), FlushSink);
+  for (size_t i = 0; i < m_buffers.size(); ++i) {
+    delete m_buffers[i];
+  }
 }
 
 /**
- *
+ * Messages logged before the call are written once the logger thread has
+ * started, and finished, a pass which found nothing left to write.
  */
 void LogManager::flush() {
-  m_messages.waitEmpty();
+  {
+    std::unique_lock< std::mutex > lock(m_wakeMutex);
+    const u64 target = m_idlePasses + 2;
+    m_flushPasses = std::max(m_flushPasses, target);
+    m_wakeup = true;
+    m_wakeCondition.notify_one();
+    m_idleCondition.wait(
+        lock, [&]() { return m_idlePasses >= target || !m_running; });
+  }
+
+  std::lock_guard< std::mutex > lock(m_mutex);
   std::for_each(m_sinks.begin(), m_sinks.end(), FlushSink);
 }
 
@@ -89,11 +274,27 @@ void LogManager::flush() {
  *
  */
 Status LogManager::registerSink(std::shared_ptr< iLogSink > pSink) {
-  std::lock_guard< std::mutex > lock(m_mutex);
-  if (std::find(m_sinks.begin(), m_sinks.end(), pSink) != m_sinks.end()) {
-    return Status(Status::BAD_ARGUMENT);
+  {
+    std::lock_guard< std::mutex > lock(m_mutex);
+    if (std::find(m_sinks.begin(), m_sinks.end(), pSink) != m_sinks.end()) {
+      return Status(Status::BAD_ARGUMENT);
+    }
+    m_sinks.push_back(pSink);
+
+    u32 levels = 0;
+    for (size_t i = 0; i < m_sinks.size(); ++i) {
+      for (u32 level = 0; level < LL::COUNT; ++level) {
+        if (m_sinks[i]->getLevels().isSet((LL::type) level)) {
+          levels |= 1u << level;
+        }
+      }
+    }
+    g_sinkLevels.store(levels, std::memory_order_relaxed);
+    m_hasSinks.store(true, std::memory_order_release);
   }
-  m_sinks.push_back(pSink);
+
+  // Messages may have been waiting for a sink.
+  wake();
   return Status::ok();
 }
 
@@ -101,50 +302,231 @@ Status LogManager::registerSink(std::shared_ptr< iLogSink > pSink) {
  *
  */
 LogMessageBuilder::~LogMessageBuilder() {
-  Status ret = GetDefaultLogger().write(m_message);
+  Status ret = GetDefaultLogger().write(std::move(m_message));
   if (!ret) {
     std::cerr << "Log message not logged to all sinks." << std::endl;
   }
 }
 
 /**
- *
+ * Waits for the logger thread if the thread's buffer is full. Until a sink is
+ * registered, or once the logger thread has stopped, nothing drains the
+ * buffer, so a message which does not fit is dropped and counted in the
+ * "log_dropped" {@link AppStat} instead.
  */
-Status LogManager::write(const LogMessage &message) {
-  m_messages.push(message);
+Status LogManager::write(LogMessage &&message) {
+  core::memory::ScopedMemoryTag tag(core::memory::eMemoryTag::LOG);
+  ThreadLogBuffer *pBuffer = getThreadBuffer();
+
+  const size_t msgLen = std::min(message.m_msgLen, (size_t) MAX_LOG_LEN - 1);
+  const size_t size = sizeof(LogRecord) + msgLen;
+  u8 *pRecord = pBuffer->m_ring.reserve(size);
+  core::arch::Backoff backoff;
+  while (pRecord == NULL) {
+    if (!m_hasSinks.load(std::memory_order_acquire)
+        || !m_loggerAlive.load(std::memory_order_acquire)) {
+      m_droppedStat.increment();
+      return Status::ok();
+    }
+    wake();
+    backoff.pause();
+    pRecord = pBuffer->m_ring.reserve(size);
+  }
+
+  LogRecord *pHeader = (LogRecord *) pRecord;
+  pHeader->m_timestamp =
+      (s64) message.m_trace.m_timestamp.time_since_epoch().count();
+  pHeader->m_file = message.m_trace.m_file;
+  pHeader->m_function = message.m_trace.m_function;
+  pHeader->m_stackPtr = message.m_trace.m_stackPtr;
+  pHeader->m_line = message.m_trace.m_line;
+  pHeader->m_level = message.m_logLevel;
+  pHeader->m_msgLen = (u32) msgLen;
+  memcpy(pRecord + sizeof(LogRecord), message.m_msg, msgLen);
+  pBuffer->m_ring.commit();
+
+  if (s_threadExiting) {
+    pBuffer->m_retired.store(true, std::memory_order_release);
+  }
+
+  // Pairs with the fence in logFn, so either the logger thread sees the
+  // record, or this thread sees it sleeping.
+  core::arch::ThreadFence(std::memory_order_seq_cst);
+  if (m_sleeping.load(std::memory_order_relaxed)) {
+    wake();
+  }
   return Status::ok();
 }
 
+/**
+ * A thread logging after it started exiting gets a new buffer per message,
+ * retired as soon as it is written.
+ */
+ThreadLogBuffer *LogManager::getThreadBuffer() {
+  if (s_pThreadBuffer != NULL) {
+    return s_pThreadBuffer;
+  }
+
+  ThreadLogBuffer *pBuffer =
+      new ThreadLogBuffer((size_t) std::max(g_logBufferSize.get(), 0));
+  {
+    std::lock_guard< std::mutex > lock(m_buffersMutex);
+    m_buffers.push_back(pBuffer);
+  }
+  if (!s_threadExiting) {
+    // Touched so its destructor runs as the thread exits.
+    (void) &s_threadBufferRetirer;
+    s_pThreadBuffer = pBuffer;
+  }
+  return pBuffer;
+}
+
 /**
  *
  */
-void LogManager::logFn(LogManager *pManager) {
-  while (pManager->m_messages.isOpen()) {
-    {
-      std::lock_guard< std::mutex > lock(pManager->m_mutex);
-      if (pManager->m_sinks.empty()) {
-        std::this_thread::yield();
-        continue;
+void LogManager::wake() {
+  {
+    std::lock_guard< std::mutex > lock(m_wakeMutex);
+    m_wakeup = true;
+  }
+  m_wakeCondition.notify_one();
+}
+
+/**
+ *
+ */
+bool LogManager::hasPendingRecords() {
+  {
+    std::lock_guard< std::mutex > lock(m_mutex);
+    if (m_sinks.empty()) {
+      return false;
+    }
+  }
+
+  std::lock_guard< std::mutex > lock(m_buffersMutex);
+  for (size_t i = 0; i < m_buffers.size(); ++i) {
+    if (!m_buffers[i]->m_ring.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Records are merged in timestamp order across the records waiting at the
+ * time. One logged while the pass runs may be written in the next pass, after
+ * records with later timestamps.
+ */
+size_t LogManager::drain() {
+  std::lock_guard< std::mutex > sinksLock(m_mutex);
+  if (m_sinks.empty()) {
+    return 0;
+  }
+
+  {
+    std::lock_guard< std::mutex > lock(m_buffersMutex);
+    m_draining = m_buffers;
+  }
+  m_fronts.resize(m_draining.size());
+  for (size_t i = 0; i < m_draining.size(); ++i) {
+    size_t size;
+    m_fronts[i] = (const LogRecord *) m_draining[i]->m_ring.front(size);
+  }
+
+  size_t written = 0;
+  while (written < MAX_RECORDS_PER_PASS) {
+    size_t oldest = m_fronts.size();
+    for (size_t i = 0; i < m_fronts.size(); ++i) {
+      if (m_fronts[i] != NULL
+          && (oldest == m_fronts.size()
+              || m_fronts[i]->m_timestamp < m_fronts[oldest]->m_timestamp)) {
+        oldest = i;
       }
     }
+    if (oldest == m_fronts.size()) {
+      break;
+    }
+
+    ThreadLogBuffer *pBuffer = m_draining[oldest];
+    writeRecord(*pBuffer, *m_fronts[oldest]);
+    pBuffer->m_ring.pop();
+    size_t size;
+    m_fronts[oldest] = (const LogRecord *) pBuffer->m_ring.front(size);
+    written++;
+  }
+
+  // Retired before checked empty, so no record can follow.
+  std::lock_guard< std::mutex > lock(m_buffersMutex);
+  for (size_t i = 0; i < m_buffers.size();) {
+    ThreadLogBuffer *pBuffer = m_buffers[i];
+    if (pBuffer->m_retired.load(std::memory_order_acquire)
+        && pBuffer->m_ring.empty()) {
+      m_buffers[i] = m_buffers.back();
+      m_buffers.pop_back();
+      delete pBuffer;
+    } else {
+      ++i;
+    }
+  }
+  return written;
+}
+
+/**
+ *
+ */
+void LogManager::writeRecord(
+    const ThreadLogBuffer &buffer, const LogRecord &record) {
+  m_message.m_logLevel = (LL::type) record.m_level;
+  m_message.m_trace.m_file = record.m_file;
+  m_message.m_trace.m_function = record.m_function;
+  m_message.m_trace.m_line = record.m_line;
+  m_message.m_trace.m_threadId = buffer.m_threadId;
+  m_message.m_trace.m_stackPtr = record.m_stackPtr;
+  m_message.m_trace.m_timestamp = std::chrono::system_clock::time_point(
+      std::chrono::system_clock::duration(record.m_timestamp));
+  m_message.m_msgLen = record.m_msgLen;
+  memcpy(m_message.m_msg, &record + 1, record.m_msgLen);
+  m_message.m_msg[record.m_msgLen] = 0;
+
+  for (std::vector< std::shared_ptr< iLogSink > >::iterator itr =
+           m_sinks.begin();
+       itr != m_sinks.end();
+       ++itr) {
+    Status ret = (*itr)->log(m_message);
+    if (ret.getStatus() != Status::OK) {
+      std::cerr << "LogMessage lost on channel "
+                << std::distance(m_sinks.begin(), itr) << "!" << std::endl;
+    }
+  }
+}
+
+/**
+ *
+ */
+void LogManager::logFn(LogManager *pManager) {
+  core::memory::ScopedMemoryTag tag(core::memory::eMemoryTag::LOG);
+  while (true) {
+    if (pManager->drain() > 0) {
+      continue;
+    }
 
-    LogMessage message;
-    if (!pManager->m_messages.pop(message)) {
+    std::unique_lock< std::mutex > lock(pManager->m_wakeMutex);
+    pManager->m_idlePasses++;
+    pManager->m_idleCondition.notify_all();
+    if (!pManager->m_running) {
       break;
     }
 
-    std::lock_guard< std::mutex > lock(pManager->m_mutex);
-    for (std::vector< std::shared_ptr< iLogSink > >::iterator itr =
-             pManager->m_sinks.begin();
-         itr != pManager->m_sinks.end();
-         ++itr) {
-      Status ret = (*itr)->log(message);
-      if (ret.getStatus() != Status::OK) {
-        std::cerr << "LogMessage lost on channel "
-                  << std::distance(pManager->m_sinks.begin(), itr) << "!"
-                  << std::endl;
-      }
+    pManager->m_sleeping.store(true, std::memory_order_relaxed);
+    core::arch::ThreadFence(std::memory_order_seq_cst);
+    if (!pManager->m_wakeup
+        && pManager->m_idlePasses >= pManager->m_flushPasses
+        && !pManager->hasPendingRecords()) {
+      pManager->m_wakeCondition.wait(
+          lock, [pManager]() { return pManager->m_wakeup; });
     }
+    pManager->m_wakeup = false;
+    pManager->m_sleeping.store(false, std::memory_order_relaxed);
   }
 }
 
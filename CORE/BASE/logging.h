@@ -8,9 +8,11 @@
 #ifndef FISHY_LOGGING_H
 #define FISHY_LOGGING_H
 
+#include <CORE/ARCH/atomics.h>
+#include <CORE/ARCH/platform.h>
+#include <CORE/BASE/config.h>
 #include <CORE/BASE/status.h>
 #include <CORE/TYPES/bitset.h>
-#include <CORE/TYPES/concurrent_queue.h>
 #include <CORE/UTIL/noncopyable.h>
 
 #include <atomic>
@@ -21,12 +23,20 @@
 #include <thread>
 #include <vector>
 
+/**
+ * Lowest {@link LL} built in. Log() statements below it compile to nothing,
+ * so Trace logging is only in debug builds unless this is set lower.
+ */
+#ifndef FISHY_LOG_MIN_LEVEL
+#  define FISHY_LOG_MIN_LEVEL (FISHY_DEBUG ? 0 : 1)
+#endif
+
 namespace core {
 namespace logging {
 
 /**
  * Maximum length of a single log line.
- * If this limit is reached, the log will be written out as 1019 characters of
+ * If this limit is reached, the log will be written out as 1020 characters of
  * requested log, followed by ...\0
  */
 static const unsigned MAX_LOG_LEN = 1024;
@@ -42,8 +52,26 @@ struct LL {
     Error,   // Errors
     COUNT
   };
+  static const char *enumNames[COUNT];
 };
 
+/**
+ * Bits of the {@link LL} levels accepted by any registered sink. Every level
+ * is accepted until the first sink registers, so early messages wait for it.
+ */
+extern core::arch::Atomic< u32 > g_sinkLevels;
+
+/**
+ * Messages below this level are dropped before they are formatted.
+ */
+extern core::config::Flag< core::config::FlagEnum< LL > > g_minLogLevel;
+
+/**
+ * @return if a message at {@code level} would reach a sink. Checked by
+ *     {@code Log()} before the message is built.
+ */
+bool IsLogEnabled(const LL::type level);
+
 /**
  * Information about the call site of the logger.
  */
@@ -67,12 +95,45 @@ struct LogMessage {
   LogMessage();
   LogMessage(const LL::type, const TraceInfo &);
 
+  /**
+   * Append {@code len} characters to the message, ending it with "..." once
+   * it is full.
+   */
+  void append(const char *pStr, const size_t len);
+
   LL::type m_logLevel;
   TraceInfo m_trace;
   size_t m_msgLen;
   char m_msg[MAX_LOG_LEN];
 };
 
+/**
+ * Format a value onto the end of a log message. The overloads here write
+ * straight into the message, without allocating. Other types are formatted
+ * through {@link core::util::lexical_cast}, or may add an overload of their
+ * own.
+ */
+void AppendToLog(LogMessage &message, const char *pStr);
+void AppendToLog(LogMessage &message, char *pStr);
+void AppendToLog(LogMessage &message, const std::string &str);
+void AppendToLog(LogMessage &message, const char c);
+void AppendToLog(LogMessage &message, const bool value);
+void AppendToLog(LogMessage &message, const short value);
+void AppendToLog(LogMessage &message, const unsigned short value);
+void AppendToLog(LogMessage &message, const int value);
+void AppendToLog(LogMessage &message, const unsigned int value);
+void AppendToLog(LogMessage &message, const long value);
+void AppendToLog(LogMessage &message, const unsigned long value);
+void AppendToLog(LogMessage &message, const long long value);
+void AppendToLog(LogMessage &message, const unsigned long long value);
+void AppendToLog(LogMessage &message, const float value);
+void AppendToLog(LogMessage &message, const double value);
+void AppendToLog(LogMessage &message, const void *pPtr);
+template < typename T >
+void AppendToLog(LogMessage &message, T *pPtr);
+template < typename T >
+void AppendToLog(LogMessage &message, const T &obj);
+
 /**
  * Helper class to build a log message and submit it to the {@link LogManager}.
  * Uses stream style {@code operator <<} to write out a message.
@@ -82,24 +143,38 @@ class LogMessageBuilder : core::util::noncopyable {
   LogMessageBuilder(const LL::type, const TraceInfo &);
   ~LogMessageBuilder();
 
+  /**
+   * @see AppendToLog
+   */
   template < typename T >
   LogMessageBuilder &operator<<(const T &obj);
-  template < typename T, unsigned N >
-  LogMessageBuilder &operator<<(const T (&obj)[N]);
 
   private:
   LogMessage m_message;
 };
 
+/**
+ * Gives {@code Log()} a void result either way it goes, so a disabled level
+ * skips the whole {@code operator <<} chain.
+ */
+class LogVoidify {
+  public:
+  void operator&(const LogMessageBuilder &) {}
+};
+
 /**
  * A class that triggers an "Entering"/"Exiting" message for a given scope.
  */
 class ScopedLogger : core::util::noncopyable {
   public:
-  ScopedLogger(const TraceInfo &trace);
+  /**
+   * Builds the trace only if Trace logging is enabled.
+   */
+  ScopedLogger(const char *file, const char *function, long line);
   ~ScopedLogger();
 
   private:
+  const bool m_enabled;
   TraceInfo m_trace;
 };
 
@@ -133,6 +208,11 @@ class iLogSink : core::util::noncopyable {
    */
   virtual Status flush() { return Status::OK; }
 
+  /**
+   * @return the log levels this sink writes
+   */
+  const core::types::BitSet< LL > &getLevels() const { return m_levels; }
+
   protected:
   /**
    * Implementers should use thsi function to either write or queue for write
@@ -162,17 +242,28 @@ void FlushLogger();
 using core::logging::LL;
 
 /**
- * Log a message at the given log level.
+ * Log a message at the given log level. Nothing is evaluated if no sink takes
+ * the level.
  * Usage:
  *     Log(LL::Info) << "my Message"
  */
-#  define Log(ll) core::logging::LogMessageBuilder(ll, LOG_TRACE_INFO())
+#  define Log(ll)                       \
+    !core::logging::IsLogEnabled(ll)    \
+        ? (void) 0                      \
+        : core::logging::LogVoidify()   \
+              & core::logging::LogMessageBuilder(ll, LOG_TRACE_INFO())
 
-  /**
-   * Log a message now, and a message at the end of the scope containing the
-   * trace.
-   */
-#  define Trace() core::logging::ScopedLogger scope_logger(LOG_TRACE_INFO())
+/**
+ * Log a message now, and a message at the end of the scope containing the
+ * trace.
+ */
+#  if FISHY_LOG_MIN_LEVEL > 0
+#    define Trace() (void) 0
+#  else
+#    define Trace()                               \
+      core::logging::ScopedLogger scope_logger(   \
+          __FILE__, __FUNCTION__, __LINE__)
+#  endif
 
 /**
  * Create a logger {@link core::logging::TraceInfo} for the current calling
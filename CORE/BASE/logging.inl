@@ -3,6 +3,8 @@
 
 #include <CORE/UTIL/lexical_cast.h>
 
+#include <algorithm>
+#include <charconv>
 #include <cstring>
 #include <inttypes.h>
 
@@ -39,74 +41,244 @@ inline LogMessageBuilder::LogMessageBuilder(
     : m_message(level, trace) {
 }
 
+/**
+ * Characters of a message before it is cut short, leaving room for "..."
+ * and the terminator.
+ */
+static const size_t MAX_LOG_TEXT_LEN = MAX_LOG_LEN - 4;
+
+namespace detail {
+
+/**
+ * Format a number on the stack, then append it.
+ */
+template < typename T >
+inline void AppendNumber(LogMessage &message, const T value) {
+  char buffer[32];
+  const std::to_chars_result ret =
+      std::to_chars(buffer, buffer + sizeof(buffer), value);
+  message.append(buffer, ret.ptr - buffer);
+}
+
+/**
+ * Floats are written as {@code %g}, as std::ostream would.
+ */
+template < typename T >
+inline void AppendFloat(LogMessage &message, const T value) {
+  char buffer[32];
+  const std::to_chars_result ret = std::to_chars(
+      buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+  message.append(buffer, ret.ptr - buffer);
+}
+
+} // namespace detail
+
+/**
+ * A full message has a length past {@link MAX_LOG_TEXT_LEN}, so later appends
+ * are dropped.
+ */
+inline void LogMessage::append(const char *pStr, const size_t len) {
+  if (m_msgLen >= MAX_LOG_TEXT_LEN) {
+    return;
+  }
+  const size_t avail = MAX_LOG_TEXT_LEN - m_msgLen;
+  if (len <= avail) {
+    memcpy(m_msg + m_msgLen, pStr, len);
+    m_msgLen += len;
+  } else {
+    memcpy(m_msg + m_msgLen, pStr, avail);
+    memcpy(m_msg + MAX_LOG_TEXT_LEN, "...", 3);
+    m_msgLen = MAX_LOG_TEXT_LEN + 3;
+  }
+  m_msg[m_msgLen] = 0;
+}
+
+/**
+ *
+ */
+inline void AppendToLog(LogMessage &message, const char *pStr) {
+  if (pStr == nullptr) {
+    message.append("(null)", 6);
+  } else {
+    message.append(pStr, strlen(pStr));
+  }
+}
+
+/**
+ *
+ */
+inline void AppendToLog(LogMessage &message, char *pStr) {
+  AppendToLog(message, (const char *) pStr);
+}
+
+/**
+ *
+ */
+inline void AppendToLog(LogMessage &message, const std::string &str) {
+  message.append(str.data(), str.size());
+}
+
+/**
+ *
+ */
+inline void AppendToLog(LogMessage &message, const char c) {
+  message.append(&c, 1);
+}
+
+/**
+ * Written as 1 or 0, as std::ostream would.
+ */
+inline void AppendToLog(LogMessage &message, const bool value) {
+  message.append(value ? "1" : "0", 1);
+}
+
+/**
+ *
+ */
+inline void AppendToLog(LogMessage &message, const short value) {
+  detail::AppendNumber(message, value);
+}
+
+/**
+ *
+ */
+inline void AppendToLog(LogMessage &message, const unsigned short value) {
+  detail::AppendNumber(message, value);
+}
+
+/**
+ *
+ */
+inline void AppendToLog(LogMessage &message, const int value) {
+  detail::AppendNumber(message, value);
+}
+
+/**
+ *
+ */
+inline void AppendToLog(LogMessage &message, const unsigned int value) {
+  detail::AppendNumber(message, value);
+}
+
+/**
+ *
+ */
+inline void AppendToLog(LogMessage &message, const long value) {
+  detail::AppendNumber(message, value);
+}
+
+/**
+ *
+ */
+inline void AppendToLog(LogMessage &message, const unsigned long value) {
+  detail::AppendNumber(message, value);
+}
+
+/**
+ *
+ */
+inline void AppendToLog(LogMessage &message, const long long value) {
+  detail::AppendNumber(message, value);
+}
+
+/**
+ *
+ */
+inline void AppendToLog(LogMessage &message, const unsigned long long value) {
+  detail::AppendNumber(message, value);
+}
+
+/**
+ *
+ */
+inline void AppendToLog(LogMessage &message, const float value) {
+  detail::AppendFloat(message, value);
+}
+
+/**
+ *
+ */
+inline void AppendToLog(LogMessage &message, const double value) {
+  detail::AppendFloat(message, value);
+}
+
+/**
+ *
+ */
+inline void AppendToLog(LogMessage &message, const void *pPtr) {
+  char buffer[32] = {'0', 'x'};
+  const std::to_chars_result ret =
+      std::to_chars(buffer + 2, buffer + sizeof(buffer), (uintptr_t) pPtr, 16);
+  message.append(buffer, ret.ptr - buffer);
+}
+
 /**
  *
  */
 template < typename T >
-inline LogMessageBuilder &LogMessageBuilder::operator<<(const T &obj) {
+inline void AppendToLog(LogMessage &message, T *pPtr) {
+  AppendToLog(message, (const void *) pPtr);
+}
+
+/**
+ * Types without an overload go through a temporary string.
+ */
+template < typename T >
+inline void AppendToLog(LogMessage &message, const T &obj) {
   std::string str;
-  const size_t remainingLen = MAX_LOG_LEN - 4 - (m_message.m_msgLen + 1);
   if (core::util::lexical_cast(obj, str)) {
-    strncat(m_message.m_msg, str.c_str(), remainingLen);
-    if (remainingLen < str.length()) {
-      strcat(m_message.m_msg, "...");
-    }
+    AppendToLog(message, str);
   } else {
     char buffer[32] = {0};
-    snprintf(
+    const int len = snprintf(
         buffer,
         ARRAY_LENGTH(buffer),
         "(unknown) 0x%" PRIXPTR,
         (uintptr_t) &obj);
-    strncat(m_message.m_msg, buffer, remainingLen);
-    if (remainingLen < strlen(buffer)) {
-      strcat(m_message.m_msg, "...");
-    }
+    message.append(buffer, std::min((size_t) len, sizeof(buffer) - 1));
   }
-  return *this;
 }
 
 /**
  *
  */
-template < typename T, unsigned N >
-inline LogMessageBuilder &LogMessageBuilder::operator<<(const T (&obj)[N]) {
-  std::string str;
-  const size_t remainingLen = MAX_LOG_LEN - 4 - (m_message.m_msgLen + 1);
-  if (std::is_same< char, T >::value) {
-    strncat(m_message.m_msg, obj, remainingLen);
-    if (remainingLen < str.length()) {
-      strcat(m_message.m_msg, "...");
-    }
-  } else {
-    char buffer[32] = {0};
-    snprintf(
-        buffer,
-        ARRAY_LENGTH(buffer),
-        "(unknown array) 0x%" PRIXPTR,
-        (uintptr_t) &obj);
-    strncat(m_message.m_msg, buffer, remainingLen);
-    if (remainingLen < strlen(buffer)) {
-      strcat(m_message.m_msg, "...");
-    }
-  }
+template < typename T >
+inline LogMessageBuilder &LogMessageBuilder::operator<<(const T &obj) {
+  AppendToLog(m_message, obj);
   return *this;
 }
 
 /**
  *
  */
-inline ScopedLogger::ScopedLogger(const TraceInfo &trace) : m_trace(trace) {
-  core::logging::LogMessageBuilder(LL::Trace, m_trace)
-      << "Enter " << m_trace.m_function;
+inline bool IsLogEnabled(const LL::type level) {
+  return (int) level >= FISHY_LOG_MIN_LEVEL
+         && level >= g_minLogLevel.get().m_value
+         && (g_sinkLevels.load(std::memory_order_relaxed) & (1u << level))
+                != 0;
+}
+
+/**
+ *
+ */
+inline ScopedLogger::ScopedLogger(
+    const char *file, const char *function, long line)
+    : m_enabled(IsLogEnabled(LL::Trace)) {
+  if (m_enabled) {
+    m_trace = TraceInfo(file, function, line);
+    core::logging::LogMessageBuilder(LL::Trace, m_trace)
+        << "Enter " << m_trace.m_function;
+  }
 }
 
 /**
  *
  */
 inline ScopedLogger::~ScopedLogger() {
-  core::logging::LogMessageBuilder(LL::Trace, m_trace)
-      << "Exit " << m_trace.m_function;
+  if (m_enabled) {
+    core::logging::LogMessageBuilder(LL::Trace, m_trace)
+        << "Exit " << m_trace.m_function;
+  }
 }
 
 } // namespace logging
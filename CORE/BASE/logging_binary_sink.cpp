@@ -0,0 +1,290 @@
+#include "logging_binary_sink.h"
+
+#include <CORE/BASE/serializer_podtypes.h>
+#include <CORE/BASE/serializer_strings.h>
+#include <CORE/UTIL/lexical_cast.h>
+
+using core::memory::Blob;
+
+namespace core {
+namespace logging {
+
+/**
+ * First bytes of a binary log, "FLOG" in little endian order.
+ */
+static const u32 BINARY_LOG_MAGIC = 0x474F4C46;
+
+/**
+ * Version of the binary log layout.
+ */
+static const u32 BINARY_LOG_VERSION = 1;
+
+/**
+ * Bytes collected before they are written to the stream.
+ */
+static const size_t BINARY_LOG_BLOCK_SIZE = 64 * 1024;
+
+/**
+ * Bytes of a message record before its text: kind, level, and at most five
+ * varints of ten bytes.
+ */
+static const size_t MAX_MESSAGE_HEADER_SIZE = 2 + 5 * 10;
+
+/**
+ * Append {@code value} as a {@link VarUInt} would be serialized, without
+ * going through a sink per field.
+ */
+static void PutVarUInt(u8 *&pOut, u64 value) {
+  while (value >> 7) {
+    *pOut++ = (u8) ((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  *pOut++ = (u8) value;
+}
+
+/**
+ * @return nanoseconds since the epoch, as stored in the log
+ */
+static s64 ToNanoseconds(const std::chrono::system_clock::time_point &time) {
+  return (s64) std::chrono::duration_cast< std::chrono::nanoseconds >(
+             time.time_since_epoch())
+      .count();
+}
+
+/**
+ *
+ */
+static std::chrono::system_clock::time_point FromNanoseconds(const s64 ns) {
+  return std::chrono::system_clock::time_point(
+      std::chrono::duration_cast< std::chrono::system_clock::duration >(
+          std::chrono::nanoseconds(ns)));
+}
+
+/**
+ * The header holds the time the log started, which message times are shown
+ * relative to.
+ */
+LoggingBinarySink::LoggingBinarySink(
+    const core::types::BitSet< LL > &levels,
+    std::unique_ptr< std::ostream > pStream)
+    : iLogSink(levels), m_pStream(std::move(pStream)), m_lastTimestamp(0) {
+  m_buffer.reserve(BINARY_LOG_BLOCK_SIZE + MAX_LOG_LEN);
+  core::base::VectorSink sink(m_buffer);
+  sink << BINARY_LOG_MAGIC << BINARY_LOG_VERSION
+       << ToNanoseconds(std::chrono::system_clock::now());
+}
+
+/**
+ *
+ */
+LoggingBinarySink::~LoggingBinarySink() {
+  flush().ignoreErrors();
+}
+
+/**
+ *
+ */
+Status LoggingBinarySink::flush() {
+  Status ret = writeBuffer();
+  if (m_pStream) {
+    m_pStream->flush();
+  }
+  return ret;
+}
+
+/**
+ * Only the text of the message is kept, as its arguments were formatted by
+ * {@link AppendToLog} when it was logged.
+ */
+Status LoggingBinarySink::write(const LogMessage &message) {
+  const u32 callSite = getCallSite(message.m_trace);
+  const u32 thread = getThread(message.m_trace.m_threadId);
+  const s64 timestamp = ToNanoseconds(message.m_trace.m_timestamp);
+
+  u8 header[MAX_MESSAGE_HEADER_SIZE];
+  u8 *pOut = header;
+  *pOut++ = (u8) eBinaryLogRecord::MESSAGE;
+  *pOut++ = (u8) message.m_logLevel;
+  PutVarUInt(pOut, callSite);
+  PutVarUInt(pOut, thread);
+  PutVarUInt(pOut, encode_zigzag(timestamp - m_lastTimestamp));
+  PutVarUInt(pOut, message.m_trace.m_stackPtr);
+  PutVarUInt(pOut, message.m_msgLen);
+  m_buffer.insert(m_buffer.end(), header, pOut);
+  m_buffer.insert(
+      m_buffer.end(),
+      (const u8 *) message.m_msg,
+      (const u8 *) message.m_msg + message.m_msgLen);
+  m_lastTimestamp = timestamp;
+
+  if (m_buffer.size() >= BINARY_LOG_BLOCK_SIZE) {
+    return writeBuffer();
+  }
+  return Status::ok();
+}
+
+/**
+ * Call sites are told apart by their file and line. A site inlined from a
+ * header may be seen under more than one id, which only costs its names
+ * being written again.
+ */
+u32 LoggingBinarySink::getCallSite(const TraceInfo &trace) {
+  const std::pair< const char *, long > key(trace.m_file, trace.m_line);
+  std::map< std::pair< const char *, long >, u32 >::const_iterator itr =
+      m_callSites.find(key);
+  if (itr != m_callSites.end()) {
+    return itr->second;
+  }
+
+  const u32 id = (u32) m_callSites.size();
+  m_callSites[key] = id;
+  core::base::VectorSink sink(m_buffer);
+  sink << (u8) eBinaryLogRecord::CALL_SITE << VarUInt(id)
+       << VarInt(trace.m_line)
+       << std::string(trace.m_file != NULL ? trace.m_file : "")
+       << std::string(trace.m_function != NULL ? trace.m_function : "");
+  return id;
+}
+
+/**
+ *
+ */
+u32 LoggingBinarySink::getThread(const std::thread::id &thread) {
+  std::unordered_map< std::thread::id, u32 >::const_iterator itr =
+      m_threads.find(thread);
+  if (itr != m_threads.end()) {
+    return itr->second;
+  }
+
+  const u32 id = (u32) m_threads.size();
+  m_threads[thread] = id;
+  std::string name;
+  core::util::lexical_cast(thread, name).ignoreErrors();
+  core::base::VectorSink sink(m_buffer);
+  sink << (u8) eBinaryLogRecord::THREAD << VarUInt(id) << name;
+  return id;
+}
+
+/**
+ *
+ */
+Status LoggingBinarySink::writeBuffer() {
+  if (!m_pStream) {
+    return Status(Status::BAD_STATE);
+  }
+  m_pStream->write((const char *) m_buffer.data(), m_buffer.size());
+  m_buffer.clear();
+  return m_pStream->good() ? Status::ok() : Status(Status::GENERIC_ERROR);
+}
+
+/**
+ *
+ */
+BinaryLogReader::BinaryLogReader(core::base::iBinarySerializerSink &source)
+    : m_source(source), m_headerRead(false), m_lastTimestamp(0) {
+}
+
+/**
+ *
+ */
+Status BinaryLogReader::readHeader() {
+  u32 magic = 0;
+  u32 version = 0;
+  s64 start = 0;
+  m_source >> magic >> version >> start;
+  RET_SM(
+      !m_source.fail() && magic == BINARY_LOG_MAGIC,
+      Status::BAD_INPUT,
+      "Not a binary log.");
+  RET_SM(
+      version == BINARY_LOG_VERSION,
+      Status::BAD_INPUT,
+      "Unsupported binary log version " << version);
+  m_startTime = FromNanoseconds(start);
+  m_headerRead = true;
+  return Status::ok();
+}
+
+/**
+ * Call sites and threads are named before the first message using them, and
+ * numbered in the order they are named.
+ */
+Status BinaryLogReader::next(BinaryLogEntry &entry) {
+  if (!m_headerRead) {
+    Status ret = readHeader();
+    if (!ret) {
+      return ret;
+    }
+  }
+
+  while (m_source.avail() > 0) {
+    u8 kind = 0;
+    m_source >> kind;
+    switch (kind) {
+      case eBinaryLogRecord::CALL_SITE: {
+        VarUInt id;
+        VarInt line;
+        CallSite callSite;
+        m_source >> id >> line >> callSite.m_file >> callSite.m_function;
+        RET_SM(
+            !m_source.fail() && id.get() == m_callSites.size(),
+            Status::BAD_INPUT,
+            "Bad call site record.");
+        callSite.m_line = (long) line.get();
+        m_callSites.push_back(callSite);
+        break;
+      }
+      case eBinaryLogRecord::THREAD: {
+        VarUInt id;
+        std::string name;
+        m_source >> id >> name;
+        RET_SM(
+            !m_source.fail() && id.get() == m_threads.size(),
+            Status::BAD_INPUT,
+            "Bad thread record.");
+        m_threads.push_back(name);
+        break;
+      }
+      case eBinaryLogRecord::MESSAGE: {
+        u8 level = 0;
+        VarUInt callSite;
+        VarUInt thread;
+        VarInt timestamp;
+        VarUInt stackPtr;
+        VarUInt msgLen;
+        m_source >> level >> callSite >> thread >> timestamp >> stackPtr
+            >> msgLen;
+        RET_SM(
+            !m_source.fail() && level < LL::COUNT
+                && callSite.get() < m_callSites.size()
+                && thread.get() < m_threads.size()
+                && msgLen.get() <= m_source.avail(),
+            Status::BAD_INPUT,
+            "Bad message record.");
+
+        const CallSite &site = m_callSites[callSite.get()];
+        entry.m_logLevel = (LL::type) level;
+        entry.m_file = site.m_file;
+        entry.m_function = site.m_function;
+        entry.m_line = site.m_line;
+        entry.m_thread = m_threads[thread.get()];
+        entry.m_stackPtr = (uintptr_t) stackPtr.get();
+        m_lastTimestamp += timestamp.get();
+        entry.m_timestamp = FromNanoseconds(m_lastTimestamp);
+        entry.m_msg.resize(msgLen.get());
+        Blob msg((u8 *) &entry.m_msg[0], entry.m_msg.size());
+        RET_SM(
+            m_source.read(msg) == entry.m_msg.size(),
+            Status::BAD_INPUT,
+            "Message cut short.");
+        return Status::ok();
+      }
+      default:
+        RET_SM(false, Status::BAD_INPUT, "Unknown record " << (u32) kind);
+    }
+  }
+  return Status(Status::NOT_FOUND);
+}
+
+} // namespace logging
+} // namespace core
@@ -0,0 +1,143 @@
+/**
+ * Compact binary logging sink, and the reader for its files.
+ */
+#ifndef FISHY_LOGGING_BINARY_SINK_H
+#define FISHY_LOGGING_BINARY_SINK_H
+
+#include "logging.h"
+
+#include <CORE/BASE/serializer.h>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace core {
+namespace logging {
+
+/**
+ * Kinds of record in a binary log, after its header.
+ */
+struct eBinaryLogRecord {
+  enum type {
+    CALL_SITE = 1, // File, function and line of a new call site
+    THREAD = 2,    // Name of a new thread
+    MESSAGE = 3,   // Message referring to a call site and thread by id
+  };
+};
+
+/**
+ * {@code iLogSink} writing messages in a compact binary form, so Trace
+ * logging may stay on at a high rate. Instead of rendering a line per
+ * message, each message stores:
+ *   - the id of its call site and thread, whose names are written once, the
+ *     first time they are seen;
+ *   - its timestamp, as the change from the previous message;
+ *   - the text of the message.
+ *
+ * Messages are collected in memory, and written to the stream in large
+ * blocks. Read back by {@link BinaryLogReader}, or the logdecode tool.
+ */
+class LoggingBinarySink : public iLogSink {
+  public:
+  /**
+   * @param pStream where to write the log, such as a file opened in binary
+   *     mode
+   */
+  LoggingBinarySink(
+      const core::types::BitSet< LL > &levels,
+      std::unique_ptr< std::ostream > pStream);
+  ~LoggingBinarySink();
+
+  protected:
+  virtual Status flush() override;
+  virtual Status write(const LogMessage &) override;
+
+  private:
+  /**
+   * @return the id of the message's call site, writing its names if new
+   */
+  u32 getCallSite(const TraceInfo &trace);
+
+  /**
+   * @return the id of the message's thread, writing its name if new
+   */
+  u32 getThread(const std::thread::id &thread);
+
+  /**
+   * Write out the collected records.
+   */
+  Status writeBuffer();
+
+  std::unique_ptr< std::ostream > m_pStream;
+  std::vector< u8 > m_buffer;
+  std::map< std::pair< const char *, long >, u32 > m_callSites;
+  std::unordered_map< std::thread::id, u32 > m_threads;
+  s64 m_lastTimestamp;
+};
+
+/**
+ * A message read back from a binary log.
+ */
+struct BinaryLogEntry {
+  LL::type m_logLevel;
+  std::string m_file;
+  std::string m_function;
+  long m_line;
+  std::string m_thread;
+  uintptr_t m_stackPtr;
+  std::chrono::system_clock::time_point m_timestamp;
+  std::string m_msg;
+};
+
+/**
+ * Reads the messages of a log written by {@link LoggingBinarySink}.
+ */
+class BinaryLogReader {
+  public:
+  BinaryLogReader(core::base::iBinarySerializerSink &source);
+
+  /**
+   * Read the next message.
+   *
+   * @return Status ok if a message was read, NOT_FOUND at the end of the log,
+   *     or BAD_INPUT if the log is not valid.
+   */
+  Status next(BinaryLogEntry &entry);
+
+  /**
+   * @return when the log was started, read with the first message
+   */
+  std::chrono::system_clock::time_point getStartTime() const {
+    return m_startTime;
+  }
+
+  private:
+  /**
+   * A call site read from the log.
+   */
+  struct CallSite {
+    std::string m_file;
+    std::string m_function;
+    long m_line;
+  };
+
+  Status readHeader();
+
+  core::base::iBinarySerializerSink &m_source;
+  bool m_headerRead;
+  std::chrono::system_clock::time_point m_startTime;
+  std::vector< CallSite > m_callSites;
+  std::vector< std::string > m_threads;
+  s64 m_lastTimestamp;
+};
+
+} // namespace logging
+} // namespace core
+
+#endif
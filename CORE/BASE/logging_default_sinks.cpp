@@ -47,7 +47,7 @@ static std::string CleanupMessage(const std::string &msgIn) {
 /**
  *
  */
-static std::string formatTime(const system_clock::time_point &timestamp) {
+std::string FormatLogTime(const system_clock::time_point &timestamp) {
   static std::chrono::seconds start =
       std::chrono::duration_cast< std::chrono::seconds >(
           std::chrono::system_clock::now().time_since_epoch());
@@ -61,20 +61,50 @@ static std::string formatTime(const system_clock::time_point &timestamp) {
   return "???";
 }
 
+/**
+ *
+ */
+void WriteLogLine(
+    std::ostream &channel,
+    const LoggingStdioSink::Options::eFormat format,
+    const LL::type level,
+    const TraceInfo &trace,
+    const std::string &thread,
+    const std::string &time,
+    const std::string &msg) {
+  switch (format) {
+    case LoggingStdioSink::Options::FORMAT_VERBOSE:
+      channel << "(" << trace.m_file << "@" << trace.m_function << ":"
+              << trace.m_line << ") | " << thread << "+" << trace.m_stackPtr
+              << " | ";
+    case LoggingStdioSink::Options::FORMAT_SHORT:
+      channel << time << " | " << g_logLevelStr[level];
+    case LoggingStdioSink::Options::FORMAT_TINY:
+      channel << msg;
+  }
+}
+
+/**
+ * Only the formats which print them name the thread and the time.
+ */
 void LoggingStdioSink::writeToStream(
     std::ostream &channel, const LogMessage &info, const std::string &msg) {
-
-  switch (m_options.m_format) {
-    case Options::FORMAT_VERBOSE:
-      channel << "(" << info.m_trace.m_file << "@" << info.m_trace.m_function
-              << ":" << info.m_trace.m_line << ") | " << info.m_trace.m_threadId
-              << "+" << info.m_trace.m_stackPtr << " | ";
-    case Options::FORMAT_SHORT:
-      channel << formatTime(info.m_trace.m_timestamp) << " | "
-              << g_logLevelStr[info.m_logLevel];
-    case Options::FORMAT_TINY:
-      channel << msg;
+  std::string thread;
+  if (m_options.m_format == Options::FORMAT_VERBOSE) {
+    core::util::lexical_cast(info.m_trace.m_threadId, thread).ignoreErrors();
+  }
+  std::string time;
+  if (m_options.m_format != Options::FORMAT_TINY) {
+    time = FormatLogTime(info.m_trace.m_timestamp);
   }
+  WriteLogLine(
+      channel,
+      m_options.m_format,
+      info.m_logLevel,
+      info.m_trace,
+      thread,
+      time,
+      msg);
 }
 
 /**
@@ -39,6 +39,26 @@ class LoggingStdioSink : public iLogSink {
   Options m_options;
 };
 
+/**
+ * @return the time of a message, as seconds since logging started
+ */
+std::string FormatLogTime(
+    const std::chrono::system_clock::time_point &timestamp);
+
+/**
+ * Write a message in the layout of a {@link LoggingStdioSink}. The thread and
+ * the time since logging started are given as text, so messages decoded from
+ * elsewhere print as the sink would have printed them.
+ */
+void WriteLogLine(
+    std::ostream &channel,
+    const LoggingStdioSink::Options::eFormat format,
+    const LL::type level,
+    const TraceInfo &trace,
+    const std::string &thread,
+    const std::string &time,
+    const std::string &msg);
+
 } // namespace logging
 } // namespace core
 
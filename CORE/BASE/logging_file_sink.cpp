@@ -0,0 +1,607 @@
+#include "logging_file_sink.h"
+
+#include <CORE/ARCH/platform.h>
+#include <CORE/BASE/appstats.h>
+#include <CORE/UTIL/lexical_cast.h>
+
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+#if defined(PLAT_LINUX)
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <sys/stat.h>
+#  include <sys/uio.h>
+#  include <unistd.h>
+#endif
+
+using std::chrono::steady_clock;
+
+namespace core {
+namespace logging {
+
+/**
+ * Blocks given to one writev call.
+ */
+static const int LOG_FILE_MAX_IOV = 64;
+
+/**
+ * Emptied blocks kept for reuse, so a steady rate of logging allocates none.
+ */
+static const size_t LOG_FILE_SPARE_BLOCKS = 4;
+
+#if defined(PLAT_LINUX)
+typedef int tLogFile;
+static const tLogFile NO_LOG_FILE = -1;
+
+/**
+ * Open {@code path} for appending.
+ *
+ * @param size set to the bytes already in the file
+ */
+static tLogFile OpenLogFile(const std::string &path, size_t &size) {
+  const int fd =
+      ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  struct stat info;
+  size = (fd >= 0 && ::fstat(fd, &info) == 0) ? (size_t) info.st_size : 0;
+  return fd;
+}
+
+/**
+ * Write {@code count} blocks, with as few system calls as writes can be
+ * split into.
+ *
+ * @return if every byte was written
+ */
+static bool WriteLogFile(
+    const tLogFile file,
+    const std::vector< char > *pBlocks,
+    const size_t count) {
+  struct iovec iov[LOG_FILE_MAX_IOV];
+  size_t first = 0;
+  size_t offset = 0;
+  while (first < count) {
+    int used = 0;
+    for (size_t i = first; i < count && used < LOG_FILE_MAX_IOV; ++i) {
+      const size_t skip = i == first ? offset : 0;
+      iov[used].iov_base = (void *) (pBlocks[i].data() + skip);
+      iov[used].iov_len = pBlocks[i].size() - skip;
+      ++used;
+    }
+
+    const ssize_t ret = ::writev(file, iov, used);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret <= 0) {
+      return false;
+    }
+
+    size_t left = (size_t) ret;
+    while (left > 0) {
+      const size_t remaining = pBlocks[first].size() - offset;
+      if (left < remaining) {
+        offset += left;
+        break;
+      }
+      left -= remaining;
+      offset = 0;
+      ++first;
+    }
+  }
+  return true;
+}
+
+/**
+ *
+ */
+static void SyncLogFile(const tLogFile file) {
+  ::fdatasync(file);
+}
+
+/**
+ *
+ */
+static void CloseLogFile(const tLogFile file) {
+  ::close(file);
+}
+#else
+typedef std::FILE *tLogFile;
+static tLogFile const NO_LOG_FILE = NULL;
+
+/**
+ * Platforms without writev go through stdio, which buffers the blocks as
+ * they are written one by one.
+ */
+static tLogFile OpenLogFile(const std::string &path, size_t &size) {
+  std::FILE *pFile = std::fopen(path.c_str(), "ab");
+  size = 0;
+  if (pFile != NULL && std::fseek(pFile, 0, SEEK_END) == 0) {
+    const long pos = std::ftell(pFile);
+    size = pos > 0 ? (size_t) pos : 0;
+  }
+  return pFile;
+}
+
+/**
+ *
+ */
+static bool WriteLogFile(
+    const tLogFile file,
+    const std::vector< char > *pBlocks,
+    const size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    if (std::fwrite(pBlocks[i].data(), 1, pBlocks[i].size(), file)
+        != pBlocks[i].size()) {
+      return false;
+    }
+  }
+  return std::fflush(file) == 0;
+}
+
+/**
+ *
+ */
+static void SyncLogFile(const tLogFile file) {
+  std::fflush(file);
+}
+
+/**
+ *
+ */
+static void CloseLogFile(const tLogFile file) {
+  std::fclose(file);
+}
+#endif
+
+/**
+ * @return the name {@code path} has once rotated {@code index} times
+ */
+static std::string RotatedPath(const std::string &path, const u32 index) {
+  std::string suffix;
+  core::util::lexical_cast(index, suffix).ignoreErrors();
+  return path + "." + suffix;
+}
+
+/**
+ * Stream buffer appending to the end of a block.
+ */
+class BlockStreamBuf : public std::streambuf {
+  public:
+  BlockStreamBuf(std::vector< char > &block) : m_block(block) {}
+
+  protected:
+  virtual int_type overflow(int_type c) override {
+    if (c != traits_type::eof()) {
+      m_block.push_back((char) c);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  virtual std::streamsize xsputn(const char *pStr, std::streamsize n) override {
+    m_block.insert(m_block.end(), pStr, pStr + n);
+    return n;
+  }
+
+  private:
+  std::vector< char > &m_block;
+};
+
+/**
+ * State of a {@link LoggingFileSink}, shared by the logger thread and the
+ * sink's writer thread.
+ */
+class FileSinkDetail {
+  public:
+  FileSinkDetail(const LoggingFileSink::Options &options);
+  ~FileSinkDetail();
+
+  /**
+   * Add a message to the current block. Only called by the logger thread.
+   */
+  void append(const LogMessage &message);
+
+  /**
+   * Wait for the lines appended so far to be written.
+   */
+  void flush();
+
+  /**
+   * Write out blocks, as they fill up or the flush interval passes.
+   */
+  static void writerFn(FileSinkDetail *pDetail);
+
+  /**
+   * @return if the writer thread should run a pass before the flush interval
+   *     is up
+   */
+  bool hasWork() const;
+
+  /**
+   * Write {@code blocks} to the file, rotating it as needed.
+   *
+   * @return the bytes taken from the backlog
+   */
+  size_t writeBlocks(const std::vector< std::vector< char > > &blocks);
+
+  /**
+   * @return if the file should be rotated before more is written to it
+   */
+  bool needsRotation() const;
+
+  /**
+   * Close the file, move it and those rotated before it aside, and open a
+   * new one.
+   */
+  void rotate();
+
+  /**
+   * @return an empty block, reusing a spare one if there is
+   */
+  std::vector< char > takeBlock();
+
+  LoggingFileSink::Options m_options;
+  AppStat m_droppedStat;
+  bool m_opened;
+
+  // Only used by the writer thread, once started.
+  tLogFile m_file;
+  size_t m_fileSize;
+  steady_clock::time_point m_openedAt;
+  steady_clock::time_point m_lastSync;
+
+  // Guarded by m_mutex.
+  std::mutex m_mutex;
+  std::condition_variable m_wakeCondition;
+  std::condition_variable m_writtenCondition;
+  std::vector< char > m_pending;
+  std::vector< std::vector< char > > m_blocks;
+  std::vector< std::vector< char > > m_spare;
+  size_t m_backlog;
+  u64 m_queued;
+  u64 m_written;
+  u64 m_dropped;
+  u64 m_unreported;
+  bool m_flushRequested;
+  bool m_running;
+
+  // Render lines straight into m_pending, under m_mutex.
+  BlockStreamBuf m_streamBuf;
+  std::ostream m_stream;
+
+  std::thread m_writerThread;
+};
+
+/**
+ * The file is opened before the writer thread starts, so a bad path is
+ * reported to whoever creates the sink.
+ */
+FileSinkDetail::FileSinkDetail(const LoggingFileSink::Options &options)
+    : m_options(options),
+      m_droppedStat("log_file_dropped"),
+      m_opened(false),
+      m_file(NO_LOG_FILE),
+      m_fileSize(0),
+      m_openedAt(steady_clock::now()),
+      m_lastSync(m_openedAt),
+      m_backlog(0),
+      m_queued(0),
+      m_written(0),
+      m_dropped(0),
+      m_unreported(0),
+      m_flushRequested(false),
+      m_running(true),
+      m_streamBuf(m_pending),
+      m_stream(&m_streamBuf) {
+  m_pending.reserve(m_options.m_blockSize + MAX_LOG_LEN);
+  m_file = OpenLogFile(m_options.m_path, m_fileSize);
+  m_opened = m_file != NO_LOG_FILE;
+  if (!m_opened) {
+    std::cerr << "Unable to open log file " << m_options.m_path << std::endl;
+  }
+  m_writerThread = std::thread(&FileSinkDetail::writerFn, this);
+}
+
+/**
+ *
+ */
+FileSinkDetail::~FileSinkDetail() {
+  {
+    std::lock_guard< std::mutex > lock(m_mutex);
+    m_running = false;
+  }
+  m_wakeCondition.notify_one();
+  m_writerThread.join();
+  if (m_file != NO_LOG_FILE) {
+    CloseLogFile(m_file);
+  }
+}
+
+/**
+ * Messages are dropped once the backlog is full, rather than waiting on the
+ * writer thread: waiting here would hold up the logger thread, and through
+ * it every thread which logs.
+ */
+void FileSinkDetail::append(const LogMessage &message) {
+  std::string thread;
+  if (m_options.m_format == LoggingStdioSink::Options::FORMAT_VERBOSE) {
+    core::util::lexical_cast(message.m_trace.m_threadId, thread)
+        .ignoreErrors();
+  }
+  std::string time;
+  if (m_options.m_format != LoggingStdioSink::Options::FORMAT_TINY) {
+    time = FormatLogTime(message.m_trace.m_timestamp);
+  }
+  const std::string msg(message.m_msg, message.m_msgLen);
+
+  std::lock_guard< std::mutex > lock(m_mutex);
+  if (m_backlog >= m_options.m_maxBacklog) {
+    m_dropped++;
+    m_unreported++;
+    m_droppedStat.increment();
+    return;
+  }
+
+  const size_t before = m_pending.size();
+  if (m_unreported > 0) {
+    m_stream << "(" << m_unreported << " log messages dropped)\n";
+    m_unreported = 0;
+  }
+  WriteLogLine(
+      m_stream,
+      m_options.m_format,
+      message.m_logLevel,
+      message.m_trace,
+      thread,
+      time,
+      msg);
+  if (msg.empty() || msg.back() != '\n') {
+    m_stream << '\n';
+  }
+  m_backlog += m_pending.size() - before;
+  m_queued += m_pending.size() - before;
+
+  if (m_pending.size() >= m_options.m_blockSize) {
+    m_blocks.push_back(std::move(m_pending));
+    m_pending = takeBlock();
+    m_wakeCondition.notify_one();
+  }
+}
+
+/**
+ *
+ */
+void FileSinkDetail::flush() {
+  std::unique_lock< std::mutex > lock(m_mutex);
+  const u64 target = m_queued;
+  m_flushRequested = true;
+  m_wakeCondition.notify_one();
+  m_writtenCondition.wait(
+      lock, [&]() { return m_written >= target || !m_running; });
+}
+
+/**
+ * Each pass takes every block, the partly filled one included, so a pass
+ * woken by a full block also writes what came after it.
+ */
+void FileSinkDetail::writerFn(FileSinkDetail *pDetail) {
+  std::vector< std::vector< char > > blocks;
+  std::unique_lock< std::mutex > lock(pDetail->m_mutex);
+  while (true) {
+    if (pDetail->m_options.m_flushInterval.count() > 0) {
+      pDetail->m_wakeCondition.wait_for(
+          lock, pDetail->m_options.m_flushInterval, [pDetail]() {
+            return pDetail->hasWork();
+          });
+    } else {
+      pDetail->m_wakeCondition.wait(
+          lock, [pDetail]() { return pDetail->hasWork(); });
+    }
+
+    if (!pDetail->m_pending.empty()) {
+      pDetail->m_blocks.push_back(std::move(pDetail->m_pending));
+      pDetail->m_pending = pDetail->takeBlock();
+    }
+    blocks.swap(pDetail->m_blocks);
+    const u64 target = pDetail->m_queued;
+    const bool flushRequested = pDetail->m_flushRequested;
+    const bool running = pDetail->m_running;
+    pDetail->m_flushRequested = false;
+    lock.unlock();
+
+    const size_t written = pDetail->writeBlocks(blocks);
+    const steady_clock::time_point now = steady_clock::now();
+    const bool syncDue = flushRequested || !running
+                         || now - pDetail->m_lastSync
+                                >= pDetail->m_options.m_flushInterval;
+    if (pDetail->m_options.m_fsync && pDetail->m_file != NO_LOG_FILE
+        && written > 0 && syncDue) {
+      SyncLogFile(pDetail->m_file);
+      pDetail->m_lastSync = now;
+    }
+
+    lock.lock();
+    pDetail->m_backlog -= written;
+    pDetail->m_written = target;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+      if (pDetail->m_spare.size() < LOG_FILE_SPARE_BLOCKS) {
+        blocks[i].clear();
+        pDetail->m_spare.push_back(std::move(blocks[i]));
+      }
+    }
+    blocks.clear();
+    pDetail->m_writtenCondition.notify_all();
+    if (!running) {
+      break;
+    }
+  }
+}
+
+/**
+ *
+ */
+bool FileSinkDetail::hasWork() const {
+  return !m_running || !m_blocks.empty() || m_flushRequested;
+}
+
+/**
+ * Blocks are not split, so a file may pass the size limit by up to one
+ * block.
+ */
+size_t FileSinkDetail::writeBlocks(
+    const std::vector< std::vector< char > > &blocks) {
+  size_t total = 0;
+  size_t first = 0;
+  while (first < blocks.size()) {
+    if (needsRotation()) {
+      rotate();
+    }
+
+    size_t last = first;
+    size_t bytes = 0;
+    do {
+      bytes += blocks[last].size();
+      ++last;
+    } while (last < blocks.size()
+             && (m_options.m_maxFileSize == 0
+                 || m_fileSize + bytes + blocks[last].size()
+                        <= m_options.m_maxFileSize));
+
+    if (m_file != NO_LOG_FILE
+        && !WriteLogFile(m_file, &blocks[first], last - first)) {
+      std::cerr << "Unable to write log file " << m_options.m_path
+                << std::endl;
+    }
+    m_fileSize += bytes;
+    total += bytes;
+    first = last;
+  }
+  return total;
+}
+
+/**
+ *
+ */
+bool FileSinkDetail::needsRotation() const {
+  if (m_fileSize == 0) {
+    return false;
+  }
+  return (m_options.m_maxFileSize > 0
+          && m_fileSize >= m_options.m_maxFileSize)
+         || (m_options.m_rotateInterval.count() > 0
+             && steady_clock::now() - m_openedAt
+                    >= m_options.m_rotateInterval);
+}
+
+/**
+ *
+ */
+void FileSinkDetail::rotate() {
+  if (m_file != NO_LOG_FILE) {
+    if (m_options.m_fsync) {
+      SyncLogFile(m_file);
+    }
+    CloseLogFile(m_file);
+  }
+
+  const std::string &path = m_options.m_path;
+  if (m_options.m_maxFiles == 0) {
+    std::remove(path.c_str());
+  } else {
+    std::remove(RotatedPath(path, m_options.m_maxFiles).c_str());
+    for (u32 i = m_options.m_maxFiles - 1; i > 0; --i) {
+      std::rename(
+          RotatedPath(path, i).c_str(), RotatedPath(path, i + 1).c_str());
+    }
+    std::rename(path.c_str(), RotatedPath(path, 1).c_str());
+  }
+
+  m_file = OpenLogFile(path, m_fileSize);
+  m_openedAt = steady_clock::now();
+  if (m_file == NO_LOG_FILE) {
+    std::cerr << "Unable to open log file " << path << std::endl;
+  }
+}
+
+/**
+ *
+ */
+std::vector< char > FileSinkDetail::takeBlock() {
+  if (m_spare.empty()) {
+    std::vector< char > block;
+    block.reserve(m_options.m_blockSize + MAX_LOG_LEN);
+    return block;
+  }
+  std::vector< char > block = std::move(m_spare.back());
+  m_spare.pop_back();
+  return block;
+}
+
+/**
+ *
+ */
+LoggingFileSink::LoggingFileSink(
+    const core::types::BitSet< LL > &levels, const Options &options)
+    : iLogSink(levels), m_pDetail(new FileSinkDetail(options)) {
+}
+
+/**
+ * The writer thread writes out what is left before it stops.
+ */
+LoggingFileSink::~LoggingFileSink() {
+}
+
+/**
+ *
+ */
+bool LoggingFileSink::isOpen() const {
+  return m_pDetail->m_opened;
+}
+
+/**
+ *
+ */
+u64 LoggingFileSink::getDropped() const {
+  std::lock_guard< std::mutex > lock(m_pDetail->m_mutex);
+  return m_pDetail->m_dropped;
+}
+
+/**
+ *
+ */
+Status LoggingFileSink::flush() {
+  m_pDetail->flush();
+  return Status::ok();
+}
+
+/**
+ * A dropped message is not an error of the sink, so is still ok: the drop is
+ * counted, and noted in the file.
+ */
+Status LoggingFileSink::write(const LogMessage &message) {
+  m_pDetail->append(message);
+  return Status::ok();
+}
+
+/**
+ *
+ */
+LoggingFileSink::Options::Options()
+    : m_format(LoggingStdioSink::Options::FORMAT_SHORT),
+      m_blockSize(256 * 1024),
+      m_maxBacklog(8 * 1024 * 1024),
+      m_maxFileSize(64 * 1024 * 1024),
+      m_rotateInterval(0),
+      m_maxFiles(5),
+      m_flushInterval(200),
+      m_fsync(false) {
+}
+
+} // namespace logging
+} // namespace core
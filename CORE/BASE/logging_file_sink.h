@@ -0,0 +1,89 @@
+/**
+ * Buffered, rotating file logging sink.
+ */
+#ifndef FISHY_LOGGING_FILE_SINK_H
+#define FISHY_LOGGING_FILE_SINK_H
+
+#include "logging.h"
+#include "logging_default_sinks.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace core {
+namespace logging {
+
+class FileSinkDetail;
+
+/**
+ * {@code iLogSink} writing lines, as {@link LoggingStdioSink} prints them, to
+ * a file. Writing never waits on the disk: lines are collected in large
+ * blocks, which a thread of the sink writes out with one writev call each
+ * time it wakes. Once more than {@code m_maxBacklog} bytes wait to be written
+ * new messages are dropped, counted in the "log_file_dropped" {@link AppStat},
+ * and noted in the file when there is room again.
+ *
+ * The file is rotated once it reaches {@code m_maxFileSize} bytes, or has been
+ * open for {@code m_rotateInterval}. The file at {@code m_path} is renamed
+ * {@code m_path}.1, the one before it .2, and so on up to
+ * {@code m_maxFiles}, after which the oldest is removed.
+ */
+class LoggingFileSink : public iLogSink {
+  public:
+  /**
+   * Options for the sink. A size or interval of 0 disables that limit.
+   */
+  struct Options {
+    Options();
+    std::string m_path;
+    LoggingStdioSink::Options::eFormat m_format;
+
+    // Bytes collected before a block is handed to the writer thread.
+    size_t m_blockSize;
+
+    // Bytes waiting to be written before messages are dropped.
+    size_t m_maxBacklog;
+
+    size_t m_maxFileSize;
+    std::chrono::seconds m_rotateInterval;
+
+    // Rotated files kept besides the current one.
+    u32 m_maxFiles;
+
+    // Longest a line waits before it is written.
+    std::chrono::milliseconds m_flushInterval;
+
+    // Whether the writer thread syncs the file to disk after it writes.
+    bool m_fsync;
+  };
+
+  LoggingFileSink(
+      const core::types::BitSet< LL > &levels, const Options &options);
+  ~LoggingFileSink();
+
+  /**
+   * @return if the file was opened
+   */
+  bool isOpen() const;
+
+  /**
+   * @return messages dropped by this sink
+   */
+  u64 getDropped() const;
+
+  protected:
+  /**
+   * Waits for every line written before the call to reach the file.
+   */
+  virtual Status flush() override;
+  virtual Status write(const LogMessage &) override;
+
+  private:
+  std::unique_ptr< FileSinkDetail > m_pDetail;
+};
+
+} // namespace logging
+} // namespace core
+
+#endif
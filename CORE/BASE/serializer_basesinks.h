@@ -5,6 +5,8 @@
 #define FISHY_SERIALIZER_BASESINKS_H
 
 #include <cstring>
+#include <limits>
+#include <vector>
 
 namespace core {
 namespace base {
@@ -156,6 +158,31 @@ class ConstBlobSink : public iBinarySerializerSink {
   size_t m_pos;
 };
 
+/**
+ * Sink appending to a vector, which grows as needed.
+ */
+class VectorSink : public iBinarySerializerSink {
+  public:
+  VectorSink(std::vector< u8 > &sink) : m_sink(sink) {}
+
+  virtual size_t write(const ::core::memory::ConstBlob &b) {
+    m_sink.insert(m_sink.end(), b.data(), b.data() + b.size());
+    return b.size();
+  }
+
+  virtual size_t read(::core::memory::Blob &) {
+    CHECK_INVALID_OPERATION();
+    return 0;
+  }
+
+  virtual void seek(const size_t dist) { m_sink.resize(m_sink.size() + dist); }
+
+  virtual size_t avail() { return std::numeric_limits< size_t >::max(); }
+
+  private:
+  std::vector< u8 > &m_sink;
+};
+
 } // namespace base
 } // namespace core
 
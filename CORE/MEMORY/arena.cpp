@@ -0,0 +1,104 @@
+#include "arena.h"
+
+#include <CORE/BASE/checks.h>
+
+#include <algorithm>
+
+namespace core {
+namespace memory {
+
+/**
+ *
+ */
+Arena::Arena(const size_t chunkSize)
+    : m_chunkSize(chunkSize),
+      m_pFirst(NULL),
+      m_pCurrent(NULL),
+      m_pPos(NULL),
+      m_pEnd(NULL) {
+  CHECK_M(chunkSize > 0, "Bad arena chunk size");
+  m_pFirst = newChunk(chunkSize, NULL);
+  useChunk(m_pFirst);
+}
+
+/**
+ *
+ */
+Arena::~Arena() {
+  Chunk *pChunk = m_pFirst;
+  while (pChunk != NULL) {
+    Chunk *pNext = pChunk->m_pNext;
+    delete[]((u8 *) pChunk);
+    pChunk = pNext;
+  }
+}
+
+/**
+ *
+ */
+void Arena::reset() {
+  useChunk(m_pFirst);
+}
+
+/**
+ *
+ */
+size_t Arena::bytesUsed() const {
+  size_t ret = 0;
+  for (Chunk *pChunk = m_pFirst; pChunk != m_pCurrent;
+       pChunk = pChunk->m_pNext) {
+    ret += pChunk->m_size;
+  }
+  return ret + (m_pPos - m_pCurrent->begin());
+}
+
+/**
+ *
+ */
+size_t Arena::bytesReserved() const {
+  size_t ret = 0;
+  for (Chunk *pChunk = m_pFirst; pChunk != NULL; pChunk = pChunk->m_pNext) {
+    ret += pChunk->m_size;
+  }
+  return ret;
+}
+
+/**
+ *
+ */
+void *Arena::allocSlow(const size_t size, const size_t alignment) {
+  // Worst case padding, so any chunk start can be aligned.
+  const size_t needed = size + alignment - 1;
+
+  // Reuse the chunk kept from before a reset, if it fits.
+  Chunk *pNext = m_pCurrent->m_pNext;
+  if (pNext == NULL || pNext->m_size < needed) {
+    pNext = newChunk(std::max(m_chunkSize, needed), pNext);
+    m_pCurrent->m_pNext = pNext;
+  }
+
+  useChunk(pNext);
+  return alloc(size, alignment);
+}
+
+/**
+ *
+ */
+Arena::Chunk *Arena::newChunk(const size_t size, Chunk *pNext) {
+  Chunk *pChunk = (Chunk *) new u8[sizeof(Chunk) + size];
+  pChunk->m_pNext = pNext;
+  pChunk->m_size = size;
+  return pChunk;
+}
+
+/**
+ *
+ */
+void Arena::useChunk(Chunk *pChunk) {
+  m_pCurrent = pChunk;
+  m_pPos = pChunk->begin();
+  m_pEnd = pChunk->end();
+}
+
+} // namespace memory
+} // namespace core
@@ -0,0 +1,160 @@
+/**
+ * Chunked linear allocator, for memory that is all freed at once.
+ */
+#ifndef FISHY_ARENA_H
+#define FISHY_ARENA_H
+
+#include <CORE/MEMORY/memory.h>
+#include <CORE/UTIL/noncopyable.h>
+#include <CORE/types.h>
+
+#include <cstddef>
+#include <utility>
+
+namespace core {
+namespace memory {
+
+/**
+ * Default size of each chunk an {@link Arena} allocates from.
+ */
+static const size_t DEFAULT_ARENA_CHUNK_SIZE = 64 * 1024;
+
+/**
+ * Bump allocator over a list of chunks. Allocating is a pointer increment in
+ * the common case, and individual allocations are never freed: the whole
+ * arena is {@link #reset}, or rewound to a {@link Marker}, instead.
+ *
+ * Chunks are kept across resets and reused, so an arena reset every frame or
+ * parse stops touching the heap once it has grown to its working size.
+ * Requests larger than the chunk size get a chunk of their own.
+ *
+ * Destructors of objects made in the arena are never called, so it should
+ * only hold trivially destructible objects, or objects whose destruction the
+ * owner handles.
+ */
+class Arena : util::noncopyable {
+  private:
+  struct Chunk;
+
+  public:
+  /**
+   * A position in the arena, to rewind back to.
+   */
+  class Marker {
+    private:
+    friend class Arena;
+    Chunk *m_pChunk;
+    u8 *m_pPos;
+  };
+
+  /**
+   * @param chunkSize bytes in each chunk allocated from the heap
+   */
+  explicit Arena(const size_t chunkSize = DEFAULT_ARENA_CHUNK_SIZE);
+  ~Arena();
+
+  /**
+   * @param size bytes of requested storage
+   * @param alignment byte count of alignment, a power of two
+   * @return uninitialized storage, valid until the arena is reset past it
+   */
+  void *alloc(
+      const size_t size, const size_t alignment = alignof(std::max_align_t));
+
+  /**
+   * @return uninitialized storage for {@code count} items
+   */
+  template < typename tType >
+  tType *allocArray(const size_t count);
+
+  /**
+   * Construct a new object in the arena. Its destructor is never called.
+   */
+  template < typename tType, typename... tArgs >
+  tType *make(tArgs &&... args);
+
+  /**
+   * @return the current position, for a later {@link #rewind}
+   */
+  Marker mark() const;
+
+  /**
+   * Free everything allocated since {@code marker} was taken. The marker must
+   * come from this arena, after its last {@link #reset}.
+   */
+  void rewind(const Marker &marker);
+
+  /**
+   * Free every allocation, keeping the chunks for reuse.
+   */
+  void reset();
+
+  /**
+   * @return bytes handed out since the last reset, including alignment
+   *     padding and the unused tails of filled chunks
+   */
+  size_t bytesUsed() const;
+
+  /**
+   * @return bytes held in chunks
+   */
+  size_t bytesReserved() const;
+
+  private:
+  struct Chunk {
+    Chunk *m_pNext;
+    size_t m_size;
+
+    u8 *begin() { return (u8 *) (this + 1); }
+    u8 *end() { return begin() + m_size; }
+  };
+
+  void *allocSlow(const size_t size, const size_t alignment);
+  static Chunk *newChunk(const size_t size, Chunk *pNext);
+  void useChunk(Chunk *pChunk);
+
+  size_t m_chunkSize;
+  Chunk *m_pFirst;
+  Chunk *m_pCurrent;
+  u8 *m_pPos;
+  u8 *m_pEnd;
+};
+
+/**
+ * STL allocator drawing from an {@link Arena}. Deallocation is a no-op, so
+ * containers using it should be short lived, or sized up front.
+ */
+template < typename tType >
+class ArenaAllocator {
+  public:
+  typedef tType value_type;
+
+  ArenaAllocator(Arena &arena) : m_pArena(&arena) {}
+  template < typename tOther >
+  ArenaAllocator(const ArenaAllocator< tOther > &other)
+      : m_pArena(&other.arena()) {}
+
+  tType *allocate(const size_t count) {
+    return m_pArena->allocArray< tType >(count);
+  }
+  void deallocate(tType *, const size_t) {}
+
+  Arena &arena() const { return *m_pArena; }
+
+  private:
+  Arena *m_pArena;
+};
+
+template < typename tType, typename tOther >
+bool operator==(
+    const ArenaAllocator< tType > &lhs, const ArenaAllocator< tOther > &rhs);
+template < typename tType, typename tOther >
+bool operator!=(
+    const ArenaAllocator< tType > &lhs, const ArenaAllocator< tOther > &rhs);
+
+} // namespace memory
+} // namespace core
+
+#  include "arena.inl"
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef FISHY_ARENA_INL
+#define FISHY_ARENA_INL
+
+#include <new>
+
+namespace core {
+namespace memory {
+
+/**
+ *
+ */
+inline void *Arena::alloc(const size_t size, const size_t alignment) {
+  const intptr_t aligned = alignPtr((intptr_t) m_pPos, alignment);
+  if (aligned + (intptr_t) size <= (intptr_t) m_pEnd) {
+    m_pPos = (u8 *) aligned + size;
+    return (void *) aligned;
+  }
+  return allocSlow(size, alignment);
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline tType *Arena::allocArray(const size_t count) {
+  return (tType *) alloc(sizeof(tType) * count, alignof(tType));
+}
+
+/**
+ *
+ */
+template < typename tType, typename... tArgs >
+inline tType *Arena::make(tArgs &&... args) {
+  void *pStorage = alloc(sizeof(tType), alignof(tType));
+  return new (pStorage) tType(std::forward< tArgs >(args)...);
+}
+
+/**
+ *
+ */
+inline Arena::Marker Arena::mark() const {
+  Marker marker;
+  marker.m_pChunk = m_pCurrent;
+  marker.m_pPos = m_pPos;
+  return marker;
+}
+
+/**
+ *
+ */
+inline void Arena::rewind(const Marker &marker) {
+  m_pCurrent = marker.m_pChunk;
+  m_pPos = marker.m_pPos;
+  m_pEnd = m_pCurrent->end();
+}
+
+/**
+ *
+ */
+template < typename tType, typename tOther >
+inline bool operator==(
+    const ArenaAllocator< tType > &lhs, const ArenaAllocator< tOther > &rhs) {
+  return &lhs.arena() == &rhs.arena();
+}
+
+/**
+ *
+ */
+template < typename tType, typename tOther >
+inline bool operator!=(
+    const ArenaAllocator< tType > &lhs, const ArenaAllocator< tOther > &rhs) {
+  return !(lhs == rhs);
+}
+
+} // namespace memory
+} // namespace core
+
+#endif
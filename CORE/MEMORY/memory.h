@@ -4,6 +4,7 @@
 #ifndef FISHY_MEMORY_H
 #define FISHY_MEMORY_H
 
+#include <CORE/ARCH/atomics.h>
 #include <CORE/BASE/asserts.h>
 
 #include <stdint.h>
@@ -11,6 +12,11 @@
 namespace core {
 namespace memory {
 
+/**
+ * @see core::arch::CACHE_LINE_SIZE
+ */
+using core::arch::CACHE_LINE_SIZE;
+
 /**
  * @return true if the input pointer is aligned on a power of 2
  */
@@ -113,7 +113,8 @@ inline intptr_t getPtrFromAlignedHeader(intptr_t ptr) {
  *
  */
 inline void *allocAligned(size_t size, size_t alignment) {
-  const size_t actualSz = size + sizeof(intptr_t) + alignment * 2;
+  // Room for the header, plus at most alignment - 1 bytes of padding.
+  const size_t actualSz = size + sizeof(intptr_t) + alignment - 1;
   return (void *) alignPtrWithHeader((intptr_t) new u8[actualSz], alignment);
 }
 
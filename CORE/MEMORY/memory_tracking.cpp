@@ -0,0 +1,501 @@
+#include "memory_tracking.h"
+
+#include <CORE/ARCH/atomics.h>
+#include <CORE/BASE/appstats.h>
+#include <CORE/MEMORY/memory.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace core {
+namespace memory {
+
+/**
+ *
+ */
+const char *eMemoryTag::enumNames[eMemoryTag::COUNT] = {
+    "UNTAGGED",
+    "VFS",
+    "NET",
+    "LOG",
+    "PROTO",
+    "PARSER",
+};
+
+/**
+ * Names of the {@link AppInfo} each tag is published as.
+ */
+static const char *const MEMORY_INFO_NAMES[eMemoryTag::COUNT] = {
+    "memory_untagged",
+    "memory_vfs",
+    "memory_net",
+    "memory_log",
+    "memory_proto",
+    "memory_parser",
+};
+
+/**
+ *
+ */
+core::config::Flag< bool > g_trackAllocations(
+    "track_allocations",
+    "Count heap usage per memory tag in operator new and delete, in builds "
+    "with FISHY_MEMORY_TRACKING_HOOKS.",
+    false);
+
+/**
+ * Running totals of a tag, only written by the thread owning them.
+ */
+struct TagCounters {
+  core::arch::OwnedCounter< u64 > m_allocs;
+  core::arch::OwnedCounter< u64 > m_frees;
+  core::arch::OwnedCounter< u64 > m_allocBytes;
+  core::arch::OwnedCounter< u64 > m_freeBytes;
+};
+
+/**
+ * Counters of one thread. They are never freed, so totals of exited threads
+ * still count, and readers may walk the list without locks.
+ */
+struct ThreadMemoryCounters {
+  ThreadMemoryCounters() : m_pNext(NULL) {}
+
+  TagCounters m_tags[eMemoryTag::COUNT];
+  ThreadMemoryCounters *m_pNext;
+};
+
+/**
+ * Header in front of memory from {@link allocAlignedTagged}.
+ */
+struct TaggedHeader {
+  void *m_pBase;
+  size_t m_size;
+  u32 m_tag;
+};
+
+// Constant initialized, as they are used by operator new during static
+// initialization.
+static std::atomic< ThreadMemoryCounters * > s_pAllCounters(NULL);
+static std::atomic< s64 > s_peakBytes[eMemoryTag::COUNT];
+
+// Plain thread locals, as operator new may be called while a thread is
+// created or torn down.
+static thread_local ThreadMemoryCounters *s_pThreadCounters = NULL;
+static thread_local eMemoryTag::type s_currentTag = eMemoryTag::UNTAGGED;
+
+/**
+ * @return the calling thread's counters. Created with malloc, as they may be
+ *     needed from within operator new.
+ */
+static ThreadMemoryCounters &GetThreadCounters() {
+  if (s_pThreadCounters == NULL) {
+    void *pMem = malloc(sizeof(ThreadMemoryCounters));
+    if (pMem == NULL) {
+      throw std::bad_alloc();
+    }
+    ThreadMemoryCounters *pCounters = new (pMem) ThreadMemoryCounters();
+    ThreadMemoryCounters *pHead = s_pAllCounters.load();
+    do {
+      pCounters->m_pNext = pHead;
+    } while (!s_pAllCounters.compare_exchange_weak(pHead, pCounters));
+    s_pThreadCounters = pCounters;
+  }
+  return *s_pThreadCounters;
+}
+
+/**
+ *
+ */
+ScopedMemoryTag::ScopedMemoryTag(const eMemoryTag::type tag)
+    : m_previous(s_currentTag) {
+  s_currentTag = tag;
+}
+
+/**
+ *
+ */
+ScopedMemoryTag::~ScopedMemoryTag() {
+  s_currentTag = m_previous;
+}
+
+/**
+ *
+ */
+eMemoryTag::type getMemoryTag() {
+  return s_currentTag;
+}
+
+/**
+ *
+ */
+void trackAlloc(const eMemoryTag::type tag, const size_t size) {
+  ASSERT(tag >= 0 && tag < eMemoryTag::COUNT);
+  TagCounters &counters = GetThreadCounters().m_tags[tag];
+  counters.m_allocs.add(1);
+  counters.m_allocBytes.add(size);
+}
+
+/**
+ * Counted by the freeing thread, so another thread's allocations may be freed
+ * without sharing its counters.
+ */
+void trackFree(const eMemoryTag::type tag, const size_t size) {
+  ASSERT(tag >= 0 && tag < eMemoryTag::COUNT);
+  TagCounters &counters = GetThreadCounters().m_tags[tag];
+  counters.m_frees.add(1);
+  counters.m_freeBytes.add(size);
+}
+
+/**
+ * Memory comes from malloc rather than {@link allocAligned}, which would be
+ * counted a second time by operator new.
+ */
+void *allocAlignedTagged(
+    const size_t size, const size_t alignment, const eMemoryTag::type tag) {
+  const size_t actualAlignment = std::max(alignment, alignof(TaggedHeader));
+  u8 *pBase =
+      (u8 *) malloc(size + sizeof(TaggedHeader) + actualAlignment - 1);
+  if (pBase == NULL) {
+    throw std::bad_alloc();
+  }
+
+  u8 *pRet = (u8 *) alignPtr(
+      (intptr_t) (pBase + sizeof(TaggedHeader)), actualAlignment);
+  TaggedHeader *pHeader = ((TaggedHeader *) pRet) - 1;
+  pHeader->m_pBase = pBase;
+  pHeader->m_size = size;
+  pHeader->m_tag = tag;
+
+  trackAlloc(tag, size);
+  return pRet;
+}
+
+/**
+ *
+ */
+void freeAlignedTagged(void *pPtr) {
+  if (pPtr == NULL) {
+    return;
+  }
+  TaggedHeader *pHeader = ((TaggedHeader *) pPtr) - 1;
+  trackFree((eMemoryTag::type) pHeader->m_tag, pHeader->m_size);
+  free(pHeader->m_pBase);
+}
+
+/**
+ *
+ */
+MemoryTagStats getMemoryTagStats(const eMemoryTag::type tag) {
+  ASSERT(tag >= 0 && tag < eMemoryTag::COUNT);
+  u64 allocBytes = 0;
+  u64 freeBytes = 0;
+  MemoryTagStats ret;
+  for (ThreadMemoryCounters *pCounters = s_pAllCounters.load();
+       pCounters != NULL;
+       pCounters = pCounters->m_pNext) {
+    const TagCounters &counters = pCounters->m_tags[tag];
+    ret.m_allocs += counters.m_allocs.get();
+    ret.m_frees += counters.m_frees.get();
+    allocBytes += counters.m_allocBytes.get();
+    freeBytes += counters.m_freeBytes.get();
+  }
+  ret.m_liveBytes = (s64) (allocBytes - freeBytes);
+
+  s64 peak = s_peakBytes[tag].load(std::memory_order_relaxed);
+  while (ret.m_liveBytes > peak
+         && !s_peakBytes[tag].compare_exchange_weak(peak, ret.m_liveBytes)) {
+  }
+  ret.m_peakBytes = std::max(peak, ret.m_liveBytes);
+  return ret;
+}
+
+/**
+ *
+ */
+void publishMemoryStats() {
+  for (u32 i = 0; i < eMemoryTag::COUNT; ++i) {
+    const MemoryTagStats stats = getMemoryTagStats((eMemoryTag::type) i);
+    char buffer[128];
+    snprintf(
+        buffer,
+        sizeof(buffer),
+        "live=%lld peak=%lld allocs=%llu frees=%llu",
+        (long long) stats.m_liveBytes,
+        (long long) stats.m_peakBytes,
+        (unsigned long long) stats.m_allocs,
+        (unsigned long long) stats.m_frees);
+    AppInfo(MEMORY_INFO_NAMES[i]).set(buffer);
+  }
+}
+
+#if MEMORY_TRACKING_HOOKS
+
+/**
+ * Header in front of memory from operator new. Keeps the user pointer
+ * aligned as malloc's.
+ */
+struct NewHeader {
+  size_t m_size;
+  u32 m_tag;
+  u32 m_tracked;
+};
+static_assert(
+    sizeof(NewHeader) % alignof(std::max_align_t) == 0,
+    "NewHeader must keep allocations aligned");
+
+/**
+ * Every allocation records if it was counted, so flipping the flag at
+ * runtime never frees bytes that were not allocated.
+ */
+static void *TrackedNew(const size_t size) {
+  if (size > SIZE_MAX - sizeof(NewHeader)) {
+    return NULL;
+  }
+  NewHeader *pHeader = (NewHeader *) malloc(sizeof(NewHeader) + size);
+  if (pHeader == NULL) {
+    return NULL;
+  }
+  pHeader->m_size = size;
+  pHeader->m_tag = s_currentTag;
+  pHeader->m_tracked = g_trackAllocations.get() ? 1 : 0;
+  if (pHeader->m_tracked) {
+    trackAlloc(s_currentTag, size);
+  }
+  return pHeader + 1;
+}
+
+/**
+ *
+ */
+static void TrackedDelete(void *pPtr) {
+  if (pPtr == NULL) {
+    return;
+  }
+  NewHeader *pHeader = ((NewHeader *) pPtr) - 1;
+  if (pHeader->m_tracked) {
+    trackFree((eMemoryTag::type) pHeader->m_tag, pHeader->m_size);
+  }
+  free(pHeader);
+}
+
+/**
+ * Header in front of memory from the aligned forms of operator new, placed
+ * directly before the user pointer as with {@link TaggedHeader}.
+ */
+struct AlignedNewHeader {
+  void *m_pBase;
+  size_t m_size;
+  u32 m_tag;
+  u32 m_tracked;
+};
+
+/**
+ * Over-aligned allocations, such as {@link core::arch::CacheAligned}, are
+ * counted like any other.
+ */
+static void *TrackedAlignedNew(const size_t size, const size_t alignment) {
+  const size_t actualAlignment =
+      std::max(alignment, alignof(AlignedNewHeader));
+  if (size > SIZE_MAX - sizeof(AlignedNewHeader) - actualAlignment) {
+    return NULL;
+  }
+  u8 *pBase =
+      (u8 *) malloc(size + sizeof(AlignedNewHeader) + actualAlignment - 1);
+  if (pBase == NULL) {
+    return NULL;
+  }
+
+  u8 *pRet = (u8 *) alignPtr(
+      (intptr_t) (pBase + sizeof(AlignedNewHeader)), actualAlignment);
+  AlignedNewHeader *pHeader = ((AlignedNewHeader *) pRet) - 1;
+  pHeader->m_pBase = pBase;
+  pHeader->m_size = size;
+  pHeader->m_tag = s_currentTag;
+  pHeader->m_tracked = g_trackAllocations.get() ? 1 : 0;
+  if (pHeader->m_tracked) {
+    trackAlloc(s_currentTag, size);
+  }
+  return pRet;
+}
+
+/**
+ *
+ */
+static void TrackedAlignedDelete(void *pPtr) {
+  if (pPtr == NULL) {
+    return;
+  }
+  AlignedNewHeader *pHeader = ((AlignedNewHeader *) pPtr) - 1;
+  if (pHeader->m_tracked) {
+    trackFree((eMemoryTag::type) pHeader->m_tag, pHeader->m_size);
+  }
+  free(pHeader->m_pBase);
+}
+
+#endif
+
+} // namespace memory
+} // namespace core
+
+#if MEMORY_TRACKING_HOOKS
+
+/**
+ *
+ */
+void *operator new(size_t size) {
+  void *pRet = core::memory::TrackedNew(size);
+  if (pRet == NULL) {
+    throw std::bad_alloc();
+  }
+  return pRet;
+}
+
+/**
+ *
+ */
+void *operator new[](size_t size) {
+  return operator new(size);
+}
+
+/**
+ *
+ */
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return core::memory::TrackedNew(size);
+}
+
+/**
+ *
+ */
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return core::memory::TrackedNew(size);
+}
+
+/**
+ *
+ */
+void operator delete(void *pPtr) noexcept {
+  core::memory::TrackedDelete(pPtr);
+}
+
+/**
+ *
+ */
+void operator delete[](void *pPtr) noexcept {
+  core::memory::TrackedDelete(pPtr);
+}
+
+/**
+ *
+ */
+void operator delete(void *pPtr, size_t) noexcept {
+  core::memory::TrackedDelete(pPtr);
+}
+
+/**
+ *
+ */
+void operator delete[](void *pPtr, size_t) noexcept {
+  core::memory::TrackedDelete(pPtr);
+}
+
+/**
+ *
+ */
+void operator delete(void *pPtr, const std::nothrow_t &) noexcept {
+  core::memory::TrackedDelete(pPtr);
+}
+
+/**
+ *
+ */
+void operator delete[](void *pPtr, const std::nothrow_t &) noexcept {
+  core::memory::TrackedDelete(pPtr);
+}
+
+/**
+ *
+ */
+void *operator new(size_t size, std::align_val_t alignment) {
+  void *pRet = core::memory::TrackedAlignedNew(size, (size_t) alignment);
+  if (pRet == NULL) {
+    throw std::bad_alloc();
+  }
+  return pRet;
+}
+
+/**
+ *
+ */
+void *operator new[](size_t size, std::align_val_t alignment) {
+  return operator new(size, alignment);
+}
+
+/**
+ *
+ */
+void *operator new(
+    size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+  return core::memory::TrackedAlignedNew(size, (size_t) alignment);
+}
+
+/**
+ *
+ */
+void *operator new[](
+    size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+  return core::memory::TrackedAlignedNew(size, (size_t) alignment);
+}
+
+/**
+ *
+ */
+void operator delete(void *pPtr, std::align_val_t) noexcept {
+  core::memory::TrackedAlignedDelete(pPtr);
+}
+
+/**
+ *
+ */
+void operator delete[](void *pPtr, std::align_val_t) noexcept {
+  core::memory::TrackedAlignedDelete(pPtr);
+}
+
+/**
+ *
+ */
+void operator delete(
+    void *pPtr, size_t, std::align_val_t) noexcept {
+  core::memory::TrackedAlignedDelete(pPtr);
+}
+
+/**
+ *
+ */
+void operator delete[](
+    void *pPtr, size_t, std::align_val_t) noexcept {
+  core::memory::TrackedAlignedDelete(pPtr);
+}
+
+/**
+ *
+ */
+void operator delete(
+    void *pPtr, std::align_val_t, const std::nothrow_t &) noexcept {
+  core::memory::TrackedAlignedDelete(pPtr);
+}
+
+/**
+ *
+ */
+void operator delete[](
+    void *pPtr, std::align_val_t, const std::nothrow_t &) noexcept {
+  core::memory::TrackedAlignedDelete(pPtr);
+}
+
+#endif
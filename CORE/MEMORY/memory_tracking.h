@@ -0,0 +1,126 @@
+/**
+ * Per subsystem accounting of heap usage.
+ */
+#ifndef FISHY_MEMORY_TRACKING_H
+#define FISHY_MEMORY_TRACKING_H
+
+#include <CORE/BASE/config.h>
+#include <CORE/UTIL/noncopyable.h>
+#include <CORE/types.h>
+
+#include <stddef.h>
+
+/**
+ * Replace the global operator new and delete with versions which attribute
+ * allocations to the current {@link eMemoryTag}. The replacements add a small
+ * header to every allocation, and clash with other allocator replacements
+ * such as AddressSanitizer's, so are off unless the build opts in with the
+ * FISHY_MEMORY_TRACKING_HOOKS CMake option. Builds that do then count only
+ * while the {@code track_allocations} flag is set.
+ */
+#ifndef MEMORY_TRACKING_HOOKS
+#  define MEMORY_TRACKING_HOOKS 0
+#endif
+
+namespace core {
+namespace memory {
+
+/**
+ * Subsystems heap usage is attributed to.
+ */
+struct eMemoryTag {
+  enum type {
+    UNTAGGED,
+    VFS,
+    NET,
+    LOG,
+    PROTO,
+    PARSER,
+    COUNT
+  };
+  static const char *enumNames[COUNT];
+};
+
+/**
+ * Set to count every global operator new and delete against the current tag.
+ */
+extern core::config::Flag< bool > g_trackAllocations;
+
+/**
+ * Snapshot of the usage of a tag.
+ */
+struct MemoryTagStats {
+  MemoryTagStats()
+      : m_liveBytes(0), m_peakBytes(0), m_allocs(0), m_frees(0) {}
+
+  s64 m_liveBytes;
+
+  // Highest live byte count seen by {@link getMemoryTagStats}, rather than
+  // by every allocation.
+  s64 m_peakBytes;
+
+  u64 m_allocs;
+  u64 m_frees;
+};
+
+/**
+ * Attributes allocations on the current thread to a tag for its lifetime,
+ * restoring the previous tag when it goes out of scope.
+ */
+class ScopedMemoryTag : util::noncopyable {
+  public:
+  explicit ScopedMemoryTag(const eMemoryTag::type tag);
+  ~ScopedMemoryTag();
+
+  private:
+  const eMemoryTag::type m_previous;
+};
+
+/**
+ * @return the tag allocations on the current thread are attributed to
+ */
+eMemoryTag::type getMemoryTag();
+
+/**
+ * Count {@code size} bytes allocated against {@code tag}, for allocators
+ * which do not go through the tracked routines. Only touches counters owned
+ * by the calling thread.
+ */
+void trackAlloc(const eMemoryTag::type tag, const size_t size);
+
+/**
+ * Count {@code size} bytes freed against {@code tag}, from any thread.
+ * @see trackAlloc
+ */
+void trackFree(const eMemoryTag::type tag, const size_t size);
+
+/**
+ * {@link allocAligned}, counted against {@code tag}.
+ *
+ * @return an aligned pointer with at least {@code size} storage
+ * @see freeAlignedTagged
+ */
+void *allocAlignedTagged(
+    const size_t size, const size_t alignment, const eMemoryTag::type tag);
+
+/**
+ * @param pPtr pointer to free, must have been created with {@link
+ *     allocAlignedTagged}. Counted against the tag it was allocated with.
+ */
+void freeAlignedTagged(void *pPtr);
+
+/**
+ * Sum the counters of every thread for {@code tag}. Counters are read
+ * without synchronization, so the result may be slightly stale.
+ */
+MemoryTagStats getMemoryTagStats(const eMemoryTag::type tag);
+
+/**
+ * Refresh the {@link AppInfo} of each tag, named {@code memory_<tag>}.
+ */
+void publishMemoryStats();
+
+} // namespace memory
+} // namespace core
+
+#endif
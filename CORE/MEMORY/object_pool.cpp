@@ -0,0 +1,329 @@
+#include "object_pool.h"
+
+#include <CORE/BASE/checks.h>
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+namespace core {
+namespace memory {
+
+/**
+ * Free slots each thread caches per pool.
+ */
+static const u32 MAGAZINE_SIZE = 32;
+
+/**
+ * Pools each thread caches slots for at once.
+ */
+static const u32 THREAD_CACHE_POOLS = 8;
+
+/**
+ * Source of pool ids. Ids are never reused, so a thread cache can not mistake
+ * a new pool for a destroyed one at the same address.
+ */
+static std::atomic< u64 > s_nextPoolId(1);
+
+/**
+ *
+ */
+static std::mutex &GetRegistryMutex() {
+  static std::mutex s_mutex;
+  return s_mutex;
+}
+
+/**
+ * Live pools by id, so thread caches only return slots to pools that exist.
+ */
+static std::unordered_map< u64, SlotPool * > &GetRegistry() {
+  static std::unordered_map< u64, SlotPool * > s_registry;
+  return s_registry;
+}
+
+/**
+ * @return the concatenated name, kept for the life of the program, as
+ *     {@link AppStat} holds on to its name
+ */
+static const char *InternStatName(const char *pPrefix, const char *pSuffix) {
+  static std::mutex s_mutex;
+  static std::set< std::string > s_names;
+  std::lock_guard< std::mutex > lock(s_mutex);
+  return s_names.insert(std::string(pPrefix) + pSuffix).first->c_str();
+}
+
+/**
+ * Set once the current thread's {@link PoolThreadCache} is destroyed. Being
+ * trivially destructible, it stays readable while the thread, or the
+ * program, finishes exiting.
+ */
+static thread_local bool s_threadCacheDestroyed = false;
+
+/**
+ * The current thread's magazines of free slots, for a few pools.
+ */
+class PoolThreadCache {
+  public:
+  PoolThreadCache() : m_nextEvict(0) {
+    for (u32 i = 0; i < THREAD_CACHE_POOLS; ++i) {
+      m_magazines[i].m_poolId = 0;
+      m_magazines[i].m_count = 0;
+    }
+  }
+
+  /**
+   * Return every cached slot at thread exit. Slots allocated or freed later,
+   * such as by static destructors on the main thread, go straight to their
+   * pool.
+   */
+  ~PoolThreadCache() {
+    for (u32 i = 0; i < THREAD_CACHE_POOLS; ++i) {
+      flush(m_magazines[i]);
+    }
+    s_threadCacheDestroyed = true;
+  }
+
+  /**
+   *
+   */
+  void *alloc(SlotPool &pool) {
+    Magazine &magazine = get(pool);
+    if (magazine.m_count == 0) {
+      pool.refill(magazine.m_slots, magazine.m_count, MAGAZINE_SIZE / 2);
+    }
+    return magazine.m_slots[--magazine.m_count];
+  }
+
+  /**
+   *
+   */
+  void free(SlotPool &pool, void *pSlot) {
+    Magazine &magazine = get(pool);
+    if (magazine.m_count == MAGAZINE_SIZE) {
+      // Keep half, so alternating frees and allocs do not bounce.
+      pool.spill(magazine.m_slots + MAGAZINE_SIZE / 2, MAGAZINE_SIZE / 2);
+      magazine.m_count = MAGAZINE_SIZE / 2;
+    }
+    magazine.m_slots[magazine.m_count++] = pSlot;
+  }
+
+  private:
+  struct Magazine {
+    u64 m_poolId;
+    u32 m_count;
+    void *m_slots[MAGAZINE_SIZE];
+  };
+
+  /**
+   * @return the magazine for {@code pool}, evicting another pool's if needed
+   */
+  Magazine &get(SlotPool &pool) {
+    Magazine *pEmpty = NULL;
+    for (u32 i = 0; i < THREAD_CACHE_POOLS; ++i) {
+      if (m_magazines[i].m_poolId == pool.m_id) {
+        return m_magazines[i];
+      }
+      if (pEmpty == NULL && m_magazines[i].m_count == 0) {
+        pEmpty = &m_magazines[i];
+      }
+    }
+    if (pEmpty == NULL) {
+      pEmpty = &m_magazines[m_nextEvict];
+      m_nextEvict = (m_nextEvict + 1) % THREAD_CACHE_POOLS;
+      flush(*pEmpty);
+    }
+    pEmpty->m_poolId = pool.m_id;
+    return *pEmpty;
+  }
+
+  /**
+   * Return the slots in {@code magazine} to their pool, if it still exists.
+   */
+  void flush(Magazine &magazine) {
+    if (magazine.m_count > 0) {
+      std::lock_guard< std::mutex > lock(GetRegistryMutex());
+      std::unordered_map< u64, SlotPool * >::iterator itr =
+          GetRegistry().find(magazine.m_poolId);
+      if (itr != GetRegistry().end()) {
+        itr->second->spill(magazine.m_slots, magazine.m_count);
+      }
+    }
+    magazine.m_poolId = 0;
+    magazine.m_count = 0;
+  }
+
+  Magazine m_magazines[THREAD_CACHE_POOLS];
+  u32 m_nextEvict;
+};
+
+static thread_local PoolThreadCache s_threadCache;
+
+/**
+ *
+ */
+SlotPool::SlotPool(
+    const char *pStatName,
+    const size_t slotSize,
+    const size_t slotAlignment,
+    const size_t slotsPerSlab,
+    const bool trackStats)
+    : m_id(s_nextPoolId.fetch_add(1)),
+      // Free slots hold the free list link.
+      m_slotSize(alignPtr(
+          (intptr_t) std::max(slotSize, sizeof(FreeSlot)),
+          std::max(slotAlignment, alignof(FreeSlot)))),
+      m_slotAlignment(std::max(slotAlignment, alignof(FreeSlot))),
+      m_slotsPerSlab(slotsPerSlab),
+      m_trackStats(trackStats),
+      m_publishStats(pStatName != NULL),
+      m_pFree(NULL),
+      m_live(0),
+      m_highWater(0) {
+  CHECK_M(slotsPerSlab > 0, "Bad pool slab size");
+  if (m_publishStats) {
+    m_slabsStat = AppStat(InternStatName(pStatName, "_slabs"));
+    if (m_trackStats) {
+      m_liveStat = AppStat(InternStatName(pStatName, "_live"));
+      m_highWaterStat = AppStat(InternStatName(pStatName, "_high_water"));
+    }
+  }
+
+  std::lock_guard< std::mutex > lock(GetRegistryMutex());
+  GetRegistry()[m_id] = this;
+}
+
+/**
+ *
+ */
+SlotPool::~SlotPool() {
+  {
+    // Cached slots of other threads are dropped from here on.
+    std::lock_guard< std::mutex > lock(GetRegistryMutex());
+    GetRegistry().erase(m_id);
+  }
+  for (size_t i = 0; i < m_slabs.size(); ++i) {
+    freeAligned(m_slabs[i]);
+  }
+}
+
+/**
+ *
+ */
+void *SlotPool::alloc() {
+  if (m_trackStats) {
+    countAlloc();
+  }
+  if (s_threadCacheDestroyed) {
+    void *pSlot = NULL;
+    u32 count = 0;
+    refill(&pSlot, count, 1);
+    return pSlot;
+  }
+  return s_threadCache.alloc(*this);
+}
+
+/**
+ *
+ */
+void SlotPool::free(void *pSlot) {
+  if (m_trackStats) {
+    countFree();
+  }
+  if (s_threadCacheDestroyed) {
+    spill(&pSlot, 1);
+    return;
+  }
+  s_threadCache.free(*this, pSlot);
+}
+
+/**
+ *
+ */
+ObjectPoolStats SlotPool::stats() const {
+  ObjectPoolStats ret;
+  ret.m_live = m_live.load(std::memory_order_relaxed);
+  ret.m_highWater = m_highWater.load(std::memory_order_relaxed);
+  std::lock_guard< std::mutex > lock(m_mutex);
+  ret.m_slabs = (u32) m_slabs.size();
+  return ret;
+}
+
+/**
+ *
+ */
+void SlotPool::refill(void **ppSlots, u32 &count, const u32 wanted) {
+  std::lock_guard< std::mutex > lock(m_mutex);
+  while (count < wanted) {
+    if (m_pFree == NULL) {
+      allocSlab();
+    }
+    ppSlots[count++] = m_pFree;
+    m_pFree = m_pFree->m_pNext;
+  }
+}
+
+/**
+ *
+ */
+void SlotPool::spill(void *const *ppSlots, const u32 count) {
+  std::lock_guard< std::mutex > lock(m_mutex);
+  for (u32 i = 0; i < count; ++i) {
+    FreeSlot *pSlot = (FreeSlot *) ppSlots[i];
+    pSlot->m_pNext = m_pFree;
+    m_pFree = pSlot;
+  }
+}
+
+/**
+ * Called with the pool lock held.
+ */
+void SlotPool::allocSlab() {
+  u8 *pSlab =
+      (u8 *) allocAligned(m_slotSize * m_slotsPerSlab, m_slotAlignment);
+  m_slabs.push_back(pSlab);
+  if (m_publishStats) {
+    m_slabsStat.increment();
+  }
+
+  // Link back to front, so slots are handed out in address order.
+  for (size_t i = m_slotsPerSlab; i > 0; --i) {
+    FreeSlot *pSlot = (FreeSlot *) (pSlab + (i - 1) * m_slotSize);
+    pSlot->m_pNext = m_pFree;
+    m_pFree = pSlot;
+  }
+}
+
+/**
+ *
+ */
+void SlotPool::countAlloc() {
+  const u64 live = m_live.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (m_publishStats) {
+    m_liveStat.increment();
+  }
+  u64 highWater = m_highWater.load(std::memory_order_relaxed);
+  while (live > highWater) {
+    if (m_highWater.compare_exchange_weak(
+            highWater, live, std::memory_order_relaxed)) {
+      // Each raise adds only its own step, so the stat sums to the peak.
+      if (m_publishStats) {
+        m_highWaterStat.increment((u32) (live - highWater));
+      }
+      break;
+    }
+  }
+}
+
+/**
+ *
+ */
+void SlotPool::countFree() {
+  m_live.fetch_sub(1, std::memory_order_relaxed);
+  if (m_publishStats) {
+    m_liveStat.decrement();
+  }
+}
+
+} // namespace memory
+} // namespace core
@@ -0,0 +1,173 @@
+/**
+ * Fixed size object pools, with per-thread caches.
+ */
+#ifndef FISHY_OBJECT_POOL_H
+#define FISHY_OBJECT_POOL_H
+
+#include <CORE/ARCH/platform.h>
+#include <CORE/BASE/appstats.h>
+#include <CORE/MEMORY/memory.h>
+#include <CORE/UTIL/noncopyable.h>
+#include <CORE/types.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+/**
+ * Pools track live and high-water counts by default only in debug builds.
+ */
+#ifndef OBJECT_POOL_STATS
+#  define OBJECT_POOL_STATS FISHY_DEBUG
+#endif
+
+namespace core {
+namespace memory {
+
+/**
+ * Default number of objects in each slab a pool allocates.
+ */
+static const size_t DEFAULT_POOL_SLAB_ITEMS = 256;
+
+/**
+ * Snapshot of a pool's usage.
+ */
+struct ObjectPoolStats {
+  ObjectPoolStats() : m_live(0), m_highWater(0), m_slabs(0) {}
+
+  // Only counted by pools tracking stats.
+  u64 m_live;
+  u64 m_highWater;
+
+  u32 m_slabs;
+};
+
+class PoolThreadCache;
+
+/**
+ * Untyped pool of fixed size slots, carved out of slabs that live as long as
+ * the pool.
+ *
+ * Each thread keeps a small magazine of free slots per pool, so most
+ * allocations and frees never touch shared state. Magazines refill from, and
+ * spill half their slots into, the pool's central free list under a lock.
+ * Slots may be freed from any thread, they simply join that thread's
+ * magazine.
+ */
+class SlotPool : util::noncopyable {
+  public:
+  /**
+   * @param pStatName prefix of the {@link AppStat}s the pool publishes, or
+   *     NULL to publish none
+   * @param slotSize bytes in each slot
+   * @param slotAlignment byte count of alignment of each slot
+   * @param slotsPerSlab slots allocated together from the heap
+   * @param trackStats count live slots and the high-water mark, at the cost
+   *     of a shared atomic on every allocation and free
+   */
+  SlotPool(
+      const char *pStatName,
+      const size_t slotSize,
+      const size_t slotAlignment,
+      const size_t slotsPerSlab,
+      const bool trackStats);
+
+  /**
+   * Frees every slab. Slots still in use become invalid.
+   */
+  ~SlotPool();
+
+  /**
+   * @return an uninitialized slot
+   */
+  void *alloc();
+
+  /**
+   * Return a slot from {@link #alloc} to the pool, from any thread.
+   */
+  void free(void *pSlot);
+
+  /**
+   * @return the current usage of the pool
+   */
+  ObjectPoolStats stats() const;
+
+  private:
+  friend class PoolThreadCache;
+
+  struct FreeSlot {
+    FreeSlot *m_pNext;
+  };
+
+  void refill(void **ppSlots, u32 &count, const u32 wanted);
+  void spill(void *const *ppSlots, const u32 count);
+  void allocSlab();
+  void countAlloc();
+  void countFree();
+
+  const u64 m_id;
+  const size_t m_slotSize;
+  const size_t m_slotAlignment;
+  const size_t m_slotsPerSlab;
+  const bool m_trackStats;
+  const bool m_publishStats;
+
+  mutable std::mutex m_mutex;
+  FreeSlot *m_pFree;
+  std::vector< void * > m_slabs;
+
+  std::atomic< u64 > m_live;
+  std::atomic< u64 > m_highWater;
+
+  AppStat m_slabsStat;
+  AppStat m_liveStat;
+  AppStat m_highWaterStat;
+};
+
+/**
+ * Pool of {@code tType} objects, constructed and destructed in place in the
+ * slots of a {@link SlotPool}.
+ */
+template < typename tType >
+class ObjectPool : util::noncopyable {
+  public:
+  /**
+   * @see SlotPool
+   */
+  explicit ObjectPool(
+      const char *pStatName = NULL,
+      const size_t slotsPerSlab = DEFAULT_POOL_SLAB_ITEMS,
+      const bool trackStats = OBJECT_POOL_STATS != 0);
+
+  /**
+   * @return a new default constructed object
+   */
+  tType *make();
+
+  /**
+   * @return a new object, constructed from {@code param}
+   */
+  template < typename tParamType >
+  tType *make(const tParamType &param);
+
+  /**
+   * Destruct an object from {@link #make}, and return it to the pool. May be
+   * called from any thread.
+   */
+  void release(tType *pObj);
+
+  /**
+   * @return the current usage of the pool
+   */
+  ObjectPoolStats stats() const { return m_slots.stats(); }
+
+  private:
+  SlotPool m_slots;
+};
+
+} // namespace memory
+} // namespace core
+
+#  include "object_pool.inl"
+
+#endif
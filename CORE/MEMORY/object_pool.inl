@@ -0,0 +1,52 @@
+#ifndef FISHY_OBJECT_POOL_INL
+#define FISHY_OBJECT_POOL_INL
+
+namespace core {
+namespace memory {
+
+/**
+ *
+ */
+template < typename tType >
+inline ObjectPool< tType >::ObjectPool(
+    const char *pStatName, const size_t slotsPerSlab, const bool trackStats)
+    : m_slots(
+          pStatName,
+          sizeof(tType),
+          alignof(tType),
+          slotsPerSlab,
+          trackStats) {
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline tType *ObjectPool< tType >::make() {
+  return construct((tType *) m_slots.alloc());
+}
+
+/**
+ *
+ */
+template < typename tType >
+template < typename tParamType >
+inline tType *ObjectPool< tType >::make(const tParamType &param) {
+  return construct((tType *) m_slots.alloc(), param);
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline void ObjectPool< tType >::release(tType *pObj) {
+  if (pObj == NULL) {
+    return;
+  }
+  m_slots.free(destruct(pObj));
+}
+
+} // namespace memory
+} // namespace core
+
+#endif
@@ -0,0 +1,242 @@
+#include "shared_buffer.h"
+
+#include <CORE/MEMORY/object_pool.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+namespace core {
+namespace memory {
+
+/**
+ * Pooled capacities of buffer storage. Larger buffers come from the heap.
+ */
+static const size_t SIZE_CLASSES[] = {64, 256, 1024, 4096, 16384, 65536};
+static const u32 SIZE_CLASS_COUNT =
+    sizeof(SIZE_CLASSES) / sizeof(SIZE_CLASSES[0]);
+static const char *const SIZE_CLASS_STATS[] = {
+    "shared_buffer_64",
+    "shared_buffer_256",
+    "shared_buffer_1k",
+    "shared_buffer_4k",
+    "shared_buffer_16k",
+    "shared_buffer_64k",
+};
+
+/**
+ * Bytes of storage allocated from the heap at once, per size class.
+ */
+static const size_t SLAB_BYTES = 256 * 1024;
+
+/**
+ * Create a pool per size class. Pools only allocate slabs once used.
+ */
+static SlotPool **CreateStoragePools(const size_t headerSize) {
+  SlotPool **ppPools = new SlotPool *[SIZE_CLASS_COUNT];
+  for (u32 i = 0; i < SIZE_CLASS_COUNT; ++i) {
+    const size_t slotSize = headerSize + SIZE_CLASSES[i];
+    ppPools[i] = new SlotPool(
+        SIZE_CLASS_STATS[i],
+        slotSize,
+        alignof(std::max_align_t),
+        std::max(SLAB_BYTES / slotSize, (size_t) 1),
+        OBJECT_POOL_STATS != 0);
+  }
+  return ppPools;
+}
+
+/**
+ *
+ */
+SharedBuffer::SharedBuffer() : m_pStorage(NULL), m_offset(0), m_size(0) {
+}
+
+/**
+ *
+ */
+SharedBuffer::SharedBuffer(
+    Storage *pStorage, const size_t offset, const size_t size)
+    : m_pStorage(pStorage), m_offset(offset), m_size(size) {
+  if (m_pStorage != NULL) {
+    m_pStorage->m_refs.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+/**
+ *
+ */
+SharedBuffer::SharedBuffer(const SharedBuffer &other)
+    : SharedBuffer(other.m_pStorage, other.m_offset, other.m_size) {
+}
+
+/**
+ *
+ */
+SharedBuffer::SharedBuffer(SharedBuffer &&other)
+    : m_pStorage(other.m_pStorage),
+      m_offset(other.m_offset),
+      m_size(other.m_size) {
+  other.m_pStorage = NULL;
+  other.m_offset = 0;
+  other.m_size = 0;
+}
+
+/**
+ *
+ */
+SharedBuffer::~SharedBuffer() {
+  release();
+}
+
+/**
+ *
+ */
+SharedBuffer &SharedBuffer::operator=(const SharedBuffer &other) {
+  if (other.m_pStorage != NULL) {
+    other.m_pStorage->m_refs.fetch_add(1, std::memory_order_relaxed);
+  }
+  release();
+  m_pStorage = other.m_pStorage;
+  m_offset = other.m_offset;
+  m_size = other.m_size;
+  return *this;
+}
+
+/**
+ *
+ */
+SharedBuffer &SharedBuffer::operator=(SharedBuffer &&other) {
+  if (this != &other) {
+    release();
+    m_pStorage = other.m_pStorage;
+    m_offset = other.m_offset;
+    m_size = other.m_size;
+    other.m_pStorage = NULL;
+    other.m_offset = 0;
+    other.m_size = 0;
+  }
+  return *this;
+}
+
+/**
+ * The pools are never destroyed, and once a thread's pool cache is gone its
+ * frees go straight to the pool, so buffers may be released by static
+ * destructors.
+ */
+SlotPool &SharedBuffer::GetStoragePool(const u32 sizeClass) {
+  static SlotPool **s_ppPools = CreateStoragePools(sizeof(Storage));
+  return *s_ppPools[sizeClass];
+}
+
+/**
+ *
+ */
+SharedBuffer SharedBuffer::allocate(const size_t size) {
+  if (size == 0) {
+    return SharedBuffer();
+  }
+
+  u32 sizeClass = 0;
+  while (sizeClass < SIZE_CLASS_COUNT && SIZE_CLASSES[sizeClass] < size) {
+    sizeClass++;
+  }
+
+  Storage *pStorage;
+  if (sizeClass < SIZE_CLASS_COUNT) {
+    pStorage = (Storage *) GetStoragePool(sizeClass).alloc();
+    pStorage->m_capacity = SIZE_CLASSES[sizeClass];
+  } else {
+    pStorage = (Storage *) allocAligned(
+        sizeof(Storage) + size, alignof(std::max_align_t));
+    pStorage->m_capacity = size;
+  }
+  pStorage->m_sizeClass = sizeClass;
+  new (&pStorage->m_refs) std::atomic< u32 >(0);
+  return SharedBuffer(pStorage, 0, size);
+}
+
+/**
+ *
+ */
+SharedBuffer SharedBuffer::copy(const ConstBlob &blob) {
+  SharedBuffer ret = allocate(blob.size());
+  if (!ret.empty()) {
+    memcpy(ret.m_pStorage->data(), blob.data(), blob.size());
+  }
+  return ret;
+}
+
+/**
+ *
+ */
+SharedBuffer
+SharedBuffer::slice(const size_t offset, const size_t size) const {
+  const size_t start = std::min(offset, m_size);
+  return SharedBuffer(
+      m_pStorage, m_offset + start, std::min(size, m_size - start));
+}
+
+/**
+ *
+ */
+const u8 *SharedBuffer::data() const {
+  return m_pStorage == NULL ? NULL : m_pStorage->data() + m_offset;
+}
+
+/**
+ *
+ */
+Blob SharedBuffer::writable() {
+  ASSERT(m_pStorage == NULL || unique());
+  return Blob(
+      m_pStorage == NULL ? NULL : m_pStorage->data() + m_offset, m_size);
+}
+
+/**
+ *
+ */
+bool SharedBuffer::unique() const {
+  return useCount() == 1;
+}
+
+/**
+ *
+ */
+u32 SharedBuffer::useCount() const {
+  if (m_pStorage == NULL) {
+    return 0;
+  }
+  return m_pStorage->m_refs.load(std::memory_order_acquire);
+}
+
+/**
+ *
+ */
+SharedBuffer::operator ConstBlob() const {
+  return ConstBlob(data(), m_size);
+}
+
+/**
+ *
+ */
+void SharedBuffer::release() {
+  if (m_pStorage == NULL) {
+    return;
+  }
+  if (m_pStorage->m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    const u32 sizeClass = m_pStorage->m_sizeClass;
+    if (sizeClass < SIZE_CLASS_COUNT) {
+      GetStoragePool(sizeClass).free(m_pStorage);
+    } else {
+      freeAligned(m_pStorage);
+    }
+  }
+  m_pStorage = NULL;
+  m_offset = 0;
+  m_size = 0;
+}
+
+} // namespace memory
+} // namespace core
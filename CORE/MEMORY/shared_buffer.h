@@ -0,0 +1,114 @@
+/**
+ * Reference counted, owning byte buffers.
+ */
+#ifndef FISHY_SHARED_BUFFER_H
+#define FISHY_SHARED_BUFFER_H
+
+#include <CORE/MEMORY/blob.h>
+#include <CORE/types.h>
+
+#include <atomic>
+
+namespace core {
+namespace memory {
+
+class SlotPool;
+
+/**
+ * Owning counterpart to {@link ConstBlob}. Copies and slices share one
+ * allocation through an intrusive reference count, which is freed when the
+ * last of them goes away, so data can be handed downstream without copying.
+ *
+ * Storage up to 64K is drawn from size class pools, so buffers on hot paths
+ * such as network receives do not churn the heap.
+ *
+ * The reference count is thread-safe, the bytes are not: fill a buffer while
+ * it is {@link #unique}, and treat it as read only once shared.
+ */
+class SharedBuffer {
+  public:
+  /**
+   * An empty buffer.
+   */
+  SharedBuffer();
+  SharedBuffer(const SharedBuffer &other);
+  SharedBuffer(SharedBuffer &&other);
+  ~SharedBuffer();
+
+  SharedBuffer &operator=(const SharedBuffer &other);
+  SharedBuffer &operator=(SharedBuffer &&other);
+
+  /**
+   * @return a new buffer of {@code size} uninitialized bytes
+   */
+  static SharedBuffer allocate(const size_t size);
+
+  /**
+   * @return a new buffer holding a copy of {@code blob}
+   */
+  static SharedBuffer copy(const ConstBlob &blob);
+
+  /**
+   * @return a buffer over {@code size} bytes from {@code offset}, sharing
+   *     this buffer's storage. Clamped to the end of this buffer.
+   */
+  SharedBuffer slice(const size_t offset, const size_t size) const;
+
+  /**
+   * Get a pointer to the contained data.
+   */
+  const u8 *data() const;
+
+  /**
+   * Get a writable view of the contained data. The buffer must not be
+   * shared.
+   */
+  Blob writable();
+
+  /**
+   * Return the size of the contained data.
+   */
+  size_t size() const { return m_size; }
+
+  /**
+   * @return if the buffer holds no data
+   */
+  bool empty() const { return m_size == 0; }
+
+  /**
+   * @return if no other buffer or slice shares this storage
+   */
+  bool unique() const;
+
+  /**
+   * @return the number of buffers and slices sharing this storage
+   */
+  u32 useCount() const;
+
+  /**
+   * Convert to a {@link ConstBlob}, valid while this buffer is alive.
+   */
+  operator ConstBlob() const;
+
+  private:
+  struct Storage {
+    std::atomic< u32 > m_refs;
+    u32 m_sizeClass;
+    size_t m_capacity;
+
+    u8 *data() { return (u8 *) (this + 1); }
+  };
+
+  SharedBuffer(Storage *pStorage, const size_t offset, const size_t size);
+  void release();
+  static SlotPool &GetStoragePool(const u32 sizeClass);
+
+  Storage *m_pStorage;
+  size_t m_offset;
+  size_t m_size;
+};
+
+} // namespace memory
+} // namespace core
+
+#endif
@@ -12,13 +12,18 @@
 #  include <cstdlib>
 #  include <netdb.h>
 #  include <netinet/in.h>
+#  include <poll.h>
+#  include <sys/eventfd.h>
 #  include <sys/socket.h>
 #  include <sys/types.h>
+#  include <sys/uio.h>
 #  include <unistd.h>
 #else
 #  error "networking not supported on this platform"
 #endif
 #include <algorithm>
+#include <cstring>
+#include <vector>
 
 using core::memory::Blob;
 using core::memory::ConstBlob;
@@ -61,6 +66,10 @@ static void closesocket(SOCKET &fd) {
 namespace core {
 namespace net {
 
+static const int BLOCKING_WAIT_MS = 1000;
+// Bytes an async stream client may have queued before further sends fail.
+static const size_t MAX_WRITE_QUEUE = 4 * 1024 * 1024;
+
 /**
  * Implementation of the {@link NetClient} logic for PLAT_WIN32
  */
@@ -70,16 +79,57 @@ class NetClient::Impl {
    *
    */
   Impl(const eConnectionMode::type mode)
-      : m_mode(mode), m_pThis(nullptr), m_socket(INVALID_SOCKET) {}
+      : m_mode(mode),
+        m_pThis(nullptr),
+        m_socket(INVALID_SOCKET),
+        m_waitMs(-1),
+        m_writeHead(0) {
+#if defined(PLAT_LINUX)
+    // Lives as long as the client, so wake() never races a reconnect.
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeFd == INVALID_SOCKET) {
+      Log(LL::Warning) << "Error <" << NetGetLastError()
+                       << "> creating client wake event.";
+    }
+#endif
+    if (m_mode == eConnectionMode::UDP_ASYNC
+        || m_mode == eConnectionMode::UDP_BLOCKING) {
+      m_buffers.resize(MAX_DATAGRAM_BATCH * MAX_PACKET_SIZE);
+      m_sizes.resize(MAX_DATAGRAM_BATCH);
+#if defined(PLAT_LINUX)
+      m_vecs.resize(MAX_DATAGRAM_BATCH);
+      m_headers.resize(MAX_DATAGRAM_BATCH);
+      for (size_t i = 0; i < MAX_DATAGRAM_BATCH; ++i) {
+        m_vecs[i].iov_base = &m_buffers[i * MAX_PACKET_SIZE];
+        m_vecs[i].iov_len = MAX_PACKET_SIZE;
+        memset(&m_headers[i], 0, sizeof(mmsghdr));
+        m_headers[i].msg_hdr.msg_iov = &m_vecs[i];
+        m_headers[i].msg_hdr.msg_iovlen = 1;
+      }
+#endif
+    }
+  }
 
-  ~Impl() { ASSERT(m_socket == INVALID_SOCKET); }
+  ~Impl() {
+    ASSERT(m_socket == INVALID_SOCKET);
+#if defined(PLAT_LINUX)
+    if (m_wakeFd != INVALID_SOCKET) {
+      closesocket(m_wakeFd);
+    }
+#endif
+  }
 
   /**
    *
    */
-  Status
-  start(NetClient *pThis, const std::string &remoteHost, const u32 port) {
+  Status start(
+      NetClient *pThis,
+      const std::string &remoteHost,
+      const u32 port,
+      const int waitMs) {
     m_pThis = pThis;
+    m_waitMs = waitMs;
+    m_pThis->m_counters.reset();
     struct addrinfo hints;
     memset(&hints, 0, sizeof(hints));
     hints.ai_family = AF_INET;
@@ -157,7 +207,7 @@ class NetClient::Impl {
 #endif
     }
 
-    m_pThis->m_stats.m_activeConnections = 1;
+    m_pThis->m_counters.setActiveConnections(1);
     Log(LL::Info) << "Connected to server: " << addrString;
     return Status::OK;
   }
@@ -166,37 +216,76 @@ class NetClient::Impl {
    *
    */
   Status readConnections(iClientConnectionHandler &handler) {
-    timeval selectTime = {0, 0};
-
-    switch (m_mode) {
-      case eConnectionMode::TCP_BLOCKING:
-      case eConnectionMode::UDP_BLOCKING: {
-        static const timeval waitTimer = {1, 0};
-        selectTime = waitTimer;
-        break;
+    int waitMs = m_waitMs;
+    if (waitMs < 0) {
+      waitMs = 0;
+      switch (m_mode) {
+        case eConnectionMode::TCP_BLOCKING:
+        case eConnectionMode::UDP_BLOCKING:
+          waitMs = BLOCKING_WAIT_MS;
+          break;
+        default:
+          break;
       }
     }
 
+#if defined(PLAT_LINUX)
+    pollfd fds[2];
+    memset(fds, 0, sizeof(fds));
+    fds[0].fd = m_socket;
+    fds[0].events = POLLIN | (m_writeQueue.empty() ? 0 : POLLOUT);
+    fds[1].fd = m_wakeFd;
+    fds[1].events = POLLIN;
+    const nfds_t fdCount = (m_wakeFd != INVALID_SOCKET) ? 2 : 1;
+
+    int ret = poll(fds, fdCount, waitMs);
+    if (ret == SOCKET_ERROR && NetGetLastError() == EINTR) {
+      return Status::OK;
+    }
+    if (ret > 0) {
+      if (fdCount > 1 && fds[1].revents != 0) {
+        u64 wakeCount;
+        while (read(m_wakeFd, &wakeCount, sizeof(wakeCount)) > 0) {
+        }
+      }
+      if ((fds[0].revents & POLLOUT) && !flushWrites()) {
+        Log(LL::Info) << "Connection error talking to server.";
+        stop(eCloseReason::FAILED);
+        return Status::OK;
+      }
+      if ((fds[0].revents & ~POLLOUT) == 0) {
+        return Status::OK;
+      }
+      ret = 1;
+    }
+#else
+    timeval selectTime = {waitMs / 1000, (waitMs % 1000) * 1000};
     fd_set fd;
     FD_ZERO(&fd);
     FD_SET(m_socket, &fd);
 
-    int ret = select(1, &fd, nullptr, nullptr, &selectTime);
-    if (ret == 1) {
+    int ret = select((int) m_socket + 1, &fd, nullptr, nullptr, &selectTime);
+#endif
+    if (ret == 1
+        && (m_mode == eConnectionMode::UDP_ASYNC
+            || m_mode == eConnectionMode::UDP_BLOCKING)) {
+      receiveDatagrams(handler);
+    } else if (ret == 1) {
       u8 buffer[MAX_PACKET_SIZE] = {0};
       Blob data(buffer, MAX_PACKET_SIZE);
       int ret = ::recv(m_socket, (char *) data.data(), MAX_PACKET_SIZE, 0);
+      m_pThis->m_counters.addRecvCall();
       if (ret > 0) {
-        m_pThis->m_stats.m_bytesRecieved += ret;
+        m_pThis->m_counters.addRecieved(ret);
         data.trimSize(ret);
-        handler.process(*m_pThis, data);
+        process(handler, data);
         handler.cleanup();
       } else if (ret == 0) {
         Log(LL::Info) << "Connection to server closed.";
-        stop();
+        stop(eCloseReason::REMOTE);
       } else {
         Log(LL::Info) << "Connection error talking to server.";
-        stop();
+        stop(eCloseReason::FAILED);
       }
     } else if (ret == 0) {
       return Status::TIMEOUT;
@@ -209,28 +298,163 @@ class NetClient::Impl {
   /**
    *
    */
-  Status send(const ConstBlob &data) {
-    char *pStart = (char *) data.data();
-    char *pEnd = pStart + data.size();
+  Status send(const ConstBlob *parts, const size_t count) {
+#if defined(PLAT_LINUX)
+    // Datagrams must go out whole, streams may be written piecemeal.
+    m_sendVecs.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      m_sendVecs[i].iov_base = (void *) parts[i].data();
+      m_sendVecs[i].iov_len = parts[i].size();
+    }
+    iovec *pVec = m_sendVecs.data();
+    iovec *pEnd = pVec + count;
+
+    // Async streams never block: whatever the socket will not take now, and
+    // anything sent behind it, is queued until the socket is writable.
+    const bool async = m_mode == eConnectionMode::TCP_ASYNC;
+    if (async && !m_writeQueue.empty()) {
+      return queueWrite(pVec, pEnd);
+    }
+    while (pVec != pEnd) {
+      if (pVec->iov_len == 0) {
+        ++pVec;
+        continue;
+      }
+      msghdr header;
+      memset(&header, 0, sizeof(header));
+      header.msg_iov = pVec;
+      header.msg_iovlen = std::distance(pVec, pEnd);
+      const ssize_t ret = ::sendmsg(
+          m_socket, &header, MSG_NOSIGNAL | (async ? MSG_DONTWAIT : 0));
+      if (ret == SOCKET_ERROR) {
+        m_pThis->m_counters.addSendCall(0, 0);
+        const int errorcode = NetGetLastError();
+        if (errorcode == EINTR) {
+          continue;
+        }
+        if (async && (errorcode == EWOULDBLOCK || errorcode == EAGAIN)) {
+          return queueWrite(pVec, pEnd);
+        }
+        return Status::GENERIC_ERROR;
+      }
+      m_pThis->m_counters.addSendCall(ret, 0);
+
+      size_t advance = ret;
+      while (advance > 0 && advance >= pVec->iov_len) {
+        advance -= pVec->iov_len;
+        ++pVec;
+      }
+      if (advance > 0) {
+        pVec->iov_base = (u8 *) pVec->iov_base + advance;
+        pVec->iov_len -= advance;
+      }
+    }
+    m_pThis->m_counters.addSent(0, 1);
+    return Status::OK;
+#else
+    std::vector< u8 > joined;
+    for (size_t i = 0; i < count; ++i) {
+      joined.insert(
+          joined.end(), parts[i].data(), parts[i].data() + parts[i].size());
+    }
+
+    char *pStart = (char *) joined.data();
+    char *pEnd = pStart + joined.size();
     while (pStart != pEnd) {
       const int sz = static_cast< int >(std::distance(pStart, pEnd));
       const int ret = ::send(m_socket, pStart, sz, 0);
       if (ret == SOCKET_ERROR) {
+        m_pThis->m_counters.addSendCall(0, 0);
         return Status::GENERIC_ERROR;
       }
       pStart += ret;
-      m_pThis->m_stats.m_bytesSent += ret;
+      m_pThis->m_counters.addSendCall(ret, 0);
     }
+    m_pThis->m_counters.addSent(0, 1);
     return Status::OK;
+#endif
+  }
+
+  /**
+   *
+   */
+  Status sendBatch(const ConstBlob *msgs, const size_t count) {
+    Status::eError result = Status::OK;
+#if defined(PLAT_LINUX)
+    if (m_mode == eConnectionMode::UDP_ASYNC
+        || m_mode == eConnectionMode::UDP_BLOCKING) {
+      mmsghdr headers[MAX_DATAGRAM_BATCH];
+      iovec vecs[MAX_DATAGRAM_BATCH];
+      for (size_t idx = 0; idx < count;) {
+        const unsigned pending = static_cast< unsigned >(
+            std::min(count - idx, MAX_DATAGRAM_BATCH));
+        for (unsigned i = 0; i < pending; ++i) {
+          vecs[i].iov_base = (void *) msgs[idx + i].data();
+          vecs[i].iov_len = msgs[idx + i].size();
+          memset(&headers[i], 0, sizeof(mmsghdr));
+          headers[i].msg_hdr.msg_iov = &vecs[i];
+          headers[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        unsigned sent = 0;
+        while (sent < pending) {
+          const int ret = sendmmsg(m_socket, &headers[sent], pending - sent, 0);
+          if (ret == SOCKET_ERROR) {
+            m_pThis->m_counters.addSendCall(0, 0);
+            if (NetGetLastError() == EINTR) {
+              continue;
+            }
+            // Skip the datagram that failed and carry on with the rest.
+            result = Status::GENERIC_ERROR;
+            sent++;
+            continue;
+          }
+          u64 bytes = 0;
+          for (int i = 0; i < ret; ++i) {
+            bytes += headers[sent + i].msg_len;
+          }
+          m_pThis->m_counters.addSendCall(bytes, ret);
+          sent += ret;
+        }
+        idx += pending;
+      }
+      return Status(result);
+    }
+#endif
+    for (size_t i = 0; i < count; ++i) {
+      Status ret = send(&msgs[i], 1);
+      if (!ret && result == Status::OK) {
+        result = ret.getStatus();
+      }
+    }
+    return Status(result);
   }
 
   /**
    *
    */
-  void stop() {
+  void stop(const eCloseReason::type reason) {
     Log(LL::Info) << "Closing connection to server.";
     closesocket(m_socket);
     m_socket = INVALID_SOCKET;
+    m_writeQueue.clear();
+    m_writeHead = 0;
+    m_pThis->m_counters.addClose(reason);
+    m_pThis->m_counters.setActiveConnections(0);
+  }
+
+  /**
+   *
+   */
+  void wake() {
+#if defined(PLAT_LINUX)
+    if (m_wakeFd != INVALID_SOCKET) {
+      const u64 one = 1;
+      if (write(m_wakeFd, &one, sizeof(one)) != sizeof(one)) {
+        // Only fails once the counter is huge, so a wake is already pending.
+      }
+    }
+#endif
   }
 
   /**
@@ -247,6 +471,141 @@ class NetClient::Impl {
   eConnectionMode::type m_mode;
   NetClient *m_pThis;
   SOCKET m_socket;
+  int m_waitMs;
+#if defined(PLAT_LINUX)
+  int m_wakeFd;
+#endif
+
+  // Stream data the socket would not take yet, written from m_writeHead on.
+  std::vector< u8 > m_writeQueue;
+  size_t m_writeHead;
+
+  // Reusable ring of receive buffers for batched datagram reads.
+  std::vector< u8 > m_buffers;
+  std::vector< size_t > m_sizes;
+#if defined(PLAT_LINUX)
+  std::vector< iovec > m_vecs;
+  std::vector< mmsghdr > m_headers;
+  std::vector< iovec > m_sendVecs;
+#endif
+
+#if defined(PLAT_LINUX)
+  /**
+   * Queue the unsent bytes of {@code pVec} up to {@code pEnd}, to be written
+   * once the socket is writable again.
+   */
+  Status queueWrite(const iovec *pVec, const iovec *pEnd) {
+    size_t total = 0;
+    for (const iovec *pItr = pVec; pItr != pEnd; ++pItr) {
+      total += pItr->iov_len;
+    }
+    // Messages are queued whole or not at all, so a refusal cannot tear one.
+    if (!m_writeQueue.empty()
+        && m_writeQueue.size() - m_writeHead + total > MAX_WRITE_QUEUE) {
+      Log(LL::Warning) << "Write queue to server full.";
+      return Status::OUT_OF_BOUNDS;
+    }
+
+    for (; pVec != pEnd; ++pVec) {
+      const u8 *pData = (const u8 *) pVec->iov_base;
+      m_writeQueue.insert(m_writeQueue.end(), pData, pData + pVec->iov_len);
+    }
+    m_pThis->m_counters.addSent(0, 1);
+    return Status::OK;
+  }
+
+  /**
+   * Write as much of the queued data as the socket will take.
+   *
+   * @return false if the connection failed
+   */
+  bool flushWrites() {
+    while (m_writeHead < m_writeQueue.size()) {
+      const ssize_t ret = ::send(
+          m_socket,
+          &m_writeQueue[m_writeHead],
+          m_writeQueue.size() - m_writeHead,
+          MSG_NOSIGNAL | MSG_DONTWAIT);
+      if (ret == SOCKET_ERROR) {
+        m_pThis->m_counters.addSendCall(0, 0);
+        const int errorcode = NetGetLastError();
+        if (errorcode == EINTR) {
+          continue;
+        }
+        if (errorcode != EWOULDBLOCK && errorcode != EAGAIN) {
+          return false;
+        }
+        break;
+      }
+      m_pThis->m_counters.addSendCall(ret, 0);
+      m_writeHead += ret;
+    }
+
+    if (m_writeHead == m_writeQueue.size()) {
+      m_writeQueue.clear();
+      m_writeHead = 0;
+    } else if (m_writeHead > m_writeQueue.size() / 2) {
+      m_writeQueue.erase(
+          m_writeQueue.begin(), m_writeQueue.begin() + m_writeHead);
+      m_writeHead = 0;
+    }
+    return true;
+  }
+#endif
+
+  /**
+   * Hand {@code data} to the handler, timing how long it takes.
+   */
+  void process(iClientConnectionHandler &handler, const ConstBlob &data) {
+    const u64 start = timer::GetTicks();
+    handler.process(*m_pThis, data);
+    m_pThis->m_counters.recordProcessTicks(timer::GetTicks() - start);
+  }
+
+  /**
+   * Read up to {@link MAX_DATAGRAM_BATCH} datagrams in one syscall, and hand
+   * them all to the handler.
+   */
+  void receiveDatagrams(iClientConnectionHandler &handler) {
+    size_t count = 0;
+#if defined(PLAT_LINUX)
+    int ret;
+    do {
+      ret = recvmmsg(
+          m_socket, &m_headers[0], MAX_DATAGRAM_BATCH, MSG_DONTWAIT, nullptr);
+      m_pThis->m_counters.addRecvCall();
+    } while (ret == SOCKET_ERROR && NetGetLastError() == EINTR);
+    if (ret == SOCKET_ERROR
+        && (NetGetLastError() == EWOULDBLOCK || NetGetLastError() == EAGAIN)) {
+      return;
+    }
+    if (ret != SOCKET_ERROR) {
+      count = static_cast< size_t >(ret);
+      for (size_t i = 0; i < count; ++i) {
+        m_sizes[i] = m_headers[i].msg_len;
+      }
+    }
+#else
+    const int ret =
+        ::recv(m_socket, (char *) &m_buffers[0], MAX_PACKET_SIZE, 0);
+    m_pThis->m_counters.addRecvCall();
+    if (ret != SOCKET_ERROR) {
+      count = 1;
+      m_sizes[0] = ret;
+    }
+#endif
+    if (ret == SOCKET_ERROR) {
+      Log(LL::Info) << "Connection error talking to server.";
+      stop(eCloseReason::FAILED);
+      return;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+      m_pThis->m_counters.addRecieved(m_sizes[i]);
+      process(handler, ConstBlob(&m_buffers[i * MAX_PACKET_SIZE], m_sizes[i]));
+    }
+    handler.cleanup();
+  }
 };
 
 /**
@@ -275,10 +634,10 @@ Status NetClient::start(const ClientDef &def) {
                  << def.m_port;
 
   CHECK_M(!def.m_dnsName.empty(), "ServerDef missing required field: dns_name");
-  CHECK_M(def.m_port == 0, "ServerDef missing required field: port");
+  CHECK_M(def.m_port != 0, "ServerDef missing required field: port");
 
   CHECK_M(core::net::IsInitialized(), "net::Initialize() must be called");
-  return m_pImpl->start(this, def.m_dnsName, def.m_port);
+  return m_pImpl->start(this, def.m_dnsName, def.m_port, def.m_waitMs);
 }
 
 /**
@@ -289,7 +648,7 @@ void NetClient::stop() {
     return;
   }
 
-  m_pImpl->stop();
+  m_pImpl->stop(eCloseReason::STOPPED);
 }
 
 /**
@@ -310,7 +669,34 @@ Status NetClient::send(const ConstBlob &data) {
     return Status::BAD_STATE;
   }
   ASSERT(data.size() < std::numeric_limits< int >::max());
-  return m_pImpl->send(data);
+  return m_pImpl->send(&data, 1);
+}
+
+/**
+ * Delegate to implementation
+ */
+Status NetClient::send(const ConstBlob *parts, const size_t count) {
+  if (!valid()) {
+    return Status::BAD_STATE;
+  }
+  return m_pImpl->send(parts, count);
+}
+
+/**
+ * Delegate to implementation
+ */
+Status NetClient::sendBatch(const ConstBlob *msgs, const size_t count) {
+  if (!valid()) {
+    return Status::BAD_STATE;
+  }
+  return m_pImpl->sendBatch(msgs, count);
+}
+
+/**
+ *
+ */
+NetStats NetClient::stats() const {
+  return m_counters.snapshot();
 }
 
 /**
@@ -320,5 +706,12 @@ eConnectionMode::type NetClient::getConnectionMode() const {
   return m_pImpl->getConnectionMode();
 }
 
+/**
+ * Delegate to implementation
+ */
+void NetClient::wake() {
+  m_pImpl->wake();
+}
+
 } // namespace net
 } // namespace core
@@ -5,6 +5,7 @@
 #define FISHY_NET_CLIENT_H
 
 #include "net_common.h"
+#include "net_stats.h"
 
 #include <CORE/BASE/status.h>
 #include <CORE/MEMORY/blob.h>
@@ -80,6 +81,28 @@ class iNetClient : public util::noncopyable {
    */
   virtual Status send(const core::memory::ConstBlob &msg) = 0;
 
+  /**
+   * Send a single message gathered from several parts, without first joining
+   * them into one buffer. Datagram modes send the parts as one datagram.
+   *
+   * @param parts pieces of the message, in order. Caller owns the blobs.
+   * @param count number of entries in {@code parts}
+   * @return true if all the data was successfully sent
+   */
+  virtual Status
+  send(const core::memory::ConstBlob *parts, const size_t count) = 0;
+
+  /**
+   * Send many messages to the server, coalesced into as few syscalls as the
+   * protocol allows.
+   *
+   * @param msgs messages to send. Caller owns the blobs.
+   * @param count number of messages in {@code msgs}
+   * @return OK if every message was sent, otherwise the first error seen.
+   */
+  virtual Status
+  sendBatch(const core::memory::ConstBlob *msgs, const size_t count) = 0;
+
   /**
    * @return statistics about the connection
    */
@@ -93,6 +116,10 @@ class iNetClient : public util::noncopyable {
 
 /**
  * Networking client
+ *
+ * TCP_ASYNC sends never block. Whatever the socket will not take is queued,
+ * and written by {@link #update} once the socket is writable; sends fail with
+ * OUT_OF_BOUNDS while too much is queued. Other modes block until sent.
  */
 class NetClient : public iNetClient {
   public:
@@ -107,13 +134,21 @@ class NetClient : public iNetClient {
   virtual Status update(iClientConnectionHandler &handler);
   virtual bool valid() const;
   virtual Status send(const memory::ConstBlob &msg);
-  virtual NetStats stats() const { return m_stats; }
+  virtual Status send(const memory::ConstBlob *parts, const size_t count);
+  virtual Status sendBatch(const memory::ConstBlob *msgs, const size_t count);
+  virtual NetStats stats() const;
   virtual eConnectionMode::type getConnectionMode() const;
 
+  /**
+   * Return an {@link #update} waiting for data on another thread early. Safe
+   * to call from any thread for the life of the client.
+   */
+  void wake();
+
   protected:
   class Impl;
   Impl *m_pImpl;
-  NetStats m_stats;
+  NetCounters m_counters;
 };
 
 } // namespace net
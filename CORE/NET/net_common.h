@@ -34,15 +34,19 @@ typedef u32 tConnectionId;
 static const tConnectionId INVALID_CONNECTION_ID = (tConnectionId) -1;
 
 /**
- * Basic status structure used by TCP/UDP client/servers.
+ * Sharded servers tag the top bits of every connection id with the index of
+ * the shard that owns the connection.
  */
-struct NetStats {
-  NetStats() : m_bytesSent(0), m_bytesRecieved(0), m_activeConnections(0) {}
+static const u32 CONNECTION_SHARD_BITS = 8;
+static const u32 CONNECTION_SHARD_SHIFT = 32 - CONNECTION_SHARD_BITS;
+static const u32 CONNECTION_LOCAL_MASK = (1u << CONNECTION_SHARD_SHIFT) - 1;
 
-  u64 m_bytesSent;
-  u64 m_bytesRecieved;
-  u32 m_activeConnections;
-};
+/**
+ * @return the index of the shard owning {@code connectionId}
+ */
+inline u32 GetConnectionShard(const tConnectionId connectionId) {
+  return connectionId >> CONNECTION_SHARD_SHIFT;
+}
 
 /**
  * Connection modes
@@ -51,38 +55,81 @@ struct eConnectionMode {
   enum type { TCP_ASYNC, TCP_BLOCKING, UDP_ASYNC, UDP_BLOCKING, COUNT };
 };
 
+/**
+ * Socket readiness backends for servers.
+ */
+struct eEventBackend {
+  enum type {
+    // Portable select() on every connection, every update.
+    SELECT,
+    // Edge-triggered epoll, only ready sockets are touched on update. Falls
+    // back to SELECT on platforms without epoll.
+    EPOLL,
+    COUNT
+  };
+};
+
 struct ServerDef {
   int m_port;
   int m_maxConnections;
   float m_connectionTimeoutSec;
-
-  ServerDef() : m_port(0), m_maxConnections(0), m_connectionTimeoutSec(60) {}
+  eEventBackend::type m_eventBackend;
+  // Allow several servers to bind the same port (SO_REUSEPORT), with the
+  // kernel balancing new connections between them.
+  bool m_reusePort;
+  // Longest an EPOLL backed update waits for socket activity or a wake, in
+  // milliseconds. Negative waits as the mode does by default: a second for
+  // blocking modes, not at all for async ones.
+  int m_waitMs;
+
+  ServerDef()
+      : m_port(0),
+        m_maxConnections(0),
+        m_connectionTimeoutSec(60),
+        m_eventBackend(eEventBackend::SELECT),
+        m_reusePort(false),
+        m_waitMs(-1) {}
   ServerDef(
       const int port,
       const int maxConnections,
-      const float connectionTimeoutSec)
+      const float connectionTimeoutSec,
+      const eEventBackend::type eventBackend = eEventBackend::SELECT)
       : m_port(port),
         m_maxConnections(maxConnections),
-        m_connectionTimeoutSec(connectionTimeoutSec) {}
+        m_connectionTimeoutSec(connectionTimeoutSec),
+        m_eventBackend(eventBackend),
+        m_reusePort(false),
+        m_waitMs(-1) {}
 };
 
 struct ClientDef {
   std::string m_dnsName;
   int m_port;
   float m_connectionTimeoutSec;
+  // Longest an update waits for data or a wake, in milliseconds. Negative
+  // waits as the mode does by default: a second for blocking modes, not at
+  // all for async ones.
+  int m_waitMs;
 
-  ClientDef() : m_port(0), m_connectionTimeoutSec(60) {}
+  ClientDef() : m_port(0), m_connectionTimeoutSec(60), m_waitMs(-1) {}
   ClientDef(
       const std::string &dnsName,
       const int port,
       const float connectionTimeoutSec)
       : m_dnsName(dnsName),
         m_port(port),
-        m_connectionTimeoutSec(connectionTimeoutSec) {}
+        m_connectionTimeoutSec(connectionTimeoutSec),
+        m_waitMs(-1) {}
 };
 
 static const size_t MAX_PACKET_SIZE = 8192;
 
+/**
+ * Maximum number of datagrams moved by a single batched receive or send
+ * syscall.
+ */
+static const size_t MAX_DATAGRAM_BATCH = 32;
+
 } // namespace net
 } // namespace core
 
@@ -0,0 +1,211 @@
+#include "net_framing.h"
+
+#include <CORE/BASE/logging.h>
+#include <CORE/BASE/serializer_podtypes.h>
+
+#include <algorithm>
+#include <cstring>
+
+using core::memory::Blob;
+using core::memory::ConstBlob;
+
+namespace core {
+namespace net {
+
+/**
+ * Smallest read the ring will offer, so a stream of small messages does not
+ * turn into a stream of small reads.
+ */
+static const size_t MIN_FRAME_READ = MAX_PACKET_SIZE;
+
+/**
+ *
+ */
+FrameBuffer::FrameBuffer(const size_t maxMessageSize)
+    : m_head(0),
+      m_tail(0),
+      m_pending(0),
+      m_headerSize(0),
+      m_maxMessageSize(maxMessageSize) {
+}
+
+/**
+ *
+ */
+Blob FrameBuffer::writable() {
+  if (m_head == m_tail) {
+    m_head = m_tail = 0;
+  }
+
+  const size_t used = m_tail - m_head;
+  const size_t want = std::max(used + MIN_FRAME_READ, m_pending);
+  if (m_head + want > m_data.size()) {
+    // Wrap: move the partial message back to the start of the ring.
+    if (m_head != 0) {
+      memmove(&m_data[0], &m_data[m_head], used);
+      m_head = 0;
+      m_tail = used;
+    }
+    if (want > m_data.size()) {
+      size_t capacity = std::max(m_data.size(), MIN_FRAME_READ);
+      while (capacity < want) {
+        capacity *= 2;
+      }
+      m_data.resize(capacity);
+    }
+  }
+  return Blob(&m_data[m_tail], m_data.size() - m_tail);
+}
+
+/**
+ *
+ */
+void FrameBuffer::commit(const size_t size) {
+  ASSERT(m_tail + size <= m_data.size());
+  m_tail += size;
+}
+
+/**
+ *
+ */
+void FrameBuffer::receive(const ConstBlob &data) {
+  if (m_tail < m_data.size() && data.data() == &m_data[m_tail]) {
+    commit(data.size());
+    return;
+  }
+
+  size_t offset = 0;
+  while (offset < data.size()) {
+    Blob space = writable();
+    const size_t sz = std::min(space.size(), data.size() - offset);
+    memcpy(space.data(), data.data() + offset, sz);
+    commit(sz);
+    offset += sz;
+  }
+}
+
+/**
+ *
+ */
+eFrameResult::type FrameBuffer::next(ConstBlob &message) {
+  const size_t used = m_tail - m_head;
+  if (used == 0) {
+    return eFrameResult::INCOMPLETE;
+  }
+  if (m_pending == 0) {
+    const ConstBlob header(
+        &m_data[m_head], std::min(used, MAX_FRAME_HEADER_SIZE));
+    core::base::ConstBlobSink sink(header);
+    VarUInt length;
+    sink >> length;
+    if (sink.fail()) {
+      return (header.size() < MAX_FRAME_HEADER_SIZE)
+                 ? eFrameResult::INCOMPLETE
+                 : eFrameResult::MALFORMED;
+    }
+    if (length.get() > m_maxMessageSize) {
+      Log(LL::Warning) << "Framed message of " << length.get()
+                       << " bytes exceeds the limit of " << m_maxMessageSize;
+      return eFrameResult::MALFORMED;
+    }
+    m_headerSize = header.size() - sink.avail();
+    m_pending = m_headerSize + (size_t) length.get();
+  }
+
+  if (used < m_pending) {
+    return eFrameResult::INCOMPLETE;
+  }
+
+  message =
+      ConstBlob(&m_data[m_head + m_headerSize], m_pending - m_headerSize);
+  m_head += m_pending;
+  m_pending = 0;
+  return eFrameResult::MESSAGE;
+}
+
+/**
+ *
+ */
+FramedConnectionHandler::FramedConnectionHandler(
+    iMessageHandler &handler, const size_t maxMessageSize)
+    : m_handler(handler), m_maxMessageSize(maxMessageSize) {
+}
+
+/**
+ *
+ */
+bool FramedConnectionHandler::process(
+    iNetServer &server,
+    const tConnectionId connectionId,
+    const ConstBlob &data) {
+  tFrameBufferMap::iterator itr = m_buffers.find(connectionId);
+  if (itr == m_buffers.end()) {
+    return false;
+  }
+
+  FrameBuffer &buffer = itr->second;
+  buffer.receive(data);
+  while (true) {
+    ConstBlob message;
+    switch (buffer.next(message)) {
+      case eFrameResult::INCOMPLETE:
+        return true;
+      case eFrameResult::MALFORMED:
+        Log(LL::Warning) << "Dropping badly framed connection "
+                         << connectionId;
+        return false;
+      case eFrameResult::MESSAGE:
+        if (!m_handler.process(server, connectionId, message)) {
+          return false;
+        }
+        break;
+    }
+  }
+}
+
+/**
+ *
+ */
+void FramedConnectionHandler::open(const tConnectionId connectionId) {
+  m_buffers.insert(
+      std::make_pair(connectionId, FrameBuffer(m_maxMessageSize)));
+  m_handler.open(connectionId);
+}
+
+/**
+ *
+ */
+void FramedConnectionHandler::close(const tConnectionId connectionId) {
+  m_buffers.erase(connectionId);
+  m_handler.close(connectionId);
+}
+
+/**
+ *
+ */
+Blob FramedConnectionHandler::readBuffer(const tConnectionId connectionId) {
+  tFrameBufferMap::iterator itr = m_buffers.find(connectionId);
+  if (itr == m_buffers.end()) {
+    return Blob();
+  }
+  return itr->second.writable();
+}
+
+/**
+ *
+ */
+Status SendFramed(
+    iNetServer &server,
+    const tConnectionId connectionId,
+    const ConstBlob &message) {
+  u8 header[MAX_FRAME_HEADER_SIZE];
+  Blob headerBlob(header, MAX_FRAME_HEADER_SIZE);
+  core::base::BlobSink sink(headerBlob);
+  sink << VarUInt(message.size());
+
+  const ConstBlob parts[2] = {ConstBlob(header, sink.size()), message};
+  return server.send(connectionId, parts, 2);
+}
+
+} // namespace net
+} // namespace core
@@ -0,0 +1,170 @@
+/**
+ * Length prefixed message framing over stream connections.
+ */
+#ifndef FISHY_NET_FRAMING_H
+#define FISHY_NET_FRAMING_H
+
+#include "net_server.h"
+
+#include <map>
+#include <vector>
+
+namespace core {
+namespace net {
+
+/**
+ * Largest encoding of a {@link VarUInt} frame header.
+ */
+static const size_t MAX_FRAME_HEADER_SIZE = 10;
+
+/**
+ * Default cap on the size of a single framed message.
+ */
+static const size_t DEFAULT_MAX_MESSAGE_SIZE = 16 * 1024 * 1024;
+
+/**
+ * Results of {@link FrameBuffer#next}
+ */
+struct eFrameResult {
+  enum type {
+    // More data is needed to complete the next message.
+    INCOMPLETE,
+    // A complete message was returned.
+    MESSAGE,
+    // The stream is not validly framed, and should be dropped.
+    MALFORMED
+  };
+};
+
+/**
+ * Growable receive ring for a single stream connection, holding messages
+ * framed by a {@link VarUInt} length prefix.
+ *
+ * Data is received straight into {@link #writable}, and complete messages are
+ * returned pointing into the ring. A partial message is only moved when it
+ * would otherwise wrap the end of the ring, and the ring only grows to fit
+ * messages larger than itself.
+ */
+class FrameBuffer {
+  public:
+  FrameBuffer(const size_t maxMessageSize = DEFAULT_MAX_MESSAGE_SIZE);
+
+  /**
+   * @return free space after any buffered data, large enough for the rest of
+   *     the pending message. Invalidates previously returned messages.
+   */
+  core::memory::Blob writable();
+
+  /**
+   * Mark {@code size} bytes of {@link #writable} as filled.
+   */
+  void commit(const size_t size);
+
+  /**
+   * Add received data. Data that was read into {@link #writable} is
+   * committed in place, anything else is copied in.
+   */
+  void receive(const core::memory::ConstBlob &data);
+
+  /**
+   * Pop the next complete message.
+   *
+   * @param message set to the message body, valid until the next call to
+   *     {@link #writable} or {@link #receive}.
+   */
+  eFrameResult::type next(core::memory::ConstBlob &message);
+
+  /**
+   * @return number of buffered, undelivered bytes.
+   */
+  size_t size() const { return m_tail - m_head; }
+
+  private:
+  std::vector< u8 > m_data;
+  size_t m_head;
+  size_t m_tail;
+  // Bytes from m_head needed to complete the pending message, or 0 if its
+  // header has not been read yet.
+  size_t m_pending;
+  size_t m_headerSize;
+  size_t m_maxMessageSize;
+};
+
+/**
+ * Handler for complete framed messages.
+ * @see FramedConnectionHandler
+ */
+class iMessageHandler {
+  public:
+  virtual ~iMessageHandler() {}
+
+  /**
+   * Called with each complete message from a single client.
+   *
+   * @param server server to send responses with.
+   * @param connectionId identifier for the connection who sent the message.
+   * @param message message body, without its length prefix. Only valid for
+   *     the duration of the call.
+   * @return false to close the connection.
+   */
+  virtual bool process(
+      iNetServer &server,
+      const tConnectionId connectionId,
+      const core::memory::ConstBlob &message) = 0;
+
+  /**
+   * Called when a new client connects
+   */
+  virtual void open(const tConnectionId connectionId) = 0;
+
+  /**
+   * Called when an existing client disconnects
+   */
+  virtual void close(const tConnectionId connectionId) = 0;
+};
+
+/**
+ * {@link iServerConnectionHandler} which splits stream data into length
+ * prefixed messages, and hands them whole to an {@link iMessageHandler}.
+ *
+ * Each connection has a {@link FrameBuffer} the server reads straight into,
+ * so messages reach the handler without being copied. Not thread-safe, use
+ * one per {@link NetServer}.
+ */
+class FramedConnectionHandler : public iServerConnectionHandler {
+  public:
+  FramedConnectionHandler(
+      iMessageHandler &handler,
+      const size_t maxMessageSize = DEFAULT_MAX_MESSAGE_SIZE);
+
+  virtual bool process(
+      iNetServer &server,
+      const tConnectionId connectionId,
+      const core::memory::ConstBlob &data);
+  virtual void open(const tConnectionId connectionId);
+  virtual void close(const tConnectionId connectionId);
+  virtual core::memory::Blob readBuffer(const tConnectionId connectionId);
+  virtual void cleanup() {}
+
+  private:
+  typedef std::map< tConnectionId, FrameBuffer > tFrameBufferMap;
+
+  iMessageHandler &m_handler;
+  size_t m_maxMessageSize;
+  tFrameBufferMap m_buffers;
+};
+
+/**
+ * Send {@code message} to a client reading with a
+ * {@link FramedConnectionHandler}, prefixed by its length. The prefix and body
+ * are gathered into a single send.
+ */
+Status SendFramed(
+    iNetServer &server,
+    const tConnectionId connectionId,
+    const core::memory::ConstBlob &message);
+
+} // namespace net
+} // namespace core
+
+#endif
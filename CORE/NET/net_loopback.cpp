@@ -0,0 +1,615 @@
+#include "net_loopback.h"
+
+#include <CORE/ARCH/timer.h>
+#include <CORE/BASE/logging.h>
+
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using core::memory::ConstBlob;
+
+namespace core {
+namespace net {
+
+/**
+ * @return the combined size of {@code parts}
+ */
+static size_t TotalSize(const ConstBlob *parts, const size_t count) {
+  size_t size = 0;
+  for (size_t i = 0; i < count; ++i) {
+    size += parts[i].size();
+  }
+  return size;
+}
+
+/**
+ * Single producer, single consumer ring of messages.
+ *
+ * Each message is a u32 length followed by its body, padded to keep the next
+ * length aligned. Messages never wrap, a message which would is written from
+ * the start of the ring behind a skip marker, so the reader always sees it
+ * whole and contiguous.
+ */
+class LoopbackRing {
+  public:
+  LoopbackRing() : m_data(LOOPBACK_RING_SIZE), m_head(0), m_tail(0) {}
+
+  /**
+   * Write one message gathered from {@code parts}. Only called by the
+   * producer.
+   *
+   * @return false if the ring is too full to take the message.
+   */
+  bool write(const ConstBlob *parts, const size_t count) {
+    const size_t size = TotalSize(parts, count);
+    if (size > LOOPBACK_MAX_MESSAGE_SIZE) {
+      return false;
+    }
+
+    const u64 tail = m_tail.load(std::memory_order_relaxed);
+    const u64 head = m_head.load(std::memory_order_acquire);
+    const size_t offset = (size_t) (tail % m_data.size());
+    const size_t record = recordSize(size);
+    // A record which would run off the end starts over at the front.
+    const size_t skip = (offset + record > m_data.size())
+                            ? m_data.size() - offset
+                            : 0;
+    if (tail + skip + record - head > m_data.size()) {
+      return false;
+    }
+
+    if (skip != 0) {
+      writeLength(offset, SKIP_MARKER);
+    }
+    u8 *pOut = &m_data[(offset + skip) % m_data.size()];
+    writeLength((offset + skip) % m_data.size(), (u32) size);
+    pOut += sizeof(u32);
+    for (size_t i = 0; i < count; ++i) {
+      memcpy(pOut, parts[i].data(), parts[i].size());
+      pOut += parts[i].size();
+    }
+    m_tail.store(tail + skip + record, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Look at the oldest message, without removing it. Only called by the
+   * consumer.
+   *
+   * @param message set to the message body, valid until {@link #pop}.
+   * @return false if the ring is empty
+   */
+  bool peek(ConstBlob &message) {
+    u64 head = m_head.load(std::memory_order_relaxed);
+    const u64 tail = m_tail.load(std::memory_order_acquire);
+    if (head == tail) {
+      return false;
+    }
+    size_t offset = (size_t) (head % m_data.size());
+    u32 size = readLength(offset);
+    if (size == SKIP_MARKER) {
+      head += m_data.size() - offset;
+      m_head.store(head, std::memory_order_release);
+      offset = 0;
+      size = readLength(offset);
+    }
+    message = ConstBlob(&m_data[offset + sizeof(u32)], size);
+    return true;
+  }
+
+  /**
+   * Remove the message returned by {@link #peek}.
+   */
+  void pop(const ConstBlob &message) {
+    m_head.store(
+        m_head.load(std::memory_order_relaxed) + recordSize(message.size()),
+        std::memory_order_release);
+  }
+
+  /**
+   * @return true if there are no messages left to read.
+   */
+  bool empty() const {
+    return m_head.load(std::memory_order_acquire)
+           == m_tail.load(std::memory_order_acquire);
+  }
+
+  private:
+  static const u32 SKIP_MARKER = (u32) -1;
+
+  static size_t recordSize(const size_t size) {
+    return (sizeof(u32) + size + sizeof(u32) - 1) & ~(sizeof(u32) - 1);
+  }
+
+  void writeLength(const size_t offset, const u32 size) {
+    memcpy(&m_data[offset], &size, sizeof(size));
+  }
+
+  u32 readLength(const size_t offset) const {
+    u32 size;
+    memcpy(&size, &m_data[offset], sizeof(size));
+    return size;
+  }
+
+  std::vector< u8 > m_data;
+  // Total bytes ever consumed and produced. Kept apart, so the consumer and
+  // producer don't share a cache line.
+  alignas(64) std::atomic< u64 > m_head;
+  alignas(64) std::atomic< u64 > m_tail;
+};
+
+/**
+ * Both directions of one loopback connection.
+ */
+struct LoopbackChannel {
+  LoopbackChannel() {
+    m_clientClosed = false;
+    m_serverClosed = false;
+  }
+
+  LoopbackRing m_toServer;
+  LoopbackRing m_toClient;
+  std::atomic_bool m_clientClosed;
+  std::atomic_bool m_serverClosed;
+};
+
+/**
+ * Connections made to a listening server, not yet picked up by its update.
+ */
+struct LoopbackListener {
+  std::vector< std::shared_ptr< LoopbackChannel > > m_pending;
+};
+
+/**
+ * Guards the listener registry, and every listener's pending connections.
+ */
+static std::mutex &GetListenerMutex() {
+  static std::mutex s_mutex;
+  return s_mutex;
+}
+
+/**
+ * Listening loopback servers, by port.
+ */
+static std::map< int, LoopbackListener * > &GetListeners() {
+  static std::map< int, LoopbackListener * > s_listeners;
+  return s_listeners;
+}
+
+/**
+ * Server side of a set of loopback connections.
+ */
+class LoopbackNetServer::Impl {
+  public:
+  Impl(LoopbackNetServer *pThis)
+      : m_pThis(pThis), m_port(0), m_running(false), m_connectionIdNext(0) {}
+
+  /**
+   *
+   */
+  Status start(const ServerDef &def) {
+    std::lock_guard< std::mutex > lock(GetListenerMutex());
+    std::map< int, LoopbackListener * > &listeners = GetListeners();
+    RET_SM(
+        listeners.find(def.m_port) == listeners.end(),
+        Status::BAD_STATE,
+        "Loopback port " << def.m_port << " is already in use.");
+    listeners[def.m_port] = &m_listener;
+    m_port = def.m_port;
+    m_maxConnections = def.m_maxConnections;
+    m_running = true;
+    return Status::OK;
+  }
+
+  /**
+   *
+   */
+  void stop() {
+    {
+      std::lock_guard< std::mutex > lock(GetListenerMutex());
+      GetListeners().erase(m_port);
+      // Connections never accepted still see the server close.
+      for (size_t i = 0; i < m_listener.m_pending.size(); ++i) {
+        m_listener.m_pending[i]->m_serverClosed = true;
+      }
+      m_listener.m_pending.clear();
+    }
+    for (tConnectionMap::iterator itr = m_connections.begin();
+         itr != m_connections.end();
+         ++itr) {
+      itr->second->m_serverClosed = true;
+      m_pThis->m_counters.addClose(eCloseReason::STOPPED);
+    }
+    m_connections.clear();
+    m_pThis->m_counters.setActiveConnections(0);
+    m_running = false;
+  }
+
+  /**
+   *
+   */
+  bool valid() const { return m_running; }
+
+  /**
+   *
+   */
+  Status update(iServerConnectionHandler &handler) {
+    acceptConnections(handler);
+
+    for (tConnectionMap::iterator itr = m_connections.begin();
+         itr != m_connections.end();) {
+      LoopbackChannel &channel = *itr->second;
+      bool open = true;
+      ConstBlob message;
+      while (open && channel.m_toServer.peek(message)) {
+        m_pThis->m_counters.addRecieved(message.size());
+        const u64 start = timer::GetTicks();
+        open = handler.process(*m_pThis, itr->first, message);
+        m_pThis->m_counters.recordProcessTicks(timer::GetTicks() - start);
+        channel.m_toServer.pop(message);
+      }
+
+      // Deliver everything the client sent before it closed.
+      if (!open
+          || (channel.m_clientClosed.load() && channel.m_toServer.empty())) {
+        channel.m_serverClosed = true;
+        m_pThis->m_counters.addClose(
+            open ? eCloseReason::REMOTE : eCloseReason::HANDLER);
+        handler.close(itr->first);
+        itr = m_connections.erase(itr);
+        m_pThis->m_counters.setActiveConnections(
+            static_cast< u32 >(m_connections.size()));
+      } else {
+        ++itr;
+      }
+    }
+    handler.cleanup();
+    return Status::OK;
+  }
+
+  /**
+   *
+   */
+  Status send(
+      const tConnectionId connectionId,
+      const ConstBlob *parts,
+      const size_t count) {
+    tConnectionMap::iterator itr = m_connections.find(connectionId);
+    if (itr == m_connections.end()) {
+      return Status::NOT_FOUND;
+    }
+    if (itr->second->m_clientClosed.load()) {
+      return Status::CANCELED;
+    }
+    if (!itr->second->m_toClient.write(parts, count)) {
+      return Status::OUT_OF_BOUNDS;
+    }
+    m_pThis->m_counters.addSent(TotalSize(parts, count), 1);
+    return Status::OK;
+  }
+
+  private:
+  typedef std::map< tConnectionId, std::shared_ptr< LoopbackChannel > >
+      tConnectionMap;
+
+  /**
+   * Pick up the connections made since the last update.
+   */
+  void acceptConnections(iServerConnectionHandler &handler) {
+    {
+      std::lock_guard< std::mutex > lock(GetListenerMutex());
+      m_accepting.swap(m_listener.m_pending);
+    }
+    for (size_t i = 0; i < m_accepting.size(); ++i) {
+      if (m_maxConnections > 0
+          && m_connections.size() >= (size_t) m_maxConnections) {
+        Log(LL::Warning) << "Loopback server full, refusing connection.";
+        m_accepting[i]->m_serverClosed = true;
+        continue;
+      }
+      const tConnectionId connectionId =
+          (m_connectionIdNext++) & CONNECTION_LOCAL_MASK;
+      m_connections[connectionId] = m_accepting[i];
+      m_pThis->m_counters.addAccept();
+      m_pThis->m_counters.setActiveConnections(
+          static_cast< u32 >(m_connections.size()));
+      handler.open(connectionId);
+    }
+    m_accepting.clear();
+  }
+
+  LoopbackNetServer *m_pThis;
+  int m_port;
+  int m_maxConnections;
+  bool m_running;
+  tConnectionId m_connectionIdNext;
+  LoopbackListener m_listener;
+  std::vector< std::shared_ptr< LoopbackChannel > > m_accepting;
+  tConnectionMap m_connections;
+};
+
+/**
+ *
+ */
+LoopbackNetServer::LoopbackNetServer() : m_pImpl(new Impl(this)) {}
+
+/**
+ *
+ */
+LoopbackNetServer::~LoopbackNetServer() {
+  if (valid()) {
+    stop();
+  }
+  delete m_pImpl;
+}
+
+/**
+ * Delegate to implementation
+ */
+Status LoopbackNetServer::start(const ServerDef &def) {
+  RET_SM(!valid(), Status::BAD_STATE, "Loopback server already started.");
+  m_counters.reset();
+  return m_pImpl->start(def);
+}
+
+/**
+ * Delegate to implementation
+ */
+void LoopbackNetServer::stop() {
+  m_pImpl->stop();
+}
+
+/**
+ * Delegate to implementation
+ */
+Status LoopbackNetServer::update(iServerConnectionHandler &handler) {
+  if (!valid()) {
+    return Status::BAD_STATE;
+  }
+  return m_pImpl->update(handler);
+}
+
+/**
+ * Delegate to implementation
+ */
+bool LoopbackNetServer::valid() const {
+  return m_pImpl->valid();
+}
+
+/**
+ * Delegate to implementation
+ */
+Status
+LoopbackNetServer::send(const tConnectionId connectionId, const ConstBlob &msg) {
+  return m_pImpl->send(connectionId, &msg, 1);
+}
+
+/**
+ * Delegate to implementation
+ */
+Status LoopbackNetServer::send(
+    const tConnectionId connectionId,
+    const ConstBlob *parts,
+    const size_t count) {
+  return m_pImpl->send(connectionId, parts, count);
+}
+
+/**
+ *
+ */
+Status
+LoopbackNetServer::sendBatch(const OutboundMessage *msgs, const size_t count) {
+  Status::eError ret = Status::OK;
+  for (size_t i = 0; i < count; ++i) {
+    Status::eError sent =
+        m_pImpl->send(msgs[i].m_connectionId, &msgs[i].m_data, 1).getStatus();
+    if (ret == Status::OK) {
+      ret = sent;
+    }
+  }
+  return Status(ret);
+}
+
+/**
+ *
+ */
+NetStats LoopbackNetServer::stats() const {
+  return m_counters.snapshot();
+}
+
+/**
+ *
+ */
+eConnectionMode::type LoopbackNetServer::getConnectionMode() const {
+  return eConnectionMode::TCP_ASYNC;
+}
+
+/**
+ * Client side of a single loopback connection.
+ */
+class LoopbackNetClient::Impl {
+  public:
+  Impl(LoopbackNetClient *pThis) : m_pThis(pThis) {}
+
+  /**
+   *
+   */
+  Status start(const ClientDef &def) {
+    std::lock_guard< std::mutex > lock(GetListenerMutex());
+    std::map< int, LoopbackListener * > &listeners = GetListeners();
+    std::map< int, LoopbackListener * >::iterator itr =
+        listeners.find(def.m_port);
+    RET_SM(
+        itr != listeners.end(),
+        Status::NOT_FOUND,
+        "No loopback server on port " << def.m_port);
+    m_channel = std::make_shared< LoopbackChannel >();
+    itr->second->m_pending.push_back(m_channel);
+    m_pThis->m_counters.setActiveConnections(1);
+    return Status::OK;
+  }
+
+  /**
+   *
+   */
+  void stop(const eCloseReason::type reason) {
+    if (m_channel) {
+      m_channel->m_clientClosed = true;
+      m_channel.reset();
+      m_pThis->m_counters.addClose(reason);
+    }
+    m_pThis->m_counters.setActiveConnections(0);
+  }
+
+  /**
+   *
+   */
+  bool valid() const { return m_channel != nullptr; }
+
+  /**
+   *
+   */
+  Status update(iClientConnectionHandler &handler) {
+    ConstBlob message;
+    while (m_channel->m_toClient.peek(message)) {
+      m_pThis->m_counters.addRecieved(message.size());
+      const u64 start = timer::GetTicks();
+      handler.process(*m_pThis, message);
+      m_pThis->m_counters.recordProcessTicks(timer::GetTicks() - start);
+      // The handler may have stopped the client.
+      if (!m_channel) {
+        return Status::OK;
+      }
+      m_channel->m_toClient.pop(message);
+    }
+    handler.cleanup();
+
+    if (m_channel->m_serverClosed.load() && m_channel->m_toClient.empty()) {
+      Log(LL::Info) << "Connection to loopback server closed.";
+      stop(eCloseReason::REMOTE);
+    }
+    return Status::OK;
+  }
+
+  /**
+   *
+   */
+  Status send(const ConstBlob *parts, const size_t count) {
+    if (m_channel->m_serverClosed.load()) {
+      return Status::CANCELED;
+    }
+    if (!m_channel->m_toServer.write(parts, count)) {
+      return Status::OUT_OF_BOUNDS;
+    }
+    m_pThis->m_counters.addSent(TotalSize(parts, count), 1);
+    return Status::OK;
+  }
+
+  private:
+  LoopbackNetClient *m_pThis;
+  std::shared_ptr< LoopbackChannel > m_channel;
+};
+
+/**
+ *
+ */
+LoopbackNetClient::LoopbackNetClient() : m_pImpl(new Impl(this)) {}
+
+/**
+ *
+ */
+LoopbackNetClient::~LoopbackNetClient() {
+  stop();
+  delete m_pImpl;
+}
+
+/**
+ * Delegate to implementation
+ */
+Status LoopbackNetClient::start(const ClientDef &def) {
+  RET_SM(!valid(), Status::BAD_STATE, "Loopback client already connected.");
+  m_counters.reset();
+  return m_pImpl->start(def);
+}
+
+/**
+ * Delegate to implementation
+ */
+void LoopbackNetClient::stop() {
+  m_pImpl->stop(eCloseReason::STOPPED);
+}
+
+/**
+ * Delegate to implementation
+ */
+Status LoopbackNetClient::update(iClientConnectionHandler &handler) {
+  if (!valid()) {
+    return Status::BAD_STATE;
+  }
+  return m_pImpl->update(handler);
+}
+
+/**
+ * Delegate to implementation
+ */
+bool LoopbackNetClient::valid() const {
+  return m_pImpl->valid();
+}
+
+/**
+ * Delegate to implementation
+ */
+Status LoopbackNetClient::send(const ConstBlob &msg) {
+  if (!valid()) {
+    return Status::BAD_STATE;
+  }
+  return m_pImpl->send(&msg, 1);
+}
+
+/**
+ * Delegate to implementation
+ */
+Status LoopbackNetClient::send(const ConstBlob *parts, const size_t count) {
+  if (!valid()) {
+    return Status::BAD_STATE;
+  }
+  return m_pImpl->send(parts, count);
+}
+
+/**
+ *
+ */
+Status LoopbackNetClient::sendBatch(const ConstBlob *msgs, const size_t count) {
+  if (!valid()) {
+    return Status::BAD_STATE;
+  }
+  Status::eError ret = Status::OK;
+  for (size_t i = 0; i < count; ++i) {
+    Status::eError sent = m_pImpl->send(&msgs[i], 1).getStatus();
+    if (ret == Status::OK) {
+      ret = sent;
+    }
+  }
+  return Status(ret);
+}
+
+/**
+ *
+ */
+NetStats LoopbackNetClient::stats() const {
+  return m_counters.snapshot();
+}
+
+/**
+ *
+ */
+eConnectionMode::type LoopbackNetClient::getConnectionMode() const {
+  return eConnectionMode::TCP_ASYNC;
+}
+
+} // namespace net
+} // namespace core
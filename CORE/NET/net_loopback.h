@@ -0,0 +1,103 @@
+/**
+ * In-process network transport, for servers and clients in the same process.
+ */
+#ifndef FISHY_NET_LOOPBACK_H
+#define FISHY_NET_LOOPBACK_H
+
+#include "net_client.h"
+#include "net_server.h"
+
+namespace core {
+namespace net {
+
+/**
+ * Capacity in bytes of each direction of a loopback connection.
+ */
+static const size_t LOOPBACK_RING_SIZE = 1024 * 1024;
+
+/**
+ * Largest single message a loopback connection can carry.
+ */
+static const size_t LOOPBACK_MAX_MESSAGE_SIZE = LOOPBACK_RING_SIZE / 2 - 8;
+
+/**
+ * {@link iNetServer} for clients within the same process, such as the local
+ * player of a listen server, or tests.
+ *
+ * Each connection is a pair of single producer, single consumer rings, one per
+ * direction, so the server and a client may run on different threads. Sends
+ * are written straight into the ring, and received messages are handed to the
+ * handler pointing into it, without passing through the kernel.
+ *
+ * Messages keep their boundaries, are delivered reliably and in order, and
+ * nothing blocks. A send to a full ring fails with {@code OUT_OF_BOUNDS}, and
+ * may be retried once the other end has read.
+ */
+class LoopbackNetServer : public iNetServer {
+  public:
+  LoopbackNetServer();
+  ~LoopbackNetServer();
+
+  /**
+   * Listen for {@link LoopbackNetClient}s on {@code def.m_port}. Ports are a
+   * separate namespace from real sockets.
+   */
+  virtual Status start(const core::net::ServerDef &def);
+  virtual void stop();
+  virtual Status update(iServerConnectionHandler &handler);
+  virtual bool valid() const;
+  virtual Status
+  send(const tConnectionId connectionId, const core::memory::ConstBlob &msg);
+  virtual Status send(
+      const tConnectionId connectionId,
+      const core::memory::ConstBlob *parts,
+      const size_t count);
+  virtual Status sendBatch(const OutboundMessage *msgs, const size_t count);
+  virtual NetStats stats() const;
+
+  /**
+   * @return TCP_ASYNC, the closest socket mode: reliable, ordered and
+   *     non-blocking.
+   */
+  virtual eConnectionMode::type getConnectionMode() const;
+
+  private:
+  class Impl;
+  Impl *m_pImpl;
+  NetCounters m_counters;
+};
+
+/**
+ * {@link iNetClient} connecting to a {@link LoopbackNetServer}.
+ * @see LoopbackNetServer
+ */
+class LoopbackNetClient : public iNetClient {
+  public:
+  LoopbackNetClient();
+  ~LoopbackNetClient();
+
+  /**
+   * Connect to the loopback server listening on {@code server.m_port}. The
+   * host name is ignored.
+   */
+  virtual Status start(const core::net::ClientDef &server);
+  virtual void stop();
+  virtual Status update(iClientConnectionHandler &handler);
+  virtual bool valid() const;
+  virtual Status send(const core::memory::ConstBlob &msg);
+  virtual Status send(const core::memory::ConstBlob *parts, const size_t count);
+  virtual Status
+  sendBatch(const core::memory::ConstBlob *msgs, const size_t count);
+  virtual NetStats stats() const;
+  virtual eConnectionMode::type getConnectionMode() const;
+
+  private:
+  class Impl;
+  Impl *m_pImpl;
+  NetCounters m_counters;
+};
+
+} // namespace net
+} // namespace core
+
+#endif
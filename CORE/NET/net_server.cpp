@@ -3,24 +3,34 @@
 #include <CORE/ARCH/timer.h>
 #include <CORE/BASE/checks.h>
 #include <CORE/BASE/logging.h>
+#include <CORE/HASH/crc32.h>
+#include <CORE/MEMORY/memory_tracking.h>
 #include <CORE/UTIL/algorithm.h>
 #include <CORE/UTIL/lexical_cast.h>
+#include <CORE/UTIL/timer_wheel.h>
 
 #if defined(PLAT_WIN32)
 #  include <WS2tcpip.h>
 #  include <WinSock2.h>
 #elif defined(PLAT_LINUX)
 #  include <cstdlib>
+#  include <fcntl.h>
 #  include <netdb.h>
 #  include <netinet/in.h>
+#  include <sys/epoll.h>
+#  include <sys/eventfd.h>
 #  include <sys/socket.h>
 #  include <sys/types.h>
+#  include <sys/uio.h>
 #  include <unistd.h>
 #else
 #  error "networking not supported on this platform"
 #endif
 
+#include <climits>
+#include <cstring>
 #include <map>
+#include <vector>
 
 using core::memory::Blob;
 using core::memory::ConstBlob;
@@ -60,10 +70,40 @@ static void closesocket(SOCKET &fd) {
 #  error "networking not supported on this platform"
 #endif
 
+/**
+ * Cross platform wrap making a socket non-blocking.
+ */
+static bool SetNonBlocking(SOCKET socket) {
+#if defined(PLAT_WIN32)
+  u_long enable = 1;
+  return ioctlsocket(socket, FIONBIO, &enable) == 0;
+#else
+  const int flags = fcntl(socket, F_GETFL, 0);
+  return flags != SOCKET_ERROR
+         && fcntl(socket, F_SETFL, flags | O_NONBLOCK) != SOCKET_ERROR;
+#endif
+}
+
 namespace core {
 namespace net {
 
 static const int MAX_PENDING_CONNECTIONS = 10;
+static const int MAX_EPOLL_EVENTS = 256;
+static const int BLOCKING_WAIT_MS = 1000;
+// Epoll tag of the wake event. Its shard bits are those of no shard.
+static const tConnectionId WAKE_EVENT_ID = INVALID_CONNECTION_ID - 1;
+static const size_t MIN_ADDRESS_SLOTS = 16;
+// Connection timeouts are tracked with this granularity, on a wheel spanning
+// TIMEOUT_SLOTS of them. Longer timeouts take several turns of the wheel.
+static const f64 TIMEOUT_SLOT_SEC = 0.1;
+static const size_t TIMEOUT_SLOTS = 512;
+// Bytes a slow stream client may have queued before further sends fail.
+static const size_t MAX_WRITE_QUEUE = 4 * 1024 * 1024;
+#if defined(IOV_MAX)
+static const size_t MAX_SEND_PARTS = IOV_MAX;
+#else
+static const size_t MAX_SEND_PARTS = 1024;
+#endif
 
 /**
  * Implementation of the {@link NetServer} logic for PLAT_WIN32
@@ -78,19 +118,26 @@ class NetServer::Impl {
         : m_id(INVALID_CONNECTION_ID),
           m_lastModified(0),
           m_socket(INVALID_SOCKET),
-          m_clientAddr() {}
+          m_clientAddr(),
+          m_writeHead(0),
+          m_statsSlot(ConnectionStatsTable::INVALID_SLOT),
+          m_timeoutDeadline(0) {}
 
     Connection(
         tConnectionId id,
         u64 lastModified,
         SOCKET socket,
         const std::string &hostName,
-        sockaddr_storage clientAddr)
+        sockaddr_storage clientAddr,
+        u32 statsSlot)
         : m_id(id),
           m_lastModified(lastModified),
           m_socket(socket),
           m_hostName(hostName),
-          m_clientAddr(clientAddr){};
+          m_clientAddr(clientAddr),
+          m_writeHead(0),
+          m_statsSlot(statsSlot),
+          m_timeoutDeadline(0){};
 
     bool operator==(const tConnectionId id) { return m_id == id; }
 
@@ -99,18 +146,286 @@ class NetServer::Impl {
     SOCKET m_socket;
     std::string m_hostName;
     sockaddr_storage m_clientAddr;
+    // Stream data the socket would not yet take, from m_writeHead onwards.
+    std::vector< u8 > m_writeQueue;
+    size_t m_writeHead;
+    // Slot of the connection's counters in m_connectionStats.
+    u32 m_statsSlot;
+    // Deadline of the connection's entry in m_timeouts. Entries left behind
+    // by an earlier connection with the same id carry another deadline.
+    u64 m_timeoutDeadline;
+  };
+
+  /**
+   * Reusable ring of receive buffers for batched datagram reads. Each slot
+   * holds one {@link MAX_PACKET_SIZE} datagram and its sender address.
+   */
+  class DatagramRing {
+    public:
+    DatagramRing()
+        : m_buffers(MAX_DATAGRAM_BATCH * MAX_PACKET_SIZE),
+          m_addrs(MAX_DATAGRAM_BATCH),
+          m_sizes(MAX_DATAGRAM_BATCH, 0) {
+#if defined(PLAT_LINUX)
+      m_vecs.resize(MAX_DATAGRAM_BATCH);
+      m_headers.resize(MAX_DATAGRAM_BATCH);
+      for (size_t i = 0; i < MAX_DATAGRAM_BATCH; ++i) {
+        m_vecs[i].iov_base = &m_buffers[i * MAX_PACKET_SIZE];
+        m_vecs[i].iov_len = MAX_PACKET_SIZE;
+        memset(&m_headers[i], 0, sizeof(mmsghdr));
+        m_headers[i].msg_hdr.msg_iov = &m_vecs[i];
+        m_headers[i].msg_hdr.msg_iovlen = 1;
+        m_headers[i].msg_hdr.msg_name = &m_addrs[i];
+      }
+#endif
+    }
+
+    /**
+     * Fill the ring from {@code socket} without blocking.
+     *
+     * @return the number of datagrams read, 0 if none were pending.
+     */
+    size_t receive(SOCKET socket) {
+#if defined(PLAT_LINUX)
+      for (size_t i = 0; i < MAX_DATAGRAM_BATCH; ++i) {
+        m_headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+      }
+      int ret;
+      do {
+        ret = recvmmsg(
+            socket, &m_headers[0], MAX_DATAGRAM_BATCH, MSG_DONTWAIT, NULL);
+      } while (ret == SOCKET_ERROR && NetGetLastError() == EINTR);
+      if (ret == SOCKET_ERROR) {
+        return 0;
+      }
+      for (int i = 0; i < ret; ++i) {
+        m_sizes[i] = m_headers[i].msg_len;
+      }
+      return static_cast< size_t >(ret);
+#else
+      // No batched receive, read the single datagram select() reported.
+      socklen_t addrlen = sizeof(sockaddr_storage);
+      const int ret = ::recvfrom(
+          socket,
+          (char *) &m_buffers[0],
+          MAX_PACKET_SIZE,
+          0,
+          (sockaddr *) &m_addrs[0],
+          &addrlen);
+      if (ret == SOCKET_ERROR) {
+        return 0;
+      }
+      m_sizes[0] = ret;
+      return 1;
+#endif
+    }
+
+    ConstBlob data(const size_t idx) const {
+      return ConstBlob(&m_buffers[idx * MAX_PACKET_SIZE], m_sizes[idx]);
+    }
+
+    const sockaddr_storage &address(const size_t idx) const {
+      return m_addrs[idx];
+    }
+
+    private:
+    std::vector< u8 > m_buffers;
+    std::vector< sockaddr_storage > m_addrs;
+    std::vector< size_t > m_sizes;
+#if defined(PLAT_LINUX)
+    std::vector< iovec > m_vecs;
+    std::vector< mmsghdr > m_headers;
+#endif
+  };
+
+  /**
+   * Binary identity of a remote peer: address family, port and address.
+   * Lets datagrams be matched to connections without formatting host names.
+   */
+  struct AddressKey {
+    AddressKey() { memset(this, 0, sizeof(*this)); }
+
+    AddressKey(const sockaddr_storage &addr) {
+      memset(this, 0, sizeof(*this));
+      m_family = addr.ss_family;
+      if (addr.ss_family == AF_INET) {
+        const sockaddr_in &in = (const sockaddr_in &) addr;
+        m_port = in.sin_port;
+        memcpy(m_addr, &in.sin_addr, sizeof(in.sin_addr));
+      } else if (addr.ss_family == AF_INET6) {
+        const sockaddr_in6 &in6 = (const sockaddr_in6 &) addr;
+        m_port = in6.sin6_port;
+        memcpy(m_addr, &in6.sin6_addr, sizeof(in6.sin6_addr));
+      }
+    }
+
+    bool operator==(const AddressKey &other) const {
+      return memcmp(this, &other, sizeof(*this)) == 0;
+    }
+
+    Signature hash() const { return core::hash::CRC32(this, sizeof(*this)); }
+
+    u16 m_family;
+    u16 m_port;
+    u8 m_addr[16];
+  };
+
+  /**
+   * Flat open-addressed (linear probing) table from {@link AddressKey} to
+   * {@link tConnectionId}. Capacity is a power of two, kept at most half full.
+   */
+  class AddressTable {
+    public:
+    AddressTable() : m_size(0) {}
+
+    /**
+     * @return the connection for {@code key}, or INVALID_CONNECTION_ID
+     */
+    tConnectionId find(const AddressKey &key) const {
+      if (m_slots.empty()) {
+        return INVALID_CONNECTION_ID;
+      }
+      const size_t mask = m_slots.size() - 1;
+      const Signature hash = key.hash();
+      for (size_t idx = hash & mask;; idx = (idx + 1) & mask) {
+        const Slot &slot = m_slots[idx];
+        if (slot.m_id == INVALID_CONNECTION_ID) {
+          return INVALID_CONNECTION_ID;
+        }
+        if (slot.m_hash == hash && slot.m_key == key) {
+          return slot.m_id;
+        }
+      }
+    }
+
+    /**
+     * Insert or replace the connection for {@code key}.
+     */
+    void insert(const AddressKey &key, const tConnectionId id) {
+      ASSERT(id != INVALID_CONNECTION_ID);
+      if ((m_size + 1) * 2 > m_slots.size()) {
+        rehash(std::max< size_t >(MIN_ADDRESS_SLOTS, m_slots.size() * 2));
+      }
+      const size_t mask = m_slots.size() - 1;
+      const Signature hash = key.hash();
+      for (size_t idx = hash & mask;; idx = (idx + 1) & mask) {
+        Slot &slot = m_slots[idx];
+        if (slot.m_id == INVALID_CONNECTION_ID) {
+          slot.m_key = key;
+          slot.m_hash = hash;
+          slot.m_id = id;
+          m_size++;
+          return;
+        }
+        if (slot.m_hash == hash && slot.m_key == key) {
+          slot.m_id = id;
+          return;
+        }
+      }
+    }
+
+    /**
+     * Remove {@code key}, shifting later entries of the probe run back so no
+     * tombstones are needed.
+     */
+    void erase(const AddressKey &key) {
+      if (m_slots.empty()) {
+        return;
+      }
+      const size_t mask = m_slots.size() - 1;
+      const Signature hash = key.hash();
+      size_t hole = hash & mask;
+      while (true) {
+        const Slot &slot = m_slots[hole];
+        if (slot.m_id == INVALID_CONNECTION_ID) {
+          return;
+        }
+        if (slot.m_hash == hash && slot.m_key == key) {
+          break;
+        }
+        hole = (hole + 1) & mask;
+      }
+
+      for (size_t next = (hole + 1) & mask;
+           m_slots[next].m_id != INVALID_CONNECTION_ID;
+           next = (next + 1) & mask) {
+        const size_t home = m_slots[next].m_hash & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+          m_slots[hole] = m_slots[next];
+          hole = next;
+        }
+      }
+      m_slots[hole].m_id = INVALID_CONNECTION_ID;
+      m_size--;
+    }
+
+    void clear() {
+      m_slots.clear();
+      m_size = 0;
+    }
+
+    private:
+    struct Slot {
+      Slot() : m_hash(0), m_id(INVALID_CONNECTION_ID) {}
+
+      AddressKey m_key;
+      Signature m_hash;
+      tConnectionId m_id;
+    };
+
+    std::vector< Slot > m_slots;
+    size_t m_size;
+
+    void rehash(const size_t capacity) {
+      std::vector< Slot > old;
+      old.swap(m_slots);
+      m_slots.resize(capacity);
+      m_size = 0;
+      for (std::vector< Slot >::const_iterator itr = old.begin();
+           itr != old.end();
+           ++itr) {
+        if (itr->m_id != INVALID_CONNECTION_ID) {
+          insert(itr->m_key, itr->m_id);
+        }
+      }
+    }
   };
 
   /**
    *
    */
-  Impl(eConnectionMode::type mode)
+  Impl(eConnectionMode::type mode, const u32 shard)
       : m_mode(mode),
         m_socket(INVALID_SOCKET),
         m_pThis(NULL),
-        m_connectionIdNext(1) {}
+#if defined(PLAT_LINUX)
+        m_epollFd(INVALID_SOCKET),
+        m_wakeFd(INVALID_SOCKET),
+#endif
+        m_port(0),
+        m_waitMs(-1),
+        m_timeoutTicks(0),
+        m_timeouts(1, TIMEOUT_SLOTS),
+        m_shardTag(shard << CONNECTION_SHARD_SHIFT),
+        m_connectionIdNext(1) {
+#if defined(PLAT_LINUX)
+    // Lives as long as the server, so wake() never races a stop.
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeFd == INVALID_SOCKET) {
+      Log(LL::Warning) << "Error <" << NetGetLastError()
+                       << "> creating server wake event.";
+    }
+#endif
+  }
 
-  ~Impl() { ASSERT(m_socket == INVALID_SOCKET); }
+  ~Impl() {
+    ASSERT(m_socket == INVALID_SOCKET);
+#if defined(PLAT_LINUX)
+    if (m_wakeFd != INVALID_SOCKET) {
+      closesocket(m_wakeFd);
+    }
+#endif
+  }
 
   /**
    *
@@ -119,12 +434,21 @@ class NetServer::Impl {
       NetServer *pThis,
       const u32 port,
       const u32 maxConnections,
-      const f32 timeoutSec) {
+      const f32 timeoutSec,
+      const eEventBackend::type eventBackend,
+      const bool reusePort,
+      const int waitMs) {
 
     m_pThis = pThis;
+    m_waitMs = waitMs;
 
     m_maxConnections = maxConnections;
-    m_timeoutSec = timeoutSec;
+    m_connectionStats.reset(maxConnections);
+    m_pThis->m_counters.reset();
+    m_timeoutTicks = timer::TimeToTicks(timeoutSec);
+    m_timeouts = util::TimerWheel(
+        std::max(timer::TimeToTicks(TIMEOUT_SLOT_SEC), (u64) 1), TIMEOUT_SLOTS);
+    m_port = port;
 
     struct addrinfo hints;
     memset(&hints, 0, sizeof(hints));
@@ -163,6 +487,30 @@ class NetServer::Impl {
         Status::GENERIC_ERROR,
         "Error creating socket for server.");
 
+    if (reusePort) {
+#if defined(SO_REUSEPORT)
+      const int enable = 1;
+      ret = setsockopt(
+          m_socket,
+          SOL_SOCKET,
+          SO_REUSEPORT,
+          (const char *) &enable,
+          sizeof(enable));
+      if (ret != 0) {
+        Log(LL::Error) << "Error <" << NetGetLastError()
+                       << "> enabling port reuse.";
+        closesocket(m_socket);
+        m_socket = INVALID_SOCKET;
+        return Status::GENERIC_ERROR;
+      }
+#else
+      Log(LL::Error) << "Port reuse is not supported on this platform.";
+      closesocket(m_socket);
+      m_socket = INVALID_SOCKET;
+      return Status::UNSUPPORTED;
+#endif
+    }
+
     ret = bind(m_socket, result->ai_addr, (int) result->ai_addrlen);
     if (ret != 0) {
       Log(LL::Error) << "Error <" << NetGetLastError() << "> binding socket.";
@@ -182,8 +530,7 @@ class NetServer::Impl {
       }
     }
 
-    if (m_mode == eConnectionMode::TCP_ASYNC
-        || m_mode == eConnectionMode::TCP_BLOCKING) {
+    if (isStreamMode()) {
       ret = listen(m_socket, MAX_PENDING_CONNECTIONS);
       if (ret != 0) {
         Log(LL::Error) << "Error <" << NetGetLastError()
@@ -194,6 +541,20 @@ class NetServer::Impl {
       }
     }
 
+    if (eventBackend == eEventBackend::EPOLL) {
+#if defined(PLAT_LINUX)
+      if (!openEventQueue()) {
+        Log(LL::Error) << "Error <" << NetGetLastError()
+                       << "> creating epoll queue.";
+        closesocket(m_socket);
+        m_socket = INVALID_SOCKET;
+        return Status::GENERIC_ERROR;
+      }
+#else
+      Log(LL::Warning) << "epoll is not available, falling back to select.";
+#endif
+    }
+
     Log(LL::Info) << "Started Server at port: " << m_port;
     return Status::OK;
   }
@@ -203,6 +564,12 @@ class NetServer::Impl {
    */
   Status acceptConnections(iServerConnectionHandler &handler) {
     ASSERT(valid());
+#if defined(PLAT_LINUX)
+    if (m_epollFd != INVALID_SOCKET) {
+      // Accepts are driven by listen socket events in readConnections.
+      return Status::OK;
+    }
+#endif
 
     timeval selectTime = {0, 0};
     switch (m_mode) {
@@ -221,7 +588,7 @@ class NetServer::Impl {
     FD_ZERO(&fd);
     FD_SET(m_socket, &fd);
 
-    int ret = select(1, &fd, NULL, NULL, &selectTime);
+    int ret = select((int) m_socket + 1, &fd, NULL, NULL, &selectTime);
     if (ret == 1) {
       SOCKET clientSocket = accept(m_socket, NULL, NULL);
       if (clientSocket == INVALID_SOCKET) {
@@ -245,6 +612,15 @@ class NetServer::Impl {
    *
    */
   Status readConnections(iServerConnectionHandler &handler) {
+#if defined(PLAT_LINUX)
+    if (m_epollFd != INVALID_SOCKET) {
+      Status ret = readReadySockets(handler);
+      if (!ret) {
+        return ret;
+      }
+      return expireConnections(handler);
+    }
+#endif
     timeval selectTime = {0, 0};
     switch (m_mode) {
       case eConnectionMode::TCP_BLOCKING:
@@ -255,6 +631,15 @@ class NetServer::Impl {
       }
     }
 
+    // Without write events, retry queued writes once per update.
+    if (isStreamMode()) {
+      for (tConnectionMap::iterator itr = m_connections.begin();
+           itr != m_connections.end();
+           ++itr) {
+        flushWrites(itr->second, handler);
+      }
+    }
+
     std::vector< SOCKET > sockets;
     switch (m_mode) {
       case eConnectionMode::TCP_BLOCKING:
@@ -274,60 +659,66 @@ class NetServer::Impl {
       FD_ZERO(&fd);
       FD_SET(*itr, &fd);
 
-      int ret = select(1, &fd, NULL, NULL, &selectTime);
-      if (ret == 1) {
-        u8 buffer[MAX_PACKET_SIZE] = {0};
-        Blob data(buffer, MAX_PACKET_SIZE);
-
-        sockaddr_storage addr;
-        socklen_t addrlen = sizeof(addr);
-        int ret = ::recvfrom(
-            *itr,
-            (char *) data.data(),
-            MAX_PACKET_SIZE,
-            0,
-            (sockaddr *) &addr,
-            &addrlen);
-
-        Connection *con;
-        if (!getConnectionForHost(&con, *itr, addr, handler)) {
-          continue;
-        }
-
-        if (ret > 0) {
-          data.trimSize(ret);
-          m_pThis->m_stats.m_bytesRecieved += ret;
-          if (!handler.process(*m_pThis, con->m_id, data)) {
-            closeConnection(*con, &handler);
-          }
-          con->m_lastModified = timer::GetTicks();
-        } else if (ret == 0) {
-          Log(LL::Info) << "Connection closed: " << con->m_id;
-          closeConnection(*con, &handler);
-        } else {
-          Log(LL::Info) << "Connection error on connection: " << con->m_id;
-          closeConnection(*con, &handler);
+      int ret = select((int) *itr + 1, &fd, NULL, NULL, &selectTime);
+      if (ret == 1 && !isStreamMode()) {
+        receiveDatagrams(handler);
+      } else if (ret == 1) {
+        tConnectionSocketMap::const_iterator con =
+            m_connectedSockets.find(*itr);
+        if (con != m_connectedSockets.end()) {
+          receiveStream(m_connections[con->second], handler, 0);
         }
       }
     }
 
-    for (tConnectionMap::iterator it = m_connections.begin();
-         it != m_connections.end();) {
-      if (timer::TicksToTime(timer::GetTicks() - it->second.m_lastModified)
-          > m_timeoutSec) {
-        Log(LL::Info) << "Connection timeout: " << it->second.m_id;
-        closeConnection(it->second, &handler);
+    return expireConnections(handler);
+  }
+
+  /**
+   * Close any connections which have passed the timeout, and drop closed
+   * connections from the connection table.
+   *
+   * Only deadlines the timer wheel reports as due are looked at. Activity
+   * just refreshes {@link Connection#m_lastModified}, and a connection whose
+   * deadline moved is put back in the wheel when its old deadline comes up.
+   * Closed connections leave their entry in the wheel, which is ignored when
+   * it comes due, even if the id was reused.
+   */
+  Status expireConnections(iServerConnectionHandler &handler) {
+    const u64 now = timer::GetTicks();
+    m_timeouts.advance(now, m_expired);
+    for (size_t i = 0; i < m_expired.size(); ++i) {
+      tConnectionMap::iterator it = m_connections.find(m_expired[i].m_id);
+      if (it == m_connections.end() || isConnectionClosed(*it)
+          || it->second.m_timeoutDeadline != m_expired[i].m_deadline) {
+        continue;
       }
-      if (isConnectionClosed(*it)) {
-        m_connectedHosts.erase(it->second.m_hostName);
-        it = m_connections.erase(it);
+      const u64 deadline = it->second.m_lastModified + m_timeoutTicks;
+      if (deadline > now) {
+        it->second.m_timeoutDeadline = deadline;
+        m_timeouts.schedule(it->first, deadline);
       } else {
-        ++it;
+        Log(LL::Info) << "Connection timeout: " << it->second.m_id;
+        closeConnection(it->second, &handler, eCloseReason::TIMEOUT);
       }
     }
+    m_expired.clear();
 
-    m_pThis->m_stats.m_activeConnections =
-        static_cast< u32 >(m_connections.size());
+    for (size_t i = 0; i < m_closedIds.size(); ++i) {
+      tConnectionMap::iterator it = m_connections.find(m_closedIds[i]);
+      if (it == m_connections.end()) {
+        continue;
+      }
+      if (!isStreamMode()) {
+        m_connectedAddrs.erase(AddressKey(it->second.m_clientAddr));
+      }
+      m_connections.erase(it);
+    }
+    m_closedIds.clear();
+
+    m_pThis->m_counters.setActiveConnections(
+        static_cast< u32 >(m_connections.size()));
+    m_pThis->m_counters.recordExpireTicks(timer::GetTicks() - now);
     handler.cleanup();
 
     return Status::OK;
@@ -336,30 +727,123 @@ class NetServer::Impl {
   /**
    *
    */
-  Status send(const tConnectionId connectionId, const ConstBlob &data) {
+  Status send(
+      const tConnectionId connectionId,
+      const ConstBlob *parts,
+      const size_t count) {
     tConnectionMap::iterator itr = m_connections.find(connectionId);
     if (itr == m_connections.end() || itr->second.m_socket == INVALID_SOCKET) {
       return Status::BAD_ARGUMENT;
     }
+    Connection &con = itr->second;
 
-    char *pStart = (char *) data.data();
-    char *pEnd = pStart + data.size();
-    while (pStart != pEnd) {
-      const int sz = static_cast< int >(std::distance(pStart, pEnd));
-      const int ret = ::sendto(
-          itr->second.m_socket,
-          pStart,
-          sz,
-          0, // flags
-          (const sockaddr *) &(itr->second.m_clientAddr),
-          sizeof(itr->second.m_clientAddr));
-      if (ret == SOCKET_ERROR) {
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+      total += parts[i].size();
+    }
+
+    if (!isStreamMode()) {
+      return sendDatagram(con, parts, count, total);
+    }
+
+    // Anything already queued must go out first, to keep the stream in order.
+    // Socket errors are left for the next read to notice and close.
+    size_t written = 0;
+    if (con.m_writeQueue.empty()) {
+      if (!writeStream(con, parts, count, written)) {
         return Status::GENERIC_ERROR;
       }
-      pStart += ret;
-      m_pThis->m_stats.m_bytesSent += ret;
+      if (written == total) {
+        countStreamPacket(con);
+        return Status::OK;
+      }
     }
-    return Status::OK;
+    Status ret = queueWrite(con, parts, count, written);
+    if (ret) {
+      countStreamPacket(con);
+    }
+    return ret;
+  }
+
+  /**
+   *
+   */
+  Status sendBatch(const OutboundMessage *msgs, const size_t count) {
+    Status::eError result = Status::OK;
+    if (isStreamMode()) {
+      for (size_t i = 0; i < count; ++i) {
+        Status ret = send(msgs[i].m_connectionId, &msgs[i].m_data, 1);
+        if (!ret && result == Status::OK) {
+          result = ret.getStatus();
+        }
+      }
+      return Status(result);
+    }
+
+#if defined(PLAT_LINUX)
+    mmsghdr headers[MAX_DATAGRAM_BATCH];
+    iovec vecs[MAX_DATAGRAM_BATCH];
+    u32 slots[MAX_DATAGRAM_BATCH];
+    size_t idx = 0;
+    while (idx < count) {
+      // Gather the next run of messages with a valid destination.
+      unsigned pending = 0;
+      for (; idx < count && pending < MAX_DATAGRAM_BATCH; ++idx) {
+        tConnectionMap::iterator itr =
+            m_connections.find(msgs[idx].m_connectionId);
+        if (itr == m_connections.end()
+            || itr->second.m_socket == INVALID_SOCKET) {
+          if (result == Status::OK) {
+            result = Status::BAD_ARGUMENT;
+          }
+          continue;
+        }
+        vecs[pending].iov_base = (void *) msgs[idx].m_data.data();
+        vecs[pending].iov_len = msgs[idx].m_data.size();
+        memset(&headers[pending], 0, sizeof(mmsghdr));
+        headers[pending].msg_hdr.msg_iov = &vecs[pending];
+        headers[pending].msg_hdr.msg_iovlen = 1;
+        headers[pending].msg_hdr.msg_name = &itr->second.m_clientAddr;
+        headers[pending].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+        slots[pending] = itr->second.m_statsSlot;
+        pending++;
+      }
+
+      unsigned sent = 0;
+      while (sent < pending) {
+        const int ret =
+            sendmmsg(m_socket, &headers[sent], pending - sent, 0);
+        if (ret == SOCKET_ERROR) {
+          m_pThis->m_counters.addSendCall(0, 0);
+          if (NetGetLastError() == EINTR) {
+            continue;
+          }
+          // Skip the datagram that failed and carry on with the rest.
+          if (result == Status::OK) {
+            result = Status::GENERIC_ERROR;
+          }
+          sent++;
+          continue;
+        }
+        u64 bytes = 0;
+        for (int i = 0; i < ret; ++i) {
+          bytes += headers[sent + i].msg_len;
+          m_connectionStats.addSent(
+              slots[sent + i], headers[sent + i].msg_len, 1);
+        }
+        m_pThis->m_counters.addSendCall(bytes, ret);
+        sent += ret;
+      }
+    }
+#else
+    for (size_t i = 0; i < count; ++i) {
+      Status ret = send(msgs[i].m_connectionId, &msgs[i].m_data, 1);
+      if (!ret && result == Status::OK) {
+        result = ret.getStatus();
+      }
+    }
+#endif
+    return Status(result);
   }
 
   /**
@@ -369,14 +853,39 @@ class NetServer::Impl {
     for (tConnectionMap::iterator itr = m_connections.begin();
          itr != m_connections.end();
          ++itr) {
-      closeConnection(itr->second, NULL);
+      closeConnection(itr->second, NULL, eCloseReason::STOPPED);
     }
     m_connections.clear();
-    m_connectedHosts.clear();
+    m_connectedAddrs.clear();
+    m_connectedSockets.clear();
+    m_timeouts.clear();
+    m_closedIds.clear();
+    m_pThis->m_counters.setActiveConnections(0);
+#if defined(PLAT_LINUX)
+    if (m_epollFd != INVALID_SOCKET) {
+      closesocket(m_epollFd);
+      m_epollFd = INVALID_SOCKET;
+    }
+#endif
     closesocket(m_socket);
     m_socket = INVALID_SOCKET;
   }
 
+  /**
+   *
+   */
+  void wake() {
+#if defined(PLAT_LINUX)
+    // The wake event is never closed before the server is destroyed.
+    if (m_wakeFd != INVALID_SOCKET) {
+      const u64 one = 1;
+      if (write(m_wakeFd, &one, sizeof(one)) != sizeof(one)) {
+        // Only fails once the counter is huge, so a wake is already pending.
+      }
+    }
+#endif
+  }
+
   /**
    *
    */
@@ -387,35 +896,532 @@ class NetServer::Impl {
    */
   eConnectionMode::type getConnectionMode() const { return m_mode; }
 
+  /**
+   *
+   */
+  int getPort() const { return static_cast< int >(m_port); }
+
+  /**
+   *
+   */
+  bool connectionStats(const tConnectionId id, ConnectionStats &out) const {
+    return m_connectionStats.find(id, out);
+  }
+
   private:
   eConnectionMode::type m_mode;
   SOCKET m_socket;
   NetServer *m_pThis;
+#if defined(PLAT_LINUX)
+  int m_epollFd;
+  int m_wakeFd;
+#endif
 
   typedef std::map< tConnectionId, Connection > tConnectionMap;
-  typedef std::map< std::string, tConnectionId > tConnectionHostMap;
   typedef std::map< SOCKET, tConnectionId > tConnectionSocketMap;
   tConnectionMap m_connections;
-  tConnectionHostMap m_connectedHosts;
+  AddressTable m_connectedAddrs;
+  DatagramRing m_datagrams;
+#if defined(PLAT_LINUX)
+  std::vector< iovec > m_sendVecs;
+#endif
   tConnectionSocketMap m_connectedSockets;
   u32 m_maxConnections;
   u32 m_port;
+  int m_waitMs;
 
-  f32 m_timeoutSec;
+  u64 m_timeoutTicks;
+  util::TimerWheel m_timeouts;
+  std::vector< util::TimerWheel::Deadline > m_expired;
+  // Connections closed since the last sweep, to drop from m_connections.
+  std::vector< tConnectionId > m_closedIds;
 
+  tConnectionId m_shardTag;
   tConnectionId m_connectionIdNext;
 
-  void closeConnection(Connection &c, iServerConnectionHandler *pHandler) {
+  ConnectionStatsTable m_connectionStats;
+
+  bool isStreamMode() const {
+    return m_mode == eConnectionMode::TCP_ASYNC
+           || m_mode == eConnectionMode::TCP_BLOCKING;
+  }
+
+  /**
+   * Hand one packet of data to the handler on behalf of {@code con}.
+   *
+   * @return false if the handler closed the connection.
+   */
+  bool processPacket(
+      Connection &con,
+      const ConstBlob &data,
+      iServerConnectionHandler &handler) {
+    m_pThis->m_counters.addRecieved(data.size());
+    m_connectionStats.addRecieved(con.m_statsSlot, data.size());
+    con.m_lastModified = timer::GetTicks();
+    const bool open = handler.process(*m_pThis, con.m_id, data);
+    m_pThis->m_counters.recordProcessTicks(
+        timer::GetTicks() - con.m_lastModified);
+    if (!open) {
+      closeConnection(con, &handler, eCloseReason::HANDLER);
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Count a message handed to {@link #send} on a stream. Its bytes are counted
+   * as they are written.
+   */
+  void countStreamPacket(Connection &con) {
+    m_pThis->m_counters.addSent(0, 1);
+    m_connectionStats.addSent(con.m_statsSlot, 0, 1);
+  }
+
+#if defined(PLAT_LINUX)
+  /**
+   * Create the epoll queue and register the listen socket and the wake event
+   * with it. The listen socket is tagged with {@link INVALID_CONNECTION_ID},
+   * the wake event with {@link WAKE_EVENT_ID}, all other sockets with the id
+   * of their connection.
+   */
+  bool openEventQueue() {
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd == INVALID_SOCKET) {
+      return false;
+    }
+    // Edge triggered requires draining the listen socket without blocking.
+    if (m_wakeFd == INVALID_SOCKET
+        || (isStreamMode() && !SetNonBlocking(m_socket))
+        || !watchSocket(m_socket, INVALID_CONNECTION_ID)
+        || !watchSocket(m_wakeFd, WAKE_EVENT_ID)) {
+      closesocket(m_epollFd);
+      m_epollFd = INVALID_SOCKET;
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Register {@code socket} for edge-triggered read events.
+   */
+  bool watchSocket(SOCKET socket, const tConnectionId id) {
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+    event.data.u32 = id;
+    return epoll_ctl(m_epollFd, EPOLL_CTL_ADD, socket, &event) == 0;
+  }
+
+  /**
+   * Turn edge-triggered write events on or off for a stream connection.
+   */
+  void watchWrites(Connection &con, const bool enable) {
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events =
+        EPOLLIN | EPOLLRDHUP | EPOLLET | (enable ? (u32) EPOLLOUT : 0u);
+    event.data.u32 = con.m_id;
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_MOD, con.m_socket, &event) != 0) {
+      Log(LL::Trace) << "Error <" << NetGetLastError()
+                     << "> updating epoll events.";
+    }
+  }
+
+  /**
+   * Remove {@code socket} from the epoll queue.
+   */
+  void unwatchSocket(SOCKET socket) {
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_DEL, socket, &event) != 0) {
+      Log(LL::Trace) << "Error <" << NetGetLastError()
+                     << "> removing socket from epoll.";
+    }
+  }
+
+  /**
+   * Wait for readiness events, and service only the sockets that are ready.
+   */
+  Status readReadySockets(iServerConnectionHandler &handler) {
+    int waitMs = m_waitMs;
+    if (waitMs < 0) {
+      waitMs = 0;
+      switch (m_mode) {
+        case eConnectionMode::TCP_BLOCKING:
+        case eConnectionMode::UDP_BLOCKING:
+          waitMs = BLOCKING_WAIT_MS;
+          break;
+        default:
+          break;
+      }
+    }
+
+    epoll_event events[MAX_EPOLL_EVENTS];
+    const int count = epoll_wait(m_epollFd, events, MAX_EPOLL_EVENTS, waitMs);
+    if (count == SOCKET_ERROR) {
+      return (NetGetLastError() == EINTR) ? Status::OK : Status::GENERIC_ERROR;
+    }
+
+    for (int i = 0; i < count; ++i) {
+      const tConnectionId id = events[i].data.u32;
+      if (id == WAKE_EVENT_ID) {
+        u64 wakeCount;
+        while (read(m_wakeFd, &wakeCount, sizeof(wakeCount)) > 0) {
+        }
+        continue;
+      }
+      if (id == INVALID_CONNECTION_ID) {
+        if (isStreamMode()) {
+          Status ret = acceptPending(handler);
+          if (!ret) {
+            return ret;
+          }
+        } else {
+          drainDatagrams(handler);
+        }
+        continue;
+      }
+
+      tConnectionMap::iterator itr = m_connections.find(id);
+      if (itr == m_connections.end()
+          || itr->second.m_socket == INVALID_SOCKET) {
+        continue;
+      }
+      if (events[i].events & EPOLLOUT) {
+        flushWrites(itr->second, handler);
+      }
+      // A failed flush closes the connection.
+      if ((events[i].events & ~EPOLLOUT)
+          && itr->second.m_socket != INVALID_SOCKET) {
+        drainStream(itr->second, handler);
+      }
+    }
+    return Status::OK;
+  }
+
+  /**
+   * Accept every pending connection on the (non-blocking) listen socket.
+   */
+  Status acceptPending(iServerConnectionHandler &handler) {
+    while (true) {
+      SOCKET clientSocket = accept(m_socket, NULL, NULL);
+      if (clientSocket == INVALID_SOCKET) {
+        const int errorcode = NetGetLastError();
+        if (errorcode == EINTR || errorcode == ECONNABORTED) {
+          continue;
+        }
+        if (errorcode == SOCKET_WOULD_BLOCK || errorcode == EAGAIN) {
+          return Status::OK;
+        }
+        return Status::GENERIC_ERROR;
+      }
+      if (!insertConnection(clientSocket, handler)) {
+        closesocket(clientSocket);
+      }
+    }
+  }
+
+  /**
+   * Read everything available on a connected stream socket.
+   */
+  void drainStream(Connection &con, iServerConnectionHandler &handler) {
+    while (receiveStream(con, handler, MSG_DONTWAIT)) {
+    }
+  }
+
+  /**
+   * Read every datagram available on the shared UDP socket.
+   * A short batch means the socket reported EWOULDBLOCK, so it is drained.
+   */
+  void drainDatagrams(iServerConnectionHandler &handler) {
+    while (receiveDatagrams(handler) == MAX_DATAGRAM_BATCH) {
+    }
+  }
+#endif
+
+  /**
+   * Read one batch of datagrams from the shared UDP socket, and hand each of
+   * them to the connection of its sender.
+   *
+   * @return the number of datagrams read.
+   */
+  size_t receiveDatagrams(iServerConnectionHandler &handler) {
+    m_pThis->m_counters.addRecvCall();
+    const size_t count = m_datagrams.receive(m_socket);
+    for (size_t i = 0; i < count; ++i) {
+      const ConstBlob data = m_datagrams.data(i);
+      Connection *con;
+      if (data.size() == 0
+          || !getConnectionForHost(
+              &con, m_socket, m_datagrams.address(i), handler)) {
+        continue;
+      }
+      processPacket(*con, data, handler);
+    }
+    return count;
+  }
+
+  /**
+   * Read once from a connected stream socket, into the handler's buffer when
+   * it provides one.
+   *
+   * @return true if data was processed and the connection is still open.
+   */
+  bool receiveStream(
+      Connection &con, iServerConnectionHandler &handler, const int flags) {
+    u8 buffer[MAX_PACKET_SIZE];
+    Blob target = handler.readBuffer(con.m_id);
+    if (target.size() == 0) {
+      target = Blob(buffer, MAX_PACKET_SIZE);
+    }
+
+    int ret;
+    do {
+      ret = ::recv(
+          con.m_socket, (char *) target.data(), (int) target.size(), flags);
+      m_pThis->m_counters.addRecvCall();
+    } while (ret == SOCKET_ERROR && NetGetLastError() == EINTR);
+
+    if (ret > 0) {
+      return processPacket(con, ConstBlob(target.data(), ret), handler);
+    } else if (ret == 0) {
+      Log(LL::Info) << "Connection closed: " << con.m_id;
+      closeConnection(con, &handler, eCloseReason::REMOTE);
+    } else {
+      const int errorcode = NetGetLastError();
+      if (errorcode != SOCKET_WOULD_BLOCK && errorcode != EAGAIN) {
+        Log(LL::Info) << "Connection error on connection: " << con.m_id;
+        closeConnection(con, &handler, eCloseReason::FAILED);
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Send {@code parts} as a single datagram to {@code con}.
+   */
+  Status sendDatagram(
+      Connection &con,
+      const ConstBlob *parts,
+      const size_t count,
+      const size_t total) {
+#if defined(PLAT_LINUX)
+    RET_SM(count <= MAX_SEND_PARTS, Status::BAD_ARGUMENT, "Too many parts.");
+    m_sendVecs.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      m_sendVecs[i].iov_base = (void *) parts[i].data();
+      m_sendVecs[i].iov_len = parts[i].size();
+    }
+    msghdr header;
+    memset(&header, 0, sizeof(header));
+    header.msg_name = (void *) &con.m_clientAddr;
+    header.msg_namelen = sizeof(con.m_clientAddr);
+    header.msg_iov = m_sendVecs.data();
+    header.msg_iovlen = count;
+
+    ssize_t ret;
+    do {
+      ret = ::sendmsg(con.m_socket, &header, 0);
+    } while (ret == SOCKET_ERROR && NetGetLastError() == EINTR);
+#else
+    std::vector< u8 > joined;
+    joined.reserve(total);
+    for (size_t i = 0; i < count; ++i) {
+      joined.insert(
+          joined.end(), parts[i].data(), parts[i].data() + parts[i].size());
+    }
+    const int ret = ::sendto(
+        con.m_socket,
+        (const char *) joined.data(),
+        (int) joined.size(),
+        0, // flags
+        (const sockaddr *) &con.m_clientAddr,
+        sizeof(con.m_clientAddr));
+#endif
+    if (ret == SOCKET_ERROR) {
+      m_pThis->m_counters.addSendCall(0, 0);
+      return Status::GENERIC_ERROR;
+    }
+    m_pThis->m_counters.addSendCall(ret, 1);
+    m_connectionStats.addSent(con.m_statsSlot, ret, 1);
+    return ((size_t) ret == total) ? Status::OK : Status::GENERIC_ERROR;
+  }
+
+  /**
+   * Write {@code parts} to a stream socket, until it is all written or the
+   * socket would block.
+   *
+   * @param written set to the number of bytes written
+   * @return false on a socket error
+   */
+  bool writeStream(
+      Connection &con,
+      const ConstBlob *parts,
+      const size_t count,
+      size_t &written) {
+    written = 0;
+    size_t part = 0;
+    size_t offset = 0;
+    while (part < count) {
+      if (offset == parts[part].size()) {
+        part++;
+        offset = 0;
+        continue;
+      }
+
+#if defined(PLAT_LINUX)
+      const size_t vecs = std::min(count - part, MAX_SEND_PARTS);
+      m_sendVecs.resize(vecs);
+      for (size_t i = 0; i < vecs; ++i) {
+        m_sendVecs[i].iov_base = (void *) parts[part + i].data();
+        m_sendVecs[i].iov_len = parts[part + i].size();
+      }
+      m_sendVecs[0].iov_base = (void *) (parts[part].data() + offset);
+      m_sendVecs[0].iov_len -= offset;
+
+      msghdr header;
+      memset(&header, 0, sizeof(header));
+      header.msg_iov = m_sendVecs.data();
+      header.msg_iovlen = vecs;
+      const int flags = MSG_NOSIGNAL
+                        | (m_mode == eConnectionMode::TCP_ASYNC ? MSG_DONTWAIT
+                                                                 : 0);
+      const ssize_t ret = ::sendmsg(con.m_socket, &header, flags);
+#else
+      const int ret = ::send(
+          con.m_socket,
+          (const char *) parts[part].data() + offset,
+          (int) (parts[part].size() - offset),
+          0);
+#endif
+      if (ret == SOCKET_ERROR) {
+        m_pThis->m_counters.addSendCall(0, 0);
+        const int errorcode = NetGetLastError();
+        if (errorcode == EINTR) {
+          continue;
+        }
+        return errorcode == SOCKET_WOULD_BLOCK || errorcode == EAGAIN;
+      }
+
+      written += ret;
+      m_pThis->m_counters.addSendCall(ret, 0);
+      m_connectionStats.addSent(con.m_statsSlot, ret, 0);
+      size_t advance = ret;
+      while (advance > 0) {
+        const size_t step = std::min(advance, parts[part].size() - offset);
+        advance -= step;
+        offset += step;
+        if (offset == parts[part].size()) {
+          part++;
+          offset = 0;
+        }
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Queue everything past the first {@code skip} bytes of {@code parts}, to be
+   * written once the socket is writable again.
+   */
+  Status queueWrite(
+      Connection &con,
+      const ConstBlob *parts,
+      const size_t count,
+      size_t skip) {
+    const bool wasEmpty = con.m_writeQueue.empty();
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+      total += parts[i].size();
+    }
+    // Messages are queued whole or not at all, so a refusal cannot tear one.
+    if (!wasEmpty
+        && con.m_writeQueue.size() - con.m_writeHead + total
+               > MAX_WRITE_QUEUE) {
+      Log(LL::Warning) << "Write queue full for connection " << con.m_id;
+      return Status::OUT_OF_BOUNDS;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+      const size_t sz = parts[i].size();
+      if (skip >= sz) {
+        skip -= sz;
+        continue;
+      }
+      con.m_writeQueue.insert(
+          con.m_writeQueue.end(), parts[i].data() + skip, parts[i].data() + sz);
+      skip = 0;
+    }
+
+#if defined(PLAT_LINUX)
+    if (wasEmpty && m_epollFd != INVALID_SOCKET) {
+      watchWrites(con, true);
+    }
+#endif
+    return Status::OK;
+  }
+
+  /**
+   * Write as much of the connection's queued data as the socket will take.
+   */
+  void flushWrites(Connection &con, iServerConnectionHandler &handler) {
+    if (con.m_writeQueue.empty() || con.m_socket == INVALID_SOCKET) {
+      return;
+    }
+
+    const ConstBlob pending(
+        &con.m_writeQueue[con.m_writeHead],
+        con.m_writeQueue.size() - con.m_writeHead);
+    size_t written = 0;
+    if (!writeStream(con, &pending, 1, written)) {
+      Log(LL::Info) << "Connection error on connection: " << con.m_id;
+      closeConnection(con, &handler, eCloseReason::FAILED);
+      return;
+    }
+
+    con.m_writeHead += written;
+    if (con.m_writeHead == con.m_writeQueue.size()) {
+      con.m_writeQueue.clear();
+      con.m_writeHead = 0;
+#if defined(PLAT_LINUX)
+      if (m_epollFd != INVALID_SOCKET) {
+        watchWrites(con, false);
+      }
+#endif
+    } else if (con.m_writeHead > con.m_writeQueue.size() / 2) {
+      con.m_writeQueue.erase(
+          con.m_writeQueue.begin(),
+          con.m_writeQueue.begin() + con.m_writeHead);
+      con.m_writeHead = 0;
+    }
+  }
+
+  void closeConnection(
+      Connection &c,
+      iServerConnectionHandler *pHandler,
+      const eCloseReason::type reason) {
     if (c.m_socket == INVALID_SOCKET) {
       return;
     }
+    c.m_writeQueue.clear();
+    c.m_writeHead = 0;
+    m_closedIds.push_back(c.m_id);
+    m_pThis->m_counters.addClose(reason);
+    m_connectionStats.release(c.m_statsSlot);
+    c.m_statsSlot = ConnectionStatsTable::INVALID_SLOT;
 
     Log(LL::Info) << "Closing connection: " << c.m_id << ":" << c.m_hostName;
-    if (m_mode == eConnectionMode::TCP_ASYNC
-        || m_mode == eConnectionMode::TCP_BLOCKING) {
+    if (isStreamMode()) {
+#if defined(PLAT_LINUX)
+      if (m_epollFd != INVALID_SOCKET) {
+        unwatchSocket(c.m_socket);
+      }
+#endif
+      m_connectedSockets.erase(c.m_socket);
       closesocket(c.m_socket);
-      c.m_socket = INVALID_SOCKET;
     }
+    // Datagram connections share the server socket, so only mark them closed.
+    c.m_socket = INVALID_SOCKET;
 
     if (pHandler) {
       pHandler->close(c.m_id);
@@ -428,39 +1434,73 @@ class NetServer::Impl {
     socklen_t addr_len = sizeof(addr);
     if (getpeername(clientSocket, (struct sockaddr *) &addr, &addr_len)
         != SOCKET_ERROR) {
-      return insertConnection(clientSocket, addr, handler);
+      return insertConnection(clientSocket, addr, handler) != NULL;
     }
     return false;
   }
 
-  bool insertConnection(
+  /**
+   * @return the new connection, or NULL if it was refused.
+   */
+  Connection *insertConnection(
       SOCKET &clientSocket,
       const sockaddr_storage &host,
       iServerConnectionHandler &handler) {
     if (m_connections.size() >= m_maxConnections) {
       Log(LL::Warning) << "Max connections (" << m_maxConnections
                        << ") was reached. Dropping connection attempt.";
-      return false;
+      return NULL;
     }
 
+    // Only formatted here, for logging. Lookups use the binary address.
     std::string addrString = "<unknown>";
-    if (!getHostName(addrString, host)) {
-      return false;
+    getHostName(addrString, host);
+
+    // Async streams queue what the socket will not take, rather than block.
+    if (m_mode == eConnectionMode::TCP_ASYNC && !SetNonBlocking(clientSocket)) {
+      Log(LL::Warning) << "Error <" << NetGetLastError()
+                       << "> making connection non-blocking.";
+      return NULL;
+    }
+
+    const tConnectionId id = nextConnectionId();
+#if defined(PLAT_LINUX)
+    if (m_epollFd != INVALID_SOCKET && isStreamMode()
+        && !watchSocket(clientSocket, id)) {
+      Log(LL::Warning) << "Error <" << NetGetLastError()
+                       << "> adding connection to epoll.";
+      return NULL;
     }
+#endif
 
-    Connection con = Connection(
-        m_connectionIdNext++,
-        core::timer::GetTicks(),
-        clientSocket,
-        addrString,
-        host);
-    m_connections[con.m_id] = con;
-    m_connectedHosts[con.m_hostName] = con.m_id;
-    m_connectedSockets[clientSocket] = con.m_id;
+    const u64 now = core::timer::GetTicks();
+    Connection &con = m_connections[id];
+    con = Connection(
+        id, now, clientSocket, addrString, host, m_connectionStats.acquire(id));
+    m_pThis->m_counters.addAccept();
+    con.m_timeoutDeadline = now + m_timeoutTicks;
+    m_timeouts.schedule(id, con.m_timeoutDeadline);
+    if (isStreamMode()) {
+      m_connectedSockets[clientSocket] = con.m_id;
+    } else {
+      m_connectedAddrs.insert(AddressKey(host), con.m_id);
+    }
     handler.open(con.m_id);
     Log(LL::Info) << "Accepted connection " << con.m_id << " from "
                   << con.m_hostName;
-    return true;
+    return &con;
+  }
+
+  /**
+   * Pick the next unused connection id, tagged with this server's shard.
+   */
+  tConnectionId nextConnectionId() {
+    tConnectionId id;
+    do {
+      id = m_shardTag | m_connectionIdNext;
+      m_connectionIdNext = (m_connectionIdNext % CONNECTION_LOCAL_MASK) + 1;
+    } while (m_connections.find(id) != m_connections.end());
+    return id;
   }
 
   std::vector< SOCKET > getAllConnectedSockets() {
@@ -479,24 +1519,23 @@ class NetServer::Impl {
       const sockaddr_storage &host,
       iServerConnectionHandler &handler) {
     *rVal = NULL;
-    std::string hostName;
-    if (getHostName(hostName, host)) {
-      tConnectionHostMap::const_iterator itr = m_connectedHosts.find(hostName);
-      if (itr != m_connectedHosts.end()) {
-        *rVal = &m_connections[itr->second];
-      } else if (
-          m_mode == eConnectionMode::UDP_ASYNC
-          || m_mode == eConnectionMode::UDP_BLOCKING) {
-        if (insertConnection(clientSocket, host, handler)) {
-          *rVal = &m_connections[m_connectionIdNext - 1];
-        }
-      }
-    } else {
+    if (isStreamMode()) {
       tConnectionSocketMap::const_iterator itr =
           m_connectedSockets.find(clientSocket);
       if (itr != m_connectedSockets.end()) {
         *rVal = &m_connections[itr->second];
       }
+    } else {
+      const tConnectionId id = m_connectedAddrs.find(AddressKey(host));
+      if (id != INVALID_CONNECTION_ID) {
+        tConnectionMap::iterator itr = m_connections.find(id);
+        if (itr != m_connections.end()
+            && itr->second.m_socket != INVALID_SOCKET) {
+          *rVal = &itr->second;
+        }
+      } else {
+        *rVal = insertConnection(clientSocket, host, handler);
+      }
     }
     return *rVal != NULL;
   }
@@ -520,7 +1559,7 @@ class NetServer::Impl {
             NI_MAXHOST,
             nullptr,
             0,
-            NI_NUMERICSERV)
+            NI_NUMERICHOST | NI_NUMERICSERV)
         != 0) {
       Log(LL::Trace) << "Could not resolve host name.";
       return false;
@@ -541,8 +1580,9 @@ class NetServer::Impl {
 /**
  * Delegate to implementation
  */
-NetServer::NetServer(eConnectionMode::type mode)
-    : m_pImpl(new NetServer::Impl(mode)) {
+NetServer::NetServer(eConnectionMode::type mode, const u32 shard)
+    : m_pImpl(new NetServer::Impl(mode, shard)) {
+  CHECK_M(shard < (1u << CONNECTION_SHARD_BITS) - 1, "Bad server shard");
 }
 
 /**
@@ -568,10 +1608,19 @@ Status NetServer::start(const core::net::ServerDef &def) {
   CHECK_M(
       def.m_connectionTimeoutSec >= 0,
       "Bad server timeout"); // require positive
+  CHECK_M(
+      def.m_eventBackend >= 0 && def.m_eventBackend < eEventBackend::COUNT,
+      "Bad server event backend");
 
   CHECK_M(core::net::IsInitialized(), "net::Initialize() must be called");
   return m_pImpl->start(
-      this, def.m_port, def.m_maxConnections, def.m_connectionTimeoutSec);
+      this,
+      def.m_port,
+      def.m_maxConnections,
+      def.m_connectionTimeoutSec,
+      def.m_eventBackend,
+      def.m_reusePort,
+      def.m_waitMs);
 }
 
 /**
@@ -591,6 +1640,7 @@ Status NetServer::update(iServerConnectionHandler &handler) {
   if (!valid()) {
     return Status::BAD_STATE;
   }
+  core::memory::ScopedMemoryTag tag(core::memory::eMemoryTag::NET);
 
   Status ret = m_pImpl->acceptConnections(handler);
   if (!ret) {
@@ -599,6 +1649,13 @@ Status NetServer::update(iServerConnectionHandler &handler) {
   return m_pImpl->readConnections(handler);
 }
 
+/**
+ * Delegate to implementation
+ */
+void NetServer::wake() {
+  m_pImpl->wake();
+}
+
 /**
  * Delegate to implementation
  */
@@ -615,7 +1672,55 @@ Status NetServer::send(const tConnectionId connectionId, const ConstBlob &msg) {
   }
   ASSERT(msg.size() < std::numeric_limits< int >::max());
 
-  return m_pImpl->send(connectionId, msg);
+  core::memory::ScopedMemoryTag tag(core::memory::eMemoryTag::NET);
+  return m_pImpl->send(connectionId, &msg, 1);
+}
+
+/**
+ * Delegate to implementation
+ */
+Status NetServer::send(
+    const tConnectionId connectionId,
+    const ConstBlob *parts,
+    const size_t count) {
+  if (!valid()) {
+    return Status::BAD_STATE;
+  }
+  core::memory::ScopedMemoryTag tag(core::memory::eMemoryTag::NET);
+  return m_pImpl->send(connectionId, parts, count);
+}
+
+/**
+ * Delegate to implementation
+ */
+Status NetServer::sendBatch(const OutboundMessage *msgs, const size_t count) {
+  if (!valid()) {
+    return Status::BAD_STATE;
+  }
+  core::memory::ScopedMemoryTag tag(core::memory::eMemoryTag::NET);
+  return m_pImpl->sendBatch(msgs, count);
+}
+
+/**
+ * Delegate to implementation
+ */
+int NetServer::getPort() const {
+  return m_pImpl->getPort();
+}
+
+/**
+ * Delegate to implementation
+ */
+bool NetServer::connectionStats(
+    const tConnectionId connectionId, ConnectionStats &out) const {
+  return m_pImpl->connectionStats(connectionId, out);
+}
+
+/**
+ *
+ */
+NetStats NetServer::stats() const {
+  return m_counters.snapshot();
 }
 
 /**
@@ -5,6 +5,7 @@
 #define FISHY_NET_SERVER_H
 
 #include "net_common.h"
+#include "net_stats.h"
 
 #include <CORE/BASE/status.h>
 #include <CORE/MEMORY/blob.h>
@@ -15,6 +16,19 @@ namespace net {
 
 class iNetServer;
 
+/**
+ * A single message for {@link iNetServer#sendBatch}.
+ */
+struct OutboundMessage {
+  OutboundMessage() : m_connectionId(INVALID_CONNECTION_ID) {}
+  OutboundMessage(
+      const tConnectionId connectionId, const core::memory::ConstBlob &data)
+      : m_connectionId(connectionId), m_data(data) {}
+
+  tConnectionId m_connectionId;
+  core::memory::ConstBlob m_data;
+};
+
 /**
  * Data handler called from {@link iNetServer#update}
  */
@@ -48,6 +62,19 @@ class iServerConnectionHandler {
    */
   virtual void close(const tConnectionId connectionId) = 0;
 
+  /**
+   * Called before reading stream data for a connection. Handlers which buffer
+   * stream data may return free space to receive directly into, and the data
+   * passed to {@link #process} will then point into that space.
+   *
+   * @param connectionId the connection about to be read
+   * @return writable space, or an empty blob to use the server's own buffer
+   */
+  virtual core::memory::Blob readBuffer(const tConnectionId connectionId) {
+    (void) connectionId;
+    return core::memory::Blob();
+  }
+
   /**
    * Called after all calls to process before {@link iNetServer#update} returns.
    * Allows the connection handler to clean out temporary data and compact
@@ -94,6 +121,33 @@ class iNetServer : util::noncopyable {
   virtual Status send(
       const tConnectionId connectionId, const core::memory::ConstBlob &msg) = 0;
 
+  /**
+   * Send a single message gathered from several parts, without first joining
+   * them into one buffer. Datagram modes send the parts as one datagram.
+   *
+   * Async stream modes never block: whatever the socket will not take is
+   * queued on the connection, and written as the socket becomes writable.
+   *
+   * @param connectionId active connection to send data to
+   * @param parts pieces of the message, in order. Caller owns the blobs.
+   * @param count number of entries in {@code parts}
+   */
+  virtual Status send(
+      const tConnectionId connectionId,
+      const core::memory::ConstBlob *parts,
+      const size_t count) = 0;
+
+  /**
+   * Send many messages, coalesced into as few syscalls as the protocol
+   * allows. Intended to be called once per tick with all outbound traffic.
+   *
+   * @param msgs messages to send. Caller owns the blobs.
+   * @param count number of messages in {@code msgs}
+   * @return OK if every message was sent, otherwise the first error seen.
+   *     Sending continues past failed messages.
+   */
+  virtual Status sendBatch(const OutboundMessage *msgs, const size_t count) = 0;
+
   /**
    * @return statistics about the connection
    */
@@ -112,8 +166,11 @@ class NetServer : public iNetServer {
   public:
   /**
    * Create a server with {@code mode} type of network protocol.
+   *
+   * @param shard index tagged into every connection id, see
+   *     {@link GetConnectionShard}
    */
-  NetServer(eConnectionMode::type mode);
+  NetServer(eConnectionMode::type mode, const u32 shard = 0);
   ~NetServer();
 
   virtual Status start(const core::net::ServerDef &def);
@@ -122,14 +179,40 @@ class NetServer : public iNetServer {
   virtual bool valid() const;
   virtual Status
   send(const tConnectionId connectionId, const core::memory::ConstBlob &msg);
+  virtual Status send(
+      const tConnectionId connectionId,
+      const core::memory::ConstBlob *parts,
+      const size_t count);
+  virtual Status sendBatch(const OutboundMessage *msgs, const size_t count);
   virtual eConnectionMode::type getConnectionMode() const;
 
-  virtual NetStats stats() const { return m_stats; }
+  virtual NetStats stats() const;
+
+  /**
+   * Return an {@link #update} waiting for socket activity on another thread
+   * early. Safe to call from any thread while the server is started. Only
+   * the EPOLL backend waits on the wake; SELECT returns once its wait is up.
+   */
+  void wake();
+
+  /**
+   * @return the port the server is bound to, useful after starting on port 0
+   */
+  int getPort() const;
+
+  /**
+   * Copy the traffic counters of connection {@code connectionId}. Safe to call
+   * from any thread.
+   *
+   * @return false if there is no such open connection
+   */
+  bool connectionStats(
+      const tConnectionId connectionId, ConnectionStats &out) const;
 
   private:
   class Impl;
   Impl *m_pImpl;
-  NetStats m_stats;
+  NetCounters m_counters;
 };
 
 } // namespace net
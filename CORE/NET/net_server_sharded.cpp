@@ -0,0 +1,515 @@
+#include "net_server_sharded.h"
+
+#include <CORE/BASE/checks.h>
+#include <CORE/BASE/logging.h>
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using core::memory::ConstBlob;
+
+namespace core {
+namespace net {
+
+/**
+ * Longest a shard waits for socket activity or a queued send, so connection
+ * timeouts are still checked about as often as the timer wheel turns.
+ */
+static const int SHARD_WAIT_MS = 100;
+
+/**
+ * Bytes other threads may have queued for a shard before further sends fail,
+ * so a stalled shard can not grow memory without limit.
+ */
+static const size_t MAX_SHARD_QUEUE = 4 * 1024 * 1024;
+
+/**
+ * Message queued for a shard by a thread that does not own it.
+ */
+struct QueuedMessage {
+  QueuedMessage(
+      const tConnectionId connectionId,
+      const ConstBlob *parts,
+      const size_t count)
+      : m_next(NULL), m_connectionId(connectionId) {
+    for (size_t i = 0; i < count; ++i) {
+      m_data.insert(
+          m_data.end(), parts[i].data(), parts[i].data() + parts[i].size());
+    }
+  }
+
+  QueuedMessage *m_next;
+  tConnectionId m_connectionId;
+  std::vector< u8 > m_data;
+};
+
+/**
+ * A single {@link NetServer}, its thread and its outbound queue.
+ * Forwards handler calls to the user handler with the sharded server.
+ */
+class Shard : public iServerConnectionHandler {
+  public:
+  Shard(iNetServer &owner, eConnectionMode::type mode, const u32 index)
+      : m_owner(owner),
+        m_server(mode, index),
+        m_handler(NULL),
+        m_running(false),
+        m_failed(false),
+        m_outbound(NULL),
+        m_outboundBytes(0) {}
+
+  ~Shard() { freeMessages(m_outbound.exchange(NULL)); }
+
+  /**
+   *
+   */
+  virtual bool process(
+      iNetServer &, const tConnectionId connectionId, const ConstBlob &data) {
+    return m_handler->process(m_owner, connectionId, data);
+  }
+
+  /**
+   *
+   */
+  virtual void open(const tConnectionId connectionId) {
+    m_handler->open(connectionId);
+  }
+
+  /**
+   *
+   */
+  virtual void close(const tConnectionId connectionId) {
+    m_handler->close(connectionId);
+  }
+
+  /**
+   *
+   */
+  virtual core::memory::Blob readBuffer(const tConnectionId connectionId) {
+    return m_handler->readBuffer(connectionId);
+  }
+
+  /**
+   *
+   */
+  virtual void cleanup() { m_handler->cleanup(); }
+
+  /**
+   * Launch the shard thread, driving {@code handler}.
+   */
+  void run(iServerConnectionHandler &handler) {
+    m_handler = &handler;
+    m_running = true;
+    m_thread = std::thread(&Shard::loop, this);
+  }
+
+  /**
+   * Join the shard thread. Its server stays open, as other shards may still
+   * queue sends to it, until {@link #close}.
+   */
+  void join() {
+    m_running = false;
+    if (m_thread.joinable()) {
+      m_server.wake();
+      m_thread.join();
+    }
+  }
+
+  /**
+   * Stop the server, once every shard thread is joined.
+   */
+  void close() {
+    m_server.stop();
+    freeMessages(m_outbound.exchange(NULL));
+  }
+
+  /**
+   * @return true if the calling thread is the one driving this shard
+   */
+  bool isOwningThread() const {
+    return m_thread.get_id() == std::this_thread::get_id();
+  }
+
+  /**
+   * Queue {@code parts} to be sent from the shard thread, and wake it. Lock
+   * free, and safe to call from any number of threads.
+   *
+   * @return OUT_OF_BOUNDS if the shard already has {@link MAX_SHARD_QUEUE}
+   *     bytes queued
+   */
+  Status enqueue(
+      const tConnectionId connectionId,
+      const ConstBlob *parts,
+      const size_t count) {
+    size_t size = 0;
+    for (size_t i = 0; i < count; ++i) {
+      size += parts[i].size();
+    }
+    if (m_outboundBytes.fetch_add(size, std::memory_order_relaxed) + size
+        > MAX_SHARD_QUEUE) {
+      m_outboundBytes.fetch_sub(size, std::memory_order_relaxed);
+      return Status::OUT_OF_BOUNDS;
+    }
+
+    QueuedMessage *msg = new QueuedMessage(connectionId, parts, count);
+    msg->m_next = m_outbound.load(std::memory_order_relaxed);
+    while (!m_outbound.compare_exchange_weak(
+        msg->m_next,
+        msg,
+        std::memory_order_release,
+        std::memory_order_relaxed)) {
+    }
+
+    // Messages pushed on top of others go out with them, on the wake the
+    // first one gave.
+    if (msg->m_next == NULL) {
+      m_server.wake();
+    }
+    return Status::OK;
+  }
+
+  bool failed() const { return m_failed; }
+
+  NetServer &server() { return m_server; }
+
+  private:
+  iNetServer &m_owner;
+  NetServer m_server;
+  iServerConnectionHandler *m_handler;
+  std::thread m_thread;
+  std::atomic_bool m_running;
+  std::atomic_bool m_failed;
+  std::atomic< QueuedMessage * > m_outbound;
+  std::atomic< size_t > m_outboundBytes;
+
+  /**
+   * Shard thread main loop. Each update waits for socket activity, or for
+   * {@link #enqueue} or {@link #stop} to wake it.
+   */
+  void loop() {
+    while (m_running) {
+      flushOutbound();
+      if (!m_server.update(*this)) {
+        Log(LL::Error) << "Server shard stopped on update failure.";
+        m_failed = true;
+        break;
+      }
+    }
+    flushOutbound();
+  }
+
+  /**
+   * Send everything queued by other threads, in the order it was queued.
+   */
+  void flushOutbound() {
+    QueuedMessage *head = m_outbound.exchange(NULL, std::memory_order_acquire);
+    if (head == NULL) {
+      return;
+    }
+
+    // The queue is a stack, reverse it to preserve send order.
+    QueuedMessage *ordered = NULL;
+    while (head != NULL) {
+      QueuedMessage *next = head->m_next;
+      head->m_next = ordered;
+      ordered = head;
+      head = next;
+    }
+
+    for (QueuedMessage *msg = ordered; msg != NULL; msg = msg->m_next) {
+      if (!m_server.send(
+              msg->m_connectionId,
+              ConstBlob(msg->m_data.data(), msg->m_data.size()))) {
+        Log(LL::Trace) << "Dropped queued message for connection "
+                       << msg->m_connectionId;
+      }
+    }
+    freeMessages(ordered);
+  }
+
+  /**
+   *
+   */
+  void freeMessages(QueuedMessage *msg) {
+    while (msg != NULL) {
+      QueuedMessage *next = msg->m_next;
+      m_outboundBytes.fetch_sub(msg->m_data.size(), std::memory_order_relaxed);
+      delete msg;
+      msg = next;
+    }
+  }
+};
+
+/**
+ *
+ */
+class ShardedNetServer::Impl {
+  public:
+  Impl(iNetServer &owner, eConnectionMode::type mode, const u32 shardCount)
+      : m_mode(mode), m_handler(NULL), m_port(0) {
+    for (u32 i = 0; i < shardCount; ++i) {
+      m_shards.push_back(new Shard(owner, mode, i));
+    }
+  }
+
+  ~Impl() {
+    for (size_t i = 0; i < m_shards.size(); ++i) {
+      delete m_shards[i];
+    }
+  }
+
+  /**
+   *
+   */
+  Status start(const ServerDef &def) {
+    ServerDef shardDef = def;
+    shardDef.m_reusePort = true;
+    shardDef.m_eventBackend = eEventBackend::EPOLL;
+    if (shardDef.m_waitMs < 0) {
+      shardDef.m_waitMs = SHARD_WAIT_MS;
+    }
+    for (size_t i = 0; i < m_shards.size(); ++i) {
+      Status ret = m_shards[i]->server().start(shardDef);
+      if (!ret) {
+        stop();
+        return ret;
+      }
+      if (i == 0) {
+        // Remaining shards join whichever port the first one was given.
+        m_port = m_shards[0]->server().getPort();
+        shardDef.m_port = m_port;
+      }
+    }
+    return Status::ok();
+  }
+
+  /**
+   *
+   */
+  void stop() {
+    // Any running shard may send to any other, so all are joined before the
+    // first server is stopped.
+    for (size_t i = 0; i < m_shards.size(); ++i) {
+      m_shards[i]->join();
+    }
+    for (size_t i = 0; i < m_shards.size(); ++i) {
+      m_shards[i]->close();
+    }
+    m_handler = NULL;
+  }
+
+  /**
+   *
+   */
+  Status update(iServerConnectionHandler &handler) {
+    if (m_handler == NULL) {
+      m_handler = &handler;
+      for (size_t i = 0; i < m_shards.size(); ++i) {
+        m_shards[i]->run(handler);
+      }
+    }
+    ASSERT(m_handler == &handler);
+
+    for (size_t i = 0; i < m_shards.size(); ++i) {
+      RET_SM(!m_shards[i]->failed(), Status::GENERIC_ERROR, "Shard failed.");
+    }
+    return Status::ok();
+  }
+
+  /**
+   *
+   */
+  bool valid() const {
+    for (size_t i = 0; i < m_shards.size(); ++i) {
+      if (m_shards[i]->failed() || !m_shards[i]->server().valid()) {
+        return false;
+      }
+    }
+    return !m_shards.empty();
+  }
+
+  /**
+   *
+   */
+  Status send(
+      const tConnectionId connectionId,
+      const ConstBlob *parts,
+      const size_t count) {
+    const u32 index = GetConnectionShard(connectionId);
+    RET_SM(index < m_shards.size(), Status::NOT_FOUND, "Bad connection id.");
+
+    Shard *shard = m_shards[index];
+    if (m_handler == NULL || shard->isOwningThread()) {
+      // Not yet threaded, or replying from within the shard's own handler.
+      return shard->server().send(connectionId, parts, count);
+    }
+    return shard->enqueue(connectionId, parts, count);
+  }
+
+  /**
+   *
+   */
+  NetStats stats() const {
+    NetStats ret;
+    for (size_t i = 0; i < m_shards.size(); ++i) {
+      // Shard counters are safe to read while the shard threads run.
+      ret.merge(m_shards[i]->server().stats());
+    }
+    return ret;
+  }
+
+  /**
+   *
+   */
+  bool connectionStats(
+      const tConnectionId connectionId, ConnectionStats &out) const {
+    const u32 index = GetConnectionShard(connectionId);
+    if (index >= m_shards.size()) {
+      return false;
+    }
+    return m_shards[index]->server().connectionStats(connectionId, out);
+  }
+
+  eConnectionMode::type getConnectionMode() const { return m_mode; }
+
+  int getPort() const { return m_port; }
+
+  u32 getShardCount() const { return static_cast< u32 >(m_shards.size()); }
+
+  private:
+  eConnectionMode::type m_mode;
+  std::vector< Shard * > m_shards;
+  iServerConnectionHandler *m_handler;
+  int m_port;
+};
+
+/**
+ * Delegate to implementation
+ */
+ShardedNetServer::ShardedNetServer(
+    eConnectionMode::type mode, const u32 shardCount)
+    : m_pImpl(NULL) {
+  CHECK_M(shardCount > 0, "Bad server shard count");
+  CHECK_M(
+      shardCount < (1u << CONNECTION_SHARD_BITS) - 1, "Bad server shard count");
+  m_pImpl = new ShardedNetServer::Impl(*this, mode, shardCount);
+}
+
+/**
+ *
+ */
+ShardedNetServer::~ShardedNetServer() {
+  m_pImpl->stop();
+  delete m_pImpl;
+}
+
+/**
+ * Delegate to implementation
+ */
+Status ShardedNetServer::start(const core::net::ServerDef &def) {
+  return m_pImpl->start(def);
+}
+
+/**
+ * Delegate to implementation
+ */
+void ShardedNetServer::stop() {
+  m_pImpl->stop();
+}
+
+/**
+ * Delegate to implementation
+ */
+Status ShardedNetServer::update(iServerConnectionHandler &handler) {
+  if (!valid()) {
+    return Status::BAD_STATE;
+  }
+  return m_pImpl->update(handler);
+}
+
+/**
+ * Delegate to implementation
+ */
+bool ShardedNetServer::valid() const {
+  return m_pImpl->valid();
+}
+
+/**
+ * Delegate to implementation
+ */
+Status ShardedNetServer::send(
+    const tConnectionId connectionId, const ConstBlob &msg) {
+  if (!valid()) {
+    return Status::BAD_STATE;
+  }
+  return m_pImpl->send(connectionId, &msg, 1);
+}
+
+/**
+ * Delegate to implementation
+ */
+Status ShardedNetServer::send(
+    const tConnectionId connectionId,
+    const ConstBlob *parts,
+    const size_t count) {
+  if (!valid()) {
+    return Status::BAD_STATE;
+  }
+  return m_pImpl->send(connectionId, parts, count);
+}
+
+/**
+ *
+ */
+Status
+ShardedNetServer::sendBatch(const OutboundMessage *msgs, const size_t count) {
+  Status ret = Status::ok();
+  for (size_t i = 0; i < count; ++i) {
+    Status sent = send(msgs[i].m_connectionId, msgs[i].m_data);
+    if (!sent && ret) {
+      ret = sent;
+    }
+  }
+  return ret;
+}
+
+/**
+ * Delegate to implementation
+ */
+NetStats ShardedNetServer::stats() const {
+  return m_pImpl->stats();
+}
+
+/**
+ * Delegate to implementation
+ */
+eConnectionMode::type ShardedNetServer::getConnectionMode() const {
+  return m_pImpl->getConnectionMode();
+}
+
+/**
+ * Delegate to implementation
+ */
+int ShardedNetServer::getPort() const {
+  return m_pImpl->getPort();
+}
+
+/**
+ * Delegate to implementation
+ */
+u32 ShardedNetServer::getShardCount() const {
+  return m_pImpl->getShardCount();
+}
+
+/**
+ * Delegate to implementation
+ */
+bool ShardedNetServer::connectionStats(
+    const tConnectionId connectionId, ConnectionStats &out) const {
+  return m_pImpl->connectionStats(connectionId, out);
+}
+
+} // namespace net
+} // namespace core
@@ -0,0 +1,93 @@
+/**
+ * Multi-threaded network server, sharded over SO_REUSEPORT listeners.
+ */
+#ifndef FISHY_NET_SERVER_SHARDED_H
+#define FISHY_NET_SERVER_SHARDED_H
+
+#include "net_server.h"
+
+namespace core {
+namespace net {
+
+/**
+ * Networking server that runs one {@link NetServer} per shard, each with its
+ * own listener, event loop, connection table and thread. All listeners share
+ * the port, and the kernel balances incoming connections between them.
+ *
+ * The shard owning a connection is encoded in its id (see
+ * {@link GetConnectionShard}), so {@link #send} can be called from any thread.
+ * Sends from outside the owning shard's thread are queued on a lock-free
+ * outbound queue, which wakes the shard to flush them. A shard with too much
+ * queued fails further sends with OUT_OF_BOUNDS.
+ *
+ * The {@link iServerConnectionHandler} is called concurrently from every shard
+ * thread, and must be thread-safe.
+ */
+class ShardedNetServer : public iNetServer {
+  public:
+  /**
+   * Create a server with {@code shardCount} shards of {@code mode} type.
+   * Shards of every mode wait on epoll for socket activity or queued sends,
+   * so idle shards use no CPU.
+   */
+  ShardedNetServer(eConnectionMode::type mode, const u32 shardCount);
+  ~ShardedNetServer();
+
+  /**
+   * Start every shard listening on {@code def.m_port}. Connection limits
+   * apply per shard. The EPOLL backend is always used, and a negative
+   * {@code def.m_waitMs} waits a tenth of a second at most.
+   */
+  virtual Status start(const core::net::ServerDef &def);
+
+  /**
+   * Join all shard threads, then stop every shard.
+   */
+  virtual void stop();
+
+  /**
+   * The first call launches the shard threads, which then drive
+   * {@code handler} until {@link #stop}. Later calls only report whether all
+   * shards are still healthy.
+   */
+  virtual Status update(iServerConnectionHandler &handler);
+
+  virtual bool valid() const;
+  virtual Status
+  send(const tConnectionId connectionId, const core::memory::ConstBlob &msg);
+  virtual Status send(
+      const tConnectionId connectionId,
+      const core::memory::ConstBlob *parts,
+      const size_t count);
+  virtual Status sendBatch(const OutboundMessage *msgs, const size_t count);
+  virtual NetStats stats() const;
+  virtual eConnectionMode::type getConnectionMode() const;
+
+  /**
+   * @return the port shared by every shard
+   */
+  int getPort() const;
+
+  /**
+   * @return the number of shards
+   */
+  u32 getShardCount() const;
+
+  /**
+   * Copy the traffic counters of connection {@code connectionId}, from
+   * whichever shard owns it. Safe to call from any thread.
+   *
+   * @return false if there is no such open connection
+   */
+  bool connectionStats(
+      const tConnectionId connectionId, ConnectionStats &out) const;
+
+  private:
+  class Impl;
+  Impl *m_pImpl;
+};
+
+} // namespace net
+} // namespace core
+
+#endif
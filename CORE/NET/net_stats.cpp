@@ -0,0 +1,416 @@
+#include "net_stats.h"
+
+#include <CORE/BASE/checks.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+namespace core {
+namespace net {
+
+static const u64 SUB_BUCKETS = (u64) 1 << HISTOGRAM_SUB_BITS;
+
+/**
+ * @return the index of the highest set bit of {@code value}, which is non-zero
+ */
+static u32 HighestBit(const u64 value) {
+#if defined(_MSC_VER)
+  unsigned long idx;
+  _BitScanReverse64(&idx, value);
+  return (u32) idx;
+#else
+  return 63 - (u32) __builtin_clzll(value);
+#endif
+}
+
+/**
+ * Add {@code value} to a counter, which other threads may also be adding to.
+ */
+static void Bump(std::atomic< u64 > &counter, const u64 value) {
+  counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+/**
+ *
+ */
+LatencyHistogram::LatencyHistogram() : m_count(0), m_sum(0), m_max(0) {
+  memset(m_buckets, 0, sizeof(m_buckets));
+}
+
+/**
+ *
+ */
+void LatencyHistogram::record(const u64 value) {
+  m_buckets[BucketIndex(value)]++;
+  m_count++;
+  m_sum += value;
+  m_max = std::max(m_max, value);
+}
+
+/**
+ *
+ */
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+  for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+    m_buckets[i] += other.m_buckets[i];
+  }
+  m_count += other.m_count;
+  m_sum += other.m_sum;
+  m_max = std::max(m_max, other.m_max);
+}
+
+/**
+ *
+ */
+u64 LatencyHistogram::percentile(const f64 fraction) const {
+  if (m_count == 0) {
+    return 0;
+  }
+  const f64 clamped = std::min(std::max(fraction, 0.0), 1.0);
+  const u64 rank = std::max((u64) (clamped * m_count + 0.5), (u64) 1);
+  u64 seen = 0;
+  for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+    seen += m_buckets[i];
+    if (seen >= rank) {
+      return std::min(BucketUpperBound(i), m_max);
+    }
+  }
+  return m_max;
+}
+
+/**
+ *
+ */
+size_t LatencyHistogram::BucketIndex(const u64 value) {
+  if (value < SUB_BUCKETS) {
+    return (size_t) value;
+  }
+  const u32 bit = HighestBit(value);
+  if (bit >= HISTOGRAM_MAX_BITS) {
+    return HISTOGRAM_BUCKETS - 1;
+  }
+  const u32 shift = bit - HISTOGRAM_SUB_BITS;
+  return ((size_t) (shift + 1) << HISTOGRAM_SUB_BITS)
+         | (size_t) ((value >> shift) & (SUB_BUCKETS - 1));
+}
+
+/**
+ *
+ */
+u64 LatencyHistogram::BucketLowerBound(const size_t idx) {
+  const size_t group = idx >> HISTOGRAM_SUB_BITS;
+  const u64 sub = idx & (SUB_BUCKETS - 1);
+  if (group == 0) {
+    return sub;
+  }
+  return (SUB_BUCKETS + sub) << (group - 1);
+}
+
+/**
+ *
+ */
+u64 LatencyHistogram::BucketUpperBound(const size_t idx) {
+  const size_t group = idx >> HISTOGRAM_SUB_BITS;
+  if (group == 0) {
+    return BucketLowerBound(idx);
+  }
+  return BucketLowerBound(idx) + ((u64) 1 << (group - 1)) - 1;
+}
+
+/**
+ *
+ */
+AtomicLatencyHistogram::AtomicLatencyHistogram() {
+  reset();
+}
+
+/**
+ *
+ */
+void AtomicLatencyHistogram::record(const u64 value) {
+  Bump(m_buckets[LatencyHistogram::BucketIndex(value)], 1);
+  Bump(m_sum, value);
+  // Single writer, so there is no race to raise the maximum.
+  if (value > m_max.load(std::memory_order_relaxed)) {
+    m_max.store(value, std::memory_order_relaxed);
+  }
+}
+
+/**
+ *
+ */
+void AtomicLatencyHistogram::snapshot(LatencyHistogram &out) const {
+  out.m_count = 0;
+  for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+    out.m_buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    // Counted from the buckets, so percentiles always add up.
+    out.m_count += out.m_buckets[i];
+  }
+  out.m_sum = m_sum.load(std::memory_order_relaxed);
+  out.m_max = m_max.load(std::memory_order_relaxed);
+}
+
+/**
+ *
+ */
+void AtomicLatencyHistogram::reset() {
+  for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+    m_buckets[i].store(0, std::memory_order_relaxed);
+  }
+  m_sum.store(0, std::memory_order_relaxed);
+  m_max.store(0, std::memory_order_relaxed);
+}
+
+/**
+ *
+ */
+NetStats::NetStats()
+    : m_bytesSent(0),
+      m_bytesRecieved(0),
+      m_activeConnections(0),
+      m_packetsSent(0),
+      m_packetsRecieved(0),
+      m_sendCalls(0),
+      m_recvCalls(0),
+      m_accepts(0) {
+  memset(m_closes, 0, sizeof(m_closes));
+}
+
+/**
+ *
+ */
+void NetStats::merge(const NetStats &other) {
+  m_bytesSent += other.m_bytesSent;
+  m_bytesRecieved += other.m_bytesRecieved;
+  m_activeConnections += other.m_activeConnections;
+  m_packetsSent += other.m_packetsSent;
+  m_packetsRecieved += other.m_packetsRecieved;
+  m_sendCalls += other.m_sendCalls;
+  m_recvCalls += other.m_recvCalls;
+  m_accepts += other.m_accepts;
+  for (size_t i = 0; i < eCloseReason::COUNT; ++i) {
+    m_closes[i] += other.m_closes[i];
+  }
+  m_processTicks.merge(other.m_processTicks);
+  m_expireTicks.merge(other.m_expireTicks);
+}
+
+/**
+ *
+ */
+NetCounters::NetCounters() {
+  reset();
+}
+
+/**
+ *
+ */
+void NetCounters::reset() {
+  m_bytesSent.set(0);
+  m_bytesRecieved.set(0);
+  m_activeConnections.set(0);
+  m_packetsSent.set(0);
+  m_packetsRecieved.set(0);
+  m_sendCalls.set(0);
+  m_recvCalls.set(0);
+  m_accepts.set(0);
+  for (size_t i = 0; i < eCloseReason::COUNT; ++i) {
+    m_closes[i].set(0);
+  }
+  m_processTicks.reset();
+  m_expireTicks.reset();
+}
+
+/**
+ *
+ */
+void NetCounters::addSendCall(const u64 bytes, const u64 packets) {
+  m_sendCalls.add(1);
+  addSent(bytes, packets);
+}
+
+/**
+ *
+ */
+void NetCounters::addRecvCall() {
+  m_recvCalls.add(1);
+}
+
+/**
+ *
+ */
+void NetCounters::addSent(const u64 bytes, const u64 packets) {
+  m_bytesSent.add(bytes);
+  m_packetsSent.add(packets);
+}
+
+/**
+ *
+ */
+void NetCounters::addRecieved(const u64 bytes) {
+  m_bytesRecieved.add(bytes);
+  m_packetsRecieved.add(1);
+}
+
+/**
+ *
+ */
+void NetCounters::addAccept() {
+  m_accepts.add(1);
+}
+
+/**
+ *
+ */
+void NetCounters::addClose(const eCloseReason::type reason) {
+  ASSERT(reason >= 0 && reason < eCloseReason::COUNT);
+  m_closes[reason].add(1);
+}
+
+/**
+ *
+ */
+void NetCounters::setActiveConnections(const u32 count) {
+  m_activeConnections.set(count);
+}
+
+/**
+ *
+ */
+NetStats NetCounters::snapshot() const {
+  NetStats ret;
+  ret.m_bytesSent = m_bytesSent.get();
+  ret.m_bytesRecieved = m_bytesRecieved.get();
+  ret.m_activeConnections = m_activeConnections.get();
+  ret.m_packetsSent = m_packetsSent.get();
+  ret.m_packetsRecieved = m_packetsRecieved.get();
+  ret.m_sendCalls = m_sendCalls.get();
+  ret.m_recvCalls = m_recvCalls.get();
+  ret.m_accepts = m_accepts.get();
+  for (size_t i = 0; i < eCloseReason::COUNT; ++i) {
+    ret.m_closes[i] = m_closes[i].get();
+  }
+  m_processTicks.snapshot(ret.m_processTicks);
+  m_expireTicks.snapshot(ret.m_expireTicks);
+  return ret;
+}
+
+/**
+ *
+ */
+ConnectionStatsTable::ConnectionStatsTable() : m_slots(NULL), m_size(0) {}
+
+/**
+ *
+ */
+ConnectionStatsTable::~ConnectionStatsTable() {
+  delete[] m_slots;
+}
+
+/**
+ *
+ */
+void ConnectionStatsTable::reset(const size_t slots) {
+  if (slots != m_size) {
+    delete[] m_slots;
+    m_slots = new Slot[slots];
+    m_size = slots;
+  }
+  m_free.clear();
+  for (size_t i = 0; i < m_size; ++i) {
+    m_slots[i].m_id.store(INVALID_CONNECTION_ID, std::memory_order_relaxed);
+    // Handed out lowest first.
+    m_free.push_back((u32) (m_size - 1 - i));
+  }
+}
+
+/**
+ *
+ */
+u32 ConnectionStatsTable::acquire(const tConnectionId id) {
+  if (m_free.empty()) {
+    return INVALID_SLOT;
+  }
+  const u32 slot = m_free.back();
+  m_free.pop_back();
+
+  Slot &s = m_slots[slot];
+  s.m_bytesSent.store(0, std::memory_order_relaxed);
+  s.m_bytesRecieved.store(0, std::memory_order_relaxed);
+  s.m_packetsSent.store(0, std::memory_order_relaxed);
+  s.m_packetsRecieved.store(0, std::memory_order_relaxed);
+  // Published after the counters are zeroed, see find().
+  s.m_id.store(id, std::memory_order_release);
+  return slot;
+}
+
+/**
+ *
+ */
+void ConnectionStatsTable::release(const u32 slot) {
+  if (slot == INVALID_SLOT) {
+    return;
+  }
+  ASSERT(slot < m_size);
+  m_slots[slot].m_id.store(INVALID_CONNECTION_ID, std::memory_order_relaxed);
+  // Readers that see the counters zeroed for the next owner must also see
+  // the old id go away.
+  std::atomic_thread_fence(std::memory_order_release);
+  m_free.push_back(slot);
+}
+
+/**
+ *
+ */
+void ConnectionStatsTable::addSent(
+    const u32 slot, const u64 bytes, const u64 packets) {
+  if (slot == INVALID_SLOT) {
+    return;
+  }
+  Bump(m_slots[slot].m_bytesSent, bytes);
+  Bump(m_slots[slot].m_packetsSent, packets);
+}
+
+/**
+ *
+ */
+void ConnectionStatsTable::addRecieved(const u32 slot, const u64 bytes) {
+  if (slot == INVALID_SLOT) {
+    return;
+  }
+  Bump(m_slots[slot].m_bytesRecieved, bytes);
+  Bump(m_slots[slot].m_packetsRecieved, 1);
+}
+
+/**
+ *
+ */
+bool ConnectionStatsTable::find(
+    const tConnectionId id, ConnectionStats &out) const {
+  if (id == INVALID_CONNECTION_ID) {
+    return false;
+  }
+  for (size_t i = 0; i < m_size; ++i) {
+    const Slot &s = m_slots[i];
+    if (s.m_id.load(std::memory_order_acquire) != id) {
+      continue;
+    }
+    out.m_bytesSent = s.m_bytesSent.load(std::memory_order_relaxed);
+    out.m_bytesRecieved = s.m_bytesRecieved.load(std::memory_order_relaxed);
+    out.m_packetsSent = s.m_packetsSent.load(std::memory_order_relaxed);
+    out.m_packetsRecieved =
+        s.m_packetsRecieved.load(std::memory_order_relaxed);
+    // If the slot was handed to another connection while reading, the counts
+    // may belong to it instead.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return s.m_id.load(std::memory_order_relaxed) == id;
+  }
+  return false;
+}
+
+} // namespace net
+} // namespace core
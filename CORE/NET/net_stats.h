@@ -0,0 +1,322 @@
+/**
+ * Instrumentation for network servers and clients.
+ */
+#ifndef FISHY_NET_STATS_H
+#define FISHY_NET_STATS_H
+
+#include "net_common.h"
+
+#include <CORE/ARCH/atomics.h>
+#include <CORE/UTIL/noncopyable.h>
+
+#include <atomic>
+#include <vector>
+
+namespace core {
+namespace net {
+
+/**
+ * Why a connection was closed.
+ */
+struct eCloseReason {
+  enum type {
+    // The other end closed the connection.
+    REMOTE,
+    // The handler refused data from the connection.
+    HANDLER,
+    // Nothing was received within the connection timeout.
+    TIMEOUT,
+    // A socket error.
+    FAILED,
+    // The server or client was stopped locally.
+    STOPPED,
+    COUNT
+  };
+};
+
+/**
+ * Each power of two range of a {@link LatencyHistogram} is split into
+ * 2^HISTOGRAM_SUB_BITS linear buckets, bounding the error to 1/8th of a value.
+ */
+static const u32 HISTOGRAM_SUB_BITS = 3;
+
+/**
+ * Values of 2^HISTOGRAM_MAX_BITS and above land in the last bucket.
+ */
+static const u32 HISTOGRAM_MAX_BITS = 40;
+
+static const size_t HISTOGRAM_BUCKETS =
+    (HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 1) << HISTOGRAM_SUB_BITS;
+
+/**
+ * Log-linear (HDR style) histogram of durations in timer ticks, with a fixed
+ * relative precision across the whole range. See {@link AtomicLatencyHistogram}
+ * to record into one from a thread others are reading from.
+ */
+class LatencyHistogram {
+  public:
+  LatencyHistogram();
+
+  /**
+   * Count one more {@code value}.
+   */
+  void record(const u64 value);
+
+  /**
+   * Add all of {@code other}'s values to this one.
+   */
+  void merge(const LatencyHistogram &other);
+
+  /**
+   * @return the number of values recorded
+   */
+  u64 count() const { return m_count; }
+
+  /**
+   * @return the sum of all values recorded
+   */
+  u64 sum() const { return m_sum; }
+
+  /**
+   * @return the largest value recorded
+   */
+  u64 maxValue() const { return m_max; }
+
+  /**
+   * @return the highest value of the bucket holding the value at
+   *     {@code fraction} (0 to 1) through the recorded values, or 0 when empty
+   */
+  u64 percentile(const f64 fraction) const;
+
+  /**
+   * @return the number of values recorded in bucket {@code idx}
+   */
+  u64 bucketCount(const size_t idx) const { return m_buckets[idx]; }
+
+  /**
+   * @return the bucket holding {@code value}
+   */
+  static size_t BucketIndex(const u64 value);
+
+  /**
+   * @return the lowest value held by bucket {@code idx}
+   */
+  static u64 BucketLowerBound(const size_t idx);
+
+  /**
+   * @return the highest value held by bucket {@code idx}
+   */
+  static u64 BucketUpperBound(const size_t idx);
+
+  private:
+  friend class AtomicLatencyHistogram;
+
+  u64 m_buckets[HISTOGRAM_BUCKETS];
+  u64 m_count;
+  u64 m_sum;
+  u64 m_max;
+};
+
+/**
+ * {@link LatencyHistogram} written by one thread and read from any.
+ *
+ * Every field is a relaxed atomic, so recording is a couple of uncontended
+ * adds. A snapshot never sees a torn field, but may be a few values out of
+ * date in some buckets relative to others.
+ */
+class AtomicLatencyHistogram : util::noncopyable {
+  public:
+  AtomicLatencyHistogram();
+
+  /**
+   * Count one more {@code value}.
+   */
+  void record(const u64 value);
+
+  /**
+   * Copy the current counts into {@code out}, replacing its contents.
+   */
+  void snapshot(LatencyHistogram &out) const;
+
+  /**
+   * Drop all values. Not safe against concurrent {@link #record}.
+   */
+  void reset();
+
+  private:
+  std::atomic< u64 > m_buckets[HISTOGRAM_BUCKETS];
+  std::atomic< u64 > m_sum;
+  std::atomic< u64 > m_max;
+};
+
+/**
+ * Statistics structure used by TCP/UDP client/servers.
+ *
+ * Packets are messages as seen by the handler and the caller of send: one
+ * datagram, or one read or send of a stream. Calls count send and receive
+ * syscalls, including those that moved nothing, so bytes per call shows how
+ * well they are batched.
+ */
+struct NetStats {
+  NetStats();
+
+  /**
+   * Add {@code other}'s counts to this one, such as to total up shards.
+   */
+  void merge(const NetStats &other);
+
+  u64 m_bytesSent;
+  u64 m_bytesRecieved;
+  u32 m_activeConnections;
+
+  u64 m_packetsSent;
+  u64 m_packetsRecieved;
+  u64 m_sendCalls;
+  u64 m_recvCalls;
+
+  // Connections accepted since start. Sample twice for the accept rate.
+  u64 m_accepts;
+  u64 m_closes[eCloseReason::COUNT];
+
+  // Ticks spent in each call of the handler's process.
+  LatencyHistogram m_processTicks;
+  // Ticks spent in each sweep for timed out and closed connections.
+  LatencyHistogram m_expireTicks;
+};
+
+/**
+ * Traffic of a single connection.
+ */
+struct ConnectionStats {
+  ConnectionStats()
+      : m_bytesSent(0),
+        m_bytesRecieved(0),
+        m_packetsSent(0),
+        m_packetsRecieved(0) {}
+
+  u64 m_bytesSent;
+  u64 m_bytesRecieved;
+  u64 m_packetsSent;
+  u64 m_packetsRecieved;
+};
+
+/**
+ * Live counters behind {@link NetStats}. Mostly updated by the thread driving
+ * a server or client, but any thread may add to them, such as callers sending
+ * on a client. Read with {@link #snapshot} from any thread.
+ */
+class NetCounters : util::noncopyable {
+  public:
+  NetCounters();
+
+  /**
+   * Zero every counter. Not safe against concurrent updates.
+   */
+  void reset();
+
+  /**
+   * Count a send syscall which wrote {@code bytes} holding {@code packets}.
+   */
+  void addSendCall(const u64 bytes, const u64 packets);
+
+  /**
+   * Count a receive syscall, the data it read is counted with
+   * {@link #addRecieved}.
+   */
+  void addRecvCall();
+
+  /**
+   * Count {@code bytes} sent without a syscall.
+   */
+  void addSent(const u64 bytes, const u64 packets);
+
+  /**
+   * Count a packet of {@code bytes} received.
+   */
+  void addRecieved(const u64 bytes);
+
+  void addAccept();
+  void addClose(const eCloseReason::type reason);
+  void setActiveConnections(const u32 count);
+
+  void recordProcessTicks(const u64 ticks) { m_processTicks.record(ticks); }
+  void recordExpireTicks(const u64 ticks) { m_expireTicks.record(ticks); }
+
+  /**
+   * @return a copy of all the counters
+   */
+  NetStats snapshot() const;
+
+  private:
+  core::arch::RelaxedCounter< u64 > m_bytesSent;
+  core::arch::RelaxedCounter< u64 > m_bytesRecieved;
+  core::arch::RelaxedCounter< u32 > m_activeConnections;
+  core::arch::RelaxedCounter< u64 > m_packetsSent;
+  core::arch::RelaxedCounter< u64 > m_packetsRecieved;
+  core::arch::RelaxedCounter< u64 > m_sendCalls;
+  core::arch::RelaxedCounter< u64 > m_recvCalls;
+  core::arch::RelaxedCounter< u64 > m_accepts;
+  core::arch::RelaxedCounter< u64 > m_closes[eCloseReason::COUNT];
+  AtomicLatencyHistogram m_processTicks;
+  AtomicLatencyHistogram m_expireTicks;
+};
+
+/**
+ * Fixed table of per-connection counters, one slot for each connection a
+ * server may hold. Slots are handed out and updated by the server thread, and
+ * {@link #find} may be called from any thread.
+ */
+class ConnectionStatsTable : util::noncopyable {
+  public:
+  static const u32 INVALID_SLOT = (u32) -1;
+
+  ConnectionStatsTable();
+  ~ConnectionStatsTable();
+
+  /**
+   * Make room for {@code slots} connections, dropping all current ones.
+   * Called as a server starts, before other threads may look it up.
+   */
+  void reset(const size_t slots);
+
+  /**
+   * Hand out a zeroed slot for {@code id}.
+   *
+   * @return the slot, or INVALID_SLOT if the table is full
+   */
+  u32 acquire(const tConnectionId id);
+
+  /**
+   * Return {@code slot} once its connection is closed.
+   */
+  void release(const u32 slot);
+
+  void addSent(const u32 slot, const u64 bytes, const u64 packets);
+  void addRecieved(const u32 slot, const u64 bytes);
+
+  /**
+   * Copy the counters of connection {@code id} into {@code out}. Scans the
+   * whole table, it is meant for diagnostics rather than every packet.
+   *
+   * @return false if there is no such connection
+   */
+  bool find(const tConnectionId id, ConnectionStats &out) const;
+
+  private:
+  struct Slot {
+    std::atomic< tConnectionId > m_id;
+    std::atomic< u64 > m_bytesSent;
+    std::atomic< u64 > m_bytesRecieved;
+    std::atomic< u64 > m_packetsSent;
+    std::atomic< u64 > m_packetsRecieved;
+  };
+
+  Slot *m_slots;
+  size_t m_size;
+  std::vector< u32 > m_free;
+};
+
+} // namespace net
+} // namespace core
+
+#endif
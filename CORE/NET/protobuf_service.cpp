@@ -1,55 +1,119 @@
-#if 0
-#  include "protobuf_service.h"
-
-#  include <CORE/ARCH/intrinsics.h>
-#  include <CORE/ARCH/timer.h>
-
+#include "protobuf_service.h"
+
+#include <CORE/ARCH/timer.h>
+#include <CORE/BASE/logging.h>
+#include <CORE/BASE/serializer_basesinks.h>
+#include <CORE/BASE/serializer_podtypes.h>
+#include <CORE/MEMORY/memory_tracking.h>
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+using core::base::BlobSink;
+using core::base::ConstBlobSink;
+using core::memory::Blob;
+using core::memory::ConstBlob;
+using core::net::ClientDef;
+using core::net::iNetClient;
+using core::net::iNetServer;
 using core::net::ServerDef;
-using core::util::thread::ThreadPool;
-using wrappers::net::util::ServerPacketHandler;
-using wrappers::net::util::ClientPacketHandler;
+using core::net::tConnectionId;
+using core::types::iProtoMessage;
 
 namespace core {
 namespace util {
 
 /**
- * Helper class for delegating requests to the worker threads.
+ * Request ids hold the index of their slot in the pending call table in their
+ * low bits, and a per slot sequence number in their high bits, so late
+ * responses to a reused slot are told apart.
+ */
+static const u32 RPC_SLOT_MASK = MAX_RPC_IN_FLIGHT - 1;
+
+/**
+ * Longest the network threads sleep without a wake, so connection timeouts
+ * are still checked.
+ */
+static const int RPC_WAIT_MS = 100;
+
+/**
+ * Bytes of requests a client may have waiting for its network thread before
+ * further requests fail.
+ */
+static const size_t MAX_RPC_SEND_BUFFER = 4 * 1024 * 1024;
+
+/**
+ * Write {@code value} as a {@link VarUInt} to {@code pOut}, which must hold at
+ * least {@link MAX_FRAME_HEADER_SIZE} bytes.
+ *
+ * @return the number of bytes written
+ */
+static size_t WriteVarUInt(u8 *pOut, const u64 value) {
+  Blob out(pOut, core::net::MAX_FRAME_HEADER_SIZE);
+  BlobSink sink(out);
+  sink << VarUInt(value);
+  return core::net::MAX_FRAME_HEADER_SIZE - sink.avail();
+}
+
+/**
+ * Append {@code value} as a {@link VarUInt} to {@code buffer}.
  */
-class ProcessRunner : public core::util::Runnable {
+static void AppendVarUInt(std::vector< u8 > &buffer, const u64 value) {
+  u8 header[core::net::MAX_FRAME_HEADER_SIZE];
+  buffer.insert(buffer.end(), header, header + WriteVarUInt(header, value));
+}
+
+/**
+ * Reads the messages of every connection, and queues them for the workers.
+ */
+class iProtoServiceServer::RequestHandler : public core::net::iMessageHandler {
   public:
-    typedef srutil::delegate<bool(core::net::iNetServer &server,
-                                  const core::net::tConnectionId connectionId,
-                                  const wrappers::net::util::Packet &data)> tProc;
-
-    ProcessRunner(
-      core::net::iNetServer &server,
-      core::net::tConnectionId connectionId,
-      const wrappers::net::util::Packet &data,
-      tProc proc)
-      : m_server(server),
-        m_connectionId(connectionId),
-        m_data(data),
-        m_proc(proc) {
+  RequestHandler(iProtoServiceServer &owner) : m_owner(owner) {}
+
+  virtual bool process(
+      iNetServer &server,
+      const tConnectionId connectionId,
+      const ConstBlob &message) {
+    (void) server;
+
+    ConstBlobSink sink(message);
+    VarUInt requestId;
+    VarUInt method;
+    sink >> requestId >> method;
+    if (sink.fail()) {
+      Log(LL::Warning) << "Malformed RPC request from " << connectionId;
+      return false;
     }
 
-    virtual void run() override {
-      m_proc(m_server, m_connectionId, m_data);
-    }
+    Request request;
+    request.m_connectionId = connectionId;
+    request.m_requestId = (u32) requestId.get();
+    request.m_method = (u32) method.get();
+    const u8 *pBody = message.data() + message.size() - sink.avail();
+    request.m_body.assign(pBody, pBody + sink.avail());
+    m_owner.m_requests.push(std::move(request));
+    return true;
+  }
+
+  virtual void open(const tConnectionId) {}
+  virtual void close(const tConnectionId) {}
 
   private:
-    tProc m_proc;
-    core::net::iNetServer &m_server;
-    core::net::tConnectionId m_connectionId;
-    const wrappers::net::util::Packet &m_data;
+  iProtoServiceServer &m_owner;
 };
 
 /**
  *
  */
-iProtoServiceServer::iProtoServiceServer(const ThreadPool::PoolOptions &poolOptions)
-  : m_server(core::net::eConnectionMode::TCP_BLOCKING),
-    m_workerPool(poolOptions) {
+iProtoServiceServer::iProtoServiceServer(const u32 workerCount)
+    : m_workerCount(workerCount),
+      m_server(core::net::eConnectionMode::TCP_ASYNC) {
+  CHECK_M(workerCount > 0, "RPC services need at least one worker");
+  m_running = false;
 }
+
 /**
  *
  */
@@ -62,15 +126,24 @@ iProtoServiceServer::~iProtoServiceServer() {
 /**
  *
  */
-bool iProtoServiceServer::start(const ServerDef &def) {
-  if (!m_server.start(def)) {
-    return false;
+Status iProtoServiceServer::start(const ServerDef &def) {
+  ServerDef serverDef = def;
+  serverDef.m_eventBackend = core::net::eEventBackend::EPOLL;
+  if (serverDef.m_waitMs < 0) {
+    serverDef.m_waitMs = RPC_WAIT_MS;
+  }
+  Status ret = m_server.start(serverDef);
+  if (!ret) {
+    return ret;
   }
   m_running = true;
 
-  m_workerPool.start();
-  m_processthread = std::thread(srutil::delegate<void(void)>::from_method<iProtoServiceServer, &iProtoServiceServer::processInternal>(this));
-  return true;
+  for (u32 i = 0; i < m_workerCount; ++i) {
+    m_workers.push_back(
+        std::thread(&iProtoServiceServer::workerInternal, this));
+  }
+  m_processthread = std::thread(&iProtoServiceServer::processInternal, this);
+  return Status::ok();
 }
 
 /**
@@ -78,9 +151,29 @@ bool iProtoServiceServer::start(const ServerDef &def) {
  */
 void iProtoServiceServer::stop() {
   m_running = false;
+  if (m_processthread.joinable()) {
+    m_server.wake();
+    m_processthread.join();
+  }
+
+  // Wake every worker, so they see the server stopped.
+  for (u32 i = 0; i < m_workerCount; ++i) {
+    m_requests.push(Request());
+  }
+  for (u32 i = 0; i < m_workers.size(); ++i) {
+    m_workers[i].join();
+  }
+  m_workers.clear();
   m_server.stop();
-  m_processthread.join();
-  m_workerPool.terminate();
+
+  std::vector< Request > requests;
+  while (!m_requests.empty()) {
+    m_requests.popN(m_requests.size(), requests).ignoreErrors();
+  }
+  std::vector< Response > responses;
+  while (!m_responses.empty()) {
+    m_responses.popN(m_responses.size(), responses).ignoreErrors();
+  }
 }
 
 /**
@@ -98,26 +191,113 @@ core::net::NetStats iProtoServiceServer::stats() const {
 }
 
 /**
- *
+ * Network thread, reading requests and sending the workers' responses.
  */
 void iProtoServiceServer::processInternal() {
-  wrappers::net::util::ServerPacketHandler packetHandler;
+  RequestHandler requests(*this);
+  core::net::FramedConnectionHandler handler(requests);
+  std::vector< Response > responses;
   while (m_running) {
-    m_server.update(packetHandler);
+    m_server.update(handler).ignoreErrors();
+
+    if (!m_responses.empty()) {
+      m_responses.popN(m_responses.size(), responses).ignoreErrors();
+      for (size_t i = 0; i < responses.size(); ++i) {
+        // The connection may have closed while its request was processed.
+        core::net::SendFramed(
+            m_server,
+            responses[i].m_connectionId,
+            ConstBlob(
+                responses[i].m_message.data(),
+                responses[i].m_message.size()))
+            .ignoreErrors();
+      }
+      responses.clear();
+    }
+  }
+}
 
-    const ServerPacketHandler::tPacketList packets = packetHandler.getPackets();
-    std::vector<ProcessRunner> runners;
-    runners.reserve(packets.size());
-    for (ServerPacketHandler::tPacketList::const_iterator packet = packets.begin(); packet != packets.end(); ++packet) {
-      runners.push_back(ProcessRunner(m_server, packet->first, packet->second, ProcessRunner::tProc::from_method<iProtoServiceServer, &iProtoServiceServer::process>(this)));
+/**
+ * Worker thread, processing requests until the server stops.
+ */
+void iProtoServiceServer::workerInternal() {
+  core::memory::ScopedMemoryTag tag(core::memory::eMemoryTag::PROTO);
+  Request request;
+  while (m_requests.pop(request) && m_running) {
+    Response response;
+    response.m_connectionId = request.m_connectionId;
+    AppendVarUInt(response.m_message, request.m_requestId);
+    // The status is patched in once the request is processed.
+    const size_t statusOffset = response.m_message.size();
+    response.m_message.push_back((u8) Status::OK);
+
+    if (!process(
+            request.m_method,
+            ConstBlob(request.m_body.data(), request.m_body.size()),
+            response.m_message)) {
+      response.m_message.resize(statusOffset + 1);
+      response.m_message[statusOffset] = (u8) Status::GENERIC_ERROR;
     }
-    for (u32 idx = 0; idx < packets.size(); ++idx) {
-      m_workerPool.execute(&runners[idx]);
+    m_responses.push(std::move(response));
+    m_server.wake();
+  }
+}
+
+/**
+ * Reads the framed responses from the server.
+ */
+class iProtoServiceClient::ResponseHandler
+    : public core::net::iClientConnectionHandler {
+  public:
+  ResponseHandler(iProtoServiceClient &owner) : m_owner(owner) {}
+
+  virtual void process(iNetClient &client, const ConstBlob &data) {
+    m_frames.receive(data);
+
+    ConstBlob message;
+    core::net::eFrameResult::type result;
+    while ((result = m_frames.next(message))
+           == core::net::eFrameResult::MESSAGE) {
+      ConstBlobSink sink(message);
+      VarUInt requestId;
+      u8 status;
+      sink >> requestId >> status;
+      if (sink.fail()) {
+        result = core::net::eFrameResult::MALFORMED;
+        break;
+      }
+      m_owner.completeCall(
+          (u32) requestId.get(),
+          (Status::eError) status,
+          ConstBlob(message.data() + message.size() - sink.avail(),
+                    sink.avail()));
     }
-    m_workerPool.wait();
 
-    std::this_thread::yield();
+    if (result == core::net::eFrameResult::MALFORMED) {
+      Log(LL::Error) << "Malformed RPC response from server.";
+      client.stop();
+    }
   }
+
+  virtual void cleanup() {}
+
+  /**
+   * Drop any partially read response, after a reconnect.
+   */
+  void reset() { m_frames = core::net::FrameBuffer(); }
+
+  private:
+  iProtoServiceClient &m_owner;
+  core::net::FrameBuffer m_frames;
+};
+
+/**
+ *
+ */
+iProtoServiceClient::iProtoServiceClient()
+    : m_timeoutTicks(0), m_client(core::net::eConnectionMode::TCP_ASYNC) {
+  m_running = false;
+  m_connected = false;
 }
 
 /**
@@ -132,16 +312,22 @@ iProtoServiceClient::~iProtoServiceClient() {
 /**
  *
  */
-bool iProtoServiceClient::start(const core::net::ServerDef &def) {
-  if (!m_client.start(def)) {
-    return false;
+Status iProtoServiceClient::start(const ClientDef &def) {
+  m_clientDef = def;
+  if (m_clientDef.m_waitMs < 0) {
+    m_clientDef.m_waitMs = RPC_WAIT_MS;
+  }
+  Status ret = m_client.start(m_clientDef);
+  if (!ret) {
+    return ret;
   }
   m_running = true;
-  m_clientDef = def;
+  m_connected = true;
+  m_timeoutTicks = core::timer::TimeToTicks(
+      static_cast< f64 >(def.m_connectionTimeoutSec));
 
-  m_processthread = std::thread(srutil::delegate<void(void)>::from_method<iProtoServiceClient, &iProtoServiceClient::processInternal>(this));
-  m_timeoutTicks = core::timer::TimeToTicks(static_cast<f64>(def.get_connection_timeout_sec()));
-  return true;
+  m_processthread = std::thread(&iProtoServiceClient::processInternal, this);
+  return Status::ok();
 }
 
 /**
@@ -149,17 +335,26 @@ bool iProtoServiceClient::start(const core::net::ServerDef &def) {
  */
 void iProtoServiceClient::stop() {
   m_running = false;
+  if (m_processthread.joinable()) {
+    m_client.wake();
+    m_processthread.join();
+  }
   if (m_client.valid()) {
     m_client.stop();
   }
-  m_processthread.join();
+  {
+    std::lock_guard< std::mutex > lock(m_sendMutex);
+    m_connected = false;
+    m_sendBuffer.clear();
+  }
+  cancelCalls();
 }
 
 /**
  *
  */
 bool iProtoServiceClient::valid() const {
-  return m_running && m_client.valid();
+  return m_running && m_connected;
 }
 
 /**
@@ -170,117 +365,299 @@ core::net::NetStats iProtoServiceClient::stats() const {
 }
 
 /**
- *
+ * Network thread, sending queued requests, reading responses and reconnecting
+ * to the server. The only thread using {@code m_client} while it runs.
  */
 void iProtoServiceClient::processInternal() {
-  ClientPacketHandler packetHandler;
+  ResponseHandler handler(*this);
+  std::vector< u8 > sending;
 
-  u64 timeoutTicks = 0;
   while (m_running) {
     if (!m_client.valid()) {
-      u32 RECONNECT_DELAY_SEC = 5;
-      std::this_thread::sleep_for(std::chrono::seconds(RECONNECT_DELAY_SEC));
+      // Nothing sent before the disconnect will be answered. Requests queued
+      // after the buffer is dropped are canceled below, or sent once
+      // reconnected.
+      {
+        std::lock_guard< std::mutex > lock(m_sendMutex);
+        m_connected = false;
+        m_sendBuffer.clear();
+      }
+      sending.clear();
+      cancelCalls();
+
+      static const u32 RECONNECT_DELAY_SEC = 5;
+      for (u32 i = 0; i < RECONNECT_DELAY_SEC * 10 && m_running; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      }
+      if (!m_running) {
+        break;
+      }
+
       if (!m_client.start(m_clientDef)) {
-        Log(LL::Error) << "Failed to reconnect to server. Retrying in " << RECONNECT_DELAY_SEC << "s." << std::endl;
+        Log(LL::Error) << "Failed to reconnect to server. Retrying in "
+                       << RECONNECT_DELAY_SEC << "s.";
       } else {
-        Log(LL::Warning) << "Reconnected to server." << std::endl;
+        Log(LL::Warning) << "Reconnected to server.";
+        handler.reset();
+        m_connected = true;
       }
       continue;
     }
-    m_client.update(packetHandler);
 
-    const ClientPacketHandler::tPacketList packets = packetHandler.getPackets();
-
-    m_mutex.lock();
-    for (ClientPacketHandler::tPacketList::const_iterator packet = packets.begin(); packet != packets.end(); ++packet) {
-      tCallbackMap::iterator callback = m_callbacks.find(packet->getHeader().m_index);
-      if (callback == m_callbacks.end()) {
-        continue;
-      }
-      callback->second(packet->getHeader().m_index, *packet);
-      m_callbacks.erase(callback);
+    if (!flushSends(sending)) {
+      Log(LL::Error) << "Failed to send RPC requests to server.";
+      m_client.stop();
+      continue;
     }
-    m_mutex.unlock();
+    m_client.update(handler).ignoreErrors();
+  }
+}
+
+/**
+ * Send every frame queued by {@link #sendRpc}, using {@code sending} as
+ * scratch space. Frames the client has no room to queue are kept in
+ * {@code sending}, and retried once the socket has drained.
+ *
+ * @return false if the send failed
+ */
+bool iProtoServiceClient::flushSends(std::vector< u8 > &sending) {
+  if (sending.empty()) {
+    std::lock_guard< std::mutex > lock(m_sendMutex);
+    sending.swap(m_sendBuffer);
+  }
+  if (sending.empty()) {
+    return true;
+  }
+  Status ret = m_client.send(ConstBlob(sending.data(), sending.size()));
+  if (ret.getStatus() == Status::OUT_OF_BOUNDS) {
+    return true;
+  }
+  sending.clear();
+  return ret;
+}
 
-    const u64 now = core::timer::GetTicks();
-    if (now > timeoutTicks) {
-      timeoutTicks = now + m_timeoutTicks;
-      m_cv.notify_all();
+/**
+ * Pop the call waiting on {@code requestId}, and hand it the response.
+ */
+void iProtoServiceClient::completeCall(
+    const u32 requestId,
+    const Status::eError status,
+    const ConstBlob &response) {
+  tCallback callback;
+  {
+    std::lock_guard< std::mutex > lock(m_mutex);
+    const u32 slot = requestId & RPC_SLOT_MASK;
+    if (slot >= m_calls.size() || m_calls[slot].m_requestId != requestId
+        || !m_calls[slot].m_callback) {
+      // Timed out, or the response was never wanted.
+      return;
     }
-    std::this_thread::yield();
+    callback.swap(m_calls[slot].m_callback);
+    m_freeCalls.push_back(slot);
   }
-  m_running = false;
+  callback(Status(status), response);
 }
 
 /**
- *
+ * Fail every outstanding call.
  */
-void iProtoServiceClient::signalCallback(const u16 index, const wrappers::net::util::Packet &packet) {
-  m_recvPackets[index] = packet;
-  m_cv.notify_all();
+void iProtoServiceClient::cancelCalls() {
+  std::vector< tCallback > callbacks;
+  {
+    std::lock_guard< std::mutex > lock(m_mutex);
+    for (u32 slot = 0; slot < m_calls.size(); ++slot) {
+      if (m_calls[slot].m_callback) {
+        callbacks.push_back(tCallback());
+        callbacks.back().swap(m_calls[slot].m_callback);
+        m_freeCalls.push_back(slot);
+      }
+    }
+  }
+  for (size_t i = 0; i < callbacks.size(); ++i) {
+    callbacks[i](Status(Status::CANCELED), ConstBlob());
+  }
 }
 
 /**
+ * Drop the call waiting on {@code requestId}.
  *
+ * @return false if the call was already completed.
  */
-u16 iProtoServiceClient::doAsyncRpc(wrappers::net::util::Packet &packet, tCallback *pCallback) {
-  u16 index = m_nextIndex++;
-
-  if (pCallback) {
-    LOCK_MUTEX(m_mutex);
-    m_callbacks[index] = *pCallback;
+bool iProtoServiceClient::cancelCall(const u32 requestId) {
+  std::lock_guard< std::mutex > lock(m_mutex);
+  const u32 slot = requestId & RPC_SLOT_MASK;
+  if (slot >= m_calls.size() || m_calls[slot].m_requestId != requestId
+      || !m_calls[slot].m_callback) {
+    return false;
   }
-  packet.setIndex(index);
-  wrappers::net::util::SendPacket(m_client, packet);
-  return index;
+  m_calls[slot].m_callback = tCallback();
+  m_freeCalls.push_back(slot);
+  return true;
 }
 
 /**
  *
  */
-bool iProtoServiceClient::doSyncRpc(wrappers::net::util::Packet &packetSend, wrappers::net::util::Packet &packetRecv) {
-  tCallback callback = tCallback::from_method<iProtoServiceClient, &iProtoServiceClient::signalCallback>(this);
-  std::unique_lock<std::mutex> lock(m_mutex);
-  const u16 index = doAsyncRpc(packetSend, &callback);
+Status iProtoServiceClient::doAsyncRpc(
+    const u32 method, const iProtoMessage &request, const tCallback &callback) {
+  u32 requestId;
+  return sendRpc(method, request, callback, requestId);
+}
 
-  const u64 timeoutTicks = core::timer::GetTicks() + m_timeoutTicks;
-  const long timeoutMillis = static_cast<long>(core::timeunit::Seconds.toMillis(core::timer::TicksToTime(m_timeoutTicks)));
-  while (core::timer::GetTicks() < timeoutTicks) {
-    m_cv.wait_for(lock, std::chrono::milliseconds(timeoutMillis));
+/**
+ * Register {@code callback} under a new request id, and queue the request for
+ * the network thread, waking it if the queue was empty.
+ */
+Status iProtoServiceClient::sendRpc(
+    const u32 method,
+    const iProtoMessage &request,
+    const tCallback &callback,
+    u32 &requestId) {
+  requestId = 0;
+  if (callback) {
+    std::lock_guard< std::mutex > lock(m_mutex);
+    u32 slot;
+    if (!m_freeCalls.empty()) {
+      slot = m_freeCalls.back();
+      m_freeCalls.pop_back();
+    } else if (m_calls.size() < MAX_RPC_IN_FLIGHT) {
+      slot = (u32) m_calls.size();
+      m_calls.push_back(PendingCall());
+      m_calls[slot].m_requestId = slot;
+    } else {
+      return Status(Status::OUT_OF_BOUNDS);
+    }
+    m_calls[slot].m_requestId += MAX_RPC_IN_FLIGHT;
+    if (m_calls[slot].m_requestId == 0) {
+      // Id 0 is reserved for requests without a callback.
+      m_calls[slot].m_requestId += MAX_RPC_IN_FLIGHT;
+    }
+    m_calls[slot].m_callback = callback;
+    requestId = m_calls[slot].m_requestId;
+  }
 
-    tRecvMap::iterator itr = m_recvPackets.find(index);
-    if (itr == m_recvPackets.end()) {
-      continue;
+  Status::eError ret = Status::OK;
+  bool wake = false;
+  {
+    std::lock_guard< std::mutex > lock(m_sendMutex);
+    std::vector< u8 > &buffer = m_sendBuffer;
+    const size_t frameStart = buffer.size();
+
+    if (!m_connected) {
+      ret = Status::BAD_STATE;
+    } else if (frameStart >= MAX_RPC_SEND_BUFFER) {
+      ret = Status::OUT_OF_BOUNDS;
+    } else {
+      // Leave room for the frame header, sized once the request is
+      // serialized.
+      buffer.resize(frameStart + core::net::MAX_FRAME_HEADER_SIZE);
+      AppendVarUInt(buffer, requestId);
+      AppendVarUInt(buffer, method);
+      if (!ProtoToBuffer(request, buffer)) {
+        buffer.resize(frameStart);
+        ret = Status::BAD_ARGUMENT;
+      } else {
+        u8 frameHeader[core::net::MAX_FRAME_HEADER_SIZE];
+        const size_t bodyStart = frameStart + core::net::MAX_FRAME_HEADER_SIZE;
+        const size_t headerSize =
+            WriteVarUInt(frameHeader, buffer.size() - bodyStart);
+        memcpy(&buffer[frameStart], frameHeader, headerSize);
+        buffer.erase(
+            buffer.begin() + frameStart + headerSize,
+            buffer.begin() + bodyStart);
+        wake = (frameStart == 0);
+      }
     }
+  }
+  if (wake) {
+    m_client.wake();
+  }
 
-    packetRecv = itr->second;
-    m_recvPackets.erase(itr);
-    return true;
+  if (ret != Status::OK && callback) {
+    cancelCall(requestId);
   }
+  return Status(ret);
+}
+
+/**
+ * State shared between a synchronous call, and its callback on the network
+ * thread. The callback may outlive the caller if the call times out.
+ */
+struct SyncCall {
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_done;
+  bool m_abandoned;
+  Status::eError m_status;
+  iProtoMessage *m_pResponse;
+};
 
-  return false;
+/**
+ *
+ */
+Status iProtoServiceClient::doSyncRpc(
+    const u32 method, const iProtoMessage &request, iProtoMessage &response) {
+  std::shared_ptr< SyncCall > call = std::make_shared< SyncCall >();
+  call->m_done = false;
+  call->m_abandoned = false;
+  call->m_status = Status::TIMEOUT;
+  call->m_pResponse = &response;
+
+  u32 requestId;
+  Status ret = sendRpc(
+      method,
+      request,
+      [call](Status status, const ConstBlob &body) {
+        std::lock_guard< std::mutex > lock(call->m_mutex);
+        call->m_status = status.getStatus();
+        if (call->m_abandoned) {
+          return;
+        }
+        if (call->m_status == Status::OK
+            && !BlobToProto(body, *call->m_pResponse)) {
+          call->m_status = Status::BAD_INPUT;
+        }
+        call->m_done = true;
+        call->m_cv.notify_all();
+      },
+      requestId);
+  if (!ret) {
+    return ret;
+  }
+
+  const f64 timeoutSec = core::timer::TicksToTime(m_timeoutTicks);
+  std::unique_lock< std::mutex > lock(call->m_mutex);
+  if (!call->m_cv.wait_for(
+          lock,
+          std::chrono::duration< f64 >(timeoutSec),
+          [&call]() { return call->m_done; })) {
+    call->m_abandoned = true;
+    lock.unlock();
+    cancelCall(requestId);
+    return Status(Status::TIMEOUT);
+  }
+  return Status(call->m_status);
 }
 
 /**
  *
  */
-bool PacketToProto(const wrappers::net::util::Packet &packet, iProtoMessage &proto) {
-  core::base::ConstBlobSink sink(packet.getPayload());
+bool BlobToProto(const ConstBlob &blob, iProtoMessage &proto) {
+  ConstBlobSink sink(blob);
   return proto.iserialize(sink);
 }
 
 /**
  *
  */
-bool ProtoToPacket(const iProtoMessage &proto, wrappers::net::util::Packet &packet) {
-  const size_t output_size = proto.byte_size();
-  if (output_size > wrappers::net::util::PACKET_MAX_SIZE_TCP) {
-    return false;
-  }
-  core::base::BlobSink sink(packet.getMutablePayload(output_size));
+bool ProtoToBuffer(const iProtoMessage &proto, std::vector< u8 > &buffer) {
+  const size_t offset = buffer.size();
+  const size_t outputSize = proto.byte_size();
+  buffer.resize(offset + outputSize);
+  Blob output(buffer.data() + offset, outputSize);
+  BlobSink sink(output);
   return proto.oserialize(sink);
 }
 
 } // namespace util
 } // namespace core
-#endif
@@ -2,41 +2,60 @@
  * Definitions for Fishy style protobuffer services.
  * Based loosely off Google protobuffers.
  */
-#if 0
-#  ifndef FISHY_PROTOBUF_SERVICE_H
-#    define FISHY_PROTOBUF_SERVICE_H
+#ifndef FISHY_PROTOBUF_SERVICE_H
+#define FISHY_PROTOBUF_SERVICE_H
 
-#    include "protobuf.h"
+#include "net_client.h"
+#include "net_framing.h"
+#include "net_server.h"
 
-#    include <CORE/ARCH/mutex.h>
-#    include <CORE/NET/net_client.h>
-#    include <CORE/NET/net_server.h>
-#    include <CORE/UTIL/CONCURRENT/threadpool.h>
-#    include <EXTERN_LIB/srutil/delegate/delegate.hpp>
-#    include <WRAPPERS/NET/packet_handler.h>
+#include <CORE/TYPES/concurrent_queue.h>
+#include <CORE/TYPES/protobuf.h>
 
-#    include <atomic>
-#    include <condition_variable>
-#    include <map>
-#    include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace core {
 namespace util {
 
+/**
+ * Default number of worker threads processing requests for a service.
+ */
+static const u32 DEFAULT_RPC_WORKERS = 4;
+
+/**
+ * Most requests a client may have awaiting a response at once.
+ */
+static const u32 MAX_RPC_IN_FLIGHT = 1 << 16;
+
 /**
  * Protobuffer RPC service server
+ *
+ * Requests are framed messages, each carrying a request id and method
+ * signature ahead of the proto. The network thread reads them, and hands them
+ * to a pool of worker threads calling {@link #process}. Responses go back
+ * to the network thread to be sent, tagged with the id of their request, so
+ * clients may pipeline any number of requests over one connection and have
+ * them answered in any order. The network thread sleeps on epoll until a
+ * socket is ready or a worker wakes it with a response.
  */
 class iProtoServiceServer {
   public:
   virtual ~iProtoServiceServer();
 
   /**
-   * Starts the server listener thread.
+   * Starts the server listener thread and the worker threads. The EPOLL
+   * backend is always used, and a negative {@code def.m_waitMs} waits a tenth
+   * of a second at most.
    */
-  bool start(const core::net::ServerDef &);
+  Status start(const core::net::ServerDef &def);
 
   /**
-   * Stops the server listener thread.
+   * Stops the server listener thread and the worker threads.
    */
   void stop();
 
@@ -51,46 +70,81 @@ class iProtoServiceServer {
   core::net::NetStats stats() const;
 
   protected:
-  iProtoServiceServer(const core::util::thread::ThreadPool::PoolOptions &);
+  /**
+   * @param workerCount number of threads calling {@link #process}
+   */
+  iProtoServiceServer(const u32 workerCount);
 
   /**
    * The protoc compiler should generate this function.
-   * It's purpose is to handle processing of an incoming request.
+   * It's purpose is to handle processing of an incoming request. Called
+   * concurrently from every worker thread.
+   *
+   * @param method signature of the called method
+   * @param request serialized request proto
+   * @param response the serialized response proto is appended to this
+   * @return false if the request could not be handled
    */
   virtual bool process(
-      core::net::iNetServer &server,
-      const core::net::tConnectionId connectionId,
-      const wrappers::net::util::Packet &data) = 0;
+      const u32 method,
+      const core::memory::ConstBlob &request,
+      std::vector< u8 > &response) = 0;
 
   private:
+  struct Request {
+    core::net::tConnectionId m_connectionId;
+    u32 m_requestId;
+    u32 m_method;
+    std::vector< u8 > m_body;
+  };
+
+  struct Response {
+    core::net::tConnectionId m_connectionId;
+    std::vector< u8 > m_message;
+  };
+
+  class RequestHandler;
+
   void processInternal();
+  void workerInternal();
 
   std::atomic_bool m_running;
+  u32 m_workerCount;
 
   core::net::NetServer m_server;
   std::thread m_processthread;
-  core::util::thread::ThreadPool m_workerPool;
+  std::vector< std::thread > m_workers;
+  core::types::ConcurrentQueue< Request > m_requests;
+  core::types::ConcurrentQueue< Response > m_responses;
 };
 
 /**
  * Protobuffer RPC service client
+ *
+ * Any number of threads may issue requests at once. Outstanding requests are
+ * kept in a slot table indexed by their request id, and their callbacks run on
+ * the client's network thread as responses arrive. Requests are framed into a
+ * shared buffer, which the network thread sends when it next wakes, so only
+ * that thread ever touches the socket.
  */
 class iProtoServiceClient {
   public:
   virtual ~iProtoServiceClient();
 
   /**
-   * Starts the server listener thread.
+   * Connects to the server, and starts the client network thread.
+   * Synchronous requests time out after the connection timeout. A negative
+   * {@code def.m_waitMs} waits a tenth of a second at most.
    */
-  bool start(const core::net::ServerDef &);
+  Status start(const core::net::ClientDef &def);
 
   /**
-   * Stops the server listener thread.
+   * Stops the client network thread. Outstanding requests are canceled.
    */
   void stop();
 
   /**
-   * Check if the server thread is running.
+   * Check if the client thread is running.
    */
   bool valid() const;
 
@@ -100,72 +154,87 @@ class iProtoServiceClient {
   core::net::NetStats stats() const;
 
   protected:
-  iProtoServiceClient()
-      : m_nextIndex(1),
-        m_timeoutTicks(0),
-        m_client(core::net::eConnectionMode::TCP_ASYNC) {
-    m_running = false;
-  }
-
-  typedef srutil::delegate< void(
-      const u16, const wrappers::net::util::Packet &) >
+  iProtoServiceClient();
+
+  /**
+   * Called with the result of a request, and the serialized response proto if
+   * the result is {@code OK}.
+   */
+  typedef std::function< void(Status, const core::memory::ConstBlob &) >
       tCallback;
-  u16 doAsyncRpc(wrappers::net::util::Packet &packet, tCallback *);
-  bool doSyncRpc(
-      wrappers::net::util::Packet &packetSend,
-      wrappers::net::util::Packet &packetRecv);
-
-  template < typename tType >
-  class ConvertCallback {
-    public:
-    ConvertCallback(
-        srutil::delegate< void(const u16, const typename tType &) > &cb)
-        : m_cb(cb) {}
-
-    void process(const u16 id, const wrappers::net::util::Packet &packet) {
-      tType proto;
-      if (PacketToProto(packet, proto)) {
-        m_cb(id, proto);
-      }
-      delete this;
-    }
-
-    private:
-    srutil::delegate< void(const u16, const typename tType &) > m_cb;
-  };
+
+  /**
+   * Send a request, calling {@code callback} from the network thread with
+   * its response. An empty {@code callback} discards the response.
+   *
+   * @return BAD_STATE while disconnected, or OUT_OF_BOUNDS if too many
+   *     requests wait to be sent or answered
+   */
+  Status doAsyncRpc(
+      const u32 method,
+      const core::types::iProtoMessage &request,
+      const tCallback &callback);
+
+  /**
+   * Send a request, and wait for its response.
+   */
+  Status doSyncRpc(
+      const u32 method,
+      const core::types::iProtoMessage &request,
+      core::types::iProtoMessage &response);
 
   private:
+  struct PendingCall {
+    u32 m_requestId;
+    tCallback m_callback;
+  };
+
+  class ResponseHandler;
+
   void processInternal();
-  void signalCallback(const u16, const wrappers::net::util::Packet &);
+  bool flushSends(std::vector< u8 > &sending);
+  Status sendRpc(
+      const u32 method,
+      const core::types::iProtoMessage &request,
+      const tCallback &callback,
+      u32 &requestId);
+  void completeCall(
+      const u32 requestId,
+      const Status::eError status,
+      const core::memory::ConstBlob &response);
+  void cancelCalls();
+  bool cancelCall(const u32 requestId);
 
   std::atomic_bool m_running;
-  std::atomic_int32_t m_nextIndex;
+  std::atomic_bool m_connected;
   u64 m_timeoutTicks;
   core::net::NetClient m_client;
-  core::net::ServerDef m_clientDef;
+  core::net::ClientDef m_clientDef;
   std::thread m_processthread;
+
+  // Guards the frames waiting for the network thread to send them.
+  std::mutex m_sendMutex;
+  std::vector< u8 > m_sendBuffer;
+
+  // Guards the pending call table.
   std::mutex m_mutex;
-  std::condition_variable m_cv;
-  typedef std::map< u16, wrappers::net::util::Packet > tRecvMap;
-  tRecvMap m_recvPackets;
-  typedef std::map< u16, tCallback > tCallbackMap;
-  tCallbackMap m_callbacks;
+  std::vector< PendingCall > m_calls;
+  std::vector< u32 > m_freeCalls;
 };
 
 /**
- * Utility function to parse a proto out of a packet.
+ * Utility function to parse a proto out of a serialized blob.
  */
-bool PacketToProto(
-    const wrappers::net::util::Packet &packet, iProtoMessage &proto);
+bool BlobToProto(
+    const core::memory::ConstBlob &blob, core::types::iProtoMessage &proto);
 
 /**
- * Utility function to parse a proto into a packet.
+ * Utility function to append a serialized proto to a buffer.
  */
-bool ProtoToPacket(
-    const iProtoMessage &proto, wrappers::net::util::Packet &packet);
+bool ProtoToBuffer(
+    const core::types::iProtoMessage &proto, std::vector< u8 > &buffer);
 
 } // namespace util
 } // namespace core
 
-#  endif
 #endif
@@ -86,6 +86,30 @@ class MockNetClient : public ::core::net::iNetClient {
     return Status(wasSent);
   }
 
+  /**
+   * Store each part in order, as with {@link #send}.
+   */
+  virtual Status
+  send(const ::core::memory::ConstBlob *parts, const size_t count) {
+    bool wasSent = true;
+    for (size_t i = 0; i < count; ++i) {
+      wasSent = send(parts[i]) && wasSent;
+    }
+    return Status(wasSent);
+  }
+
+  /**
+   * Store each message as with {@link #send}.
+   */
+  virtual Status
+  sendBatch(const ::core::memory::ConstBlob *msgs, const size_t count) {
+    bool wasSent = true;
+    for (size_t i = 0; i < count; ++i) {
+      wasSent = send(msgs[i]) && wasSent;
+    }
+    return Status(wasSent);
+  }
+
   /**
    * @see #send
    */
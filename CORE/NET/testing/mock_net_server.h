@@ -114,6 +114,32 @@ class MockNetServer : public ::core::net::iNetServer {
     return Status(wasSent);
   }
 
+  /**
+   * Store each part in order, as with {@link #send}.
+   */
+  virtual Status send(
+      const ::core::net::tConnectionId connectionId,
+      const ::core::memory::ConstBlob *parts,
+      const size_t count) {
+    bool wasSent = true;
+    for (size_t i = 0; i < count; ++i) {
+      wasSent = send(connectionId, parts[i]) && wasSent;
+    }
+    return Status(wasSent);
+  }
+
+  /**
+   * Store each message as with {@link #send}.
+   */
+  virtual Status
+  sendBatch(const ::core::net::OutboundMessage *msgs, const size_t count) {
+    bool wasSent = true;
+    for (size_t i = 0; i < count; ++i) {
+      wasSent = send(msgs[i].m_connectionId, msgs[i].m_data) && wasSent;
+    }
+    return Status(wasSent);
+  }
+
   /**
    * @see #send
    */
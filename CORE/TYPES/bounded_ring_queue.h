@@ -0,0 +1,153 @@
+/**
+ * Lock-free, fixed capacity, multi producer and multi consumer queue.
+ */
+#ifndef FISHY_BOUNDED_RING_QUEUE
+#define FISHY_BOUNDED_RING_QUEUE
+
+#include <CORE/BASE/status.h>
+#include <CORE/MEMORY/memory.h>
+#include <CORE/UTIL/noncopyable.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+namespace core {
+namespace types {
+
+/**
+ * Array based ring of sequenced slots (after Dmitry Vyukov's bounded MPMC
+ * queue). Producers and consumers each claim a slot with one compare and swap
+ * on their own index, and hand it over through the slot's sequence number, so
+ * no lock is taken while the queue is neither full nor empty.
+ *
+ * The blocking {@link #push} and {@link #pop} spin briefly, then sleep until
+ * the other side makes progress. Otherwise it behaves like
+ * {@link ConcurrentQueue}: once closed every push and pop is CANCELED.
+ */
+template < typename tType >
+class BoundedRingQueue : util::noncopyable {
+  public:
+  /**
+   * @param capacity the max size of the queue, rounded up to a power of two
+   *     of at least 2
+   */
+  explicit BoundedRingQueue(const size_t capacity);
+  ~BoundedRingQueue();
+
+  /**
+   * Push a new item into the queue, without blocking.
+   *
+   * @return Status ok if the item was pushed, OUT_OF_BOUNDS if the queue is
+   *     full, or CANCELED if the queue was closed.
+   */
+  Status tryPush(const tType &val);
+
+  /**
+   * Pop an item from the queue, without blocking.
+   *
+   * @return Status ok if an item was popped, NOT_FOUND if the queue is empty,
+   *     or CANCELED if the queue was closed.
+   */
+  Status tryPop(tType &out);
+
+  /**
+   * Push a new item into the queue.
+   * This function blocks if the queue is full.
+   *
+   * @return Status ok if the item was pushed, or CANCELED if the queue was
+   *     closed.
+   */
+  Status push(const tType &val);
+
+  /**
+   * Pop an item from the queue.
+   * This function blocks if the queue is empty.
+   *
+   * @return Status ok if an item was popped, or CANCELED if the queue was
+   *     closed.
+   */
+  Status pop(tType &out);
+
+  /**
+   * @return the approximate size of the queue, exact if no push or pop is in
+   *     progress
+   */
+  size_t size() const;
+
+  /**
+   * @return if the queue is likely empty.
+   */
+  bool empty() const { return size() == 0; }
+
+  /**
+   * @return the max size of the queue
+   */
+  size_t capacity() const { return m_mask + 1; }
+
+  /**
+   * Closes the queue. All blocking operations are released, and no more items
+   * may be put into the queue.
+   */
+  void close();
+
+  /**
+   * Check if the queue is still open.
+   */
+  bool isOpen() const;
+
+  private:
+  /**
+   * A slot is free for the push at position p when its sequence is p, and
+   * holds the item for the pop at position p when its sequence is p + 1.
+   */
+  struct Cell {
+    std::atomic< size_t > m_sequence;
+    tType m_data;
+  };
+
+  /**
+   * Threads sleeping on one side of the queue. Only locked when someone is,
+   * or is about to, sleep.
+   */
+  struct Waiters {
+    Waiters() : m_count(0) {}
+
+    std::atomic< u32 > m_count;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+  };
+
+  bool canPush() const;
+  bool canPop() const;
+
+  /**
+   * Sleep on {@code waiters} until {@code (this->*ready)()} or the queue is
+   * closed.
+   */
+  void wait(Waiters &waiters, bool (BoundedRingQueue::*ready)() const);
+
+  /**
+   * Wake anything sleeping on {@code waiters}.
+   */
+  void wake(Waiters &waiters);
+
+  Cell *m_cells;
+  size_t m_mask;
+  std::atomic_bool m_open;
+
+  alignas(memory::CACHE_LINE_SIZE) std::atomic< size_t > m_tail;
+  alignas(memory::CACHE_LINE_SIZE) std::atomic< size_t > m_head;
+
+  alignas(memory::CACHE_LINE_SIZE) Waiters m_producers;
+  Waiters m_consumers;
+};
+
+} // namespace types
+} // namespace core
+
+#  include "bounded_ring_queue.inl"
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef FISHY_BOUNDED_RING_QUEUE_INL
+#define FISHY_BOUNDED_RING_QUEUE_INL
+
+#include <CORE/ARCH/atomics.h>
+
+namespace core {
+namespace types {
+
+/**
+ * Times a blocking push or pop retries, backing off in between, before it
+ * sleeps.
+ */
+static const u32 RING_QUEUE_SPINS = 64;
+
+/**
+ *
+ */
+template < typename tType >
+inline BoundedRingQueue< tType >::BoundedRingQueue(const size_t capacity)
+    : m_cells(NULL),
+      // A single slot could not tell a stored item from a free slot a lap on.
+      m_mask(memory::nextPow2(std::max(capacity, (size_t) 2)) - 1),
+      m_open(true),
+      m_tail(0),
+      m_head(0) {
+  CHECK_M(capacity > 0, "Bad ring queue capacity");
+  m_cells = new Cell[m_mask + 1];
+  for (size_t i = 0; i <= m_mask; ++i) {
+    m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline BoundedRingQueue< tType >::~BoundedRingQueue() {
+  delete[] m_cells;
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline Status BoundedRingQueue< tType >::tryPush(const tType &val) {
+  if (!m_open.load(std::memory_order_relaxed)) {
+    return Status(Status::CANCELED);
+  }
+
+  Cell *pCell;
+  size_t pos = m_tail.load(std::memory_order_relaxed);
+  while (true) {
+    pCell = &m_cells[pos & m_mask];
+    const size_t seq = pCell->m_sequence.load(std::memory_order_acquire);
+    const intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+    if (diff == 0) {
+      if (m_tail.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The slot still holds the item from a lap ago.
+      return Status(Status::OUT_OF_BOUNDS);
+    } else {
+      pos = m_tail.load(std::memory_order_relaxed);
+    }
+  }
+
+  pCell->m_data = val;
+  pCell->m_sequence.store(pos + 1, std::memory_order_release);
+  wake(m_consumers);
+  return Status::ok();
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline Status BoundedRingQueue< tType >::tryPop(tType &out) {
+  if (!m_open.load(std::memory_order_relaxed)) {
+    return Status(Status::CANCELED);
+  }
+
+  Cell *pCell;
+  size_t pos = m_head.load(std::memory_order_relaxed);
+  while (true) {
+    pCell = &m_cells[pos & m_mask];
+    const size_t seq = pCell->m_sequence.load(std::memory_order_acquire);
+    const intptr_t diff = (intptr_t) seq - (intptr_t) (pos + 1);
+    if (diff == 0) {
+      if (m_head.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return Status(Status::NOT_FOUND);
+    } else {
+      pos = m_head.load(std::memory_order_relaxed);
+    }
+  }
+
+  out = std::move(pCell->m_data);
+  // Free the slot for the push one lap ahead.
+  pCell->m_sequence.store(pos + m_mask + 1, std::memory_order_release);
+  wake(m_producers);
+  return Status::ok();
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline Status BoundedRingQueue< tType >::push(const tType &val) {
+  core::arch::Backoff backoff;
+  for (u32 spins = 0;; ++spins) {
+    const Status::eError ret = tryPush(val).getStatus();
+    if (ret != Status::OUT_OF_BOUNDS) {
+      return Status(ret);
+    }
+    if (spins < RING_QUEUE_SPINS) {
+      backoff.pause();
+    } else {
+      wait(m_producers, &BoundedRingQueue::canPush);
+    }
+  }
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline Status BoundedRingQueue< tType >::pop(tType &out) {
+  core::arch::Backoff backoff;
+  for (u32 spins = 0;; ++spins) {
+    const Status::eError ret = tryPop(out).getStatus();
+    if (ret != Status::NOT_FOUND) {
+      return Status(ret);
+    }
+    if (spins < RING_QUEUE_SPINS) {
+      backoff.pause();
+    } else {
+      wait(m_consumers, &BoundedRingQueue::canPop);
+    }
+  }
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline size_t BoundedRingQueue< tType >::size() const {
+  const size_t head = m_head.load(std::memory_order_relaxed);
+  const size_t tail = m_tail.load(std::memory_order_relaxed);
+  if (tail < head) {
+    return 0;
+  }
+  return std::min(tail - head, capacity());
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline void BoundedRingQueue< tType >::close() {
+  m_open.store(false);
+  // Taking the locks means no sleeper can miss the flag.
+  {
+    std::lock_guard< std::mutex > lock(m_producers.m_mutex);
+    m_producers.m_cv.notify_all();
+  }
+  std::lock_guard< std::mutex > lock(m_consumers.m_mutex);
+  m_consumers.m_cv.notify_all();
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline bool BoundedRingQueue< tType >::isOpen() const {
+  return m_open.load();
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline bool BoundedRingQueue< tType >::canPush() const {
+  const size_t pos = m_tail.load(std::memory_order_relaxed);
+  const size_t seq =
+      m_cells[pos & m_mask].m_sequence.load(std::memory_order_acquire);
+  return (intptr_t) seq - (intptr_t) pos >= 0;
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline bool BoundedRingQueue< tType >::canPop() const {
+  const size_t pos = m_head.load(std::memory_order_relaxed);
+  const size_t seq =
+      m_cells[pos & m_mask].m_sequence.load(std::memory_order_acquire);
+  return (intptr_t) seq - (intptr_t) (pos + 1) >= 0;
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline void BoundedRingQueue< tType >::wait(
+    Waiters &waiters, bool (BoundedRingQueue::*ready)() const) {
+  std::unique_lock< std::mutex > lock(waiters.m_mutex);
+  waiters.m_count.fetch_add(1);
+  // Pairs with the fence in wake(): either the waker sees this sleeper, or
+  // the ready check below sees the waker's change.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while (m_open.load() && !(this->*ready)()) {
+    waiters.m_cv.wait(lock);
+  }
+  waiters.m_count.fetch_sub(1);
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline void BoundedRingQueue< tType >::wake(Waiters &waiters) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiters.m_count.load(std::memory_order_relaxed) != 0) {
+    std::lock_guard< std::mutex > lock(waiters.m_mutex);
+    waiters.m_cv.notify_all();
+  }
+}
+
+} // namespace types
+} // namespace core
+
+#endif
@@ -10,6 +10,7 @@
 #include <condition_variable>
 #include <deque>
 #include <mutex>
+#include <utility>
 #include <vector>
 
 namespace core {
@@ -29,15 +30,29 @@ class ConcurrentQueue {
    */
   void push(const tType &);
 
+  /**
+   * Push a new item into the queue, moving it in.
+   * This function blocks if the queue is full.
+   */
+  void push(tType &&);
+
+  /**
+   * Construct a new item in place at the back of the queue.
+   * This function blocks if the queue is full.
+   */
+  template < typename... tArgs >
+  void emplace(tArgs &&... args);
+
   /**
    * Push many items into the queue using a minimal number of locking steps.
+   * Pass move iterators to move the items in.
    * This function blocks if the queue is full.
    */
   template < typename tIter >
   void pushN(const tIter &begin, const tIter &end);
 
   /**
-   * Pop an item from the queue.
+   * Pop an item from the queue, moving it out.
    * This function blocks if the queue is empty.
    *
    * @return Status ok if an item was popped, or CANCELED if the queue was
@@ -46,7 +61,7 @@ class ConcurrentQueue {
   Status pop(tType &out);
 
   /**
-   * Pop up to N items from the queue.
+   * Pop up to N items from the queue, moving them to the back of {@code out}.
    * This function does not block if the queue is empty.
    *
    * @return Status ok if items were popped, or CANCELED if the queue was
@@ -81,6 +96,13 @@ class ConcurrentQueue {
   bool isOpen() const;
 
   private:
+  /**
+   * Blocks until there is room for another item, or the queue is closed.
+   *
+   * @return if the queue is still open
+   */
+  bool waitForRoom(std::unique_lock< std::mutex > &lock);
+
   mutable std::mutex m_mutex;
   mutable std::condition_variable m_producerCV;
   mutable std::condition_variable m_consumerCV;
@@ -18,14 +18,34 @@ inline ConcurrentQueue< tType >::ConcurrentQueue(size_t maxSize)
 template < typename tType >
 inline void ConcurrentQueue< tType >::push(const tType &val) {
   std::unique_lock< std::mutex > lock(m_mutex);
-  while (m_open.load()) {
-    if (m_queue.size() < m_maxSize) {
-      m_queue.push_back(val);
-      m_consumerCV.notify_one();
-      break;
-    } else {
-      m_producerCV.wait(lock);
-    }
+  if (waitForRoom(lock)) {
+    m_queue.push_back(val);
+    m_consumerCV.notify_one();
+  }
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline void ConcurrentQueue< tType >::push(tType &&val) {
+  std::unique_lock< std::mutex > lock(m_mutex);
+  if (waitForRoom(lock)) {
+    m_queue.push_back(std::move(val));
+    m_consumerCV.notify_one();
+  }
+}
+
+/**
+ *
+ */
+template < typename tType >
+template < typename... tArgs >
+inline void ConcurrentQueue< tType >::emplace(tArgs &&... args) {
+  std::unique_lock< std::mutex > lock(m_mutex);
+  if (waitForRoom(lock)) {
+    m_queue.emplace_back(std::forward< tArgs >(args)...);
+    m_consumerCV.notify_one();
   }
 }
 
@@ -42,7 +62,7 @@ inline Status ConcurrentQueue< tType >::pop(tType &out) {
     m_producerCV.notify_all();
     return Status(Status::CANCELED);
   }
-  out = m_queue.front();
+  out = std::move(m_queue.front());
   m_queue.pop_front();
   if (m_queue.empty()) {
     m_producerCV.notify_all();
@@ -86,7 +106,7 @@ ConcurrentQueue< tType >::popN(const size_t count, std::vector< tType > &out) {
     return Status(Status::CANCELED);
   }
   while (!m_queue.empty() && out.size() < count) {
-    out.push_back(m_queue.front());
+    out.push_back(std::move(m_queue.front()));
     m_queue.pop_front();
   }
   if (m_queue.empty()) {
@@ -133,6 +153,18 @@ inline bool ConcurrentQueue< tType >::isOpen() const {
   return m_open.load();
 }
 
+/**
+ *
+ */
+template < typename tType >
+inline bool
+ConcurrentQueue< tType >::waitForRoom(std::unique_lock< std::mutex > &lock) {
+  while (m_open.load() && m_queue.size() >= m_maxSize) {
+    m_producerCV.wait(lock);
+  }
+  return m_open.load();
+}
+
 } // namespace types
 } // namespace core
 
@@ -0,0 +1,102 @@
+/**
+ * Wait-free, single producer and single consumer ring of variable sized
+ * records.
+ */
+#ifndef FISHY_SPSC_BYTE_RING
+#define FISHY_SPSC_BYTE_RING
+
+#include <CORE/ARCH/atomics.h>
+#include <CORE/UTIL/noncopyable.h>
+#include <CORE/types.h>
+
+#include <vector>
+
+namespace core {
+namespace types {
+
+/**
+ * Ring of byte records for exactly one producing and one consuming thread.
+ * Unlike {@link SpscQueue}, each record only takes the bytes it needs, plus a
+ * small header, so the ring holds many short records or a few long ones.
+ *
+ * Every record is contiguous and 8 byte aligned: one that would run past the
+ * end of the ring is written at its start instead, leaving the end unused.
+ * Records may therefore be at most {@link maxRecordSize} bytes.
+ *
+ * Usage:
+ *     u8 *pRecord = ring.reserve(size);
+ *     if (pRecord != NULL) {
+ *       memcpy(pRecord, pData, size);
+ *       ring.commit();
+ *     }
+ */
+class SpscByteRing : util::noncopyable {
+  public:
+  /**
+   * @param capacity the size of the ring in bytes, rounded up to a power of
+   *     two
+   */
+  explicit SpscByteRing(const size_t capacity);
+
+  /**
+   * Make room for a record of {@code size} bytes. Only called by the
+   * producer. Nothing is visible to the consumer until {@link commit}.
+   *
+   * @return the record to fill in, or NULL if the ring is too full
+   */
+  u8 *reserve(const size_t size);
+
+  /**
+   * Publish the record from the last {@link reserve}.
+   */
+  void commit();
+
+  /**
+   * Look at the oldest record. Only called by the consumer.
+   *
+   * @return the record, which stays valid until {@link pop}, or NULL if the
+   *     ring is empty
+   */
+  const u8 *front(size_t &size);
+
+  /**
+   * Release the record from the last {@link front}.
+   */
+  void pop();
+
+  /**
+   * @return if the ring is likely empty
+   */
+  bool empty() const;
+
+  /**
+   * @return the size of the ring in bytes
+   */
+  size_t capacity() const { return m_mask + 1; }
+
+  /**
+   * @return the largest record that always fits an empty ring
+   */
+  size_t maxRecordSize() const;
+
+  private:
+  std::vector< u64 > m_bytes;
+  size_t m_mask;
+
+  // Written by the consumer.
+  alignas(arch::CACHE_LINE_SIZE) arch::Atomic< size_t > m_head;
+  size_t m_cachedTail;
+  size_t m_frontLen;
+
+  // Written by the producer.
+  alignas(arch::CACHE_LINE_SIZE) arch::Atomic< size_t > m_tail;
+  size_t m_cachedHead;
+  size_t m_reservedLen;
+};
+
+} // namespace types
+} // namespace core
+
+#  include "spsc_byte_ring.inl"
+
+#endif
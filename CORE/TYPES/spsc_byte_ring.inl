@@ -0,0 +1,148 @@
+#ifndef FISHY_SPSC_BYTE_RING_INL
+#define FISHY_SPSC_BYTE_RING_INL
+
+#include <CORE/BASE/checks.h>
+#include <CORE/MEMORY/memory.h>
+
+#include <algorithm>
+
+namespace core {
+namespace types {
+
+/**
+ * Bytes in front of each record, holding its size. Also keeps records 8 byte
+ * aligned.
+ */
+static const size_t BYTE_RING_HEADER_SIZE = sizeof(u64);
+
+/**
+ * Size of a record marking the rest of the ring as unused.
+ */
+static const u32 BYTE_RING_SKIP = 0xFFFFFFFF;
+
+namespace detail {
+
+/**
+ * @return the bytes a record of {@code size} takes, header included
+ */
+inline size_t ByteRingRecordLength(const size_t size) {
+  const size_t align = sizeof(u64);
+  return (BYTE_RING_HEADER_SIZE + size + align - 1) & ~(align - 1);
+}
+
+} // namespace detail
+
+/**
+ *
+ */
+inline SpscByteRing::SpscByteRing(const size_t capacity)
+    : m_bytes(
+          memory::nextPow2(
+              (intptr_t) std::max(capacity, 8 * BYTE_RING_HEADER_SIZE))
+          / sizeof(u64)),
+      m_mask(m_bytes.size() * sizeof(u64) - 1),
+      m_head(0),
+      m_cachedTail(0),
+      m_frontLen(0),
+      m_tail(0),
+      m_cachedHead(0),
+      m_reservedLen(0) {
+  CHECK_M(capacity > 0, "Bad spsc byte ring capacity");
+}
+
+/**
+ *
+ */
+inline u8 *SpscByteRing::reserve(const size_t size) {
+  const size_t len = detail::ByteRingRecordLength(size);
+  if (size > maxRecordSize()) {
+    return NULL;
+  }
+
+  // A record which does not fit before the end of the ring also takes the
+  // bytes it skips.
+  const size_t tail = m_tail.load(std::memory_order_relaxed);
+  size_t offset = tail & m_mask;
+  const size_t toEnd = capacity() - offset;
+  const size_t total = len <= toEnd ? len : toEnd + len;
+  if (capacity() - (tail - m_cachedHead) < total) {
+    m_cachedHead = m_head.load(std::memory_order_acquire);
+    if (capacity() - (tail - m_cachedHead) < total) {
+      return NULL;
+    }
+  }
+
+  u8 *pBytes = (u8 *) m_bytes.data();
+  if (len > toEnd) {
+    *(u32 *) (pBytes + offset) = BYTE_RING_SKIP;
+    offset = 0;
+  }
+  *(u32 *) (pBytes + offset) = (u32) size;
+  m_reservedLen = total;
+  return pBytes + offset + BYTE_RING_HEADER_SIZE;
+}
+
+/**
+ *
+ */
+inline void SpscByteRing::commit() {
+  m_tail.store(
+      m_tail.load(std::memory_order_relaxed) + m_reservedLen,
+      std::memory_order_release);
+  m_reservedLen = 0;
+}
+
+/**
+ *
+ */
+inline const u8 *SpscByteRing::front(size_t &size) {
+  const size_t head = m_head.load(std::memory_order_relaxed);
+  if (m_cachedTail == head) {
+    m_cachedTail = m_tail.load(std::memory_order_acquire);
+    if (m_cachedTail == head) {
+      return NULL;
+    }
+  }
+
+  const u8 *pBytes = (const u8 *) m_bytes.data();
+  size_t offset = head & m_mask;
+  size_t skipped = 0;
+  if (*(const u32 *) (pBytes + offset) == BYTE_RING_SKIP) {
+    skipped = capacity() - offset;
+    offset = 0;
+  }
+  size = *(const u32 *) (pBytes + offset);
+  m_frontLen = skipped + detail::ByteRingRecordLength(size);
+  return pBytes + offset + BYTE_RING_HEADER_SIZE;
+}
+
+/**
+ *
+ */
+inline void SpscByteRing::pop() {
+  m_head.store(
+      m_head.load(std::memory_order_relaxed) + m_frontLen,
+      std::memory_order_release);
+  m_frontLen = 0;
+}
+
+/**
+ *
+ */
+inline bool SpscByteRing::empty() const {
+  return m_head.load(std::memory_order_acquire)
+         == m_tail.load(std::memory_order_acquire);
+}
+
+/**
+ * Half the ring: either the free bytes before the end of the ring, or those
+ * after its start, are always at least that many.
+ */
+inline size_t SpscByteRing::maxRecordSize() const {
+  return capacity() / 2 - BYTE_RING_HEADER_SIZE;
+}
+
+} // namespace types
+} // namespace core
+
+#endif
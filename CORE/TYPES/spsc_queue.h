@@ -0,0 +1,127 @@
+/**
+ * Wait-free, fixed capacity, single producer and single consumer queue.
+ */
+#ifndef FISHY_SPSC_QUEUE
+#define FISHY_SPSC_QUEUE
+
+#include <CORE/BASE/status.h>
+#include <CORE/MEMORY/memory.h>
+#include <CORE/UTIL/noncopyable.h>
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace core {
+namespace types {
+
+/**
+ * Ring queue for exactly one producing and one consuming thread, such as the
+ * network thread feeding the game thread.
+ *
+ * Each side owns one index, and keeps a cached copy of the other side's, so
+ * the other side's cache line is only read when the cached value says the
+ * queue looks full (or empty). Nothing ever waits or retries: every call
+ * completes in a bounded number of steps.
+ *
+ * Like {@link ConcurrentQueue}, once closed every push and pop is CANCELED.
+ */
+template < typename tType >
+class SpscQueue : util::noncopyable {
+  public:
+  /**
+   * @param capacity the max size of the queue, rounded up to a power of two
+   */
+  explicit SpscQueue(const size_t capacity);
+
+  /**
+   * Push a new item into the queue. Only called by the producer.
+   *
+   * @return Status ok if the item was pushed, OUT_OF_BOUNDS if the queue is
+   *     full, or CANCELED if the queue was closed.
+   */
+  Status tryPush(const tType &val);
+
+  /**
+   * Pop an item from the queue. Only called by the consumer.
+   *
+   * @return Status ok if an item was popped, NOT_FOUND if the queue is empty,
+   *     or CANCELED if the queue was closed.
+   */
+  Status tryPop(tType &out);
+
+  /**
+   * Push as many of {@code count} items as fit, in at most two runs of
+   * copies. Only called by the producer.
+   *
+   * @return the number of items pushed, 0 if the queue was closed
+   */
+  size_t pushN(const tType *items, const size_t count);
+
+  /**
+   * Pop up to {@code count} items into {@code out}, in at most two runs of
+   * moves. Only called by the consumer.
+   *
+   * @return the number of items popped, 0 if the queue was closed
+   */
+  size_t popN(tType *out, const size_t count);
+
+  /**
+   * @return the approximate size of the queue
+   */
+  size_t size() const;
+
+  /**
+   * @return if the queue is likely empty.
+   */
+  bool empty() const { return size() == 0; }
+
+  /**
+   * @return the max size of the queue
+   */
+  size_t capacity() const { return m_mask + 1; }
+
+  /**
+   * Closes the queue. No more items may be put into, or taken out of, the
+   * queue.
+   */
+  void close();
+
+  /**
+   * Check if the queue is still open.
+   */
+  bool isOpen() const;
+
+  private:
+  /**
+   * @return how many items the producer may push, reading the consumer's
+   *     index only if the cached copy is not enough for {@code wanted}
+   */
+  size_t pushSpace(const size_t tail, const size_t wanted);
+
+  /**
+   * @return how many items the consumer may pop, reading the producer's
+   *     index only if the cached copy is not enough for {@code wanted}
+   */
+  size_t popSpace(const size_t head, const size_t wanted);
+
+  std::vector< tType > m_items;
+  size_t m_mask;
+  std::atomic_bool m_open;
+
+  // Written by the consumer.
+  alignas(memory::CACHE_LINE_SIZE) std::atomic< size_t > m_head;
+  size_t m_cachedTail;
+
+  // Written by the producer.
+  alignas(memory::CACHE_LINE_SIZE) std::atomic< size_t > m_tail;
+  size_t m_cachedHead;
+};
+
+} // namespace types
+} // namespace core
+
+#  include "spsc_queue.inl"
+
+#endif
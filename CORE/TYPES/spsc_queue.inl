@@ -0,0 +1,156 @@
+#ifndef FISHY_SPSC_QUEUE_INL
+#define FISHY_SPSC_QUEUE_INL
+
+namespace core {
+namespace types {
+
+/**
+ *
+ */
+template < typename tType >
+inline SpscQueue< tType >::SpscQueue(const size_t capacity)
+    : m_items(memory::nextPow2(capacity)),
+      m_mask(m_items.size() - 1),
+      m_open(true),
+      m_head(0),
+      m_cachedTail(0),
+      m_tail(0),
+      m_cachedHead(0) {
+  CHECK_M(capacity > 0, "Bad spsc queue capacity");
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline Status SpscQueue< tType >::tryPush(const tType &val) {
+  if (!m_open.load(std::memory_order_relaxed)) {
+    return Status(Status::CANCELED);
+  }
+  const size_t tail = m_tail.load(std::memory_order_relaxed);
+  if (pushSpace(tail, 1) == 0) {
+    return Status(Status::OUT_OF_BOUNDS);
+  }
+  m_items[tail & m_mask] = val;
+  m_tail.store(tail + 1, std::memory_order_release);
+  return Status::ok();
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline Status SpscQueue< tType >::tryPop(tType &out) {
+  if (!m_open.load(std::memory_order_relaxed)) {
+    return Status(Status::CANCELED);
+  }
+  const size_t head = m_head.load(std::memory_order_relaxed);
+  if (popSpace(head, 1) == 0) {
+    return Status(Status::NOT_FOUND);
+  }
+  out = std::move(m_items[head & m_mask]);
+  m_head.store(head + 1, std::memory_order_release);
+  return Status::ok();
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline size_t
+SpscQueue< tType >::pushN(const tType *items, const size_t count) {
+  if (!m_open.load(std::memory_order_relaxed)) {
+    return 0;
+  }
+  const size_t tail = m_tail.load(std::memory_order_relaxed);
+  const size_t n = std::min(count, pushSpace(tail, count));
+
+  // Up to the end of the ring, then wrapped around to its start.
+  const size_t offset = tail & m_mask;
+  const size_t first = std::min(n, capacity() - offset);
+  std::copy(items, items + first, m_items.begin() + offset);
+  std::copy(items + first, items + n, m_items.begin());
+
+  m_tail.store(tail + n, std::memory_order_release);
+  return n;
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline size_t SpscQueue< tType >::popN(tType *out, const size_t count) {
+  if (!m_open.load(std::memory_order_relaxed)) {
+    return 0;
+  }
+  const size_t head = m_head.load(std::memory_order_relaxed);
+  const size_t n = std::min(count, popSpace(head, count));
+
+  const size_t offset = head & m_mask;
+  const size_t first = std::min(n, capacity() - offset);
+  std::move(
+      m_items.begin() + offset, m_items.begin() + offset + first, out);
+  std::move(m_items.begin(), m_items.begin() + (n - first), out + first);
+
+  m_head.store(head + n, std::memory_order_release);
+  return n;
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline size_t SpscQueue< tType >::size() const {
+  const size_t head = m_head.load(std::memory_order_acquire);
+  const size_t tail = m_tail.load(std::memory_order_acquire);
+  return std::min(tail - head, capacity());
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline void SpscQueue< tType >::close() {
+  m_open.store(false);
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline bool SpscQueue< tType >::isOpen() const {
+  return m_open.load();
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline size_t
+SpscQueue< tType >::pushSpace(const size_t tail, const size_t wanted) {
+  size_t space = capacity() - (tail - m_cachedHead);
+  if (space < wanted) {
+    m_cachedHead = m_head.load(std::memory_order_acquire);
+    space = capacity() - (tail - m_cachedHead);
+  }
+  return space;
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline size_t
+SpscQueue< tType >::popSpace(const size_t head, const size_t wanted) {
+  size_t space = m_cachedTail - head;
+  if (space < wanted) {
+    m_cachedTail = m_tail.load(std::memory_order_acquire);
+    space = m_cachedTail - head;
+  }
+  return space;
+}
+
+} // namespace types
+} // namespace core
+
+#endif
@@ -0,0 +1,101 @@
+/**
+ * Lock-free Chase-Lev work stealing deque.
+ */
+#ifndef FISHY_WORK_STEALING_DEQUE
+#define FISHY_WORK_STEALING_DEQUE
+
+#include <CORE/MEMORY/memory.h>
+#include <CORE/UTIL/noncopyable.h>
+#include <CORE/types.h>
+
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+
+namespace core {
+namespace types {
+
+/**
+ * Deque owned by a single thread, which pushes and takes items at the bottom,
+ * while any number of other threads steal items from the top.
+ *
+ * The owner only touches a shared cache line when the deque is close to
+ * empty, so a busy owner runs almost free of contention. The backing ring
+ * grows as needed; old rings are kept until the deque is destroyed, since a
+ * thief may still be reading them.
+ *
+ * Items are stored in atomics, so must be trivially copyable (eg. pointers).
+ */
+template < typename tType >
+class WorkStealingDeque : util::noncopyable {
+  public:
+  /**
+   * @param capacity the initial capacity, rounded up to a power of two
+   */
+  explicit WorkStealingDeque(const size_t capacity = 64);
+  ~WorkStealingDeque();
+
+  /**
+   * Push an item at the bottom. Only called by the owner.
+   */
+  void push(const tType &val);
+
+  /**
+   * Take the most recently pushed item. Only called by the owner.
+   *
+   * @return false if the deque is empty
+   */
+  bool take(tType &out);
+
+  /**
+   * Steal the oldest item. May be called by any thread.
+   *
+   * @return false if the deque is empty, or another thread won the item
+   */
+  bool steal(tType &out);
+
+  /**
+   * @return the approximate size of the deque
+   */
+  size_t size() const;
+
+  /**
+   * @return if the deque is likely empty.
+   */
+  bool empty() const { return size() == 0; }
+
+  private:
+  static_assert(
+      std::is_trivially_copyable< tType >::value,
+      "WorkStealingDeque items must be trivially copyable");
+
+  struct Ring {
+    explicit Ring(const s64 capacity);
+    ~Ring();
+
+    tType get(const s64 index) const {
+      return m_items[index & m_mask].load(std::memory_order_relaxed);
+    }
+    void put(const s64 index, const tType &val) {
+      m_items[index & m_mask].store(val, std::memory_order_relaxed);
+    }
+
+    s64 m_mask;
+    std::atomic< tType > *m_items;
+    // Outgrown ring, kept alive for late thieves.
+    Ring *m_pPrevious;
+  };
+
+  Ring *grow(Ring *pRing, const s64 bottom, const s64 top);
+
+  alignas(memory::CACHE_LINE_SIZE) std::atomic< s64 > m_top;
+  alignas(memory::CACHE_LINE_SIZE) std::atomic< s64 > m_bottom;
+  std::atomic< Ring * > m_ring;
+};
+
+} // namespace types
+} // namespace core
+
+#  include "work_stealing_deque.inl"
+
+#endif
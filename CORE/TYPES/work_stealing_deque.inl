@@ -0,0 +1,135 @@
+#ifndef FISHY_WORK_STEALING_DEQUE_INL
+#define FISHY_WORK_STEALING_DEQUE_INL
+
+namespace core {
+namespace types {
+
+/**
+ *
+ */
+template < typename tType >
+inline WorkStealingDeque< tType >::Ring::Ring(const s64 capacity)
+    : m_mask(capacity - 1),
+      m_items(new std::atomic< tType >[capacity]),
+      m_pPrevious(NULL) {
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline WorkStealingDeque< tType >::Ring::~Ring() {
+  delete[] m_items;
+  delete m_pPrevious;
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline WorkStealingDeque< tType >::WorkStealingDeque(const size_t capacity)
+    : m_top(0), m_bottom(0), m_ring(NULL) {
+  const size_t size = memory::nextPow2(std::max(capacity, (size_t) 2));
+  m_ring.store(new Ring((s64) size));
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline WorkStealingDeque< tType >::~WorkStealingDeque() {
+  delete m_ring.load();
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline void WorkStealingDeque< tType >::push(const tType &val) {
+  const s64 bottom = m_bottom.load(std::memory_order_relaxed);
+  const s64 top = m_top.load(std::memory_order_acquire);
+  Ring *pRing = m_ring.load(std::memory_order_relaxed);
+  if (bottom - top > pRing->m_mask) {
+    pRing = grow(pRing, bottom, top);
+  }
+  pRing->put(bottom, val);
+  std::atomic_thread_fence(std::memory_order_release);
+  m_bottom.store(bottom + 1, std::memory_order_relaxed);
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline bool WorkStealingDeque< tType >::take(tType &out) {
+  const s64 bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+  Ring *pRing = m_ring.load(std::memory_order_relaxed);
+  m_bottom.store(bottom, std::memory_order_relaxed);
+  // Publish the claim on the bottom item before looking at the top, so a
+  // thief and the owner can not both take the last item.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  s64 top = m_top.load(std::memory_order_relaxed);
+
+  if (top > bottom) {
+    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    return false;
+  }
+  out = pRing->get(bottom);
+  if (top != bottom) {
+    return true;
+  }
+
+  // Last item, race the thieves for it.
+  const bool won = m_top.compare_exchange_strong(
+      top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+  m_bottom.store(bottom + 1, std::memory_order_relaxed);
+  return won;
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline bool WorkStealingDeque< tType >::steal(tType &out) {
+  s64 top = m_top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const s64 bottom = m_bottom.load(std::memory_order_acquire);
+  if (top >= bottom) {
+    return false;
+  }
+
+  Ring *pRing = m_ring.load(std::memory_order_acquire);
+  out = pRing->get(top);
+  return m_top.compare_exchange_strong(
+      top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline size_t WorkStealingDeque< tType >::size() const {
+  const s64 bottom = m_bottom.load(std::memory_order_relaxed);
+  const s64 top = m_top.load(std::memory_order_relaxed);
+  return bottom > top ? (size_t) (bottom - top) : 0;
+}
+
+/**
+ *
+ */
+template < typename tType >
+inline typename WorkStealingDeque< tType >::Ring *
+WorkStealingDeque< tType >::grow(Ring *pRing, const s64 bottom, const s64 top) {
+  Ring *pGrown = new Ring((pRing->m_mask + 1) * 2);
+  for (s64 i = top; i < bottom; ++i) {
+    pGrown->put(i, pRing->get(i));
+  }
+  pGrown->m_pPrevious = pRing;
+  m_ring.store(pGrown, std::memory_order_release);
+  return pGrown;
+}
+
+} // namespace types
+} // namespace core
+
+#endif
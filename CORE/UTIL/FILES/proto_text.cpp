@@ -5,6 +5,7 @@
 
 #include <CORE/BASE/logging.h>
 #include <CORE/BASE/serializer_podtypes.h>
+#include <CORE/MEMORY/memory_tracking.h>
 #include <CORE/UTIL/lexical_cast.h>
 #include <CORE/UTIL/stringutil.h>
 #include <CORE/UTIL/tokenizer.h>
@@ -294,6 +295,7 @@ bool GetFieldAsString(
  *
  */
 void TextFormat::format(std::string &retVal, const iProtoMessage &msg) {
+  core::memory::ScopedMemoryTag tag(core::memory::eMemoryTag::PROTO);
   const ProtoDescriptor &descriptor = msg.getDescriptor();
   for (std::vector< FieldDef >::const_iterator field =
            descriptor.getDef().m_fields.begin();
@@ -337,6 +339,7 @@ void TextFormat::format(std::string &retVal, const iProtoMessage &msg) {
  */
 Status TextFormat::parse(
     iProtoMessage &msg, const std::string &textProto, bool errorOnUnknown) {
+  core::memory::ScopedMemoryTag tag(core::memory::eMemoryTag::PROTO);
   const ProtoDescriptor &descriptor = msg.getDescriptor();
   std::string::const_iterator begin = textProto.begin();
 
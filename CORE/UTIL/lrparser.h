@@ -5,6 +5,7 @@
 #define FISHY_LRPARSER_H
 
 #include <CORE/BASE/logging.h>
+#include <CORE/MEMORY/memory_tracking.h>
 #include <EXTERN_LIB/srutil/delegate/delegate.hpp>
 
 #include "tokenizer.h"
@@ -260,6 +260,7 @@ inline bool LRParser< tId >::parse(
     const std::string::const_iterator &begin,
     const std::string::const_iterator &end,
     const tErrorCB &cb) const {
+  core::memory::ScopedMemoryTag tag(core::memory::eMemoryTag::PARSER);
   std::vector< TokenOrNode > stack;
   stack.reserve(m_stackDepth);
 
@@ -0,0 +1,400 @@
+#include "task_scheduler.h"
+
+#include <CORE/ARCH/atomics.h>
+#include <CORE/TYPES/work_stealing_deque.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace core {
+namespace util {
+
+/**
+ * Times an idle worker looks for a task, yielding in between, before it
+ * sleeps.
+ */
+static const u32 IDLE_SPINS = 64;
+
+/**
+ * A queued task, and the group it belongs to.
+ */
+struct ScheduledTask {
+  ScheduledTask(TaskGroup &group, tTask &&fn)
+      : m_pGroup(&group), m_fn(std::move(fn)) {}
+
+  TaskGroup *m_pGroup;
+  tTask m_fn;
+};
+
+/**
+ * Scheduler the current thread is a worker of, and its index there.
+ */
+static thread_local const void *s_pCurrentScheduler = NULL;
+static thread_local u32 s_workerIndex = 0;
+
+/**
+ *
+ */
+class TaskScheduler::Impl {
+  public:
+  Impl(const u32 workerCount);
+  ~Impl();
+
+  u32 getWorkerCount() const { return (u32) m_workers.size(); }
+  void submit(TaskGroup &group, tTask &&task);
+  void wait(TaskGroup &group);
+
+  private:
+  struct Worker {
+    Worker(const u32 index) : m_random(index * 2654435761u + 1) {}
+
+    core::types::WorkStealingDeque< ScheduledTask * > m_deque;
+    std::thread m_thread;
+    u32 m_random;
+  };
+
+  /**
+   * @return the index of the current thread's worker, or getWorkerCount() if
+   *     it is not one of ours
+   */
+  u32 currentWorker() const;
+
+  /**
+   * Find a task for worker {@code index}, which may be getWorkerCount() for
+   * an outside thread.
+   *
+   * @return NULL if no task was found
+   */
+  ScheduledTask *findTask(const u32 index);
+  ScheduledTask *popInjected();
+  void runTask(ScheduledTask *pTask);
+  void sleep();
+  void blockUntilDone(TaskGroup &group);
+  void workerFn(const u32 index);
+
+  std::vector< Worker * > m_workers;
+  std::atomic_bool m_running;
+
+  std::mutex m_injectedMutex;
+  std::deque< ScheduledTask * > m_injected;
+  std::atomic< size_t > m_injectedCount;
+
+  // Tasks queued but not yet started, so sleepers know when to wake.
+  std::atomic< u64 > m_queued;
+  std::mutex m_sleepMutex;
+  std::condition_variable m_sleepCV;
+  std::atomic< u32 > m_sleepers;
+
+  // Outside threads blocked until a group finishes.
+  std::mutex m_doneMutex;
+  std::condition_variable m_doneCV;
+  std::atomic< u32 > m_doneWaiters;
+};
+
+/**
+ *
+ */
+TaskScheduler::Impl::Impl(const u32 workerCount)
+    : m_running(true),
+      m_injectedCount(0),
+      m_queued(0),
+      m_sleepers(0),
+      m_doneWaiters(0) {
+  for (u32 i = 0; i < workerCount; ++i) {
+    m_workers.push_back(new Worker(i));
+  }
+  // Workers steal from each other, so all must exist before any starts.
+  for (u32 i = 0; i < workerCount; ++i) {
+    m_workers[i]->m_thread = std::thread(&Impl::workerFn, this, i);
+  }
+}
+
+/**
+ *
+ */
+TaskScheduler::Impl::~Impl() {
+  {
+    std::lock_guard< std::mutex > lock(m_sleepMutex);
+    m_running = false;
+    m_sleepCV.notify_all();
+  }
+  for (size_t i = 0; i < m_workers.size(); ++i) {
+    m_workers[i]->m_thread.join();
+  }
+
+  // Drop tasks of groups that were never waited on.
+  ScheduledTask *pTask;
+  for (size_t i = 0; i < m_workers.size(); ++i) {
+    while (m_workers[i]->m_deque.take(pTask)) {
+      delete pTask;
+    }
+    delete m_workers[i];
+  }
+  while ((pTask = popInjected()) != NULL) {
+    delete pTask;
+  }
+}
+
+/**
+ *
+ */
+void TaskScheduler::Impl::submit(TaskGroup &group, tTask &&task) {
+  group.m_pending.fetch_add(1, std::memory_order_relaxed);
+  m_queued.fetch_add(1, std::memory_order_relaxed);
+  ScheduledTask *pTask = new ScheduledTask(group, std::move(task));
+
+  const u32 index = currentWorker();
+  if (index < m_workers.size()) {
+    m_workers[index]->m_deque.push(pTask);
+  } else {
+    std::lock_guard< std::mutex > lock(m_injectedMutex);
+    m_injected.push_back(pTask);
+    m_injectedCount.store(m_injected.size(), std::memory_order_relaxed);
+  }
+
+  // Pairs with the fence in sleep(): either this sees the sleeper, or the
+  // sleeper sees the new task.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_sleepers.load(std::memory_order_relaxed) != 0) {
+    std::lock_guard< std::mutex > lock(m_sleepMutex);
+    m_sleepCV.notify_one();
+  }
+}
+
+/**
+ * Help run tasks until the group is done. Outside threads that run out of
+ * tasks to help with block once the backoff starts yielding, while workers
+ * keep looking, as the tasks they wait on may be queued on their own deque.
+ */
+void TaskScheduler::Impl::wait(TaskGroup &group) {
+  const u32 index = currentWorker();
+  core::arch::Backoff backoff;
+  while (group.m_pending.load(std::memory_order_acquire) != 0) {
+    ScheduledTask *pTask = findTask(index);
+    if (pTask != NULL) {
+      runTask(pTask);
+      backoff.reset();
+    } else if (index == getWorkerCount() && backoff.yielding()) {
+      blockUntilDone(group);
+    } else {
+      backoff.pause();
+    }
+  }
+}
+
+/**
+ *
+ */
+void TaskScheduler::Impl::blockUntilDone(TaskGroup &group) {
+  std::unique_lock< std::mutex > lock(m_doneMutex);
+  m_doneWaiters.fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while (group.m_pending.load(std::memory_order_acquire) != 0) {
+    m_doneCV.wait(lock);
+  }
+  m_doneWaiters.fetch_sub(1);
+}
+
+/**
+ *
+ */
+u32 TaskScheduler::Impl::currentWorker() const {
+  return s_pCurrentScheduler == this ? s_workerIndex : getWorkerCount();
+}
+
+/**
+ *
+ */
+ScheduledTask *TaskScheduler::Impl::findTask(const u32 index) {
+  ScheduledTask *pTask = NULL;
+  const u32 count = getWorkerCount();
+  if (index < count && m_workers[index]->m_deque.take(pTask)) {
+    return pTask;
+  }
+  if ((pTask = popInjected()) != NULL) {
+    return pTask;
+  }
+
+  // Steal, starting from a random victim so thieves spread out.
+  u32 start = 0;
+  if (index < count) {
+    u32 &random = m_workers[index]->m_random;
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    start = random;
+  }
+  for (u32 i = 0; i < count; ++i) {
+    const u32 victim = (start + i) % count;
+    if (victim != index && m_workers[victim]->m_deque.steal(pTask)) {
+      return pTask;
+    }
+  }
+  return NULL;
+}
+
+/**
+ *
+ */
+ScheduledTask *TaskScheduler::Impl::popInjected() {
+  if (m_injectedCount.load(std::memory_order_relaxed) == 0) {
+    return NULL;
+  }
+  std::lock_guard< std::mutex > lock(m_injectedMutex);
+  if (m_injected.empty()) {
+    return NULL;
+  }
+  ScheduledTask *pTask = m_injected.front();
+  m_injected.pop_front();
+  m_injectedCount.store(m_injected.size(), std::memory_order_relaxed);
+  return pTask;
+}
+
+/**
+ *
+ */
+void TaskScheduler::Impl::runTask(ScheduledTask *pTask) {
+  m_queued.fetch_sub(1, std::memory_order_relaxed);
+  pTask->m_fn();
+  TaskGroup *pGroup = pTask->m_pGroup;
+  delete pTask;
+  // The group may be destroyed as soon as this reaches 0.
+  if (pGroup->m_pending.fetch_sub(1, std::memory_order_release) != 1) {
+    return;
+  }
+
+  // Pairs with the fence in blockUntilDone(): either this sees the waiter, or
+  // the waiter sees the group done.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_doneWaiters.load(std::memory_order_relaxed) != 0) {
+    std::lock_guard< std::mutex > lock(m_doneMutex);
+    m_doneCV.notify_all();
+  }
+}
+
+/**
+ *
+ */
+void TaskScheduler::Impl::sleep() {
+  std::unique_lock< std::mutex > lock(m_sleepMutex);
+  m_sleepers.fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while (m_running.load() && m_queued.load(std::memory_order_relaxed) == 0) {
+    m_sleepCV.wait(lock);
+  }
+  m_sleepers.fetch_sub(1);
+}
+
+/**
+ *
+ */
+void TaskScheduler::Impl::workerFn(const u32 index) {
+  s_pCurrentScheduler = this;
+  s_workerIndex = index;
+
+  u32 idle = 0;
+  core::arch::Backoff backoff;
+  while (m_running.load(std::memory_order_relaxed)) {
+    ScheduledTask *pTask = findTask(index);
+    if (pTask != NULL) {
+      runTask(pTask);
+      idle = 0;
+      backoff.reset();
+    } else if (++idle < IDLE_SPINS) {
+      backoff.pause();
+    } else {
+      sleep();
+      idle = 0;
+      backoff.reset();
+    }
+  }
+}
+
+/**
+ *
+ */
+TaskScheduler::TaskScheduler(const u32 workerCount) : m_pImpl(NULL) {
+  u32 count = workerCount;
+  if (count == 0) {
+    count = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  m_pImpl = new Impl(count);
+}
+
+/**
+ *
+ */
+TaskScheduler::~TaskScheduler() {
+  delete m_pImpl;
+}
+
+/**
+ *
+ */
+u32 TaskScheduler::getWorkerCount() const {
+  return m_pImpl->getWorkerCount();
+}
+
+/**
+ *
+ */
+void TaskScheduler::submit(TaskGroup &group, tTask &&task) {
+  m_pImpl->submit(group, std::move(task));
+}
+
+/**
+ *
+ */
+void TaskScheduler::wait(TaskGroup &group) {
+  m_pImpl->wait(group);
+}
+
+/**
+ *
+ */
+TaskGroup::TaskGroup(TaskScheduler &scheduler)
+    : m_scheduler(scheduler), m_pending(0) {
+}
+
+/**
+ *
+ */
+TaskGroup::~TaskGroup() {
+  wait();
+}
+
+/**
+ *
+ */
+void TaskGroup::run(const tTask &task) {
+  m_scheduler.submit(*this, tTask(task));
+}
+
+/**
+ *
+ */
+void TaskGroup::run(tTask &&task) {
+  m_scheduler.submit(*this, std::move(task));
+}
+
+/**
+ *
+ */
+void TaskGroup::wait() {
+  m_scheduler.wait(*this);
+}
+
+/**
+ *
+ */
+bool TaskGroup::done() const {
+  return m_pending.load(std::memory_order_acquire) == 0;
+}
+
+} // namespace util
+} // namespace core
@@ -0,0 +1,129 @@
+/**
+ * Work stealing task scheduler, and parallel loop helpers built on it.
+ */
+#ifndef FISHY_TASK_SCHEDULER_H
+#define FISHY_TASK_SCHEDULER_H
+
+#include <CORE/UTIL/noncopyable.h>
+#include <CORE/types.h>
+
+#include <atomic>
+#include <functional>
+
+namespace core {
+namespace util {
+
+typedef std::function< void() > tTask;
+
+class TaskScheduler;
+
+/**
+ * A set of tasks run on a {@link TaskScheduler}, that can be waited on
+ * together. Tasks may add more tasks to the group they run in.
+ *
+ * The destructor waits for any tasks still in the group.
+ */
+class TaskGroup : noncopyable {
+  public:
+  explicit TaskGroup(TaskScheduler &scheduler);
+  ~TaskGroup();
+
+  /**
+   * Queue {@code task} to run on the scheduler. Safe to call from any thread.
+   */
+  void run(const tTask &task);
+  void run(tTask &&task);
+
+  /**
+   * Block until every task in the group has finished. The calling thread runs
+   * queued tasks while it waits, so waiting from inside a task does not tie
+   * up a worker.
+   */
+  void wait();
+
+  /**
+   * @return if every task in the group has finished
+   */
+  bool done() const;
+
+  private:
+  friend class TaskScheduler;
+
+  TaskScheduler &m_scheduler;
+  std::atomic< u32 > m_pending;
+};
+
+/**
+ * Pool of worker threads, each with its own {@link WorkStealingDeque}.
+ *
+ * Tasks queued from a worker go to the bottom of that worker's deque, and it
+ * runs them newest first while the work is still in cache. Tasks queued from
+ * any other thread go to a shared injection queue. An idle worker first
+ * drains the injection queue, then steals the oldest task of a random other
+ * worker, and finally sleeps until more tasks are queued.
+ *
+ * Every {@link TaskGroup} must be finished before the scheduler is destroyed.
+ */
+class TaskScheduler : noncopyable {
+  public:
+  /**
+   * @param workerCount number of worker threads, or 0 for one per core
+   */
+  explicit TaskScheduler(const u32 workerCount = 0);
+  ~TaskScheduler();
+
+  /**
+   * @return the number of worker threads
+   */
+  u32 getWorkerCount() const;
+
+  private:
+  friend class TaskGroup;
+
+  void submit(TaskGroup &group, tTask &&task);
+  void wait(TaskGroup &group);
+
+  class Impl;
+  Impl *m_pImpl;
+};
+
+/**
+ * Call {@code fn(rangeBegin, rangeEnd)} over [begin, end), split into ranges
+ * of at most {@code grain} items run in parallel. Returns once every range
+ * has been processed.
+ *
+ * Ranges are split in halves on demand, so idle workers steal large ranges
+ * and split them further themselves.
+ */
+template < typename tFn >
+void ParallelFor(
+    TaskScheduler &scheduler,
+    const size_t begin,
+    const size_t end,
+    const size_t grain,
+    const tFn &fn);
+
+/**
+ * Reduce [begin, end) in parallel. Each range of at most {@code grain} items
+ * is reduced with {@code map(rangeBegin, rangeEnd)}, then the results are
+ * combined in order with {@code combine(lhs, rhs)}, so the result does not
+ * depend on the thread timing.
+ *
+ * @return {@code identity} if the range is empty
+ */
+template < typename tValue, typename tMap, typename tCombine >
+tValue ParallelReduce(
+    TaskScheduler &scheduler,
+    const size_t begin,
+    const size_t end,
+    const size_t grain,
+    const tValue &identity,
+    const tMap &map,
+    const tCombine &combine);
+
+} // namespace util
+} // namespace core
+
+#  include "task_scheduler.inl"
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef FISHY_TASK_SCHEDULER_INL
+#define FISHY_TASK_SCHEDULER_INL
+
+#include <CORE/ARCH/atomics.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace core {
+namespace util {
+
+/**
+ * Queue the upper halves of [begin, end) as tasks until a range of at most
+ * {@code grain} items is left, then process that range on this thread.
+ */
+template < typename tFn >
+inline void SplitRange(
+    TaskGroup &group,
+    size_t begin,
+    size_t end,
+    const size_t grain,
+    const tFn &fn) {
+  while (end - begin > grain) {
+    const size_t mid = begin + (end - begin) / 2;
+    group.run([&group, mid, end, grain, &fn]() {
+      SplitRange(group, mid, end, grain, fn);
+    });
+    end = mid;
+  }
+  if (begin < end) {
+    fn(begin, end);
+  }
+}
+
+/**
+ *
+ */
+template < typename tFn >
+inline void ParallelFor(
+    TaskScheduler &scheduler,
+    const size_t begin,
+    const size_t end,
+    const size_t grain,
+    const tFn &fn) {
+  TaskGroup group(scheduler);
+  SplitRange(group, begin, end, std::max(grain, (size_t) 1), fn);
+  group.wait();
+}
+
+/**
+ *
+ */
+template < typename tValue, typename tMap, typename tCombine >
+inline tValue ParallelReduce(
+    TaskScheduler &scheduler,
+    const size_t begin,
+    const size_t end,
+    const size_t grain,
+    const tValue &identity,
+    const tMap &map,
+    const tCombine &combine) {
+  if (begin >= end) {
+    return identity;
+  }
+
+  // One result per fixed chunk, so combining order never changes. Each is
+  // an object on cache lines of its own, as chunks finish on different
+  // threads: a std::vector< bool > would pack them into shared words.
+  const size_t chunkSize = std::max(grain, (size_t) 1);
+  const size_t chunks = (end - begin + chunkSize - 1) / chunkSize;
+  const core::arch::CacheAligned< tValue > initial = {identity};
+  std::vector< core::arch::CacheAligned< tValue > > results(chunks, initial);
+  ParallelFor(
+      scheduler, 0, chunks, 1, [&](const size_t first, const size_t last) {
+        for (size_t i = first; i < last; ++i) {
+          const size_t chunkBegin = begin + i * chunkSize;
+          results[i].m_value =
+              map(chunkBegin, std::min(chunkBegin + chunkSize, end));
+        }
+      });
+
+  tValue ret = results[0].m_value;
+  for (size_t i = 1; i < chunks; ++i) {
+    ret = combine(ret, results[i].m_value);
+  }
+  return ret;
+}
+
+} // namespace util
+} // namespace core
+
+#endif
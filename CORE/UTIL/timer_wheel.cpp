@@ -0,0 +1,86 @@
+#include "timer_wheel.h"
+
+#include <CORE/BASE/checks.h>
+
+#include <algorithm>
+
+namespace core {
+namespace util {
+
+/**
+ *
+ */
+TimerWheel::TimerWheel(const u64 slotTicks, const size_t slotCount)
+    : m_slots(slotCount), m_slotTicks(slotTicks), m_next(0), m_size(0) {
+  CHECK_M(slotTicks > 0, "Bad timer wheel slot width");
+  CHECK_M(slotCount > 0, "Bad timer wheel slot count");
+}
+
+/**
+ *
+ */
+void TimerWheel::schedule(const u32 id, const u64 deadline) {
+  // Deadlines in slots that already passed go in the next slot to come due.
+  const u64 slot = std::max(deadline / m_slotTicks, m_next);
+  Deadline entry;
+  entry.m_id = id;
+  entry.m_deadline = deadline;
+  m_slots[slot % m_slots.size()].push_back(entry);
+  m_size++;
+}
+
+/**
+ *
+ */
+void TimerWheel::advance(const u64 now, std::vector< Deadline > &expired) {
+  const u64 target = now / m_slotTicks;
+  if (target < m_next) {
+    return;
+  }
+
+  if (target - m_next >= m_slots.size()) {
+    // More than a full turn passed, so every slot is due.
+    m_next = target + 1;
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+      processSlot(i, now, expired);
+    }
+    return;
+  }
+
+  while (m_next <= target) {
+    const size_t slot = m_next % m_slots.size();
+    m_next++;
+    processSlot(slot, now, expired);
+  }
+}
+
+/**
+ *
+ */
+void TimerWheel::clear() {
+  for (size_t i = 0; i < m_slots.size(); ++i) {
+    m_slots[i].clear();
+  }
+  m_size = 0;
+}
+
+/**
+ * Expire the due entries of one slot, and put the rest back for a later turn.
+ */
+void TimerWheel::processSlot(
+    const size_t slot, const u64 now, std::vector< Deadline > &expired) {
+  m_scratch.swap(m_slots[slot]);
+  m_size -= m_scratch.size();
+  for (size_t i = 0; i < m_scratch.size(); ++i) {
+    const Deadline &entry = m_scratch[i];
+    if (entry.m_deadline <= now) {
+      expired.push_back(entry);
+    } else {
+      schedule(entry.m_id, entry.m_deadline);
+    }
+  }
+  m_scratch.clear();
+}
+
+} // namespace util
+} // namespace core
@@ -0,0 +1,78 @@
+/**
+ * Hashed timing wheel, for tracking large numbers of deadlines.
+ */
+#ifndef FISHY_TIMER_WHEEL_H
+#define FISHY_TIMER_WHEEL_H
+
+#include <CORE/types.h>
+
+#include <vector>
+
+namespace core {
+namespace util {
+
+/**
+ * Tracks deadlines for ids, bucketed into fixed width slots of a wheel.
+ * Scheduling is O(1), and {@link #advance} only touches the slots that came
+ * due since the last call, regardless of how many deadlines are pending.
+ *
+ * Deadlines further out than one turn of the wheel stay in their slot, and
+ * are skipped over until the turn they are due in.
+ */
+class TimerWheel {
+  public:
+  /**
+   * A deadline for an id.
+   */
+  struct Deadline {
+    u32 m_id;
+    u64 m_deadline;
+  };
+
+  /**
+   * @param slotTicks width of each slot, in the same units as deadlines.
+   *     Deadlines fire up to one slot late.
+   * @param slotCount number of slots in one turn of the wheel
+   */
+  TimerWheel(const u64 slotTicks, const size_t slotCount);
+
+  /**
+   * Add a deadline for {@code id}. Ids are not deduplicated, rescheduling an
+   * id adds a second deadline for it.
+   */
+  void schedule(const u32 id, const u64 deadline);
+
+  /**
+   * Pop every deadline that is due by {@code now}.
+   *
+   * @param expired due deadlines are appended to this. Their deadline tells
+   *     a rescheduled id's current deadline from those it replaced.
+   */
+  void advance(const u64 now, std::vector< Deadline > &expired);
+
+  /**
+   * Remove all deadlines.
+   */
+  void clear();
+
+  /**
+   * @return the number of pending deadlines
+   */
+  size_t size() const { return m_size; }
+
+  private:
+  std::vector< std::vector< Deadline > > m_slots;
+  std::vector< Deadline > m_scratch;
+  u64 m_slotTicks;
+  // Absolute index of the next slot to come due.
+  u64 m_next;
+  size_t m_size;
+
+  void processSlot(
+      const size_t slot, const u64 now, std::vector< Deadline > &expired);
+};
+
+} // namespace util
+} // namespace core
+
+#endif
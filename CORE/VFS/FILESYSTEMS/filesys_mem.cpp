@@ -287,6 +287,18 @@ MemFileSystem::iterate(const tMountId mountId, const Path &root, bool recurse) {
 
 Status
 MemFileSystem::create(const Path &path, const core::memory::ConstBlob &blob) {
+  return createReadonly(path, blob, core::memory::SharedBuffer());
+}
+
+Status MemFileSystem::create(
+    const Path &path, const core::memory::SharedBuffer &buffer) {
+  return createReadonly(path, buffer, buffer);
+}
+
+Status MemFileSystem::createReadonly(
+    const Path &path,
+    const core::memory::ConstBlob &blob,
+    const core::memory::SharedBuffer &owner) {
   std::lock_guard< std::mutex > lock(m_lock);
   tFileMap::const_iterator itr = m_files.find(path.str());
   if (itr != m_files.end()) {
@@ -295,6 +307,7 @@ MemFileSystem::create(const Path &path, const core::memory::ConstBlob &blob) {
 
   FileInfo info;
   info.m_readableBlob = blob;
+  info.m_buffer = owner;
   info.m_readonly = true;
   info.m_stats.m_exists = true;
   info.m_stats.m_isDir = false;
@@ -5,6 +5,7 @@
 #define FISHY_FILESYS_MEM_H
 
 #include <CORE/MEMORY/blob.h>
+#include <CORE/MEMORY/shared_buffer.h>
 #include <CORE/VFS/vfs_filesystem.h>
 
 #include <mutex>
@@ -52,6 +53,12 @@ class MemFileSystem : public iFileSystem {
    */
   Status create(const Path &path, const core::memory::ConstBlob &buffer);
 
+  /**
+   * Create a readonly file in the system, sharing {@code buffer}. The file
+   * keeps the buffer alive until it is removed, so the caller need not.
+   */
+  Status create(const Path &path, const core::memory::SharedBuffer &buffer);
+
   /**
    * Create a writable file in the system.
    * This file must be deleted by a call to {@link #remove}.
@@ -66,11 +73,18 @@ class MemFileSystem : public iFileSystem {
   struct FileInfo {
     core::memory::Blob m_writeableBlob;
     core::memory::ConstBlob m_readableBlob;
+    // Owns the data of files created from a SharedBuffer.
+    core::memory::SharedBuffer m_buffer;
     FileStats m_stats;
     bool m_readonly;
   };
 
   private:
+  Status createReadonly(
+      const Path &path,
+      const core::memory::ConstBlob &blob,
+      const core::memory::SharedBuffer &owner);
+
   struct MountInfo {
     std::ios_base::openmode m_mode;
   };
@@ -5,6 +5,7 @@
 #include <CORE/BASE/asserts.h>
 #include <CORE/BASE/checks.h>
 #include <CORE/BASE/logging.h>
+#include <CORE/MEMORY/memory_tracking.h>
 #include <CORE/UTIL/algorithm.h>
 #include <CORE/UTIL/lexical_cast.h>
 #include <CORE/VFS/FILESYSTEMS/filesys_mem.h>
@@ -410,6 +411,7 @@ filters::streamfilter *open(const Path &path, const std::ios::openmode mode) {
  */
 filters::streamfilter *
 VfsDetail::open(const Path &path, const std::ios::openmode mode) {
+  core::memory::ScopedMemoryTag tag(core::memory::eMemoryTag::VFS);
   std::lock_guard< std::mutex > lock(m_mutex);
   filters::streamfilter *retVal = nullptr;
   OpenVisitor visitor(mode);
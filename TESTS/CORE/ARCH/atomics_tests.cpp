@@ -0,0 +1,81 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/ARCH/atomics.h>
+
+#include <thread>
+#include <vector>
+
+using core::arch::Atomic;
+using core::arch::Backoff;
+using core::arch::CacheAligned;
+using core::arch::OwnedCounter;
+using core::arch::RelaxedCounter;
+
+REGISTER_TEST_CASE(testAtomicOperations) {
+  Atomic< u32 > value(5);
+  TEST(testing::assertEquals(value.load(std::memory_order_relaxed), 5u));
+  TEST(testing::assertEquals(
+      value.fetchAdd(3, std::memory_order_relaxed), 5u));
+  TEST(testing::assertEquals(
+      value.fetchSub(1, std::memory_order_relaxed), 8u));
+  TEST(testing::assertEquals(
+      value.exchange(10, std::memory_order_acq_rel), 7u));
+
+  u32 expected = 9;
+  TEST(testing::assertFalse(value.compareExchange(
+      expected, 11, std::memory_order_acq_rel, std::memory_order_acquire)));
+  TEST(testing::assertEquals(expected, 10u));
+  TEST(testing::assertTrue(value.compareExchange(
+      expected, 11, std::memory_order_acq_rel, std::memory_order_acquire)));
+  TEST(testing::assertEquals(value.load(std::memory_order_acquire), 11u));
+}
+
+REGISTER_TEST_CASE(testRelaxedCounterThreads) {
+  RelaxedCounter< u64 > counter;
+  std::vector< std::thread > threads;
+  for (u32 i = 0; i < 4; ++i) {
+    threads.push_back(std::thread([&counter]() {
+      for (u32 n = 0; n < 10000; ++n) {
+        counter.add(1);
+      }
+    }));
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+  TEST(testing::assertEquals(counter.get(), 40000ull));
+  counter.sub(40000);
+  TEST(testing::assertEquals(counter.get(), 0ull));
+}
+
+REGISTER_TEST_CASE(testOwnedCounter) {
+  OwnedCounter< u64 > counter;
+  std::thread owner([&counter]() {
+    for (u32 n = 0; n < 1000; ++n) {
+      counter.add(2);
+    }
+  });
+  owner.join();
+  TEST(testing::assertEquals(counter.get(), 2000ull));
+}
+
+REGISTER_TEST_CASE(testCacheAligned) {
+  CacheAligned< u32 > values[2];
+  TEST(testing::assertEquals(
+      ((intptr_t) &values[0].m_value) % core::arch::CACHE_LINE_SIZE, 0));
+  TEST(testing::assertTrue(
+      (u8 *) &values[1].m_value - (u8 *) &values[0].m_value
+      >= (ptrdiff_t) core::arch::CACHE_LINE_SIZE));
+}
+
+REGISTER_TEST_CASE(testBackoff) {
+  Backoff backoff;
+  TEST(testing::assertFalse(backoff.yielding()));
+  for (u32 i = 0; i < 16; ++i) {
+    backoff.pause();
+  }
+  TEST(testing::assertTrue(backoff.yielding()));
+  backoff.reset();
+  TEST(testing::assertFalse(backoff.yielding()));
+}
@@ -3,8 +3,13 @@
 
 #include <CORE/BASE/appstats.h>
 
+#include <string>
+#include <thread>
+#include <vector>
+
 using core::AppInfo;
 using core::AppStat;
+using core::AppStatSnapshot;
 
 REGISTER_TEST_CASE(testAppstatGetSetReset) {
   AppStat myStat("teststat");
@@ -13,6 +18,8 @@ REGISTER_TEST_CASE(testAppstatGetSetReset) {
   TEST(testing::assertEquals(myStat.get(), 1));
   myStat.increment(19);
   TEST(testing::assertEquals(myStat.get(), 20));
+  myStat.decrement();
+  TEST(testing::assertEquals(myStat.get(), 19));
   myStat.reset();
   TEST(testing::assertEquals(myStat.get(), 0));
 }
@@ -49,3 +56,61 @@ REGISTER_TEST_CASE(testAppinfoGetSetResetGlobal) {
   myInfo.reset();
   TEST(testing::assertEquals(myInfoRef.get(), ""));
 }
+
+REGISTER_TEST_CASE(testAppstat64Bit) {
+  AppStat myStat("teststat_wide");
+  myStat.increment(0xFFFFFFFFull);
+  myStat.increment();
+  TEST(testing::assertEquals(myStat.get(), 0x100000000ull));
+  myStat.reset();
+  TEST(testing::assertEquals(myStat.get(), 0ull));
+}
+
+REGISTER_TEST_CASE(testAppstatSharded) {
+  AppStat myStat("teststat_sharded", core::eAppStatMode::SHARDED);
+  AppStat myStatRef("teststat_sharded");
+
+  std::vector< std::thread > threads;
+  for (u32 i = 0; i < 4; ++i) {
+    threads.push_back(std::thread([]() {
+      AppStat stat("teststat_sharded");
+      for (u32 n = 0; n < 1000; ++n) {
+        stat.increment();
+      }
+      stat.decrement();
+    }));
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+  TEST(testing::assertEquals(myStatRef.get(), 3996ull));
+
+  myStat.reset();
+  TEST(testing::assertEquals(myStatRef.get(), 0ull));
+  myStat.increment(5);
+  TEST(testing::assertEquals(myStatRef.get(), 5ull));
+}
+
+REGISTER_TEST_CASE(testAppstatSnapshotDelta) {
+  AppStat myStat("teststat_delta");
+  myStat.increment(10);
+  const AppStatSnapshot before = AppStatSnapshot::capture();
+  myStat.increment(7);
+  AppStat newStat("teststat_delta_new");
+  newStat.increment(3);
+  const AppStatSnapshot after = AppStatSnapshot::capture();
+
+  TEST(testing::assertTrue(after.secondsSince(before) >= 0.0));
+  u32 found = 0;
+  const core::tAppStatList deltas = after.delta(before);
+  for (size_t i = 0; i < deltas.size(); ++i) {
+    if (std::string(deltas[i].first) == "teststat_delta") {
+      TEST(testing::assertEquals(deltas[i].second, 7ull));
+      found++;
+    } else if (std::string(deltas[i].first) == "teststat_delta_new") {
+      TEST(testing::assertEquals(deltas[i].second, 3ull));
+      found++;
+    }
+  }
+  TEST(testing::assertEquals(found, 2u));
+}
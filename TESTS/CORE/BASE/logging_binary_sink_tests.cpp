@@ -0,0 +1,110 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/BASE/logging_binary_sink.h>
+#include <CORE/BASE/logging_default_sinks.h>
+
+#include <cstring>
+#include <sstream>
+#include <string>
+
+using core::logging::BinaryLogEntry;
+using core::logging::BinaryLogReader;
+using core::logging::iLogSink;
+using core::logging::LoggingBinarySink;
+using core::logging::LoggingStdioSink;
+using core::logging::LogMessage;
+using core::logging::TraceInfo;
+
+/**
+ * Build a message as the logger thread hands it to sinks.
+ */
+static LogMessage MakeMessage(
+    const LL::type level, const TraceInfo &trace, const char *pText) {
+  LogMessage message(level, trace);
+  message.append(pText, strlen(pText));
+  return message;
+}
+
+REGISTER_TEST_CASE(testBinaryLogRoundTrip) {
+  std::ostringstream *pStream = new std::ostringstream();
+  std::shared_ptr< iLogSink > pSink = std::make_shared< LoggingBinarySink >(
+      ~core::types::BitSet< LL >(),
+      std::unique_ptr< std::ostream >(pStream));
+
+  TraceInfo first("first.cpp", "first", 10);
+  TraceInfo second("second.cpp", "second", 20);
+  second.m_timestamp = first.m_timestamp + std::chrono::milliseconds(1500);
+  TEST(testing::assertTrue(
+      pSink->log(MakeMessage(LL::Info, first, "one"))));
+  TEST(testing::assertTrue(
+      pSink->log(MakeMessage(LL::Error, second, "two"))));
+  TEST(testing::assertTrue(
+      pSink->log(MakeMessage(LL::Trace, first, "three"))));
+  TEST(testing::assertTrue(pSink->flush()));
+
+  const std::string content = pStream->str();
+  const core::memory::ConstBlob contentBlob(content);
+  core::base::ConstBlobSink source(contentBlob);
+  BinaryLogReader reader(source);
+  BinaryLogEntry entry;
+
+  TEST(testing::assertTrue(reader.next(entry)));
+  TEST(testing::assertEquals(entry.m_logLevel, LL::Info));
+  TEST(testing::assertEquals(entry.m_file, std::string("first.cpp")));
+  TEST(testing::assertEquals(entry.m_function, std::string("first")));
+  TEST(testing::assertEquals(entry.m_line, 10l));
+  TEST(testing::assertEquals(entry.m_stackPtr, first.m_stackPtr));
+  TEST(testing::assertEquals(entry.m_msg, std::string("one")));
+  TEST(testing::assertTrue(
+      std::chrono::duration_cast< std::chrono::nanoseconds >(
+          entry.m_timestamp - first.m_timestamp)
+          .count()
+      == 0));
+  const std::string thread = entry.m_thread;
+  TEST(testing::assertFalse(thread.empty()));
+
+  TEST(testing::assertTrue(reader.next(entry)));
+  TEST(testing::assertEquals(entry.m_logLevel, LL::Error));
+  TEST(testing::assertEquals(entry.m_file, std::string("second.cpp")));
+  TEST(testing::assertEquals(entry.m_msg, std::string("two")));
+  TEST(testing::assertTrue(
+      entry.m_timestamp - first.m_timestamp
+      == std::chrono::milliseconds(1500)));
+
+  // Call sites seen before are referred to by id.
+  TEST(testing::assertTrue(reader.next(entry)));
+  TEST(testing::assertEquals(entry.m_file, std::string("first.cpp")));
+  TEST(testing::assertEquals(entry.m_thread, thread));
+  TEST(testing::assertEquals(entry.m_msg, std::string("three")));
+
+  Status end = reader.next(entry);
+  TEST(testing::assertEquals(end.getStatus(), Status::NOT_FOUND));
+}
+
+REGISTER_TEST_CASE(testBinaryLogBadInput) {
+  const std::string content = "not a binary log";
+  const core::memory::ConstBlob contentBlob(content);
+  core::base::ConstBlobSink source(contentBlob);
+  BinaryLogReader reader(source);
+  BinaryLogEntry entry;
+  Status ret = reader.next(entry);
+  TEST(testing::assertEquals(ret.getStatus(), Status::BAD_INPUT));
+}
+
+REGISTER_TEST_CASE(testWriteLogLineVerbose) {
+  TraceInfo trace("file.cpp", "function", 42);
+  trace.m_stackPtr = 1234;
+  std::ostringstream out;
+  core::logging::WriteLogLine(
+      out,
+      LoggingStdioSink::Options::FORMAT_VERBOSE,
+      LL::Warning,
+      trace,
+      "77",
+      "3s",
+      "message\n");
+  TEST(testing::assertEquals(
+      out.str(),
+      std::string("(file.cpp@function:42) | 77+1234 | 3s | W: message\n")));
+}
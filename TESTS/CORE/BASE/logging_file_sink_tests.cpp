@@ -0,0 +1,130 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/BASE/appstats.h>
+#include <CORE/BASE/logging_file_sink.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using core::AppStat;
+using core::logging::iLogSink;
+using core::logging::LoggingFileSink;
+using core::logging::LoggingStdioSink;
+using core::logging::LogMessage;
+using core::logging::TraceInfo;
+
+/**
+ *
+ */
+static LogMessage MakeMessage(const char *pText) {
+  LogMessage message(LL::Info, TraceInfo("file.cpp", "function", 1));
+  message.append(pText, strlen(pText));
+  return message;
+}
+
+/**
+ * @return the content of {@code path}, or "missing" if there is no such file
+ */
+static std::string ReadFile(const std::string &path) {
+  std::ifstream file(path.c_str(), std::ios_base::in | std::ios_base::binary);
+  if (!file) {
+    return "missing";
+  }
+  std::ostringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+/**
+ * Options writing bare messages to a test file, removing what an earlier run
+ * left behind.
+ */
+static LoggingFileSink::Options TestOptions(const std::string &path) {
+  std::remove(path.c_str());
+  for (u32 i = 1; i <= 3; ++i) {
+    std::remove((path + "." + std::to_string(i)).c_str());
+  }
+  LoggingFileSink::Options options;
+  options.m_path = path;
+  options.m_format = LoggingStdioSink::Options::FORMAT_TINY;
+  return options;
+}
+
+REGISTER_TEST_CASE(testFileSinkWritesLines) {
+  const std::string path = "logging_file_sink_test.log";
+  LoggingFileSink::Options options = TestOptions(path);
+  options.m_fsync = true;
+  {
+    LoggingFileSink fileSink(~core::types::BitSet< LL >(), options);
+    iLogSink &sink = fileSink;
+    TEST(testing::assertTrue(fileSink.isOpen()));
+    TEST(testing::assertTrue(sink.log(MakeMessage("one"))));
+    TEST(testing::assertTrue(sink.log(MakeMessage("two\n"))));
+    TEST(testing::assertTrue(sink.flush()));
+    TEST(testing::assertEquals(ReadFile(path), std::string("one\ntwo\n")));
+
+    // Lines left in the buffer are written when the sink is destroyed.
+    TEST(testing::assertTrue(sink.log(MakeMessage("three"))));
+  }
+  TEST(testing::assertEquals(
+      ReadFile(path), std::string("one\ntwo\nthree\n")));
+  std::remove(path.c_str());
+}
+
+REGISTER_TEST_CASE(testFileSinkRotates) {
+  const std::string path = "logging_file_sink_rotate_test.log";
+  LoggingFileSink::Options options = TestOptions(path);
+  options.m_blockSize = 1;
+  options.m_maxFileSize = 10;
+  options.m_maxFiles = 2;
+  {
+    LoggingFileSink fileSink(~core::types::BitSet< LL >(), options);
+    iLogSink &sink = fileSink;
+    const char *lines[] = {"line0", "line1", "line2", "line3",
+                           "line4", "line5", "line6"};
+    for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); ++i) {
+      TEST(testing::assertTrue(sink.log(MakeMessage(lines[i]))));
+      TEST(testing::assertTrue(sink.flush()));
+    }
+  }
+  TEST(testing::assertEquals(ReadFile(path), std::string("line6\n")));
+  TEST(testing::assertEquals(
+      ReadFile(path + ".1"), std::string("line4\nline5\n")));
+  TEST(testing::assertEquals(
+      ReadFile(path + ".2"), std::string("line2\nline3\n")));
+  TEST(testing::assertEquals(ReadFile(path + ".3"), std::string("missing")));
+  TestOptions(path);
+}
+
+REGISTER_TEST_CASE(testFileSinkDropsWhenFull) {
+  const std::string path = "logging_file_sink_drop_test.log";
+  LoggingFileSink::Options options = TestOptions(path);
+  options.m_maxBacklog = 10;
+  options.m_flushInterval = std::chrono::milliseconds(0);
+  AppStat dropped("log_file_dropped");
+  const u64 droppedBefore = dropped.get();
+  {
+    LoggingFileSink fileSink(~core::types::BitSet< LL >(), options);
+    iLogSink &sink = fileSink;
+
+    // Nothing is written until the flush, so the third message finds the
+    // backlog full.
+    TEST(testing::assertTrue(sink.log(MakeMessage("12345"))));
+    TEST(testing::assertTrue(sink.log(MakeMessage("12345"))));
+    TEST(testing::assertTrue(sink.log(MakeMessage("12345"))));
+    TEST(testing::assertEquals(fileSink.getDropped(), 1ull));
+    TEST(testing::assertEquals(dropped.get() - droppedBefore, 1ull));
+
+    TEST(testing::assertTrue(sink.flush()));
+    TEST(testing::assertTrue(sink.log(MakeMessage("after"))));
+    TEST(testing::assertTrue(sink.flush()));
+  }
+  TEST(testing::assertEquals(
+      ReadFile(path),
+      std::string("12345\n12345\n(1 log messages dropped)\nafter\n")));
+  std::remove(path.c_str());
+}
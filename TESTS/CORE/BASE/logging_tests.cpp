@@ -0,0 +1,199 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/BASE/logging.h>
+
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using core::logging::AppendToLog;
+using core::logging::iLogSink;
+using core::logging::IsLogEnabled;
+using core::logging::LogMessage;
+using core::logging::MAX_LOG_LEN;
+
+REGISTER_TEST_CASE(testAppendToLogTypes) {
+  LogMessage message;
+  const char *pName = "name";
+  AppendToLog(message, "x=");
+  AppendToLog(message, -42);
+  AppendToLog(message, ' ');
+  AppendToLog(message, (u64) 18446744073709551615ull);
+  AppendToLog(message, ' ');
+  AppendToLog(message, 1.5f);
+  AppendToLog(message, ' ');
+  AppendToLog(message, 0.1);
+  AppendToLog(message, ' ');
+  AppendToLog(message, true);
+  AppendToLog(message, ' ');
+  AppendToLog(message, std::string("str"));
+  AppendToLog(message, ' ');
+  AppendToLog(message, pName);
+
+  const std::string expected = "x=-42 18446744073709551615 1.5 0.1 1 str name";
+  TEST(testing::assertEquals(std::string(message.m_msg), expected));
+  TEST(testing::assertEquals(message.m_msgLen, expected.size()));
+}
+
+REGISTER_TEST_CASE(testAppendToLogPointers) {
+  LogMessage message;
+  int value = 0;
+  AppendToLog(message, &value);
+  TEST(testing::assertEquals(std::string(message.m_msg, 2), std::string("0x")));
+  TEST(testing::assertTrue(message.m_msgLen > 2));
+
+  LogMessage nullMessage;
+  AppendToLog(nullMessage, (const char *) nullptr);
+  TEST(testing::assertEquals(
+      std::string(nullMessage.m_msg), std::string("(null)")));
+}
+
+REGISTER_TEST_CASE(testAppendToLogTruncates) {
+  LogMessage message;
+  const std::string chunk(300, 'a');
+  for (u32 i = 0; i < 5; ++i) {
+    AppendToLog(message, chunk);
+  }
+  const std::string text(message.m_msg);
+  TEST(testing::assertEquals(text.size(), (size_t) MAX_LOG_LEN - 1));
+  TEST(testing::assertEquals(text.substr(text.size() - 3), std::string("...")));
+  TEST(testing::assertEquals(message.m_msgLen, text.size()));
+
+  // Nothing more is written once full.
+  AppendToLog(message, 7);
+  TEST(testing::assertEquals(std::string(message.m_msg), text));
+}
+
+static int s_evaluated = 0;
+
+/**
+ * Counts if the arguments of a Log() statement are evaluated.
+ */
+static int EvaluateLogArgument() {
+  return ++s_evaluated;
+}
+
+REGISTER_TEST_CASE(testMinLogLevelFlag) {
+  TEST(testing::assertTrue(IsLogEnabled(LL::Error)));
+  TEST(testing::assertEquals(
+      IsLogEnabled(LL::Trace), FISHY_LOG_MIN_LEVEL == LL::Trace));
+
+  TEST(testing::assertTrue(
+      core::logging::g_minLogLevel.fromString("Warning")));
+  TEST(testing::assertFalse(IsLogEnabled(LL::Trace)));
+  TEST(testing::assertFalse(IsLogEnabled(LL::Info)));
+  TEST(testing::assertTrue(IsLogEnabled(LL::Warning)));
+  TEST(testing::assertTrue(IsLogEnabled(LL::Error)));
+  TEST(testing::assertTrue(core::logging::g_minLogLevel.fromString("Trace")));
+}
+
+REGISTER_TEST_CASE(testDisabledLogSkipsArguments) {
+  TEST(testing::assertTrue(core::logging::g_minLogLevel.fromString("Error")));
+  s_evaluated = 0;
+  Log(LL::Info) << "skipped " << EvaluateLogArgument();
+  TEST(testing::assertEquals(s_evaluated, 0));
+
+  TEST(testing::assertTrue(core::logging::g_minLogLevel.fromString("Trace")));
+  Log(LL::Info) << "evaluated " << EvaluateLogArgument();
+  TEST(testing::assertEquals(s_evaluated, 1));
+}
+
+/**
+ * Keeps the messages starting with "capture ".
+ */
+class CaptureSink : public iLogSink {
+  public:
+  CaptureSink()
+      : iLogSink(core::types::BitSet< LL >() | LL::Info | LL::Warning) {}
+
+  std::vector< LogMessage > takeMessages() {
+    std::lock_guard< std::mutex > lock(m_mutex);
+    std::vector< LogMessage > ret;
+    ret.swap(m_messages);
+    return ret;
+  }
+
+  protected:
+  Status write(const LogMessage &message) override {
+    if (strncmp(message.m_msg, "capture ", 8) == 0) {
+      std::lock_guard< std::mutex > lock(m_mutex);
+      m_messages.push_back(message);
+    }
+    return Status::ok();
+  }
+
+  private:
+  std::mutex m_mutex;
+  std::vector< LogMessage > m_messages;
+};
+
+/**
+ * Registered once, as sinks can not be removed.
+ */
+static std::shared_ptr< CaptureSink > GetCaptureSink() {
+  static std::shared_ptr< CaptureSink > s_pSink;
+  if (!s_pSink) {
+    s_pSink = std::make_shared< CaptureSink >();
+    CHECK(core::logging::RegisterSink(s_pSink));
+  }
+  return s_pSink;
+}
+
+REGISTER_TEST_CASE(testLogThreadBuffers) {
+  std::shared_ptr< CaptureSink > pSink = GetCaptureSink();
+  static const u32 THREAD_COUNT = 4;
+  static const u32 MESSAGE_COUNT = 2000;
+
+  std::vector< std::thread > threads;
+  for (u32 t = 0; t < THREAD_COUNT; ++t) {
+    threads.push_back(std::thread([t]() {
+      for (u32 i = 0; i < MESSAGE_COUNT; ++i) {
+        Log(LL::Info) << "capture " << t << " " << i;
+      }
+    }));
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+  core::logging::FlushLogger();
+
+  // Every message arrives, in order for each thread.
+  const std::vector< LogMessage > messages = pSink->takeMessages();
+  TEST(testing::assertEquals(
+      messages.size(), (size_t) (THREAD_COUNT * MESSAGE_COUNT)));
+  std::vector< u32 > next(THREAD_COUNT, 0);
+  bool inOrder = true;
+  for (size_t i = 0; i < messages.size(); ++i) {
+    u32 t = 0;
+    u32 n = 0;
+    sscanf(messages[i].m_msg, "capture %u %u", &t, &n);
+    inOrder = inOrder && t < THREAD_COUNT && n == next[t]
+              && messages[i].m_msgLen == strlen(messages[i].m_msg);
+    next[t] = n + 1;
+  }
+  TEST(testing::assertTrue(inOrder));
+}
+
+REGISTER_TEST_CASE(testLogRecordFields) {
+  std::shared_ptr< CaptureSink > pSink = GetCaptureSink();
+  const std::string text(2000, 'x');
+  const long line = __LINE__ + 1;
+  Log(LL::Warning) << "capture " << text;
+  core::logging::FlushLogger();
+
+  const std::vector< LogMessage > messages = pSink->takeMessages();
+  TEST(testing::assertEquals(messages.size(), (size_t) 1));
+  const LogMessage &message = messages[0];
+  TEST(testing::assertEquals(message.m_logLevel, LL::Warning));
+  TEST(testing::assertEquals(message.m_trace.m_line, line));
+  TEST(testing::assertEquals(
+      std::string(message.m_trace.m_file), std::string(__FILE__)));
+  TEST(testing::assertTrue(
+      message.m_trace.m_threadId == std::this_thread::get_id()));
+  TEST(testing::assertEquals(message.m_msgLen, (size_t) MAX_LOG_LEN - 1));
+  TEST(testing::assertEquals(
+      std::string(message.m_msg + message.m_msgLen - 3), std::string("...")));
+}
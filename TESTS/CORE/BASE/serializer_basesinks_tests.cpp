@@ -6,6 +6,7 @@
 using core::base::BlobSink;
 using core::base::ConstBlobSink;
 using core::base::RangeSink;
+using core::base::VectorSink;
 using core::memory::Blob;
 using core::memory::ConstBlob;
 
@@ -72,3 +73,15 @@ REGISTER_TEST_CASE(testRangeSink) {
   TEST(testing::assertEquals(source.avail(), 0));
   TEST(testing::assertEquals(memcmp(actual, expected.data(), 4), 0));
 }
+
+REGISTER_TEST_CASE(testVectorSink) {
+  std::vector< u8 > buffer;
+  VectorSink sink(buffer);
+  TEST(testing::assertEquals(sink.write(ConstBlob(std::string("hello"))), 5));
+  sink.seek(2);
+  TEST(testing::assertEquals(sink.write(ConstBlob(std::string("world"))), 5));
+  TEST(testing::assertFalse(sink.fail()));
+  TEST(testing::assertEquals(buffer.size(), (size_t) 12));
+  TEST(testing::assertEquals(memcmp(buffer.data(), "hello", 5), 0));
+  TEST(testing::assertEquals(memcmp(buffer.data() + 7, "world", 5), 0));
+}
@@ -0,0 +1,74 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/MEMORY/arena.h>
+#include <CORE/types.h>
+
+#include <vector>
+
+using core::memory::Arena;
+using core::memory::ArenaAllocator;
+
+REGISTER_TEST_CASE(testArenaAlignedAlloc) {
+  Arena arena(256);
+  for (size_t alignment = 1; alignment <= 64; alignment <<= 1) {
+    arena.alloc(1, 1);
+    void *pPtr = arena.alloc(24, alignment);
+    TEST(testing::assertEquals(
+        (size_t) ((intptr_t) pPtr & (alignment - 1)), (size_t) 0));
+  }
+
+  // Larger than a chunk, so it gets a chunk of its own.
+  u8 *pBig = arena.allocArray< u8 >(1000);
+  pBig[999] = 1;
+  TEST(testing::assertTrue(arena.bytesReserved() >= 1256));
+}
+
+REGISTER_TEST_CASE(testArenaResetReusesChunks) {
+  Arena arena(128);
+  for (int i = 0; i < 100; ++i) {
+    arena.alloc(32);
+  }
+  const size_t reserved = arena.bytesReserved();
+  TEST(testing::assertTrue(arena.bytesUsed() >= 100 * 32));
+
+  arena.reset();
+  TEST(testing::assertEquals(arena.bytesUsed(), (size_t) 0));
+  for (int i = 0; i < 100; ++i) {
+    arena.alloc(32);
+  }
+  TEST(testing::assertEquals(arena.bytesReserved(), reserved));
+}
+
+REGISTER_TEST_CASE(testArenaMarkerRewind) {
+  Arena arena(64);
+  int *pKept = arena.make< int >(7);
+  const Arena::Marker marker = arena.mark();
+  const size_t used = arena.bytesUsed();
+
+  for (int i = 0; i < 20; ++i) {
+    arena.make< u64 >((u64) i);
+  }
+  TEST(testing::assertTrue(arena.bytesUsed() > used));
+
+  arena.rewind(marker);
+  TEST(testing::assertEquals(arena.bytesUsed(), used));
+  TEST(testing::assertEquals(*pKept, 7));
+  // The next allocation lands where the rewound ones started.
+  int *pNext = arena.make< int >(8);
+  TEST(testing::assertTrue(pNext == pKept + 1));
+}
+
+REGISTER_TEST_CASE(testArenaAllocator) {
+  Arena arena(1024);
+  typedef std::vector< int, ArenaAllocator< int > > tArenaVector;
+  tArenaVector values((ArenaAllocator< int >(arena)));
+  for (int i = 0; i < 500; ++i) {
+    values.push_back(i);
+  }
+  TEST(testing::assertEquals(values[499], 499));
+  TEST(testing::assertTrue(arena.bytesUsed() >= 500 * sizeof(int)));
+
+  ArenaAllocator< u64 > other(values.get_allocator());
+  TEST(testing::assertTrue(other == values.get_allocator()));
+}
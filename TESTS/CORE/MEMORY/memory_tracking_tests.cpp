@@ -0,0 +1,136 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/ARCH/atomics.h>
+#include <CORE/BASE/appstats.h>
+#include <CORE/MEMORY/memory_tracking.h>
+
+#include <thread>
+#include <vector>
+
+using core::memory::eMemoryTag;
+using core::memory::getMemoryTagStats;
+using core::memory::MemoryTagStats;
+using core::memory::ScopedMemoryTag;
+
+REGISTER_TEST_CASE(testTaggedAllocFree) {
+  const MemoryTagStats before = getMemoryTagStats(eMemoryTag::PARSER);
+
+  void *pSmall = core::memory::allocAlignedTagged(100, 8, eMemoryTag::PARSER);
+  void *pLarge = core::memory::allocAlignedTagged(300, 64, eMemoryTag::PARSER);
+  TEST(testing::assertEquals(((intptr_t) pLarge) & 63, 0));
+
+  MemoryTagStats stats = getMemoryTagStats(eMemoryTag::PARSER);
+  TEST(testing::assertEquals(stats.m_allocs - before.m_allocs, 2));
+  TEST(testing::assertEquals(stats.m_liveBytes - before.m_liveBytes, 400));
+  TEST(testing::assertTrue(stats.m_peakBytes >= stats.m_liveBytes));
+
+  core::memory::freeAlignedTagged(pSmall);
+  core::memory::freeAlignedTagged(pLarge);
+  stats = getMemoryTagStats(eMemoryTag::PARSER);
+  TEST(testing::assertEquals(stats.m_frees - before.m_frees, 2));
+  TEST(testing::assertEquals(stats.m_liveBytes, before.m_liveBytes));
+  TEST(testing::assertTrue(stats.m_peakBytes >= before.m_liveBytes + 400));
+}
+
+REGISTER_TEST_CASE(testScopedMemoryTag) {
+  TEST(testing::assertEquals(
+      core::memory::getMemoryTag(), eMemoryTag::UNTAGGED));
+  {
+    ScopedMemoryTag outer(eMemoryTag::NET);
+    TEST(testing::assertEquals(core::memory::getMemoryTag(), eMemoryTag::NET));
+    {
+      ScopedMemoryTag inner(eMemoryTag::PROTO);
+      TEST(testing::assertEquals(
+          core::memory::getMemoryTag(), eMemoryTag::PROTO));
+    }
+    TEST(testing::assertEquals(core::memory::getMemoryTag(), eMemoryTag::NET));
+  }
+  TEST(testing::assertEquals(
+      core::memory::getMemoryTag(), eMemoryTag::UNTAGGED));
+}
+
+REGISTER_TEST_CASE(testCrossThreadFree) {
+  const MemoryTagStats before = getMemoryTagStats(eMemoryTag::PARSER);
+
+  void *pPtr = NULL;
+  std::thread allocator([&pPtr]() {
+    pPtr = core::memory::allocAlignedTagged(64, 16, eMemoryTag::PARSER);
+  });
+  allocator.join();
+  TEST(testing::assertEquals(
+      getMemoryTagStats(eMemoryTag::PARSER).m_liveBytes - before.m_liveBytes,
+      64));
+
+  core::memory::freeAlignedTagged(pPtr);
+  TEST(testing::assertEquals(
+      getMemoryTagStats(eMemoryTag::PARSER).m_liveBytes, before.m_liveBytes));
+}
+
+#if MEMORY_TRACKING_HOOKS
+REGISTER_TEST_CASE(testTrackGlobalNew) {
+  // Allocated before tracking, so its delete must not be counted.
+  std::vector< int > *pUntracked = NULL;
+  {
+    ScopedMemoryTag tag(eMemoryTag::PARSER);
+    pUntracked = new std::vector< int >(16);
+  }
+
+  core::memory::g_trackAllocations.fromString("true");
+  const MemoryTagStats before = getMemoryTagStats(eMemoryTag::PARSER);
+  std::vector< int > *pTracked = NULL;
+  {
+    ScopedMemoryTag tag(eMemoryTag::PARSER);
+    pTracked = new std::vector< int >(256);
+  }
+  MemoryTagStats stats = getMemoryTagStats(eMemoryTag::PARSER);
+  TEST(testing::assertEquals(stats.m_allocs - before.m_allocs, 2));
+  TEST(testing::assertEquals(
+      stats.m_liveBytes - before.m_liveBytes,
+      (s64) (sizeof(std::vector< int >) + 256 * sizeof(int))));
+
+  // Counted against the tag it was allocated with, not the current one.
+  delete pTracked;
+  delete pUntracked;
+  stats = getMemoryTagStats(eMemoryTag::PARSER);
+  TEST(testing::assertEquals(stats.m_frees - before.m_frees, 2));
+  TEST(testing::assertEquals(stats.m_liveBytes, before.m_liveBytes));
+  core::memory::g_trackAllocations.fromString("false");
+}
+
+REGISTER_TEST_CASE(testTrackAlignedNew) {
+  typedef core::arch::CacheAligned< u64 > AlignedValue;
+  core::memory::g_trackAllocations.fromString("true");
+  const MemoryTagStats before = getMemoryTagStats(eMemoryTag::PARSER);
+  AlignedValue *pValue = NULL;
+  AlignedValue *pValues = NULL;
+  {
+    ScopedMemoryTag tag(eMemoryTag::PARSER);
+    pValue = new AlignedValue();
+    pValues = new AlignedValue[4];
+  }
+  TEST(testing::assertEquals(
+      ((intptr_t) pValue) & (alignof(AlignedValue) - 1), 0));
+  TEST(testing::assertEquals(
+      ((intptr_t) pValues) & (alignof(AlignedValue) - 1), 0));
+  MemoryTagStats stats = getMemoryTagStats(eMemoryTag::PARSER);
+  TEST(testing::assertEquals(stats.m_allocs - before.m_allocs, 2));
+  TEST(testing::assertTrue(
+      stats.m_liveBytes - before.m_liveBytes
+      >= (s64) (5 * sizeof(AlignedValue))));
+
+  delete pValue;
+  delete[] pValues;
+  stats = getMemoryTagStats(eMemoryTag::PARSER);
+  TEST(testing::assertEquals(stats.m_frees - before.m_frees, 2));
+  TEST(testing::assertEquals(stats.m_liveBytes, before.m_liveBytes));
+  core::memory::g_trackAllocations.fromString("false");
+}
+#endif
+
+REGISTER_TEST_CASE(testPublishMemoryStats) {
+  core::memory::publishMemoryStats();
+  const std::string info = core::AppInfo("memory_parser").get();
+  TEST(testing::assertTrue(info.find("live=") == 0));
+  TEST(testing::assertTrue(info.find("allocs=") != std::string::npos));
+}
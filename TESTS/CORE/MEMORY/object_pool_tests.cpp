@@ -0,0 +1,128 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/BASE/appstats.h>
+#include <CORE/MEMORY/object_pool.h>
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+using core::AppStat;
+using core::memory::ObjectPool;
+using core::memory::ObjectPoolStats;
+
+/**
+ * Counts live instances, to check construction and destruction.
+ */
+struct PooledObject {
+  PooledObject() : m_value(0) { s_live++; }
+  PooledObject(const int value) : m_value(value) { s_live++; }
+  ~PooledObject() { s_live--; }
+
+  int m_value;
+  static int s_live;
+};
+
+int PooledObject::s_live = 0;
+
+REGISTER_TEST_CASE(testObjectPoolMakeRelease) {
+  ObjectPool< PooledObject > pool("test_pool", 16, true);
+  std::vector< PooledObject * > objects;
+  std::set< PooledObject * > unique;
+  for (int i = 0; i < 40; ++i) {
+    objects.push_back(pool.make(i));
+    unique.insert(objects.back());
+  }
+  TEST(testing::assertEquals(unique.size(), (size_t) 40));
+  TEST(testing::assertEquals(PooledObject::s_live, 40));
+  TEST(testing::assertEquals(objects[39]->m_value, 39));
+
+  ObjectPoolStats stats = pool.stats();
+  TEST(testing::assertEquals(stats.m_live, (u64) 40));
+  TEST(testing::assertEquals(stats.m_highWater, (u64) 40));
+  TEST(testing::assertEquals(stats.m_slabs, (u32) 3));
+  TEST(testing::assertEquals(AppStat("test_pool_slabs").get(), (u32) 3));
+  TEST(testing::assertEquals(AppStat("test_pool_live").get(), (u32) 40));
+
+  for (size_t i = 0; i < objects.size(); ++i) {
+    pool.release(objects[i]);
+  }
+  TEST(testing::assertEquals(PooledObject::s_live, 0));
+
+  // Freed slots are reused before any new slab.
+  for (int i = 0; i < 40; ++i) {
+    objects[i] = pool.make();
+  }
+  stats = pool.stats();
+  TEST(testing::assertEquals(stats.m_slabs, (u32) 3));
+  TEST(testing::assertEquals(stats.m_highWater, (u64) 40));
+  for (size_t i = 0; i < objects.size(); ++i) {
+    pool.release(objects[i]);
+  }
+  TEST(testing::assertEquals(pool.stats().m_live, (u64) 0));
+  TEST(testing::assertEquals(AppStat("test_pool_live").get(), (u32) 0));
+}
+
+REGISTER_TEST_CASE(testObjectPoolCrossThreadRelease) {
+  static const int COUNT = 10000;
+  ObjectPool< u64 > pool(NULL, 64, true);
+  std::vector< u64 * > objects(COUNT);
+
+  // Allocated on one thread, released on another.
+  std::thread producer([&]() {
+    for (int i = 0; i < COUNT; ++i) {
+      objects[i] = pool.make((u64) i);
+    }
+  });
+  producer.join();
+  std::thread consumer([&]() {
+    for (int i = 0; i < COUNT; ++i) {
+      pool.release(objects[i]);
+    }
+  });
+  consumer.join();
+  TEST(testing::assertEquals(pool.stats().m_live, (u64) 0));
+
+  // The exited threads returned their cached slots, so no slab is added.
+  const u32 slabs = pool.stats().m_slabs;
+  for (int i = 0; i < COUNT; ++i) {
+    objects[i] = pool.make((u64) i);
+  }
+  TEST(testing::assertEquals(pool.stats().m_slabs, slabs));
+  for (int i = 0; i < COUNT; ++i) {
+    pool.release(objects[i]);
+  }
+}
+
+REGISTER_TEST_CASE(testObjectPoolConcurrent) {
+  static const int THREADS = 4;
+  static const int ROUNDS = 2000;
+  ObjectPool< PooledObject > pool(NULL, 32, true);
+  std::atomic_bool valid(true);
+
+  std::vector< std::thread > threads;
+  for (int t = 0; t < THREADS; ++t) {
+    threads.push_back(std::thread([&pool, &valid, t]() {
+      PooledObject *objects[8];
+      for (int round = 0; round < ROUNDS; ++round) {
+        for (int i = 0; i < 8; ++i) {
+          objects[i] = pool.make(t * 100 + i);
+        }
+        for (int i = 0; i < 8; ++i) {
+          if (objects[i]->m_value != t * 100 + i) {
+            valid = false;
+          }
+          pool.release(objects[i]);
+        }
+      }
+    }));
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+  TEST(testing::assertTrue(valid.load()));
+  TEST(testing::assertEquals(pool.stats().m_live, (u64) 0));
+  TEST(testing::assertTrue(pool.stats().m_highWater <= (u64) THREADS * 8));
+}
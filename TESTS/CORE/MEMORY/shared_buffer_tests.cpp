@@ -0,0 +1,100 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/MEMORY/shared_buffer.h>
+#include <CORE/types.h>
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <utility>
+
+using core::memory::Blob;
+using core::memory::ConstBlob;
+using core::memory::SharedBuffer;
+
+REGISTER_TEST_CASE(testSharedBufferCopyShares) {
+  SharedBuffer empty;
+  TEST(testing::assertTrue(empty.empty()));
+  TEST(testing::assertEquals(empty.useCount(), (u32) 0));
+
+  SharedBuffer buffer = SharedBuffer::copy(ConstBlob(std::string("hello")));
+  TEST(testing::assertEquals(buffer.size(), (size_t) 5));
+  TEST(testing::assertTrue(buffer.unique()));
+  {
+    SharedBuffer shared = buffer;
+    TEST(testing::assertEquals(buffer.useCount(), (u32) 2));
+    TEST(testing::assertTrue(shared.data() == buffer.data()));
+  }
+  TEST(testing::assertTrue(buffer.unique()));
+
+  SharedBuffer moved = std::move(buffer);
+  TEST(testing::assertTrue(buffer.empty()));
+  TEST(testing::assertTrue(moved.unique()));
+  const ConstBlob blob = moved;
+  TEST(testing::assertEquals(
+      std::string((const char *) blob.data(), blob.size()),
+      std::string("hello")));
+}
+
+REGISTER_TEST_CASE(testSharedBufferSlice) {
+  SharedBuffer buffer = SharedBuffer::allocate(10);
+  Blob writable = buffer.writable();
+  for (size_t i = 0; i < writable.size(); ++i) {
+    writable.data(i) = (u8) i;
+  }
+
+  SharedBuffer slice = buffer.slice(4, 3);
+  TEST(testing::assertEquals(slice.size(), (size_t) 3));
+  TEST(testing::assertEquals((int) slice.data()[0], 4));
+  TEST(testing::assertEquals(buffer.useCount(), (u32) 2));
+
+  // A slice keeps the storage alive without the parent.
+  buffer = SharedBuffer();
+  TEST(testing::assertTrue(slice.unique()));
+  TEST(testing::assertEquals((int) slice.data()[2], 6));
+
+  SharedBuffer nested = slice.slice(1, 100);
+  TEST(testing::assertEquals(nested.size(), (size_t) 2));
+  TEST(testing::assertEquals((int) nested.data()[0], 5));
+  TEST(testing::assertTrue(slice.slice(5, 1).empty()));
+}
+
+REGISTER_TEST_CASE(testSharedBufferSizes) {
+  // Pooled classes, and past the largest one.
+  const size_t sizes[] = {1, 64, 65, 1000, 70000};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+    SharedBuffer buffer = SharedBuffer::allocate(sizes[i]);
+    TEST(testing::assertEquals(buffer.size(), sizes[i]));
+    memset(buffer.writable().data(), 0xab, sizes[i]);
+    TEST(testing::assertEquals((int) buffer.data()[sizes[i] - 1], 0xab));
+  }
+  TEST(testing::assertTrue(SharedBuffer::allocate(0).empty()));
+}
+
+/**
+ * Holds a buffer until its thread exits, like a static holds one until the
+ * program exits.
+ */
+struct BufferHolder {
+  ~BufferHolder() {
+    m_buffer = SharedBuffer();
+    s_released = true;
+  }
+  SharedBuffer m_buffer;
+  static bool s_released;
+};
+bool BufferHolder::s_released = false;
+
+REGISTER_TEST_CASE(testSharedBufferReleasedAtThreadExit) {
+  std::thread thread([]() {
+    // Made before the thread's pool cache, so destroyed after it.
+    static thread_local BufferHolder s_holder;
+    s_holder.m_buffer = SharedBuffer::allocate(32);
+  });
+  thread.join();
+  TEST(testing::assertTrue(BufferHolder::s_released));
+
+  SharedBuffer buffer = SharedBuffer::allocate(32);
+  TEST(testing::assertEquals(buffer.size(), (size_t) 32));
+}
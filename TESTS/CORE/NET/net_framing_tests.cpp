@@ -0,0 +1,209 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/NET/net_framing.h>
+#include <CORE/NET/testing/mock_net_server.h>
+
+#if defined(PLAT_LINUX)
+#  include <arpa/inet.h>
+#  include <netinet/in.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+#endif
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using core::memory::Blob;
+using core::memory::ConstBlob;
+using core::net::eConnectionMode;
+using core::net::eFrameResult;
+using core::net::FrameBuffer;
+using core::net::FramedConnectionHandler;
+using core::net::iMessageHandler;
+using core::net::iNetServer;
+using core::net::NetServer;
+using core::net::ServerDef;
+using core::net::tConnectionId;
+using testing::core::net::MockNetServer;
+
+/**
+ * Frame {@code message} the same way {@link SendFramed} puts it on the wire.
+ */
+static std::string Frame(const std::string &message) {
+  MockNetServer server(eConnectionMode::TCP_ASYNC);
+  core::net::SendFramed(
+      server, 1, ConstBlob((const u8 *) message.data(), message.size()))
+      .ignoreErrors();
+  return server.getSent();
+}
+
+/**
+ * Collects every message delivered.
+ */
+class CollectingHandler : public iMessageHandler {
+  public:
+  virtual bool process(
+      iNetServer &, const tConnectionId, const ConstBlob &message) {
+    m_messages.push_back(
+        std::string((const char *) message.data(), message.size()));
+    return true;
+  }
+  virtual void open(const tConnectionId) {}
+  virtual void close(const tConnectionId) {}
+
+  std::vector< std::string > m_messages;
+};
+
+/**
+ * Sends every message straight back, framed.
+ */
+class EchoHandler : public CollectingHandler {
+  public:
+  virtual bool process(
+      iNetServer &server,
+      const tConnectionId connectionId,
+      const ConstBlob &message) {
+    CollectingHandler::process(server, connectionId, message);
+    return core::net::SendFramed(server, connectionId, message);
+  }
+};
+
+REGISTER_TEST_CASE(testFrameBufferSplitMessages) {
+  const std::string wire = Frame("hello") + Frame("") + Frame("world");
+  FrameBuffer buffer;
+  std::vector< std::string > messages;
+  for (size_t i = 0; i < wire.size(); ++i) {
+    buffer.receive(ConstBlob((const u8 *) &wire[i], 1));
+    ConstBlob message;
+    while (buffer.next(message) == eFrameResult::MESSAGE) {
+      messages.push_back(
+          std::string((const char *) message.data(), message.size()));
+    }
+  }
+  TEST(testing::assertEquals(messages.size(), (size_t) 3));
+  TEST(testing::assertEquals(messages[0], std::string("hello")));
+  TEST(testing::assertEquals(messages[1], std::string("")));
+  TEST(testing::assertEquals(messages[2], std::string("world")));
+  TEST(testing::assertEquals(buffer.size(), (size_t) 0));
+}
+
+REGISTER_TEST_CASE(testFrameBufferZeroCopy) {
+  const std::string wire = Frame("in place");
+  FrameBuffer buffer;
+  Blob space = buffer.writable();
+  TEST(testing::assertTrue(space.size() >= wire.size()));
+  memcpy(space.data(), wire.data(), wire.size());
+  buffer.receive(ConstBlob(space.data(), wire.size()));
+
+  ConstBlob message;
+  TEST(testing::assertEquals(buffer.next(message), eFrameResult::MESSAGE));
+  TEST(testing::assertTrue(message.data() > space.data()));
+  TEST(testing::assertTrue(
+      message.data() + message.size() <= space.data() + space.size()));
+  TEST(testing::assertEquals(
+      std::string((const char *) message.data(), message.size()),
+      std::string("in place")));
+}
+
+REGISTER_TEST_CASE(testFrameBufferLargeMessage) {
+  const std::string large(5 * core::net::MAX_PACKET_SIZE + 17, 'x');
+  const std::string wire = Frame("a") + Frame(large) + Frame("b");
+  FrameBuffer buffer;
+  std::vector< std::string > messages;
+  for (size_t offset = 0; offset < wire.size();) {
+    Blob space = buffer.writable();
+    const size_t sz = std::min(space.size(), wire.size() - offset);
+    memcpy(space.data(), wire.data() + offset, sz);
+    buffer.receive(ConstBlob(space.data(), sz));
+    offset += sz;
+
+    ConstBlob message;
+    while (buffer.next(message) == eFrameResult::MESSAGE) {
+      messages.push_back(
+          std::string((const char *) message.data(), message.size()));
+    }
+  }
+  TEST(testing::assertEquals(messages.size(), (size_t) 3));
+  TEST(testing::assertEquals(messages[0], std::string("a")));
+  TEST(testing::assertEquals(messages[1], large));
+  TEST(testing::assertEquals(messages[2], std::string("b")));
+}
+
+REGISTER_TEST_CASE(testFrameBufferMalformed) {
+  const std::string badHeader(core::net::MAX_FRAME_HEADER_SIZE, '\xFF');
+  FrameBuffer buffer;
+  buffer.receive(ConstBlob((const u8 *) badHeader.data(), badHeader.size()));
+  ConstBlob message;
+  TEST(testing::assertEquals(buffer.next(message), eFrameResult::MALFORMED));
+
+  const std::string wire = Frame("too long");
+  FrameBuffer limited(4);
+  limited.receive(ConstBlob((const u8 *) wire.data(), wire.size()));
+  TEST(testing::assertEquals(limited.next(message), eFrameResult::MALFORMED));
+}
+
+REGISTER_TEST_CASE(testFramedConnectionHandler) {
+  CollectingHandler messages;
+  FramedConnectionHandler handler(messages);
+  MockNetServer server(eConnectionMode::TCP_ASYNC);
+  server.simulateConnect(7);
+
+  const std::string wire = Frame("one") + Frame("two");
+  std::vector< std::string > chunks;
+  chunks.push_back(wire.substr(0, 2));
+  chunks.push_back(wire.substr(2));
+  server.simulateRecieve(7, chunks);
+
+  TEST(testing::assertTrue(server.update(handler)));
+  TEST(testing::assertEquals(messages.m_messages.size(), (size_t) 0));
+  TEST(testing::assertTrue(server.update(handler)));
+  TEST(testing::assertEquals(messages.m_messages.size(), (size_t) 2));
+  TEST(testing::assertEquals(messages.m_messages[0], std::string("one")));
+  TEST(testing::assertEquals(messages.m_messages[1], std::string("two")));
+}
+
+#if defined(PLAT_LINUX)
+REGISTER_TEST_CASE(testFramedTcpEcho) {
+  static const int TEST_PORT = 27123;
+  core::net::Initialize();
+  NetServer server(eConnectionMode::TCP_ASYNC);
+  TEST(testing::assertTrue(server.start(
+      ServerDef(TEST_PORT, 4, 60, core::net::eEventBackend::EPOLL))));
+
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(TEST_PORT);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  TEST(testing::assertEquals(
+      connect(fd, (const sockaddr *) &addr, sizeof(addr)), 0));
+
+  const std::string large(3 * core::net::MAX_PACKET_SIZE, 'L');
+  const std::string wire = Frame("ping") + Frame(large);
+  TEST(testing::assertEquals(
+      send(fd, wire.data(), wire.size(), 0), (ssize_t) wire.size()));
+
+  EchoHandler messages;
+  FramedConnectionHandler handler(messages);
+  for (int i = 0; i < 200 && messages.m_messages.size() < 2; ++i) {
+    TEST(testing::assertTrue(server.update(handler)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  TEST(testing::assertEquals(messages.m_messages.size(), (size_t) 2));
+  TEST(testing::assertEquals(messages.m_messages[0], std::string("ping")));
+  TEST(testing::assertEquals(messages.m_messages[1], large));
+
+  std::string echo(wire.size(), '\0');
+  TEST(testing::assertEquals(
+      recv(fd, &echo[0], echo.size(), MSG_WAITALL), (ssize_t) wire.size()));
+  TEST(testing::assertEquals(echo, wire));
+
+  close(fd);
+  server.stop();
+}
+#endif
@@ -0,0 +1,216 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/NET/net_loopback.h>
+
+#include <string>
+#include <vector>
+
+using core::memory::ConstBlob;
+using core::net::ClientDef;
+using core::net::iClientConnectionHandler;
+using core::net::iNetClient;
+using core::net::iNetServer;
+using core::net::iServerConnectionHandler;
+using core::net::LoopbackNetClient;
+using core::net::LoopbackNetServer;
+using core::net::ServerDef;
+using core::net::tConnectionId;
+
+static const int TEST_PORT = 1;
+
+/**
+ * Echoes every message back to its sender.
+ */
+class EchoServerHandler : public iServerConnectionHandler {
+  public:
+  EchoServerHandler() : m_opened(0), m_closed(0), m_lastOpened(0) {}
+
+  virtual bool process(
+      iNetServer &server,
+      const tConnectionId connectionId,
+      const ConstBlob &data) {
+    m_messages.push_back(std::string((const char *) data.data(), data.size()));
+    return server.send(connectionId, data);
+  }
+  virtual void open(const tConnectionId connectionId) {
+    m_opened++;
+    m_lastOpened = connectionId;
+  }
+  virtual void close(const tConnectionId) { m_closed++; }
+  virtual void cleanup() {}
+
+  std::vector< std::string > m_messages;
+  int m_opened;
+  int m_closed;
+  tConnectionId m_lastOpened;
+};
+
+/**
+ * Collects every message received.
+ */
+class CollectingClientHandler : public iClientConnectionHandler {
+  public:
+  virtual void process(iNetClient &, const ConstBlob &data) {
+    m_messages.push_back(std::string((const char *) data.data(), data.size()));
+  }
+  virtual void cleanup() {}
+
+  std::vector< std::string > m_messages;
+};
+
+REGISTER_TEST_CASE(testLoopbackEcho) {
+  LoopbackNetServer server;
+  TEST(testing::assertTrue(server.start(ServerDef(TEST_PORT, 4, 60))));
+  LoopbackNetClient client;
+  TEST(testing::assertTrue(client.start(ClientDef("", TEST_PORT, 60))));
+
+  const std::string first = "hello";
+  const std::string second = "world";
+  ConstBlob parts[2] = {ConstBlob(first), ConstBlob(second)};
+  TEST(testing::assertTrue(client.send(ConstBlob(first))));
+  TEST(testing::assertTrue(client.send(parts, 2)));
+
+  EchoServerHandler serverHandler;
+  TEST(testing::assertTrue(server.update(serverHandler)));
+  TEST(testing::assertEquals(serverHandler.m_opened, 1));
+  TEST(testing::assertEquals(serverHandler.m_messages.size(), (size_t) 2));
+  TEST(testing::assertEquals(serverHandler.m_messages[0], first));
+  TEST(testing::assertEquals(
+      serverHandler.m_messages[1], std::string("helloworld")));
+
+  CollectingClientHandler clientHandler;
+  TEST(testing::assertTrue(client.update(clientHandler)));
+  TEST(testing::assertEquals(clientHandler.m_messages.size(), (size_t) 2));
+  TEST(testing::assertEquals(
+      clientHandler.m_messages[1], std::string("helloworld")));
+  TEST(testing::assertEquals(server.stats().m_bytesSent, (u64) 15));
+  TEST(testing::assertEquals(client.stats().m_bytesRecieved, (u64) 15));
+
+  client.stop();
+  TEST(testing::assertTrue(server.update(serverHandler)));
+  TEST(testing::assertEquals(serverHandler.m_closed, 1));
+  TEST(testing::assertEquals(server.stats().m_activeConnections, (u32) 0));
+  server.stop();
+}
+
+REGISTER_TEST_CASE(testLoopbackRingWraps) {
+  LoopbackNetServer server;
+  TEST(testing::assertTrue(server.start(ServerDef(TEST_PORT, 4, 60))));
+  LoopbackNetClient client;
+  TEST(testing::assertTrue(client.start(ClientDef("", TEST_PORT, 60))));
+  EchoServerHandler serverHandler;
+  CollectingClientHandler clientHandler;
+
+  // Odd sizes, so records land unevenly against the end of the ring.
+  size_t expectedBytes = 0;
+  for (size_t i = 0; i < 3 * core::net::LOOPBACK_RING_SIZE / 1000; ++i) {
+    const std::string message(1000 + i % 7, (char) ('a' + i % 26));
+    TEST(testing::assertTrue(client.send(ConstBlob(message))));
+    expectedBytes += message.size();
+    TEST(testing::assertTrue(server.update(serverHandler)));
+    TEST(testing::assertTrue(client.update(clientHandler)));
+    TEST(testing::assertEquals(clientHandler.m_messages.back(), message));
+  }
+  TEST(testing::assertEquals(
+      client.stats().m_bytesRecieved, (u64) expectedBytes));
+}
+
+REGISTER_TEST_CASE(testLoopbackBackpressure) {
+  LoopbackNetServer server;
+  TEST(testing::assertTrue(server.start(ServerDef(TEST_PORT, 4, 60))));
+  LoopbackNetClient client;
+  TEST(testing::assertTrue(client.start(ClientDef("", TEST_PORT, 60))));
+
+  // Two of the largest messages fill the ring.
+  const std::string message(core::net::LOOPBACK_MAX_MESSAGE_SIZE, 'x');
+  TEST(testing::assertTrue(client.send(ConstBlob(message))));
+  TEST(testing::assertTrue(client.send(ConstBlob(message))));
+  Status full = client.send(ConstBlob(message));
+  TEST(testing::assertEquals(full.getStatus(), Status::OUT_OF_BOUNDS));
+
+  const std::string tooLarge(core::net::LOOPBACK_MAX_MESSAGE_SIZE + 1, 'x');
+  Status large = client.send(ConstBlob(tooLarge));
+  TEST(testing::assertEquals(large.getStatus(), Status::OUT_OF_BOUNDS));
+
+  EchoServerHandler serverHandler;
+  TEST(testing::assertTrue(server.update(serverHandler)));
+  TEST(testing::assertTrue(client.send(ConstBlob(message))));
+}
+
+REGISTER_TEST_CASE(testLoopbackClientSendBatch) {
+  LoopbackNetServer server;
+  TEST(testing::assertTrue(server.start(ServerDef(TEST_PORT, 4, 60))));
+  LoopbackNetClient client;
+  TEST(testing::assertTrue(client.start(ClientDef("", TEST_PORT, 60))));
+
+  // Batches carry on past a failed message, and report the first error.
+  const std::string tooLarge(core::net::LOOPBACK_MAX_MESSAGE_SIZE + 1, 'x');
+  const ConstBlob batch[3] = {
+      ConstBlob((const u8 *) "a", 1),
+      ConstBlob(tooLarge),
+      ConstBlob((const u8 *) "b", 1)};
+  Status partial = client.sendBatch(batch, 3);
+  TEST(testing::assertEquals(partial.getStatus(), Status::OUT_OF_BOUNDS));
+
+  EchoServerHandler serverHandler;
+  CollectingClientHandler clientHandler;
+  TEST(testing::assertTrue(server.update(serverHandler)));
+  TEST(testing::assertTrue(client.update(clientHandler)));
+  TEST(testing::assertEquals(clientHandler.m_messages.size(), (size_t) 2));
+  TEST(testing::assertEquals(clientHandler.m_messages[0], std::string("a")));
+  TEST(testing::assertEquals(clientHandler.m_messages[1], std::string("b")));
+}
+
+REGISTER_TEST_CASE(testLoopbackServerStop) {
+  LoopbackNetClient client;
+  Status missing = client.start(ClientDef("", TEST_PORT, 60));
+  TEST(testing::assertEquals(missing.getStatus(), Status::NOT_FOUND));
+
+  LoopbackNetServer server;
+  TEST(testing::assertTrue(server.start(ServerDef(TEST_PORT, 4, 60))));
+  LoopbackNetServer duplicate;
+  TEST(testing::assertFalse(duplicate.start(ServerDef(TEST_PORT, 4, 60))));
+
+  TEST(testing::assertTrue(client.start(ClientDef("", TEST_PORT, 60))));
+  EchoServerHandler serverHandler;
+  TEST(testing::assertTrue(server.update(serverHandler)));
+  server.stop();
+
+  CollectingClientHandler clientHandler;
+  TEST(testing::assertTrue(client.update(clientHandler)));
+  TEST(testing::assertFalse(client.valid()));
+}
+
+REGISTER_TEST_CASE(testLoopbackStopClosesPending) {
+  LoopbackNetServer server;
+  TEST(testing::assertTrue(server.start(ServerDef(TEST_PORT, 4, 60))));
+  LoopbackNetClient client;
+  TEST(testing::assertTrue(client.start(ClientDef("", TEST_PORT, 60))));
+
+  // Stopped before the connection was ever accepted.
+  server.stop();
+  const std::string message = "hello";
+  Status sent = client.send(ConstBlob(message));
+  TEST(testing::assertEquals(sent.getStatus(), Status::CANCELED));
+  CollectingClientHandler clientHandler;
+  TEST(testing::assertTrue(client.update(clientHandler)));
+  TEST(testing::assertFalse(client.valid()));
+}
+
+REGISTER_TEST_CASE(testLoopbackSendToClosedClient) {
+  LoopbackNetServer server;
+  TEST(testing::assertTrue(server.start(ServerDef(TEST_PORT, 4, 60))));
+  LoopbackNetClient client;
+  TEST(testing::assertTrue(client.start(ClientDef("", TEST_PORT, 60))));
+  EchoServerHandler serverHandler;
+  TEST(testing::assertTrue(server.update(serverHandler)));
+  TEST(testing::assertEquals(serverHandler.m_opened, 1));
+
+  client.stop();
+  const std::string message = "hello";
+  Status sent =
+      server.send(serverHandler.m_lastOpened, ConstBlob(message));
+  TEST(testing::assertEquals(sent.getStatus(), Status::CANCELED));
+  server.stop();
+}
@@ -0,0 +1,218 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/NET/net_server_sharded.h>
+
+#if defined(PLAT_LINUX)
+#  include <arpa/inet.h>
+#  include <netinet/in.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using core::memory::ConstBlob;
+using core::net::eConnectionMode;
+using core::net::eEventBackend;
+using core::net::iNetServer;
+using core::net::iServerConnectionHandler;
+using core::net::ServerDef;
+using core::net::ShardedNetServer;
+using core::net::tConnectionId;
+
+/**
+ * Records opened connections from every shard thread, and echoes data back.
+ */
+class ShardedHandler : public iServerConnectionHandler {
+  public:
+  virtual bool process(
+      iNetServer &server,
+      const tConnectionId connectionId,
+      const ConstBlob &data) {
+    server.send(connectionId, data).ignoreErrors();
+    return true;
+  }
+
+  virtual void open(const tConnectionId connectionId) {
+    std::lock_guard< std::mutex > lock(m_mutex);
+    m_opened.push_back(connectionId);
+  }
+
+  virtual void close(const tConnectionId) {}
+  virtual void cleanup() {}
+
+  std::vector< tConnectionId > opened() {
+    std::lock_guard< std::mutex > lock(m_mutex);
+    return m_opened;
+  }
+
+  private:
+  std::mutex m_mutex;
+  std::vector< tConnectionId > m_opened;
+};
+
+/**
+ * Holds its shard thread in {@code process} until released, so sends queued
+ * for that shard pile up.
+ */
+class StallingHandler : public ShardedHandler {
+  public:
+  StallingHandler() : m_stalled(false), m_release(false) {}
+
+  virtual bool process(
+      iNetServer &, const tConnectionId, const ConstBlob &) {
+    m_stalled = true;
+    while (!m_release) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+  }
+
+  std::atomic< bool > m_stalled;
+  std::atomic< bool > m_release;
+};
+
+#if defined(PLAT_LINUX)
+static const int TEST_PORT = 27122;
+static const int CLIENT_COUNT = 8;
+
+/**
+ * Open a plain blocking TCP socket to the test server.
+ */
+static int ConnectTcp(const int port) {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (const sockaddr *) &addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+REGISTER_TEST_CASE(testShardedTcpRouting) {
+  core::net::Initialize();
+  ShardedNetServer server(eConnectionMode::TCP_ASYNC, 2);
+  TEST(testing::assertTrue(server.start(
+      ServerDef(TEST_PORT, CLIENT_COUNT, 60, eEventBackend::EPOLL))));
+  TEST(testing::assertEquals(server.getPort(), TEST_PORT));
+
+  ShardedHandler handler;
+  TEST(testing::assertTrue(server.update(handler)));
+
+  std::vector< int > fds;
+  for (int i = 0; i < CLIENT_COUNT; ++i) {
+    fds.push_back(ConnectTcp(TEST_PORT));
+    TEST(testing::assertTrue(fds.back() >= 0));
+  }
+
+  // Echo replies are sent from the owning shard thread.
+  for (size_t i = 0; i < fds.size(); ++i) {
+    char echo;
+    TEST(testing::assertEquals(send(fds[i], "e", 1, 0), 1));
+    TEST(testing::assertEquals(recv(fds[i], &echo, 1, MSG_WAITALL), 1));
+    TEST(testing::assertEquals(echo, 'e'));
+  }
+
+  const std::vector< tConnectionId > opened = handler.opened();
+  TEST(testing::assertEquals(opened.size(), (size_t) CLIENT_COUNT));
+  for (size_t i = 0; i < opened.size(); ++i) {
+    TEST(testing::assertTrue(core::net::GetConnectionShard(opened[i]) < 2));
+  }
+
+  // Sends from this thread are queued to the owning shard.
+  for (size_t i = 0; i < opened.size(); ++i) {
+    TEST(testing::assertTrue(
+        server.send(opened[i], ConstBlob((const u8 *) "q", 1))));
+  }
+  for (size_t i = 0; i < fds.size(); ++i) {
+    char queued;
+    TEST(testing::assertEquals(recv(fds[i], &queued, 1, MSG_WAITALL), 1));
+    TEST(testing::assertEquals(queued, 'q'));
+  }
+
+  TEST(testing::assertTrue(server.update(handler)));
+  TEST(testing::assertEquals(
+      server.stats().m_activeConnections, (u32) CLIENT_COUNT));
+
+  for (size_t i = 0; i < fds.size(); ++i) {
+    close(fds[i]);
+  }
+  server.stop();
+  TEST(testing::assertFalse(server.valid()));
+}
+REGISTER_TEST_CASE(testShardedQueuedSendWakesShard) {
+  core::net::Initialize();
+  ShardedNetServer server(eConnectionMode::TCP_BLOCKING, 1);
+  ServerDef def(TEST_PORT, CLIENT_COUNT, 60, eEventBackend::SELECT);
+  def.m_waitMs = 10000;
+  TEST(testing::assertTrue(server.start(def)));
+
+  ShardedHandler handler;
+  TEST(testing::assertTrue(server.update(handler)));
+
+  const int fd = ConnectTcp(TEST_PORT);
+  TEST(testing::assertTrue(fd >= 0));
+  while (handler.opened().empty()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // The shard is waiting on a quiet socket, so only the wake sends this.
+  const auto start = std::chrono::steady_clock::now();
+  TEST(testing::assertTrue(
+      server.send(handler.opened()[0], ConstBlob((const u8 *) "q", 1))));
+  char queued;
+  TEST(testing::assertEquals(recv(fd, &queued, 1, MSG_WAITALL), 1));
+  TEST(testing::assertEquals(queued, 'q'));
+  TEST(testing::assertTrue(
+      std::chrono::steady_clock::now() - start < std::chrono::seconds(1)));
+
+  close(fd);
+  server.stop();
+  TEST(testing::assertFalse(server.valid()));
+}
+
+REGISTER_TEST_CASE(testShardedQueueBounded) {
+  core::net::Initialize();
+  ShardedNetServer server(eConnectionMode::TCP_ASYNC, 1);
+  TEST(testing::assertTrue(server.start(
+      ServerDef(TEST_PORT, CLIENT_COUNT, 60, eEventBackend::EPOLL))));
+
+  StallingHandler handler;
+  TEST(testing::assertTrue(server.update(handler)));
+
+  const int fd = ConnectTcp(TEST_PORT);
+  TEST(testing::assertTrue(fd >= 0));
+  TEST(testing::assertEquals(send(fd, "s", 1, 0), 1));
+  while (!handler.m_stalled) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  const tConnectionId connectionId = handler.opened()[0];
+  const std::vector< u8 > chunk(64 * 1024, 'x');
+  bool bounded = false;
+  for (int i = 0; i < 128 && !bounded; ++i) {
+    Status status = server.send(
+        connectionId, ConstBlob(chunk.data(), chunk.size()));
+    bounded = status.getStatus() == Status::OUT_OF_BOUNDS;
+    if (!bounded) {
+      TEST(testing::assertTrue(status));
+    }
+  }
+  TEST(testing::assertTrue(bounded));
+
+  handler.m_release = true;
+  close(fd);
+  server.stop();
+  TEST(testing::assertFalse(server.valid()));
+}
+#endif
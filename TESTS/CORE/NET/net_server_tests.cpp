@@ -0,0 +1,414 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/NET/net_client.h>
+#include <CORE/NET/net_server.h>
+
+#if defined(PLAT_LINUX)
+#  include <arpa/inet.h>
+#  include <netinet/in.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using core::memory::ConstBlob;
+using core::net::ConnectionStats;
+using core::net::eCloseReason;
+using core::net::eConnectionMode;
+using core::net::eEventBackend;
+using core::net::iClientConnectionHandler;
+using core::net::iNetClient;
+using core::net::iNetServer;
+using core::net::iServerConnectionHandler;
+using core::net::NetClient;
+using core::net::NetServer;
+using core::net::ClientDef;
+using core::net::ServerDef;
+using core::net::tConnectionId;
+
+/**
+ * Records everything the server reports, and echoes data back.
+ */
+class RecordingHandler : public iServerConnectionHandler {
+  public:
+  RecordingHandler() : m_opened(0), m_closed(0) {}
+
+  virtual bool process(
+      iNetServer &server,
+      const tConnectionId connectionId,
+      const ConstBlob &data) {
+    m_recieved.append((const char *) data.data(), data.size());
+    server.send(connectionId, data).ignoreErrors();
+    return true;
+  }
+
+  virtual void open(const tConnectionId) { m_opened++; }
+  virtual void close(const tConnectionId) { m_closed++; }
+  virtual void cleanup() {}
+
+  int m_opened;
+  int m_closed;
+  std::string m_recieved;
+};
+
+/**
+ * Counts the bytes a client receives.
+ */
+class CountingClientHandler : public iClientConnectionHandler {
+  public:
+  CountingClientHandler() : m_recieved(0) {}
+
+  virtual void process(iNetClient &, const ConstBlob &data) {
+    m_recieved += data.size();
+  }
+
+  virtual void cleanup() {}
+
+  size_t m_recieved;
+};
+
+#if defined(PLAT_LINUX)
+static const int TEST_PORT = 27121;
+
+/**
+ * Open a plain blocking socket to the test server.
+ */
+static int ConnectRaw(const int type, const int port) {
+  const int fd = socket(AF_INET, type, 0);
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (const sockaddr *) &addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * Pump the server until {@code done} returns true, or give up.
+ */
+template < typename tPred >
+static bool
+UpdateUntil(NetServer &server, RecordingHandler &handler, tPred done) {
+  for (int i = 0; i < 200 && !done(); ++i) {
+    if (!server.update(handler)) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return done();
+}
+#endif
+
+#if defined(PLAT_LINUX)
+REGISTER_TEST_CASE(testEpollTcpEcho) {
+  core::net::Initialize();
+  NetServer server(eConnectionMode::TCP_ASYNC);
+  TEST(testing::assertTrue(
+      server.start(ServerDef(TEST_PORT, 4, 60, eEventBackend::EPOLL))));
+
+  RecordingHandler handler;
+  const int fd = ConnectRaw(SOCK_STREAM, TEST_PORT);
+  TEST(testing::assertTrue(fd >= 0));
+  TEST(testing::assertEquals(send(fd, "hello", 5, 0), 5));
+
+  TEST(testing::assertTrue(UpdateUntil(
+      server, handler, [&]() { return handler.m_recieved.size() == 5; })));
+  TEST(testing::assertEquals(handler.m_opened, 1));
+  TEST(testing::assertEquals(handler.m_recieved, std::string("hello")));
+
+  char echo[5];
+  TEST(testing::assertEquals(recv(fd, echo, 5, MSG_WAITALL), 5));
+  TEST(testing::assertEquals(std::string(echo, 5), std::string("hello")));
+
+  ConnectionStats connection;
+  TEST(testing::assertTrue(server.connectionStats(1, connection)));
+  TEST(testing::assertEquals(connection.m_bytesRecieved, (u64) 5));
+  TEST(testing::assertEquals(connection.m_bytesSent, (u64) 5));
+  TEST(testing::assertEquals(connection.m_packetsSent, (u64) 1));
+
+  close(fd);
+  TEST(testing::assertTrue(
+      UpdateUntil(server, handler, [&]() { return handler.m_closed == 1; })));
+  const core::net::NetStats stats = server.stats();
+  TEST(testing::assertEquals(stats.m_activeConnections, 0));
+  TEST(testing::assertEquals(stats.m_accepts, (u64) 1));
+  TEST(testing::assertEquals(stats.m_closes[eCloseReason::REMOTE], (u64) 1));
+  TEST(testing::assertEquals(stats.m_processTicks.count(), (u64) 1));
+  TEST(testing::assertTrue(stats.m_recvCalls >= 2));
+  TEST(testing::assertFalse(server.connectionStats(1, connection)));
+
+  server.stop();
+}
+
+REGISTER_TEST_CASE(testEpollUdpEcho) {
+  core::net::Initialize();
+  NetServer server(eConnectionMode::UDP_ASYNC);
+  TEST(testing::assertTrue(
+      server.start(ServerDef(TEST_PORT, 4, 60, eEventBackend::EPOLL))));
+
+  RecordingHandler handler;
+  const int fd = ConnectRaw(SOCK_DGRAM, TEST_PORT);
+  TEST(testing::assertTrue(fd >= 0));
+  TEST(testing::assertEquals(send(fd, "ping", 4, 0), 4));
+  TEST(testing::assertEquals(send(fd, "pong", 4, 0), 4));
+
+  TEST(testing::assertTrue(UpdateUntil(
+      server, handler, [&]() { return handler.m_recieved.size() == 8; })));
+  TEST(testing::assertEquals(handler.m_opened, 1));
+  TEST(testing::assertEquals(handler.m_recieved, std::string("pingpong")));
+
+  close(fd);
+  server.stop();
+}
+#endif
+
+#if defined(PLAT_LINUX)
+REGISTER_TEST_CASE(testUdpPeersKeyedByPort) {
+  core::net::Initialize();
+  NetServer server(eConnectionMode::UDP_ASYNC);
+  TEST(testing::assertTrue(server.start(ServerDef(TEST_PORT, 4, 60))));
+
+  RecordingHandler handler;
+  const int fdA = ConnectRaw(SOCK_DGRAM, TEST_PORT);
+  const int fdB = ConnectRaw(SOCK_DGRAM, TEST_PORT);
+  TEST(testing::assertTrue(fdA >= 0 && fdB >= 0));
+  TEST(testing::assertEquals(send(fdA, "a", 1, 0), 1));
+  TEST(testing::assertEquals(send(fdB, "b", 1, 0), 1));
+  TEST(testing::assertEquals(send(fdA, "c", 1, 0), 1));
+
+  TEST(testing::assertTrue(UpdateUntil(
+      server, handler, [&]() { return handler.m_recieved.size() == 3; })));
+  TEST(testing::assertEquals(handler.m_opened, 2));
+  TEST(testing::assertEquals(server.stats().m_activeConnections, 2));
+
+  close(fdA);
+  close(fdB);
+  server.stop();
+}
+#endif
+
+#if defined(PLAT_LINUX)
+/**
+ * Collects data recieved by a {@link NetClient}.
+ */
+class ClientRecorder : public core::net::iClientConnectionHandler {
+  public:
+  virtual void process(core::net::iNetClient &, const ConstBlob &data) {
+    m_packets.push_back(std::string((const char *) data.data(), data.size()));
+  }
+  virtual void cleanup() {}
+
+  std::vector< std::string > m_packets;
+};
+
+REGISTER_TEST_CASE(testUdpSendBatch) {
+  core::net::Initialize();
+  NetServer server(eConnectionMode::UDP_ASYNC);
+  TEST(testing::assertTrue(
+      server.start(ServerDef(TEST_PORT, 4, 60, eEventBackend::EPOLL))));
+
+  core::net::NetClient client(eConnectionMode::UDP_ASYNC);
+  TEST(testing::assertTrue(
+      client.start(core::net::ClientDef("127.0.0.1", TEST_PORT, 60))));
+
+  // More than one batch worth, so the batch boundaries are exercised.
+  const size_t count = core::net::MAX_DATAGRAM_BATCH + 3;
+  std::vector< std::string > payloads;
+  std::vector< ConstBlob > msgs;
+  for (size_t i = 0; i < count; ++i) {
+    payloads.push_back(std::string(1, (char) ('A' + (i % 26))));
+  }
+  for (size_t i = 0; i < count; ++i) {
+    msgs.push_back(ConstBlob(payloads[i]));
+  }
+  TEST(testing::assertTrue(client.sendBatch(&msgs[0], msgs.size())));
+
+  RecordingHandler handler;
+  TEST(testing::assertTrue(UpdateUntil(
+      server, handler, [&]() { return handler.m_recieved.size() == count; })));
+  TEST(testing::assertEquals(handler.m_opened, 1));
+
+  // The handler echoed each datagram back individually; batch them again.
+  std::vector< core::net::OutboundMessage > out;
+  out.push_back(core::net::OutboundMessage(1, ConstBlob(payloads[0])));
+  out.push_back(core::net::OutboundMessage(1, ConstBlob(payloads[1])));
+  out.push_back(core::net::OutboundMessage(99, ConstBlob(payloads[2])));
+  Status ret = server.sendBatch(&out[0], out.size());
+  TEST(testing::assertEquals(ret.getStatus(), Status::BAD_ARGUMENT));
+
+  ClientRecorder recorder;
+  for (int i = 0; i < 200 && recorder.m_packets.size() < count + 2; ++i) {
+    client.update(recorder).ignoreErrors();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  TEST(testing::assertEquals(recorder.m_packets.size(), count + 2));
+  TEST(testing::assertEquals(recorder.m_packets[0], payloads[0]));
+  TEST(testing::assertEquals(recorder.m_packets[count], payloads[0]));
+  TEST(testing::assertEquals(recorder.m_packets[count + 1], payloads[1]));
+
+  client.stop();
+  server.stop();
+}
+#endif
+
+#if defined(PLAT_LINUX)
+REGISTER_TEST_CASE(testUdpVectoredSend) {
+  core::net::Initialize();
+  NetServer server(eConnectionMode::UDP_ASYNC);
+  TEST(testing::assertTrue(server.start(ServerDef(TEST_PORT, 4, 60))));
+
+  core::net::NetClient client(eConnectionMode::UDP_ASYNC);
+  TEST(testing::assertTrue(
+      client.start(core::net::ClientDef("127.0.0.1", TEST_PORT, 60))));
+
+  const std::string head = "head:";
+  const std::string body = "body";
+  const ConstBlob parts[2] = {ConstBlob(head), ConstBlob(body)};
+  TEST(testing::assertTrue(client.send(parts, 2)));
+
+  // Both parts arrive as a single datagram.
+  RecordingHandler handler;
+  TEST(testing::assertTrue(UpdateUntil(
+      server, handler, [&]() { return handler.m_recieved.size() == 9; })));
+  TEST(testing::assertEquals(handler.m_recieved, std::string("head:body")));
+
+  ClientRecorder recorder;
+  for (int i = 0; i < 200 && recorder.m_packets.empty(); ++i) {
+    client.update(recorder).ignoreErrors();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  TEST(testing::assertEquals(recorder.m_packets.size(), (size_t) 1));
+  TEST(testing::assertEquals(recorder.m_packets[0], std::string("head:body")));
+
+  client.stop();
+  server.stop();
+}
+
+REGISTER_TEST_CASE(testTcpWriteQueue) {
+  core::net::Initialize();
+  NetServer server(eConnectionMode::TCP_ASYNC);
+  TEST(testing::assertTrue(
+      server.start(ServerDef(TEST_PORT, 4, 60, eEventBackend::EPOLL))));
+
+  RecordingHandler handler;
+  const int fd = ConnectRaw(SOCK_STREAM, TEST_PORT);
+  TEST(testing::assertTrue(fd >= 0));
+  TEST(testing::assertTrue(
+      UpdateUntil(server, handler, [&]() { return handler.m_opened == 1; })));
+
+  // Far more than the socket buffers hold, while the client is not reading.
+  // None of these may block, the excess is queued on the connection.
+  static const size_t MESSAGES = 48;
+  static const size_t MESSAGE_SIZE = 64 * 1024;
+  std::string expected;
+  for (size_t i = 0; i < MESSAGES; ++i) {
+    const std::string header(1, (char) ('a' + (i % 26)));
+    const std::string body(MESSAGE_SIZE - 1, (char) ('A' + (i % 26)));
+    const ConstBlob parts[2] = {ConstBlob(header), ConstBlob(body)};
+    TEST(testing::assertTrue(server.send(1, parts, 2)));
+    expected += header + body;
+  }
+
+  std::string recieved(expected.size(), '\0');
+  ssize_t read = 0;
+  std::atomic_bool done(false);
+  std::thread reader([&]() {
+    read = recv(fd, &recieved[0], recieved.size(), MSG_WAITALL);
+    done = true;
+  });
+  UpdateUntil(server, handler, [&]() { return done.load(); });
+  reader.join();
+  TEST(testing::assertEquals(read, (ssize_t) expected.size()));
+  TEST(testing::assertTrue(recieved == expected));
+  TEST(testing::assertEquals(
+      server.stats().m_bytesSent, (u64) expected.size()));
+
+  close(fd);
+  server.stop();
+}
+#endif
+
+#if defined(PLAT_LINUX)
+REGISTER_TEST_CASE(testConnectionTimeout) {
+  core::net::Initialize();
+  NetServer server(eConnectionMode::TCP_ASYNC);
+  TEST(testing::assertTrue(server.start(ServerDef(TEST_PORT, 4, 0.3f))));
+
+  RecordingHandler handler;
+  const int idle = ConnectRaw(SOCK_STREAM, TEST_PORT);
+  const int active = ConnectRaw(SOCK_STREAM, TEST_PORT);
+  TEST(testing::assertTrue(idle >= 0 && active >= 0));
+  TEST(testing::assertTrue(
+      UpdateUntil(server, handler, [&]() { return handler.m_opened == 2; })));
+
+  // Keep one connection busy while the other sits idle past its timeout.
+  for (int i = 0; i < 16 && handler.m_closed == 0; ++i) {
+    TEST(testing::assertEquals(send(active, "k", 1, 0), 1));
+    UpdateUntil(server, handler, [&]() {
+      return handler.m_recieved.size() == (size_t) i + 1;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  TEST(testing::assertEquals(handler.m_closed, 1));
+  TEST(testing::assertEquals(server.stats().m_activeConnections, 1));
+  TEST(testing::assertEquals(
+      server.stats().m_closes[eCloseReason::TIMEOUT], (u64) 1));
+
+  close(idle);
+  close(active);
+  server.stop();
+}
+#endif
+
+#if defined(PLAT_LINUX)
+REGISTER_TEST_CASE(testTcpClientWriteQueue) {
+  // Its own port, as the timeout test leaves TEST_PORT in TIME_WAIT.
+  static const int CLIENT_TEST_PORT = 27125;
+  core::net::Initialize();
+  NetServer server(eConnectionMode::TCP_ASYNC);
+  TEST(testing::assertTrue(
+      server.start(ServerDef(CLIENT_TEST_PORT, 4, 60, eEventBackend::EPOLL))));
+
+  NetClient client(eConnectionMode::TCP_ASYNC);
+  TEST(testing::assertTrue(
+      client.start(ClientDef("localhost", CLIENT_TEST_PORT, 60))));
+
+  // Far more than the socket buffers hold, while the server is not reading.
+  // None of these may block, the excess is queued on the client.
+  static const size_t MESSAGES = 48;
+  static const size_t MESSAGE_SIZE = 64 * 1024;
+  std::string expected;
+  for (size_t i = 0; i < MESSAGES; ++i) {
+    const std::string header(1, (char) ('a' + (i % 26)));
+    const std::string body(MESSAGE_SIZE - 1, (char) ('A' + (i % 26)));
+    const ConstBlob parts[2] = {ConstBlob(header), ConstBlob(body)};
+    TEST(testing::assertTrue(client.send(parts, 2)));
+    expected += header + body;
+  }
+
+  // Client updates flush its queue as the server reads.
+  RecordingHandler handler;
+  CountingClientHandler clientHandler;
+  TEST(testing::assertTrue(UpdateUntil(server, handler, [&]() {
+    client.update(clientHandler).ignoreErrors();
+    return handler.m_recieved.size() == expected.size();
+  })));
+  TEST(testing::assertTrue(handler.m_recieved == expected));
+  TEST(testing::assertEquals(
+      client.stats().m_bytesSent, (u64) expected.size()));
+
+  client.stop();
+  server.stop();
+}
+#endif
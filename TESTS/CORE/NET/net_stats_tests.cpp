@@ -0,0 +1,156 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/NET/net_stats.h>
+
+#include <atomic>
+#include <thread>
+
+using core::net::AtomicLatencyHistogram;
+using core::net::ConnectionStats;
+using core::net::ConnectionStatsTable;
+using core::net::eCloseReason;
+using core::net::LatencyHistogram;
+using core::net::NetCounters;
+using core::net::NetStats;
+
+REGISTER_TEST_CASE(testHistogramBuckets) {
+  // Small values are exact.
+  for (u64 i = 0; i < 8; ++i) {
+    TEST(testing::assertEquals(LatencyHistogram::BucketIndex(i), (size_t) i));
+  }
+
+  // Every value lands in a bucket which holds it, within 1/8th.
+  for (u64 value = 1; value < ((u64) 1 << 39); value = value * 3 + 1) {
+    const size_t idx = LatencyHistogram::BucketIndex(value);
+    TEST(testing::assertTrue(LatencyHistogram::BucketLowerBound(idx) <= value));
+    TEST(testing::assertTrue(LatencyHistogram::BucketUpperBound(idx) >= value));
+    TEST(testing::assertTrue(
+        LatencyHistogram::BucketUpperBound(idx)
+            - LatencyHistogram::BucketLowerBound(idx)
+        <= value / 8));
+  }
+
+  // Buckets are contiguous.
+  for (size_t i = 1; i < core::net::HISTOGRAM_BUCKETS; ++i) {
+    TEST(testing::assertEquals(
+        LatencyHistogram::BucketLowerBound(i),
+        LatencyHistogram::BucketUpperBound(i - 1) + 1));
+  }
+  TEST(testing::assertEquals(
+      LatencyHistogram::BucketIndex((u64) -1),
+      core::net::HISTOGRAM_BUCKETS - 1));
+}
+
+REGISTER_TEST_CASE(testHistogramPercentiles) {
+  LatencyHistogram histogram;
+  TEST(testing::assertEquals(histogram.percentile(0.5), (u64) 0));
+
+  for (u64 i = 1; i <= 1000; ++i) {
+    histogram.record(i * 1000);
+  }
+  TEST(testing::assertEquals(histogram.count(), (u64) 1000));
+  TEST(testing::assertEquals(histogram.maxValue(), (u64) 1000000));
+  TEST(testing::assertEquals(histogram.percentile(1.0), (u64) 1000000));
+
+  const u64 median = histogram.percentile(0.5);
+  TEST(testing::assertTrue(median >= 500000 && median <= 500000 * 9 / 8));
+  const u64 p99 = histogram.percentile(0.99);
+  TEST(testing::assertTrue(p99 >= 990000 && p99 <= 1000000));
+
+  LatencyHistogram other;
+  other.record(5000000);
+  histogram.merge(other);
+  TEST(testing::assertEquals(histogram.count(), (u64) 1001));
+  TEST(testing::assertEquals(histogram.percentile(1.0), (u64) 5000000));
+}
+
+REGISTER_TEST_CASE(testNetCountersSnapshot) {
+  NetCounters counters;
+  counters.addSendCall(100, 2);
+  counters.addSendCall(0, 0);
+  counters.addRecvCall();
+  counters.addRecieved(40);
+  counters.addAccept();
+  counters.addClose(eCloseReason::TIMEOUT);
+  counters.setActiveConnections(3);
+  counters.recordProcessTicks(20);
+
+  NetStats stats = counters.snapshot();
+  TEST(testing::assertEquals(stats.m_bytesSent, (u64) 100));
+  TEST(testing::assertEquals(stats.m_packetsSent, (u64) 2));
+  TEST(testing::assertEquals(stats.m_sendCalls, (u64) 2));
+  TEST(testing::assertEquals(stats.m_recvCalls, (u64) 1));
+  TEST(testing::assertEquals(stats.m_bytesRecieved, (u64) 40));
+  TEST(testing::assertEquals(stats.m_packetsRecieved, (u64) 1));
+  TEST(testing::assertEquals(stats.m_accepts, (u64) 1));
+  TEST(testing::assertEquals(stats.m_closes[eCloseReason::TIMEOUT], (u64) 1));
+  TEST(testing::assertEquals(stats.m_activeConnections, (u32) 3));
+  TEST(testing::assertEquals(stats.m_processTicks.percentile(0.5), (u64) 20));
+
+  stats.merge(counters.snapshot());
+  TEST(testing::assertEquals(stats.m_bytesSent, (u64) 200));
+  TEST(testing::assertEquals(stats.m_processTicks.count(), (u64) 2));
+
+  counters.reset();
+  TEST(testing::assertEquals(counters.snapshot().m_bytesSent, (u64) 0));
+}
+
+REGISTER_TEST_CASE(testHistogramConcurrentSnapshot) {
+  AtomicLatencyHistogram histogram;
+  std::atomic_bool done(false);
+  std::thread writer([&]() {
+    for (u64 i = 0; i < 200000; ++i) {
+      histogram.record(i % 1024);
+    }
+    done = true;
+  });
+
+  // Counts only ever grow, as seen from another thread.
+  u64 last = 0;
+  bool monotonic = true;
+  while (!done) {
+    LatencyHistogram snapshot;
+    histogram.snapshot(snapshot);
+    monotonic = monotonic && snapshot.count() >= last;
+    last = snapshot.count();
+    std::this_thread::yield();
+  }
+  writer.join();
+  TEST(testing::assertTrue(monotonic));
+
+  LatencyHistogram snapshot;
+  histogram.snapshot(snapshot);
+  TEST(testing::assertEquals(snapshot.count(), (u64) 200000));
+  TEST(testing::assertEquals(snapshot.maxValue(), (u64) 1023));
+}
+
+REGISTER_TEST_CASE(testConnectionStatsTable) {
+  ConnectionStatsTable table;
+  table.reset(2);
+  const u32 first = table.acquire(7);
+  const u32 second = table.acquire(9);
+  TEST(testing::assertTrue(first != ConnectionStatsTable::INVALID_SLOT));
+  TEST(testing::assertTrue(second != ConnectionStatsTable::INVALID_SLOT));
+  TEST(testing::assertEquals(
+      table.acquire(11), (u32) ConnectionStatsTable::INVALID_SLOT));
+
+  table.addSent(first, 10, 1);
+  table.addRecieved(first, 4);
+  table.addRecieved(first, 6);
+
+  ConnectionStats stats;
+  TEST(testing::assertTrue(table.find(7, stats)));
+  TEST(testing::assertEquals(stats.m_bytesSent, (u64) 10));
+  TEST(testing::assertEquals(stats.m_packetsSent, (u64) 1));
+  TEST(testing::assertEquals(stats.m_bytesRecieved, (u64) 10));
+  TEST(testing::assertEquals(stats.m_packetsRecieved, (u64) 2));
+  TEST(testing::assertFalse(table.find(8, stats)));
+
+  // A reused slot starts from zero, and forgets its old owner.
+  table.release(first);
+  TEST(testing::assertFalse(table.find(7, stats)));
+  TEST(testing::assertEquals(table.acquire(11), first));
+  TEST(testing::assertTrue(table.find(11, stats)));
+  TEST(testing::assertEquals(stats.m_bytesSent, (u64) 0));
+}
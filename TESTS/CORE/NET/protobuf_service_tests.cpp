@@ -0,0 +1,181 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/NET/protobuf_service.h>
+
+#include <TESTS/CORE/NET/protobuf_service_test.pb.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using core::net::ClientDef;
+using core::net::ServerDef;
+using test::core::net::service::EchoRequest;
+using test::core::net::service::EchoResponse;
+using test::core::net::service::EchoServiceClient;
+using test::core::net::service::EchoServiceServer;
+
+static const int TEST_PORT = 27124;
+
+/**
+ * Answers requests from several workers, slower for lower ids so that
+ * pipelined responses come back out of order.
+ */
+class TestEchoServer : public EchoServiceServer {
+  public:
+  TestEchoServer() : EchoServiceServer(4) {}
+
+  virtual EchoResponse Echo(const EchoRequest &param) {
+    std::this_thread::sleep_for(
+        std::chrono::microseconds(100 * (16 - param.get_id() % 16)));
+    return EchoResponse::Builder()
+        .set_id(param.get_id())
+        .set_text(param.get_text())
+        .build();
+  }
+
+  virtual EchoResponse Reverse(const EchoRequest &param) {
+    std::string text = param.get_text();
+    std::reverse(text.begin(), text.end());
+    return EchoResponse::Builder()
+        .set_id(param.get_id())
+        .set_text(text)
+        .build();
+  }
+};
+
+REGISTER_TEST_CASE(testProtoServiceSyncCall) {
+  core::net::Initialize();
+  TestEchoServer server;
+  TEST(testing::assertTrue(server.start(ServerDef(TEST_PORT, 4, 60))));
+
+  EchoServiceClient client;
+  TEST(testing::assertTrue(
+      client.start(ClientDef("localhost", TEST_PORT, 5.0f))));
+
+  EchoResponse response;
+  TEST(testing::assertTrue(client.Reverse(
+      EchoRequest::Builder().set_id(3).set_text("stressed").build(),
+      response)));
+  TEST(testing::assertEquals(response.get_id(), 3));
+  TEST(testing::assertEquals(response.get_text(), std::string("desserts")));
+
+  client.stop();
+  server.stop();
+}
+
+REGISTER_TEST_CASE(testProtoServicePipelinedCalls) {
+  static const s32 REQUEST_COUNT = 64;
+  // Declared ahead of the client, which may cancel calls as it is destroyed.
+  std::mutex mutex;
+  std::vector< s32 > completed;
+  std::atomic_int mismatched(0);
+
+  core::net::Initialize();
+  TestEchoServer server;
+  TEST(testing::assertTrue(server.start(ServerDef(TEST_PORT, 4, 60))));
+
+  EchoServiceClient client;
+  TEST(testing::assertTrue(
+      client.start(ClientDef("localhost", TEST_PORT, 5.0f))));
+
+  for (s32 i = 0; i < REQUEST_COUNT; ++i) {
+    const std::string text = "request " + std::to_string(i);
+    TEST(testing::assertTrue(client.EchoAsync(
+        EchoRequest::Builder().set_id(i).set_text(text).build(),
+        [i, text, &mutex, &completed, &mismatched](
+            Status status, const EchoResponse &response) {
+          if (!status || response.get_id() != i
+              || response.get_text() != text) {
+            mismatched++;
+          }
+          std::lock_guard< std::mutex > lock(mutex);
+          completed.push_back(i);
+        })));
+  }
+
+  for (int i = 0; i < 500; ++i) {
+    {
+      std::lock_guard< std::mutex > lock(mutex);
+      if (completed.size() == (size_t) REQUEST_COUNT) {
+        break;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  std::lock_guard< std::mutex > lock(mutex);
+  TEST(testing::assertEquals(completed.size(), (size_t) REQUEST_COUNT));
+  TEST(testing::assertEquals(mismatched.load(), 0));
+
+  client.stop();
+  server.stop();
+}
+
+REGISTER_TEST_CASE(testProtoServiceConcurrentSyncCalls) {
+  static const s32 THREAD_COUNT = 4;
+  static const s32 CALL_COUNT = 50;
+  core::net::Initialize();
+  TestEchoServer server;
+  TEST(testing::assertTrue(server.start(ServerDef(TEST_PORT, 4, 60))));
+
+  EchoServiceClient client;
+  TEST(testing::assertTrue(
+      client.start(ClientDef("localhost", TEST_PORT, 5.0f))));
+
+  // Every thread queues its requests for the client network thread at once.
+  std::atomic_int failed(0);
+  std::vector< std::thread > threads;
+  for (s32 t = 0; t < THREAD_COUNT; ++t) {
+    threads.push_back(std::thread([t, &client, &failed]() {
+      for (s32 i = 0; i < CALL_COUNT; ++i) {
+        const s32 id = t * CALL_COUNT + i;
+        EchoResponse response;
+        if (!client.Reverse(
+                EchoRequest::Builder().set_id(id).set_text("ab").build(),
+                response)
+            || response.get_id() != id || response.get_text() != "ba") {
+          failed++;
+        }
+      }
+    }));
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+  TEST(testing::assertEquals(failed.load(), 0));
+
+  client.stop();
+  server.stop();
+}
+
+REGISTER_TEST_CASE(testProtoServiceIdleThreadsSleep) {
+  core::net::Initialize();
+  TestEchoServer server;
+  TEST(testing::assertTrue(server.start(ServerDef(TEST_PORT, 4, 60))));
+
+  EchoServiceClient client;
+  TEST(testing::assertTrue(
+      client.start(ClientDef("localhost", TEST_PORT, 5.0f))));
+
+  // Spinning network threads would each burn the whole wait in CPU time.
+  const std::clock_t start = std::clock();
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  const f64 cpuSec = (f64) (std::clock() - start) / CLOCKS_PER_SEC;
+  TEST(testing::assertTrue(cpuSec < 0.1));
+
+  // Requests still wake the sleeping threads.
+  EchoResponse response;
+  TEST(testing::assertTrue(client.Reverse(
+      EchoRequest::Builder().set_id(1).set_text("live").build(), response)));
+  TEST(testing::assertEquals(response.get_text(), std::string("evil")));
+
+  client.stop();
+  server.stop();
+}
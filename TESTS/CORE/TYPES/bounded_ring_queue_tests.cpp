@@ -0,0 +1,111 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/TYPES/bounded_ring_queue.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using core::types::BoundedRingQueue;
+
+REGISTER_TEST_CASE(testRingQueueTryPushPop) {
+  BoundedRingQueue< int > queue(3);
+  TEST(testing::assertEquals(queue.capacity(), (size_t) 4));
+  TEST(testing::assertTrue(queue.empty()));
+
+  // Several laps, so every slot is reused.
+  for (int lap = 0; lap < 3; ++lap) {
+    for (int i = 0; i < 4; ++i) {
+      TEST(testing::assertTrue(queue.tryPush(lap * 4 + i)));
+    }
+    Status full = queue.tryPush(-1);
+    TEST(testing::assertEquals(full.getStatus(), Status::OUT_OF_BOUNDS));
+    TEST(testing::assertEquals(queue.size(), (size_t) 4));
+
+    for (int i = 0; i < 4; ++i) {
+      int val = -1;
+      TEST(testing::assertTrue(queue.tryPop(val)));
+      TEST(testing::assertEquals(val, lap * 4 + i));
+    }
+    int val = -1;
+    Status empty = queue.tryPop(val);
+    TEST(testing::assertEquals(empty.getStatus(), Status::NOT_FOUND));
+  }
+}
+
+REGISTER_TEST_CASE(testRingQueueClose) {
+  BoundedRingQueue< int > queue(2);
+  TEST(testing::assertTrue(queue.tryPush(1)));
+
+  std::atomic_bool released(false);
+  std::thread blocked([&]() {
+    // Fills the queue, then blocks until the close.
+    TEST(testing::assertTrue(queue.push(2)));
+    Status ret = queue.push(3);
+    TEST(testing::assertEquals(ret.getStatus(), Status::CANCELED));
+    released = true;
+  });
+  while (queue.size() != 2) {
+    std::this_thread::yield();
+  }
+  queue.close();
+  blocked.join();
+  TEST(testing::assertTrue(released.load()));
+  TEST(testing::assertFalse(queue.isOpen()));
+
+  int val;
+  Status ret = queue.pop(val);
+  TEST(testing::assertEquals(ret.getStatus(), Status::CANCELED));
+}
+
+REGISTER_TEST_CASE(testRingQueueBlockingPop) {
+  BoundedRingQueue< int > queue(1);
+  TEST(testing::assertEquals(queue.capacity(), (size_t) 2));
+  std::thread consumer([&]() {
+    for (int i = 0; i < 100; ++i) {
+      int val = -1;
+      TEST(testing::assertTrue(queue.pop(val)));
+      TEST(testing::assertEquals(val, i));
+    }
+  });
+  for (int i = 0; i < 100; ++i) {
+    TEST(testing::assertTrue(queue.push(i)));
+  }
+  consumer.join();
+  TEST(testing::assertTrue(queue.empty()));
+}
+
+REGISTER_TEST_CASE(testRingQueueManyProducersConsumers) {
+  static const int THREADS = 4;
+  static const int PER_THREAD = 20000;
+  BoundedRingQueue< int > queue(64);
+  std::atomic< long long > sum(0);
+  std::atomic_int popped(0);
+
+  std::vector< std::thread > threads;
+  for (int t = 0; t < THREADS; ++t) {
+    threads.push_back(std::thread([&queue, t]() {
+      for (int i = 0; i < PER_THREAD; ++i) {
+        queue.push(t * PER_THREAD + i).ignoreErrors();
+      }
+    }));
+    threads.push_back(std::thread([&queue, &sum, &popped]() {
+      for (int i = 0; i < PER_THREAD; ++i) {
+        int val = 0;
+        if (queue.pop(val)) {
+          sum += val;
+          popped++;
+        }
+      }
+    }));
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  const long long total = THREADS * PER_THREAD;
+  TEST(testing::assertEquals(popped.load(), (int) total));
+  TEST(testing::assertEquals(sum.load(), total * (total - 1) / 2));
+  TEST(testing::assertTrue(queue.empty()));
+}
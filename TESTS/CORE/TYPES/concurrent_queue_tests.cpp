@@ -3,6 +3,8 @@
 
 #include <CORE/TYPES/concurrent_queue.h>
 
+#include <memory>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -80,3 +82,67 @@ REGISTER_TEST_CASE(testPopNEmpty) {
   testThread.join();
   queue.close();
 }
+
+/**
+ * Element type that may only be copied, never moved.
+ */
+struct CopyOnly {
+  CopyOnly() : m_value(0) {}
+  CopyOnly(const int value) : m_value(value) {}
+  CopyOnly(const CopyOnly &other) : m_value(other.m_value) {}
+  CopyOnly &operator=(const CopyOnly &other) {
+    m_value = other.m_value;
+    return *this;
+  }
+
+  int m_value;
+};
+
+REGISTER_TEST_CASE(testMoveOnlyItems) {
+  ConcurrentQueue< std::unique_ptr< int > > queue(4);
+  std::unique_ptr< int > pItem(new int(1));
+  queue.push(std::move(pItem));
+  TEST(testing::assertTrue(pItem.get() == NULL));
+  queue.emplace(new int(2));
+
+  std::unique_ptr< int > pOut;
+  TEST(testing::assertTrue(queue.pop(pOut)));
+  TEST(testing::assertEquals(*pOut, 1));
+
+  std::vector< std::unique_ptr< int > > out;
+  TEST(testing::assertTrue(queue.popN(2, out)));
+  TEST(testing::assertEquals(out.size(), (size_t) 1));
+  TEST(testing::assertEquals(*out[0], 2));
+  queue.close();
+}
+
+REGISTER_TEST_CASE(testCopyOnlyItems) {
+  ConcurrentQueue< CopyOnly > queue(4);
+  const CopyOnly item(1);
+  queue.push(item);
+  queue.push(CopyOnly(2));
+  queue.emplace(3);
+
+  CopyOnly out;
+  TEST(testing::assertTrue(queue.pop(out)));
+  TEST(testing::assertEquals(out.m_value, 1));
+  std::vector< CopyOnly > outN;
+  TEST(testing::assertTrue(queue.popN(2, outN)));
+  TEST(testing::assertEquals(outN[0].m_value, 2));
+  TEST(testing::assertEquals(outN[1].m_value, 3));
+  queue.close();
+}
+
+REGISTER_TEST_CASE(testPushNMovesItems) {
+  ConcurrentQueue< std::string > queue(4);
+  std::vector< std::string > items(2, std::string(64, 'x'));
+  queue.pushN(
+      std::make_move_iterator(items.begin()),
+      std::make_move_iterator(items.end()));
+  TEST(testing::assertTrue(items[0].empty()));
+
+  std::string out;
+  TEST(testing::assertTrue(queue.pop(out)));
+  TEST(testing::assertEquals(out.size(), (size_t) 64));
+  queue.close();
+}
@@ -0,0 +1,101 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/TYPES/spsc_byte_ring.h>
+
+#include <cstring>
+#include <thread>
+
+using core::types::SpscByteRing;
+
+REGISTER_TEST_CASE(testByteRingReserveCommit) {
+  SpscByteRing ring(100);
+  TEST(testing::assertEquals(ring.capacity(), (size_t) 128));
+  TEST(testing::assertTrue(ring.empty()));
+
+  size_t size = 0;
+  TEST(testing::assertTrue(ring.front(size) == NULL));
+
+  u8 *pRecord = ring.reserve(5);
+  TEST(testing::assertTrue(pRecord != NULL));
+  memcpy(pRecord, "hello", 5);
+  // Not visible until committed.
+  TEST(testing::assertTrue(ring.front(size) == NULL));
+  ring.commit();
+
+  const u8 *pFront = ring.front(size);
+  TEST(testing::assertTrue(pFront != NULL));
+  TEST(testing::assertEquals(size, (size_t) 5));
+  TEST(testing::assertEquals(memcmp(pFront, "hello", 5), 0));
+  ring.pop();
+  TEST(testing::assertTrue(ring.empty()));
+
+  TEST(testing::assertTrue(ring.reserve(ring.maxRecordSize() + 1) == NULL));
+}
+
+REGISTER_TEST_CASE(testByteRingWrapsRecords) {
+  SpscByteRing ring(128);
+
+  // Records of 40 bytes take 48, so the third of every lap does not fit
+  // before the end of the ring, and is written at its start.
+  for (u8 lap = 0; lap < 10; ++lap) {
+    for (u8 i = 0; i < 2; ++i) {
+      u8 *pRecord = ring.reserve(40);
+      TEST(testing::assertTrue(pRecord != NULL));
+      memset(pRecord, lap * 2 + i, 40);
+      ring.commit();
+    }
+    TEST(testing::assertTrue(ring.reserve(40) == NULL));
+
+    for (u8 i = 0; i < 2; ++i) {
+      size_t size = 0;
+      const u8 *pFront = ring.front(size);
+      TEST(testing::assertTrue(pFront != NULL));
+      TEST(testing::assertEquals(size, (size_t) 40));
+      TEST(testing::assertEquals(pFront[0], (u8) (lap * 2 + i)));
+      TEST(testing::assertEquals(pFront[39], (u8) (lap * 2 + i)));
+      TEST(testing::assertEquals(((intptr_t) pFront) & 7, 0));
+      ring.pop();
+    }
+    TEST(testing::assertTrue(ring.empty()));
+  }
+}
+
+REGISTER_TEST_CASE(testByteRingThreads) {
+  SpscByteRing ring(1024);
+  static const u32 RECORD_COUNT = 20000;
+
+  std::thread producer([&ring]() {
+    for (u32 i = 0; i < RECORD_COUNT; ++i) {
+      const size_t size = sizeof(u32) + i % 61;
+      u8 *pRecord = ring.reserve(size);
+      while (pRecord == NULL) {
+        std::this_thread::yield();
+        pRecord = ring.reserve(size);
+      }
+      memcpy(pRecord, &i, sizeof(u32));
+      memset(pRecord + sizeof(u32), (u8) i, size - sizeof(u32));
+      ring.commit();
+    }
+  });
+
+  bool inOrder = true;
+  for (u32 i = 0; i < RECORD_COUNT; ++i) {
+    size_t size = 0;
+    const u8 *pFront = ring.front(size);
+    while (pFront == NULL) {
+      std::this_thread::yield();
+      pFront = ring.front(size);
+    }
+    u32 value = 0;
+    memcpy(&value, pFront, sizeof(u32));
+    inOrder = inOrder && value == i && size == sizeof(u32) + i % 61;
+    if (size > sizeof(u32)) {
+      inOrder = inOrder && pFront[size - 1] == (u8) i;
+    }
+    ring.pop();
+  }
+  producer.join();
+  TEST(testing::assertTrue(inOrder));
+  TEST(testing::assertTrue(ring.empty()));
+}
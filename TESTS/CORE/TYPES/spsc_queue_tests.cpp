@@ -0,0 +1,106 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/TYPES/spsc_queue.h>
+
+#include <algorithm>
+#include <thread>
+
+using core::types::SpscQueue;
+
+REGISTER_TEST_CASE(testSpscTryPushPop) {
+  SpscQueue< int > queue(3);
+  TEST(testing::assertEquals(queue.capacity(), (size_t) 4));
+
+  // Several laps, so the cached indices go stale and get refreshed.
+  for (int lap = 0; lap < 3; ++lap) {
+    for (int i = 0; i < 4; ++i) {
+      TEST(testing::assertTrue(queue.tryPush(lap * 4 + i)));
+    }
+    Status full = queue.tryPush(-1);
+    TEST(testing::assertEquals(full.getStatus(), Status::OUT_OF_BOUNDS));
+    TEST(testing::assertEquals(queue.size(), (size_t) 4));
+
+    for (int i = 0; i < 4; ++i) {
+      int val = -1;
+      TEST(testing::assertTrue(queue.tryPop(val)));
+      TEST(testing::assertEquals(val, lap * 4 + i));
+    }
+    int val = -1;
+    Status empty = queue.tryPop(val);
+    TEST(testing::assertEquals(empty.getStatus(), Status::NOT_FOUND));
+  }
+}
+
+REGISTER_TEST_CASE(testSpscPushNPopNWrap) {
+  SpscQueue< int > queue(8);
+  const int items[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  int out[10];
+
+  // Move the indices to the middle of the ring, so the spans wrap.
+  TEST(testing::assertEquals(queue.pushN(items, 5), (size_t) 5));
+  TEST(testing::assertEquals(queue.popN(out, 5), (size_t) 5));
+
+  TEST(testing::assertEquals(queue.pushN(items, 10), (size_t) 8));
+  TEST(testing::assertEquals(queue.pushN(items, 1), (size_t) 0));
+  TEST(testing::assertEquals(queue.popN(out, 3), (size_t) 3));
+  TEST(testing::assertEquals(queue.pushN(items + 8, 2), (size_t) 2));
+
+  TEST(testing::assertEquals(queue.popN(out + 3, 10), (size_t) 7));
+  for (int i = 0; i < 10; ++i) {
+    TEST(testing::assertEquals(out[i], i));
+  }
+  TEST(testing::assertTrue(queue.empty()));
+
+  queue.close();
+  TEST(testing::assertFalse(queue.isOpen()));
+  TEST(testing::assertEquals(queue.pushN(items, 1), (size_t) 0));
+  Status ret = queue.tryPush(1);
+  TEST(testing::assertEquals(ret.getStatus(), Status::CANCELED));
+}
+
+REGISTER_TEST_CASE(testSpscProducerConsumer) {
+  static const int COUNT = 100000;
+  SpscQueue< int > queue(64);
+
+  std::thread producer([&queue]() {
+    int batch[7];
+    int next = 0;
+    while (next < COUNT) {
+      // Alternate single pushes and batches, so both paths share the ring.
+      if (next % 2 == 0) {
+        if (queue.tryPush(next)) {
+          next++;
+          continue;
+        }
+      } else {
+        const int count = std::min(7, COUNT - next);
+        for (int i = 0; i < count; ++i) {
+          batch[i] = next + i;
+        }
+        const size_t pushed = queue.pushN(batch, count);
+        if (pushed > 0) {
+          next += (int) pushed;
+          continue;
+        }
+      }
+      std::this_thread::yield();
+    }
+  });
+
+  int batch[5];
+  int expected = 0;
+  bool ordered = true;
+  while (expected < COUNT) {
+    const size_t popped = queue.popN(batch, 5);
+    for (size_t i = 0; i < popped; ++i) {
+      ordered = ordered && batch[i] == expected++;
+    }
+    if (popped == 0) {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  TEST(testing::assertTrue(ordered));
+  TEST(testing::assertTrue(queue.empty()));
+}
@@ -0,0 +1,82 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/TYPES/work_stealing_deque.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using core::types::WorkStealingDeque;
+
+REGISTER_TEST_CASE(testDequeTakeSteal) {
+  WorkStealingDeque< int > deque(2);
+  int val = -1;
+  TEST(testing::assertFalse(deque.take(val)));
+  TEST(testing::assertFalse(deque.steal(val)));
+
+  // Grows past the initial capacity.
+  for (int i = 0; i < 10; ++i) {
+    deque.push(i);
+  }
+  TEST(testing::assertEquals(deque.size(), (size_t) 10));
+
+  // The owner takes the newest, thieves steal the oldest.
+  TEST(testing::assertTrue(deque.take(val)));
+  TEST(testing::assertEquals(val, 9));
+  TEST(testing::assertTrue(deque.steal(val)));
+  TEST(testing::assertEquals(val, 0));
+
+  for (int i = 8; i > 0; --i) {
+    TEST(testing::assertTrue(deque.take(val)));
+    TEST(testing::assertEquals(val, i));
+  }
+  TEST(testing::assertFalse(deque.take(val)));
+  TEST(testing::assertTrue(deque.empty()));
+}
+
+REGISTER_TEST_CASE(testDequeConcurrentSteal) {
+  static const int COUNT = 50000;
+  static const int THIEVES = 3;
+  WorkStealingDeque< int > deque(16);
+  std::atomic_bool producing(true);
+  std::atomic< long long > sum(0);
+  std::atomic_int seen(0);
+
+  std::vector< std::thread > thieves;
+  for (int t = 0; t < THIEVES; ++t) {
+    thieves.push_back(std::thread([&]() {
+      int val;
+      while (producing.load() || !deque.empty()) {
+        if (deque.steal(val)) {
+          sum += val;
+          seen++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    }));
+  }
+
+  // The owner takes every other item back, racing the thieves for the last.
+  int val;
+  for (int i = 0; i < COUNT; ++i) {
+    deque.push(i);
+    if (i % 2 == 0 && deque.take(val)) {
+      sum += val;
+      seen++;
+    }
+  }
+  producing = false;
+  for (size_t i = 0; i < thieves.size(); ++i) {
+    thieves[i].join();
+  }
+  while (deque.take(val)) {
+    sum += val;
+    seen++;
+  }
+
+  TEST(testing::assertEquals(seen.load(), COUNT));
+  TEST(testing::assertEquals(
+      sum.load(), (long long) COUNT * (COUNT - 1) / 2));
+}
@@ -0,0 +1,133 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/UTIL/task_scheduler.h>
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+using core::util::ParallelFor;
+using core::util::ParallelReduce;
+using core::util::TaskGroup;
+using core::util::TaskScheduler;
+
+REGISTER_TEST_CASE(testTaskGroupWait) {
+  TaskScheduler scheduler(3);
+  TEST(testing::assertEquals(scheduler.getWorkerCount(), (u32) 3));
+
+  std::atomic_int count(0);
+  TaskGroup group(scheduler);
+  for (int i = 0; i < 1000; ++i) {
+    group.run([&count]() { count++; });
+  }
+  group.wait();
+  TEST(testing::assertTrue(group.done()));
+  TEST(testing::assertEquals(count.load(), 1000));
+}
+
+REGISTER_TEST_CASE(testTaskGroupWaitBlocks) {
+  TaskScheduler scheduler(2);
+  TaskGroup group(scheduler);
+  std::atomic_bool started(false);
+  group.run([&started]() {
+    started = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  });
+  while (!started) {
+    std::this_thread::yield();
+  }
+
+  // The task sleeps on a worker, so a waiter spinning all along would burn
+  // the whole wait in CPU time.
+  const std::clock_t start = std::clock();
+  group.wait();
+  const f64 cpuSec = (f64) (std::clock() - start) / CLOCKS_PER_SEC;
+  TEST(testing::assertTrue(group.done()));
+  TEST(testing::assertTrue(cpuSec < 0.1));
+}
+
+/**
+ * Recursive fibonacci, waiting on nested groups from inside tasks.
+ */
+static int Fib(TaskScheduler &scheduler, const int n) {
+  if (n < 2) {
+    return n;
+  }
+  int lhs = 0;
+  TaskGroup group(scheduler);
+  group.run([&scheduler, &lhs, n]() { lhs = Fib(scheduler, n - 1); });
+  const int rhs = Fib(scheduler, n - 2);
+  group.wait();
+  return lhs + rhs;
+}
+
+REGISTER_TEST_CASE(testNestedTaskGroups) {
+  TaskScheduler scheduler(2);
+  TEST(testing::assertEquals(Fib(scheduler, 18), 2584));
+}
+
+REGISTER_TEST_CASE(testParallelFor) {
+  TaskScheduler scheduler(4);
+  std::vector< int > values(10007, 0);
+  ParallelFor(
+      scheduler, 0, values.size(), 64, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          values[i] += (int) i;
+        }
+      });
+  bool allSet = true;
+  for (size_t i = 0; i < values.size(); ++i) {
+    allSet = allSet && values[i] == (int) i;
+  }
+  TEST(testing::assertTrue(allSet));
+
+  // Empty ranges never call the function.
+  bool called = false;
+  ParallelFor(scheduler, 5, 5, 1, [&](size_t, size_t) { called = true; });
+  TEST(testing::assertFalse(called));
+}
+
+REGISTER_TEST_CASE(testParallelReduce) {
+  TaskScheduler scheduler(4);
+  const u64 sum = ParallelReduce(
+      scheduler,
+      1,
+      100001,
+      1000,
+      (u64) 0,
+      [](size_t begin, size_t end) {
+        u64 ret = 0;
+        for (size_t i = begin; i < end; ++i) {
+          ret += i;
+        }
+        return ret;
+      },
+      [](u64 lhs, u64 rhs) { return lhs + rhs; });
+  TEST(testing::assertEquals(sum, (u64) 5000050000ull));
+
+  const int empty = ParallelReduce(
+      scheduler,
+      0,
+      0,
+      1,
+      7,
+      [](size_t, size_t) { return 0; },
+      [](int lhs, int rhs) { return lhs + rhs; });
+  TEST(testing::assertEquals(empty, 7));
+
+  // Chunks finishing at once on different threads each keep their result.
+  for (u32 run = 0; run < 20; ++run) {
+    const bool allMapped = ParallelReduce(
+        scheduler,
+        0,
+        4096,
+        1,
+        false,
+        [](size_t, size_t) { return true; },
+        [](bool lhs, bool rhs) { return lhs && rhs; });
+    TEST(testing::assertTrue(allMapped));
+  }
+}
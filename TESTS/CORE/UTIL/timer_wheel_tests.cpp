@@ -0,0 +1,100 @@
+#include <TESTS/test_assertions.h>
+#include <TESTS/testcase.h>
+
+#include <CORE/UTIL/timer_wheel.h>
+
+#include <algorithm>
+#include <vector>
+
+using core::util::TimerWheel;
+
+REGISTER_TEST_CASE(testTimerWheelExpiresInOrder) {
+  TimerWheel wheel(10, 8);
+  wheel.schedule(1, 25);
+  wheel.schedule(2, 55);
+  wheel.schedule(3, 35);
+  TEST(testing::assertEquals(wheel.size(), (size_t) 3));
+
+  std::vector< TimerWheel::Deadline > expired;
+  wheel.advance(20, expired);
+  TEST(testing::assertTrue(expired.empty()));
+
+  wheel.advance(40, expired);
+  std::sort(
+      expired.begin(),
+      expired.end(),
+      [](const TimerWheel::Deadline &a, const TimerWheel::Deadline &b) {
+        return a.m_id < b.m_id;
+      });
+  TEST(testing::assertEquals(expired.size(), (size_t) 2));
+  TEST(testing::assertEquals(expired[0].m_id, (u32) 1));
+  TEST(testing::assertEquals(expired[1].m_id, (u32) 3));
+
+  expired.clear();
+  wheel.advance(60, expired);
+  TEST(testing::assertEquals(expired.size(), (size_t) 1));
+  TEST(testing::assertEquals(expired[0].m_id, (u32) 2));
+  TEST(testing::assertEquals(wheel.size(), (size_t) 0));
+}
+
+REGISTER_TEST_CASE(testTimerWheelMultipleTurns) {
+  TimerWheel wheel(10, 8);
+  wheel.schedule(1, 1005);
+
+  // Each turn is 80 ticks, so the deadline is passed over several times.
+  std::vector< TimerWheel::Deadline > expired;
+  for (u64 now = 0; now < 1000; now += 10) {
+    wheel.advance(now, expired);
+  }
+  TEST(testing::assertTrue(expired.empty()));
+  TEST(testing::assertEquals(wheel.size(), (size_t) 1));
+
+  wheel.advance(1010, expired);
+  TEST(testing::assertEquals(expired.size(), (size_t) 1));
+}
+
+REGISTER_TEST_CASE(testTimerWheelLargeJump) {
+  TimerWheel wheel(10, 8);
+  for (u32 i = 0; i < 100; ++i) {
+    wheel.schedule(i, i * 10);
+  }
+
+  std::vector< TimerWheel::Deadline > expired;
+  wheel.advance(495, expired);
+  TEST(testing::assertEquals(expired.size(), (size_t) 50));
+  TEST(testing::assertEquals(wheel.size(), (size_t) 50));
+
+  expired.clear();
+  wheel.advance(100000, expired);
+  TEST(testing::assertEquals(expired.size(), (size_t) 50));
+  TEST(testing::assertEquals(wheel.size(), (size_t) 0));
+}
+
+REGISTER_TEST_CASE(testTimerWheelPastDeadline) {
+  TimerWheel wheel(10, 8);
+  std::vector< TimerWheel::Deadline > expired;
+  wheel.advance(100, expired);
+
+  // Already due, fires on the next advance.
+  wheel.schedule(7, 50);
+  wheel.advance(100, expired);
+  TEST(testing::assertTrue(expired.empty()));
+  wheel.advance(110, expired);
+  TEST(testing::assertEquals(expired.size(), (size_t) 1));
+  TEST(testing::assertEquals(expired[0].m_id, (u32) 7));
+}
+
+REGISTER_TEST_CASE(testTimerWheelReportsDeadlines) {
+  TimerWheel wheel(10, 8);
+  wheel.schedule(4, 25);
+  wheel.schedule(4, 32);
+
+  // Both deadlines of a rescheduled id fire, each with its own deadline.
+  std::vector< TimerWheel::Deadline > expired;
+  wheel.advance(40, expired);
+  TEST(testing::assertEquals(expired.size(), (size_t) 2));
+  TEST(testing::assertEquals(expired[0].m_id, (u32) 4));
+  TEST(testing::assertEquals(expired[0].m_deadline, (u64) 25));
+  TEST(testing::assertEquals(expired[1].m_id, (u32) 4));
+  TEST(testing::assertEquals(expired[1].m_deadline, (u64) 32));
+}
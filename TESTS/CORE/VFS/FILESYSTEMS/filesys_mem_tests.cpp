@@ -115,6 +115,36 @@ REGISTER_TEST_CASE(testMemFileCreateRemove) {
       filesys.remove(vfs::INVALID_MOUNT_ID, vfs::Path(), ret)));
 }
 
+REGISTER_TEST_CASE(testMemFileCreateShared) {
+  MemFileSystem filesys;
+  const vfs::tMountId mountId = 1;
+  TEST(testing::assertEquals(
+      filesys.mount(mountId, "memfile/", std::ios::in | std::ios::binary)
+          .getStatus(),
+      Status::OK));
+
+  const vfs::Path filename("memfile/shared.txt");
+  {
+    // The file keeps the buffer alive once the caller drops it.
+    core::memory::SharedBuffer buffer = core::memory::SharedBuffer::copy(
+        core::memory::ConstBlob(std::string("shared data")));
+    TEST(testing::assertTrue(filesys.create(filename, buffer)));
+  }
+
+  vfs::filters::BaseFsStreamFilter *pFile = nullptr;
+  TEST(testing::assertTrue(
+      filesys.open(pFile, mountId, filename, std::ios::in | std::ios::binary)));
+  char actualContent[16] = {0};
+  pFile->sgetn(actualContent, 11);
+  TEST(testing::assertEquals(
+      std::string(actualContent), std::string("shared data")));
+  filesys.close(pFile);
+
+  bool ret = false;
+  TEST(testing::assertTrue(filesys.remove(mountId, filename, ret)));
+  TEST(testing::assertTrue(ret));
+}
+
 REGISTER_TEST_CASE(testMemMkdirRmdir) {
   MemFileSystem filesys;
 
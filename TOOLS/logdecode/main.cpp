@@ -0,0 +1,124 @@
+#include <APP_SHARED/app_main.h>
+#include <APP_SHARED/fileutil.h>
+
+#include <CORE/BASE/config.h>
+#include <CORE/BASE/logging.h>
+#include <CORE/BASE/logging_binary_sink.h>
+#include <CORE/BASE/logging_default_sinks.h>
+#include <CORE/UTIL/lexical_cast.h>
+#include <CORE/VFS/vfs.h>
+#include <CORE/VFS/vfs_file.h>
+#include <CORE/types.h>
+
+#include <chrono>
+#include <iostream>
+
+FISHY_APPLICATION(LogDecode)
+
+using core::config::Flag;
+using core::logging::BinaryLogEntry;
+using core::logging::BinaryLogReader;
+using core::logging::LoggingStdioSink;
+
+static Status DecodeLog(std::ostream &out);
+
+Flag< std::string > g_inputFileName("infile", "binary log to decode", "");
+Flag< std::string > g_outputFileName(
+    "outfile", "file to write the text log to, instead of stdout", "");
+
+/**
+ *
+ */
+void LogDecode::init(const char *arg0) {
+  (void) arg0;
+}
+
+/**
+ *
+ */
+void LogDecode::printHelp() {
+  std::cout << "Decode a binary log into text." << std::endl;
+  std::cout << "Usage:" << std::endl;
+  std::cout << "    logdecode --infile <log> [--outfile <text>]" << std::endl;
+}
+
+/**
+ *
+ */
+int LogDecode::main() {
+  g_inputFileName.checkSet();
+  if (g_outputFileName.get().empty()) {
+    return DecodeLog(std::cout) ? 0 : -1;
+  }
+
+  const vfs::tMountId writeableMount = vfs::Mount(
+      vfs::Path("./"),
+      vfs::Path("./"),
+      std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+  CHECK_M(
+      writeableMount != vfs::INVALID_MOUNT_ID,
+      "Could not mount drive for writing.");
+
+  int ret = -1;
+  {
+    vfs::ofstream ofile(vfs::Path(g_outputFileName.get()));
+    if (ofile.is_open()) {
+      ret = DecodeLog(ofile) ? 0 : -1;
+    } else {
+      Log(LL::Error) << "Unable to open output file "
+                     << g_outputFileName.get();
+    }
+  }
+  vfs::Unmount(writeableMount);
+  return ret;
+}
+
+/**
+ * Times are printed as whole seconds since the log started, as the stdio
+ * sink prints them since logging started.
+ */
+Status DecodeLog(std::ostream &out) {
+  std::string content;
+  Status ret = appshared::parseFileToString(
+      vfs::Path(g_inputFileName.get()), content);
+  RET_SM(
+      ret,
+      ret,
+      "Unable to read input file " << g_inputFileName.get() << " error "
+                                   << ret.getStatus());
+
+  const core::memory::ConstBlob contentBlob(content);
+  core::base::ConstBlobSink source(contentBlob);
+  BinaryLogReader reader(source);
+  BinaryLogEntry entry;
+  while (true) {
+    Status next = reader.next(entry);
+    if (!next) {
+      return next.getStatus() == Status::NOT_FOUND ? Status::ok() : next;
+    }
+
+    const s64 start = std::chrono::duration_cast< std::chrono::seconds >(
+                          reader.getStartTime().time_since_epoch())
+                          .count();
+    const s64 secs = std::chrono::duration_cast< std::chrono::seconds >(
+                         entry.m_timestamp.time_since_epoch())
+                         .count();
+    std::string time;
+    core::util::lexical_cast(secs - start, time).ignoreErrors();
+
+    core::logging::TraceInfo trace(
+        entry.m_file.c_str(), entry.m_function.c_str(), entry.m_line);
+    trace.m_stackPtr = entry.m_stackPtr;
+    if (entry.m_msg.empty() || entry.m_msg.back() != '\n') {
+      entry.m_msg += '\n';
+    }
+    core::logging::WriteLogLine(
+        out,
+        LoggingStdioSink::Options::FORMAT_VERBOSE,
+        entry.m_logLevel,
+        trace,
+        entry.m_thread,
+        time + "s",
+        entry.m_msg);
+  }
+}
@@ -106,7 +106,7 @@ static void printImports(
   ofile << "\n";
 
   if (hasServices) {
-    ofile << "#include <CORE/UTIL/protobuf_service.h>\n";
+    ofile << "#include <CORE/NET/protobuf_service.h>\n";
   } else {
     ofile << "#include <CORE/TYPES/protobuf.h>\n";
   }
@@ -702,6 +702,46 @@ static void printISerializer(
   ofile << "}\n";
 }
 
+/**
+ * Prints the server and client stubs for a service.
+ */
+static void printHeaderService(std::ofstream &ofile, const ServiceDef &srvDef) {
+  ofile << "class " << srvDef.m_name
+        << "Server : public ::core::util::iProtoServiceServer {\n";
+  ofile << "protected:\n";
+  ofile << srvDef.m_name << "Server(const u32 workerCount = "
+        << "::core::util::DEFAULT_RPC_WORKERS) : "
+        << "::core::util::iProtoServiceServer(workerCount) { }\n";
+  for (std::vector< RpcFunctionDef >::const_iterator itr =
+           srvDef.m_functions.begin();
+       itr != srvDef.m_functions.end();
+       ++itr) {
+    ofile << "virtual " << itr->m_return << " " << itr->m_name << "(const "
+          << itr->m_param << " &param) = 0;\n";
+  }
+  ofile << "virtual bool process(const u32 method, "
+           "const ::core::memory::ConstBlob &request, "
+           "std::vector< u8 > &response) final;\n";
+  ofile << "};\n";
+
+  ofile << "class " << srvDef.m_name
+        << "Client : public ::core::util::iProtoServiceClient {\n";
+  ofile << "public:\n";
+  for (std::vector< RpcFunctionDef >::const_iterator itr =
+           srvDef.m_functions.begin();
+       itr != srvDef.m_functions.end();
+       ++itr) {
+    ofile << "typedef std::function< void(::core::base::Status, const "
+          << itr->m_return << " &) > t" << itr->m_name << "Callback;\n";
+    ofile << "::core::base::Status " << itr->m_name << "(const "
+          << itr->m_param << " &param, " << itr->m_return << " &response);\n";
+    ofile << "::core::base::Status " << itr->m_name << "Async(const "
+          << itr->m_param << " &param, const t" << itr->m_name
+          << "Callback &callback);\n";
+  }
+  ofile << "};\n";
+}
+
 /**
  * Prints the header file portion of the proto
  */
@@ -734,14 +774,13 @@ bool PrintHeader(const ProtoDef &def, const std::string &fileName) {
     printMessageBuilder(ofile, *message, message->m_name);
   }
 
-  /*
   for (std::vector< ServiceDef >::const_iterator service =
            def.m_services.begin();
        service != def.m_services.end();
        ++service) {
     printHeaderService(ofile, *service);
   }
-  */
+
   printCloseNamespace(ofile, package);
 
   for (std::vector< MessageDef >::const_iterator message =
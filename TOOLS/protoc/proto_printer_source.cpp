@@ -246,6 +246,73 @@ static void printCppVirtuals(
   }
 }
 
+/**
+ * Prints the request dispatch for a service server, and the request senders
+ * for its client. Methods are identified on the wire by the CRC of their name.
+ */
+static void printCppServiceHandlers(
+    std::ofstream &ofile,
+    const ServiceDef &srvDef,
+    const std::string &package) {
+  ofile << "bool " << package << srvDef.m_name
+        << "Server::process(const u32 method, "
+           "const ::core::memory::ConstBlob &request, "
+           "std::vector< u8 > &response) {\n";
+  ofile << "switch (method) {\n";
+  for (std::vector< RpcFunctionDef >::const_iterator itr =
+           srvDef.m_functions.begin();
+       itr != srvDef.m_functions.end();
+       ++itr) {
+    const u32 sig = core::hash::CRC32(itr->m_name.begin(), itr->m_name.end());
+    ofile << "case " << sig << "u: {\n";
+    ofile << itr->m_param << " msgIn;\n";
+    ofile << "if (!::core::util::BlobToProto(request, msgIn)) {\n";
+    ofile << "return false;\n";
+    ofile << "}\n";
+    ofile << "return ::core::util::ProtoToBuffer(" << itr->m_name
+          << "(msgIn), response);\n";
+    ofile << "}\n";
+  }
+  ofile << "default:\n";
+  ofile << "return false;\n";
+  ofile << "}\n";
+  ofile << "}\n";
+
+  for (std::vector< RpcFunctionDef >::const_iterator itr =
+           srvDef.m_functions.begin();
+       itr != srvDef.m_functions.end();
+       ++itr) {
+    const u32 sig = core::hash::CRC32(itr->m_name.begin(), itr->m_name.end());
+
+    ofile << "::core::base::Status " << package << srvDef.m_name
+          << "Client::" << itr->m_name << "(const " << itr->m_param
+          << " &param, " << itr->m_return << " &response) {\n";
+    ofile << "return doSyncRpc(" << sig << "u, param, response);\n";
+    ofile << "}\n";
+
+    ofile << "::core::base::Status " << package << srvDef.m_name
+          << "Client::" << itr->m_name << "Async(const " << itr->m_param
+          << " &param, const t" << itr->m_name << "Callback &callback) {\n";
+    ofile << "if (!callback) {\n";
+    ofile << "return doAsyncRpc(" << sig << "u, param, tCallback());\n";
+    ofile << "}\n";
+    ofile << "return doAsyncRpc(" << sig << "u, param, [callback]("
+          << "::core::base::Status status, "
+          << "const ::core::memory::ConstBlob &body) {\n";
+    ofile << itr->m_return << " response;\n";
+    ofile << "if (!status) {\n";
+    ofile << "callback(status.clone(), response);\n";
+    ofile << "} else if (!::core::util::BlobToProto(body, response)) {\n";
+    ofile << "callback(::core::base::Status("
+             "::core::base::Status::BAD_INPUT), response);\n";
+    ofile << "} else {\n";
+    ofile << "callback(::core::base::Status::ok(), response);\n";
+    ofile << "}\n";
+    ofile << "});\n";
+    ofile << "}\n";
+  }
+}
+
 /**
  * Prints the cpp file portion of the proto
  */
@@ -260,9 +327,6 @@ bool PrintCpp(
 
   ofile << "#include \"" << headerName << "\"\n";
   ofile << "#include <CORE/UTIL/lexical_cast.h>\n";
-  if (!def.m_services.empty()) {
-    ofile << "#include <WRAPPERS/NET/packet_handler.h>\n";
-  }
   ofile << "\n";
 
   const std::vector< std::string > package =
@@ -298,7 +362,6 @@ bool PrintCpp(
         core::util::ReplaceStr(def.m_package, ".", "::") + "::");
   }
 
-  /*
   for (std::vector< ServiceDef >::const_iterator service =
            def.m_services.begin();
        service != def.m_services.end();
@@ -308,6 +371,5 @@ bool PrintCpp(
         *service,
         core::util::ReplaceStr(def.m_package, ".", "::") + "::");
   }
-  */
   return true;
 }
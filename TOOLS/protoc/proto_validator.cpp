@@ -1,6 +1,7 @@
 #include "proto_validator.h"
 
 #include <CORE/BASE/logging.h>
+#include <CORE/HASH/crc32.h>
 
 #include <set>
 
@@ -16,6 +17,7 @@ using core::types::ServiceDef;
  */
 bool verifyService(const ServiceDef &def) {
   std::set< std::string > knownFunctions;
+  std::set< u32 > knownSignatures;
   for (std::vector< RpcFunctionDef >::const_iterator itr =
            def.m_functions.begin();
        itr != def.m_functions.end();
@@ -24,6 +26,14 @@ bool verifyService(const ServiceDef &def) {
         knownFunctions.find(itr->m_name) == knownFunctions.end(),
         "Service function " << itr->m_name << " is defined more than once.");
     knownFunctions.insert(itr->m_name);
+
+    // Requests are dispatched by the CRC of the function name.
+    const u32 sig = core::hash::CRC32(itr->m_name.begin(), itr->m_name.end());
+    RET_M(
+        knownSignatures.find(sig) == knownSignatures.end(),
+        "Service function " << itr->m_name
+                            << " has a signature colliding with another.");
+    knownSignatures.insert(sig);
   }
   return true;
 }